@@ -0,0 +1,249 @@
+//***************************************************************************************
+// AsyncLoadBench.cpp
+//
+// Wall time to load a whole directory of .dds files (by default the Textures/ folder)
+// through AsyncTextureReader at increasing queue depths, for each AsyncFileIO backend
+// available here.  Every file is read, laid out and copied into a staging buffer in
+// the footprint layout, as a real load would, so the numbers include the parsing and
+// staging the asynchronous reads overlap with.  "sync" is the one-file-at-a-time
+// LoadDDSTextureDataFromFile baseline.
+//
+// With a warm page cache this measures the submission overhead; pass --cold to drop
+// the files from the cache before every pass (Linux only) and measure the drive.
+//
+// Built by the AsyncLoadBench target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: AsyncLoadBench [--dir Textures] [--out results.json] [--max-depth N]
+//                       [--repeat N] [--cold]
+//***************************************************************************************
+
+#include "../Common/AsyncTextureReader.h"
+#include "../Common/FileMapping.h"
+#include "../Common/TextureFootprint.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct LoadResult
+	{
+		std::string Backend;
+		unsigned int QueueDepth = 0;
+		double Seconds = 0.0;
+		double Speedup = 0.0;
+		double MegabytesPerSecond = 0.0;
+		unsigned int Failed = 0;
+	};
+
+	double Seconds(Clock::time_point a, Clock::time_point b)
+	{
+		return std::chrono::duration<double>(b - a).count();
+	}
+
+	// Asks the OS to forget the cached pages of every file.
+	void EvictFromCache(const std::vector<std::wstring>& files)
+	{
+#if !defined(_WIN32)
+		for(const std::wstring& file : files)
+		{
+			int fd = open(WideToUtf8(file.c_str()).c_str(), O_RDONLY);
+			if(fd >= 0)
+			{
+				posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+				close(fd);
+			}
+		}
+#else
+		(void)files;
+#endif
+	}
+
+	// Copies a loaded texture into staging memory; false if it cannot be staged.
+	bool Stage(const DDS_TEXTURE_DATA& data)
+	{
+		MemoryStagingSink staging;
+		DDS_STAGED_TEXTURE staged;
+		return SUCCEEDED(StageDDSTextureData(data, staging, staged));
+	}
+
+	void WriteJson(FILE* out, size_t fileCount, std::uint64_t fileBytes, bool cold,
+		const std::vector<LoadResult>& results)
+	{
+		fprintf(out, "{\n  \"files\": %zu,\n  \"fileBytes\": %llu,\n  \"cold\": %s,\n  \"runs\": [\n",
+			fileCount, (unsigned long long)fileBytes, cold ? "true" : "false");
+		for(size_t i = 0; i < results.size(); ++i)
+		{
+			const LoadResult& r = results[i];
+			fprintf(out,
+				"    { \"backend\": \"%s\", \"queueDepth\": %u, \"seconds\": %.9g, \"speedup\": %.4g, "
+				"\"megabytesPerSecond\": %.6g, \"failed\": %u }%s\n",
+				r.Backend.c_str(), r.QueueDepth, r.Seconds, r.Speedup, r.MegabytesPerSecond, r.Failed,
+				i + 1 < results.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string dir = "../Textures";
+	const char* outPath = nullptr;
+	unsigned int maxDepth = 64;
+	int repeat = 5;
+	bool cold = false;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+			dir = argv[++i];
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else if(strcmp(argv[i], "--max-depth") == 0 && i + 1 < argc)
+			maxDepth = (unsigned int)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--cold") == 0)
+			cold = true;
+		else
+		{
+			fprintf(stderr, "usage: %s [--dir Textures] [--out file.json] [--max-depth N] "
+				"[--repeat N] [--cold]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<std::wstring> files;
+	std::uint64_t fileBytes = 0;
+	std::error_code ec;
+	for(const auto& entry : std::filesystem::directory_iterator(dir, ec))
+	{
+		if(entry.is_regular_file() && entry.path().extension() == ".dds")
+		{
+			files.push_back(entry.path().wstring());
+			fileBytes += entry.file_size();
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	if(files.empty())
+	{
+		fprintf(stderr, "no .dds files in %s\n", dir.c_str());
+		return 1;
+	}
+
+	// Times the best of the passes; a warm run comes first unless the cache is
+	// dropped before each pass anyway.
+	auto timeLoads = [&](auto&& loadAll, unsigned int& failed)
+	{
+		if(!cold)
+			loadAll();
+
+		double best = 0.0;
+		for(int r = 0; r < repeat; ++r)
+		{
+			if(cold)
+				EvictFromCache(files);
+
+			failed = 0;
+			Clock::time_point start = Clock::now();
+			failed = loadAll();
+			double s = Seconds(start, Clock::now());
+			if(r == 0 || s < best)
+				best = s;
+		}
+		return best;
+	};
+
+	std::vector<LoadResult> results;
+	auto report = [&](const char* backend, unsigned int depth, double seconds, unsigned int failed, double baseline)
+	{
+		LoadResult res;
+		res.Backend = backend;
+		res.QueueDepth = depth;
+		res.Seconds = seconds;
+		res.Speedup = seconds > 0.0 ? baseline / seconds : 0.0;
+		res.MegabytesPerSecond = seconds > 0.0 ? (double)fileBytes / (1024.0*1024.0) / seconds : 0.0;
+		res.Failed = failed;
+		results.push_back(res);
+
+		fprintf(stderr, "%-9s depth %3u  %8.3f ms  %9.1f MB/s  %.2fx\n",
+			backend, depth, seconds*1000.0, res.MegabytesPerSecond, res.Speedup);
+	};
+
+	unsigned int failed = 0;
+	const double baseline = timeLoads([&]()
+	{
+		unsigned int count = 0;
+		for(const std::wstring& file : files)
+		{
+			DDS_TEXTURE_DATA data;
+			if(FAILED(LoadDDSTextureDataFromFile(file.c_str(), data)) || !Stage(data))
+				++count;
+		}
+		return count;
+	}, failed);
+	report("sync", 1, baseline, failed, baseline);
+
+	const AsyncIOBackend backends[] = { AsyncIOBackend::IoUring, AsyncIOBackend::Threads };
+	for(AsyncIOBackend backend : backends)
+	{
+		for(unsigned int depth = 1; depth <= maxDepth; depth *= 2)
+		{
+			std::unique_ptr<AsyncFileIO> io = CreateAsyncFileIO(depth, backend);
+			if(!io)
+			{
+				fprintf(stderr, "backend %s is not available\n",
+					backend == AsyncIOBackend::IoUring ? "io_uring" : "threads");
+				break;
+			}
+
+			AsyncTextureReader reader(*io);
+			double seconds = timeLoads([&]()
+			{
+				unsigned int count = 0;
+				reader.Read(files, [&](size_t, HRESULT hr, DDS_TEXTURE_DATA& data)
+				{
+					if(FAILED(hr) || !Stage(data))
+						++count;
+				});
+				return count;
+			}, failed);
+			report(io->Name(), depth, seconds, failed, baseline);
+		}
+	}
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	WriteJson(out, files.size(), fileBytes, cold, results);
+
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
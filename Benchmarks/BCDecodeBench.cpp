@@ -0,0 +1,224 @@
+//***************************************************************************************
+// BCDecodeBench.cpp
+//
+// Measures single-threaded BCDecode throughput for each supported format on a
+// synthetic surface of random blocks (every BC7 mode and partition shows up), and
+// for the block-compressed textures of a directory (by default Textures/), which
+// decode every mip of every slice.  Build it once more with -DBC_DECODE_NO_SIMD to
+// compare against the scalar path.
+//
+// Built by the BCDecodeBench target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: BCDecodeBench [--dir Textures] [--size N] [--repeat N] [--out results.json]
+//***************************************************************************************
+
+#include "../Common/BCDecode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct DecodeResult
+	{
+		std::string Name;
+		std::uint64_t Texels = 0;
+		std::uint64_t CompressedBytes = 0;
+		double Seconds = 0.0;
+		double MegatexelsPerSecond = 0.0;
+		double CompressedMegabytesPerSecond = 0.0;
+	};
+
+	// Keeps the best of repeat timed runs of decode(), after one warm-up.
+	template<typename F>
+	double BestOf(int repeat, F decode)
+	{
+		decode();
+		double best = 0.0;
+		for(int r = 0; r < repeat; ++r)
+		{
+			Clock::time_point start = Clock::now();
+			decode();
+			double s = std::chrono::duration<double>(Clock::now() - start).count();
+			if(r == 0 || s < best)
+				best = s;
+		}
+		return best;
+	}
+
+	void Finish(DecodeResult& res, double seconds)
+	{
+		res.Seconds = seconds;
+		res.MegatexelsPerSecond = seconds > 0.0 ? res.Texels / 1.0e6 / seconds : 0.0;
+		res.CompressedMegabytesPerSecond = seconds > 0.0 ? res.CompressedBytes / (1024.0*1024.0) / seconds : 0.0;
+		fprintf(stderr, "%-28s %10.3f ms  %9.1f Mtexel/s  %8.1f MB/s in\n",
+			res.Name.c_str(), seconds*1000.0, res.MegatexelsPerSecond, res.CompressedMegabytesPerSecond);
+	}
+
+	void WriteJson(FILE* out, bool simd, const std::vector<DecodeResult>& results)
+	{
+		fprintf(out, "{\n  \"simd\": %s,\n  \"runs\": [\n", simd ? "true" : "false");
+		for(size_t i = 0; i < results.size(); ++i)
+		{
+			const DecodeResult& r = results[i];
+			fprintf(out,
+				"    { \"name\": \"%s\", \"texels\": %llu, \"compressedBytes\": %llu, \"seconds\": %.9g, "
+				"\"megatexelsPerSecond\": %.6g, \"compressedMegabytesPerSecond\": %.6g }%s\n",
+				r.Name.c_str(), (unsigned long long)r.Texels, (unsigned long long)r.CompressedBytes,
+				r.Seconds, r.MegatexelsPerSecond, r.CompressedMegabytesPerSecond,
+				i + 1 < results.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string dir = "../Textures";
+	const char* outPath = nullptr;
+	std::uint32_t size = 1024;
+	int repeat = 5;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+			dir = argv[++i];
+		else if(strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			size = (std::uint32_t)std::max(4, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--dir Textures] [--size N] [--repeat N] [--out file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+#if defined(BC_DECODE_NO_SIMD)
+	const bool simd = false;
+#else
+	const bool simd = true;
+#endif
+
+	std::vector<DecodeResult> results;
+	std::vector<std::uint8_t> rgba((size_t)size*size*4);
+
+	//
+	// Synthetic surfaces.
+	//
+
+	struct Format
+	{
+		const char* Name;
+		DXGI_FORMAT Format;
+	};
+	const Format formats[] =
+	{
+		{ "BC1", DXGI_FORMAT_BC1_UNORM },
+		{ "BC2", DXGI_FORMAT_BC2_UNORM },
+		{ "BC3", DXGI_FORMAT_BC3_UNORM },
+		{ "BC4", DXGI_FORMAT_BC4_UNORM },
+		{ "BC5", DXGI_FORMAT_BC5_UNORM },
+		{ "BC5_SNORM", DXGI_FORMAT_BC5_SNORM },
+		{ "BC7", DXGI_FORMAT_BC7_UNORM },
+	};
+
+	std::mt19937 rng(1);
+	for(const Format& f : formats)
+	{
+		size_t rowBytes = 0;
+		size_t numBytes = 0;
+		GetSurfaceInfo(size, size, f.Format, &numBytes, &rowBytes, nullptr);
+
+		std::vector<std::uint8_t> blocks(numBytes);
+		for(std::uint8_t& b : blocks)
+			b = (std::uint8_t)rng();
+
+		DDS_SUBRESOURCE sub = { blocks.data(), (intptr_t)rowBytes, (intptr_t)numBytes };
+
+		DecodeResult res;
+		res.Name = std::string("synthetic ") + f.Name;
+		res.Texels = (std::uint64_t)size*size;
+		res.CompressedBytes = numBytes;
+		Finish(res, BestOf(repeat, [&]() { DecodeBC(f.Format, sub, size, size, rgba.data(), (size_t)size*4); }));
+		results.push_back(res);
+	}
+
+	//
+	// Textures on disk, grouped by format.
+	//
+
+	std::vector<std::wstring> files;
+	std::error_code ec;
+	for(const auto& entry : std::filesystem::directory_iterator(dir, ec))
+	{
+		if(entry.is_regular_file() && entry.path().extension() == ".dds")
+			files.push_back(entry.path().wstring());
+	}
+	std::sort(files.begin(), files.end());
+
+	std::vector<DDS_TEXTURE_DATA> textures;
+	for(const std::wstring& file : files)
+	{
+		DDS_TEXTURE_DATA data;
+		if(SUCCEEDED(LoadDDSTextureDataFromFile(file.c_str(), data)) && IsDecodableBC(data.info.format))
+			textures.push_back(std::move(data));
+	}
+
+	if(!textures.empty())
+	{
+		DecodeResult res;
+		res.Name = "textures (" + std::to_string(textures.size()) + " files)";
+		for(const DDS_TEXTURE_DATA& data : textures)
+		{
+			for(size_t i = 0; i < data.subresources.size(); ++i)
+			{
+				std::uint32_t mip = (std::uint32_t)(i % data.info.mipCount);
+				res.Texels += (std::uint64_t)std::max(1u, data.info.width >> mip) * std::max(1u, data.info.height >> mip);
+				res.CompressedBytes += (std::uint64_t)data.subresources[i].slicePitch;
+			}
+		}
+
+		std::vector<std::uint8_t> scratch;
+		Finish(res, BestOf(repeat, [&]()
+		{
+			for(const DDS_TEXTURE_DATA& data : textures)
+			{
+				for(size_t i = 0; i < data.subresources.size(); ++i)
+					DecodeBC(data, i, scratch, nullptr, nullptr);
+			}
+		}));
+		results.push_back(res);
+	}
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	WriteJson(out, simd, results);
+
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
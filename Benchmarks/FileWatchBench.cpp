@@ -0,0 +1,228 @@
+//***************************************************************************************
+// FileWatchBench.cpp
+//
+// Hot-reload turnaround for one texture: how long after a save the FileWatcher reports
+// the file, and how long reparsing it then takes, for each backend available here.
+// The texture is copied into a scratch directory and saved over repeatedly, half the
+// time in place and half the time as an editor's atomic save (write a temporary file,
+// rename it over the original).  The GPU upload that follows is not included.
+//
+// Built by the FileWatchBench target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: FileWatchBench [--file ../Textures/bricks.dds] [--saves N] [--settle ms]
+//                       [--out results.json]
+//***************************************************************************************
+
+#include "../Common/DDSTextureData.h"
+#include "../Common/FileWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct WatchResult
+	{
+		std::string Backend;
+		unsigned int Saves = 0;
+		unsigned int Missed = 0;
+		double MedianDetectMs = 0.0;
+		double MaxDetectMs = 0.0;
+		double MedianParseMs = 0.0;
+	};
+
+	double Milliseconds(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	double Median(std::vector<double> values)
+	{
+		if(values.empty())
+			return 0.0;
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	}
+
+	bool WriteFile(const fs::path& path, const std::vector<char>& bytes)
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(bytes.data(), (std::streamsize)bytes.size());
+		return (bool)out;
+	}
+
+	void WriteJson(FILE* out, const std::string& file, size_t fileBytes, int settleMs,
+		const std::vector<WatchResult>& results)
+	{
+		fprintf(out, "{\n  \"file\": \"%s\",\n  \"fileBytes\": %zu,\n  \"settleMs\": %d,\n  \"runs\": [\n",
+			file.c_str(), fileBytes, settleMs);
+		for(size_t i = 0; i < results.size(); ++i)
+		{
+			const WatchResult& r = results[i];
+			fprintf(out,
+				"    { \"backend\": \"%s\", \"saves\": %u, \"missed\": %u, \"medianDetectMs\": %.4g, "
+				"\"maxDetectMs\": %.4g, \"medianParseMs\": %.4g }%s\n",
+				r.Backend.c_str(), r.Saves, r.Missed, r.MedianDetectMs, r.MaxDetectMs, r.MedianParseMs,
+				i + 1 < results.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string file = "../Textures/bricks.dds";
+	const char* outPath = nullptr;
+	unsigned int saves = 20;
+	int settleMs = 50;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--file") == 0 && i + 1 < argc)
+			file = argv[++i];
+		else if(strcmp(argv[i], "--saves") == 0 && i + 1 < argc)
+			saves = (unsigned int)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--settle") == 0 && i + 1 < argc)
+			settleMs = std::max(0, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--file texture.dds] [--saves N] [--settle ms] "
+				"[--out file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<char> bytes;
+	{
+		std::ifstream in(file, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	if(bytes.empty())
+	{
+		fprintf(stderr, "cannot read %s\n", file.c_str());
+		return 1;
+	}
+
+	std::error_code ec;
+	const fs::path scratch = fs::temp_directory_path(ec) / "FileWatchBench";
+	const fs::path target = scratch / "texture.dds";
+	const fs::path temp = scratch / "texture.dds.tmp";
+
+	std::vector<WatchResult> results;
+	const FileWatchBackend backends[] = { FileWatchBackend::Native, FileWatchBackend::Polling };
+	for(FileWatchBackend backend : backends)
+	{
+		fs::remove_all(scratch, ec);
+		fs::create_directories(scratch, ec);
+		if(!WriteFile(target, bytes))
+		{
+			fprintf(stderr, "cannot write %s\n", target.string().c_str());
+			return 1;
+		}
+
+		std::unique_ptr<FileWatcher> watcher = CreateFileWatcher(scratch.wstring().c_str(), backend);
+		if(!watcher)
+		{
+			fprintf(stderr, "backend %s is not available\n",
+				backend == FileWatchBackend::Native ? "native" : "polling");
+			continue;
+		}
+		watcher->SetSettleTime(std::chrono::milliseconds(settleMs));
+
+		const std::wstring expected = FileWatcher::NormalizePath(target.wstring());
+
+		WatchResult res;
+		res.Backend = watcher->Name();
+		res.Saves = saves;
+
+		std::vector<double> detect;
+		std::vector<double> parse;
+		for(unsigned int s = 0; s < saves; ++s)
+		{
+			// Polling compares modification times, so keep saves apart.
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			watcher->Poll();
+
+			Clock::time_point saved = Clock::now();
+			if(s % 2 == 0)
+			{
+				WriteFile(target, bytes);
+			}
+			else
+			{
+				WriteFile(temp, bytes);
+				fs::rename(temp, target, ec);
+			}
+
+			// A frame loop would poll once a frame; poll far more often here so the
+			// loop's own granularity stays out of the numbers.
+			bool found = false;
+			Clock::time_point detected;
+			while(!found && Milliseconds(saved, Clock::now()) < 2000.0)
+			{
+				for(const std::wstring& changed : watcher->Poll())
+					found = found || changed == expected;
+				detected = Clock::now();
+				if(!found)
+					std::this_thread::sleep_for(std::chrono::microseconds(250));
+			}
+			if(!found)
+			{
+				++res.Missed;
+				continue;
+			}
+			detect.push_back(Milliseconds(saved, detected));
+
+			DDS_TEXTURE_DATA data;
+			Clock::time_point parseStart = Clock::now();
+			HRESULT hr = LoadDDSTextureDataFromFile(expected.c_str(), data);
+			if(SUCCEEDED(hr))
+				parse.push_back(Milliseconds(parseStart, Clock::now()));
+		}
+
+		res.MedianDetectMs = Median(detect);
+		res.MaxDetectMs = detect.empty() ? 0.0 : *std::max_element(detect.begin(), detect.end());
+		res.MedianParseMs = Median(parse);
+		results.push_back(res);
+
+		fprintf(stderr, "%-9s detect %8.2f ms (max %8.2f)  parse %7.3f ms  missed %u/%u\n",
+			res.Backend.c_str(), res.MedianDetectMs, res.MaxDetectMs, res.MedianParseMs, res.Missed, saves);
+	}
+
+	fs::remove_all(scratch, ec);
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	WriteJson(out, file, bytes.size(), settleMs, results);
+
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
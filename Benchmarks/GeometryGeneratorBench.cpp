@@ -0,0 +1,400 @@
+//***************************************************************************************
+// GeometryGeneratorBench.cpp
+//
+// Throughput benchmark for GeometryGenerator.  Runs every Create* function and
+// Subdivide across tessellation levels and reports vertices/sec, bytes allocated
+// per call and peak live heap bytes, then measures how the parallel paths
+// (independent meshes on a ThreadPool and CollisionProxy::BuildAll) scale with
+// thread count.  Results are written as JSON so runs can be diffed.
+//
+// Built by the GeometryGeneratorBench target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: GeometryGeneratorBench [--out results.json] [--min-time seconds] [--threads N]
+//***************************************************************************************
+
+#include "../Common/GeometryGenerator.h"
+#include "../Common/CollisionProxy.h"
+#include "../Common/ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+//
+// Heap accounting.  Every allocation in the process goes through these, so the
+// numbers include the std::vector growth inside the generator.
+//
+
+namespace
+{
+	std::atomic<std::uint64_t> gBytesAllocated(0);
+	std::atomic<std::uint64_t> gAllocationCount(0);
+	std::atomic<std::int64_t> gLiveBytes(0);
+	std::atomic<std::int64_t> gPeakLiveBytes(0);
+
+	// Allocations carry a small header with their size so delete can account for them.
+	const size_t kHeaderSize = alignof(std::max_align_t);
+
+	void* CountedAlloc(size_t size)
+	{
+		void* block = std::malloc(size + kHeaderSize);
+		if(block == nullptr)
+			return nullptr;
+
+		*static_cast<size_t*>(block) = size;
+
+		gBytesAllocated += size;
+		++gAllocationCount;
+		std::int64_t live = gLiveBytes += (std::int64_t)size;
+		std::int64_t peak = gPeakLiveBytes.load();
+		while(live > peak && !gPeakLiveBytes.compare_exchange_weak(peak, live))
+		{
+		}
+
+		return static_cast<std::uint8_t*>(block) + kHeaderSize;
+	}
+
+	void CountedFree(void* p)
+	{
+		if(p == nullptr)
+			return;
+
+		void* block = static_cast<std::uint8_t*>(p) - kHeaderSize;
+		gLiveBytes -= (std::int64_t)*static_cast<size_t*>(block);
+		std::free(block);
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* p = CountedAlloc(size);
+	if(p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(size);
+}
+
+void operator delete(void* p) noexcept { CountedFree(p); }
+void operator delete[](void* p) noexcept { CountedFree(p); }
+void operator delete(void* p, size_t) noexcept { CountedFree(p); }
+void operator delete[](void* p, size_t) noexcept { CountedFree(p); }
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using MeshData = GeometryGenerator::MeshData;
+
+	std::uint64_t PeakResidentBytes()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS pmc = {};
+		GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+		return pmc.PeakWorkingSetSize;
+#else
+		rusage usage = {};
+		getrusage(RUSAGE_SELF, &usage);
+		return (std::uint64_t)usage.ru_maxrss * 1024; // ru_maxrss is in KiB on Linux.
+#endif
+	}
+
+	struct GeneratorCase
+	{
+		std::string Name;
+		std::uint32_t Level;
+		std::function<MeshData()> Run;
+	};
+
+	struct CaseResult
+	{
+		std::string Name;
+		std::uint32_t Level = 0;
+		std::uint64_t Iterations = 0;
+		double SecondsPerCall = 0.0;
+		std::uint64_t Vertices = 0;
+		std::uint64_t Indices = 0;
+		double VerticesPerSecond = 0.0;
+		std::uint64_t BytesAllocatedPerCall = 0;
+		std::uint64_t AllocationsPerCall = 0;
+		std::uint64_t PeakLiveBytes = 0;
+	};
+
+	struct ScalingResult
+	{
+		std::string Name;
+		unsigned int Threads = 0;
+		double Seconds = 0.0;
+		double Speedup = 0.0;
+	};
+
+	double Seconds(Clock::time_point a, Clock::time_point b)
+	{
+		return std::chrono::duration<double>(b - a).count();
+	}
+
+	CaseResult RunCase(const GeneratorCase& c, double minTime)
+	{
+		CaseResult r;
+		r.Name = c.Name;
+		r.Level = c.Level;
+
+		// One untimed call to warm caches and record the per-call heap profile.
+		std::uint64_t bytesBefore = gBytesAllocated;
+		std::uint64_t allocsBefore = gAllocationCount;
+		gPeakLiveBytes = gLiveBytes.load();
+		std::int64_t liveBefore = gLiveBytes;
+		{
+			MeshData mesh = c.Run();
+			r.Vertices = mesh.Vertices.size();
+			r.Indices = mesh.Indices32.size();
+		}
+		r.BytesAllocatedPerCall = gBytesAllocated - bytesBefore;
+		r.AllocationsPerCall = gAllocationCount - allocsBefore;
+		r.PeakLiveBytes = (std::uint64_t)(gPeakLiveBytes - liveBefore);
+
+		std::uint64_t iterations = 0;
+		Clock::time_point start = Clock::now();
+		double elapsed = 0.0;
+		do
+		{
+			MeshData mesh = c.Run();
+			++iterations;
+			elapsed = Seconds(start, Clock::now());
+		} while(elapsed < minTime);
+
+		r.Iterations = iterations;
+		r.SecondsPerCall = elapsed / iterations;
+		r.VerticesPerSecond = r.Vertices / r.SecondsPerCall;
+
+		return r;
+	}
+
+	std::vector<GeneratorCase> MakeCases()
+	{
+		std::vector<GeneratorCase> cases;
+		const std::uint32_t levels[] = { 8, 32, 128, 512 };
+		const std::uint32_t subdivisions[] = { 0, 2, 4, 6 };
+
+		for(std::uint32_t n : levels)
+		{
+			cases.push_back({ "CreateSphere", n, [n]() { GeometryGenerator g; return g.CreateSphere(1.0f, n, n); } });
+			cases.push_back({ "CreateCylinder", n, [n]() { GeometryGenerator g; return g.CreateCylinder(1.0f, 0.5f, 3.0f, n, n); } });
+			cases.push_back({ "CreateCone", n, [n]() { GeometryGenerator g; return g.CreateCone(1.0f, 0.0f, 1.0f, 2.0f, n, n); } });
+			cases.push_back({ "CreateTorus", n, [n]() { GeometryGenerator g; return g.CreateTorus(0.3f, 1.0f, n, n); } });
+			cases.push_back({ "CreateGrid", n, [n]() { GeometryGenerator g; return g.CreateGrid(10.0f, 10.0f, n, n); } });
+		}
+
+		for(std::uint32_t n : subdivisions)
+		{
+			cases.push_back({ "CreateGeosphere", n, [n]() { GeometryGenerator g; return g.CreateGeosphere(1.0f, n); } });
+			cases.push_back({ "CreateBox", n, [n]() { GeometryGenerator g; return g.CreateBox(1.0f, 1.0f, 1.0f, n, 1.0f, 1.0f, 1.0f); } });
+			cases.push_back({ "CreateWedge", n, [n]() { GeometryGenerator g; return g.CreateWedge(1.0f, 1.0f, 1.0f, n); } });
+			cases.push_back({ "CreateTriPrism", n, [n]() { GeometryGenerator g; return g.CreateTriPrism(1.0f, 1.0f, 1.0f, n); } });
+			cases.push_back({ "CreatePyramid", n, [n]() { GeometryGenerator g; return g.CreatePyramid(1.0f, 1.0f, 1.0f, n); } });
+			cases.push_back({ "CreateDiamond", n, [n]() { GeometryGenerator g; return g.CreateDiamond(1.0f, 1.0f, 1.0f, n); } });
+
+			// Subdivide on its own, starting from a 12-triangle box.
+			cases.push_back({ "Subdivide", n, [n]()
+			{
+				GeometryGenerator g;
+				MeshData mesh = g.CreateBox(1.0f, 1.0f, 1.0f, 0, 1.0f, 1.0f, 1.0f);
+				for(std::uint32_t i = 0; i < n; ++i)
+					g.Subdivide(mesh);
+				return mesh;
+			} });
+		}
+
+		cases.push_back({ "CreateQuad", 0, []() { GeometryGenerator g; return g.CreateQuad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f); } });
+
+		const float errors[] = { 2.0f, 0.5f, 0.1f };
+		for(float e : errors)
+		{
+			GeometryGenerator::AdaptiveTessellation tess;
+			tess.MaxChordError = e;
+			std::uint32_t level = (std::uint32_t)(1.0f / e);
+
+			cases.push_back({ "CreateSphereAdaptive", level, [tess]() { GeometryGenerator g; return g.CreateSphere(1.0f, tess); } });
+			cases.push_back({ "CreateCylinderAdaptive", level, [tess]() { GeometryGenerator g; return g.CreateCylinder(1.0f, 0.5f, 3.0f, tess); } });
+			cases.push_back({ "CreateConeAdaptive", level, [tess]() { GeometryGenerator g; return g.CreateCone(1.0f, 0.0f, 1.0f, 2.0f, tess); } });
+			cases.push_back({ "CreateTorusAdaptive", level, [tess]() { GeometryGenerator g; return g.CreateTorus(0.3f, 1.0f, tess); } });
+		}
+
+		return cases;
+	}
+
+	// Times fn on 1..maxThreads threads.  fn gets a null pool for the serial
+	// baseline and must then do the work on the calling thread.
+	void RunScaling(const std::string& name, unsigned int maxThreads,
+		const std::function<void(ThreadPool*)>& fn, std::vector<ScalingResult>& results)
+	{
+		// Powers of two, plus maxThreads itself.
+		std::vector<unsigned int> counts;
+		for(unsigned int threads = 1; threads < maxThreads; threads *= 2)
+			counts.push_back(threads);
+		counts.push_back(maxThreads);
+
+		double baseline = 0.0;
+		for(unsigned int threads : counts)
+		{
+			std::unique_ptr<ThreadPool> pool;
+			if(threads > 1)
+				pool.reset(new ThreadPool(threads - 1));
+
+			fn(pool.get());
+			Clock::time_point start = Clock::now();
+			fn(pool.get());
+			double s = Seconds(start, Clock::now());
+
+			if(threads == 1)
+				baseline = s;
+
+			ScalingResult r;
+			r.Name = name;
+			r.Threads = threads;
+			r.Seconds = s;
+			r.Speedup = s > 0.0 ? baseline / s : 0.0;
+			results.push_back(r);
+		}
+	}
+
+	void WriteJson(FILE* out, const std::vector<CaseResult>& cases, const std::vector<ScalingResult>& scaling)
+	{
+		fprintf(out, "{\n  \"peakResidentBytes\": %llu,\n  \"cases\": [\n", (unsigned long long)PeakResidentBytes());
+		for(size_t i = 0; i < cases.size(); ++i)
+		{
+			const CaseResult& r = cases[i];
+			fprintf(out,
+				"    { \"name\": \"%s\", \"level\": %u, \"iterations\": %llu, \"secondsPerCall\": %.9g, "
+				"\"vertices\": %llu, \"indices\": %llu, \"verticesPerSecond\": %.6g, "
+				"\"bytesAllocatedPerCall\": %llu, \"allocationsPerCall\": %llu, \"peakLiveBytes\": %llu }%s\n",
+				r.Name.c_str(), r.Level, (unsigned long long)r.Iterations, r.SecondsPerCall,
+				(unsigned long long)r.Vertices, (unsigned long long)r.Indices, r.VerticesPerSecond,
+				(unsigned long long)r.BytesAllocatedPerCall, (unsigned long long)r.AllocationsPerCall,
+				(unsigned long long)r.PeakLiveBytes, i + 1 < cases.size() ? "," : "");
+		}
+		fprintf(out, "  ],\n  \"scaling\": [\n");
+		for(size_t i = 0; i < scaling.size(); ++i)
+		{
+			const ScalingResult& r = scaling[i];
+			fprintf(out, "    { \"name\": \"%s\", \"threads\": %u, \"seconds\": %.9g, \"speedup\": %.4g }%s\n",
+				r.Name.c_str(), r.Threads, r.Seconds, r.Speedup, i + 1 < scaling.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* outPath = nullptr;
+	double minTime = 0.25;
+	unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else if(strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+			minTime = atof(argv[++i]);
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			maxThreads = std::max(1, atoi(argv[++i]));
+		else
+		{
+			fprintf(stderr, "usage: %s [--out file.json] [--min-time seconds] [--threads N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<CaseResult> results;
+	for(const GeneratorCase& c : MakeCases())
+	{
+		results.push_back(RunCase(c, minTime));
+		fprintf(stderr, "%-24s %4u  %12.0f verts/s\n", c.Name.c_str(), c.Level, results.back().VerticesPerSecond);
+	}
+
+	//
+	// Parallel scaling: a scene of independent meshes, then the proxies for it.
+	//
+
+	const size_t sceneSize = 64;
+	std::vector<MeshData> scene(sceneSize);
+	std::vector<ScalingResult> scaling;
+
+	auto generate = [&](size_t i)
+	{
+		GeometryGenerator g;
+		scene[i] = (i % 2) ? g.CreateSphere(1.0f, 96, 96) : g.CreateGeosphere(1.0f, 4);
+	};
+
+	RunScaling("GenerateScene", maxThreads, [&](ThreadPool* pool)
+	{
+		if(pool != nullptr)
+			pool->ParallelFor(sceneSize, generate);
+		else
+		{
+			for(size_t i = 0; i < sceneSize; ++i)
+				generate(i);
+		}
+	}, scaling);
+
+	std::vector<const MeshData*> scenePtrs;
+	for(const MeshData& m : scene)
+		scenePtrs.push_back(&m);
+
+	RunScaling("CollisionProxy::BuildAll", maxThreads, [&](ThreadPool* pool)
+	{
+		if(pool != nullptr)
+			CollisionProxy::BuildAll(*pool, scenePtrs);
+		else
+		{
+			for(const MeshData* m : scenePtrs)
+				CollisionProxy::Build(*m);
+		}
+	}, scaling);
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	WriteJson(out, results, scaling);
+
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
@@ -0,0 +1,287 @@
+//***************************************************************************************
+// HeapAllocatorBench.cpp
+//
+// Exercises the two allocators behind placed buffers and per-frame upload data,
+// without a device:
+//
+//   heap  HeapSubAllocator churning through mesh-sized buffers (4 KiB to 4 MiB,
+//         spread evenly in log2 size) in one default heap kept about 70% full, with
+//         the 64 KiB placement alignment of D3D12 buffers.  Reports the time per
+//         allocation and free, how fragmented the free space got and how often a
+//         buffer did not fit although enough bytes were free.
+//   ring  FrameRingAllocator fed a frame's constants, dynamic vertices and staging
+//         copies, with the GPU finishing each frame gNumFrameResources (3) frames
+//         later.  Reports the allocation rate and the peak use of the ring.
+//
+// With --validate the heap's lists and blocks are checked after every operation and
+// the run fails on the first inconsistency.
+//
+// Built by the HeapAllocatorBench target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: HeapAllocatorBench [--heap MB] [--ops N] [--frames N] [--seed N] [--validate]
+//                           [--out results.json]
+//***************************************************************************************
+
+#include "../Common/FrameRingAllocator.h"
+#include "../Common/HeapSubAllocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	const int FramesInFlight = 3;
+	const std::uint64_t BufferAlignment = 65536;     // D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT
+	const std::uint64_t ConstantAlignment = 256;     // D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT
+	const std::uint64_t StagingAlignment = 512;      // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+
+	struct HeapResult
+	{
+		std::uint64_t Ops = 0;
+		std::uint64_t Allocations = 0;
+		std::uint64_t Frees = 0;
+		std::uint64_t Failures = 0;             // no room at all
+		std::uint64_t FragmentedFailures = 0;   // enough free bytes, no block large enough
+		double AllocateNs = 0.0;
+		double FreeNs = 0.0;
+		double MeanFragmentation = 0.0;
+		double PeakFragmentation = 0.0;
+		HeapSubAllocator::Stats Final;
+	};
+
+	struct RingResult
+	{
+		std::uint64_t Frames = 0;
+		std::uint64_t Capacity = 0;
+		double AllocateNs = 0.0;
+		FrameRingAllocator::Stats Stats;
+	};
+
+	double Nanoseconds(Clock::duration d)
+	{
+		return std::chrono::duration<double, std::nano>(d).count();
+	}
+
+	bool RunHeap(std::uint64_t heapBytes, std::uint64_t ops, unsigned int seed, bool validate, HeapResult& res)
+	{
+		HeapSubAllocator heap(heapBytes, BufferAlignment);
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<double> log2Size(12.0, 22.0);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+		std::vector<HeapSubAllocator::Allocation> live;
+		Clock::duration allocTime{};
+		Clock::duration freeTime{};
+		double fragmentationSum = 0.0;
+
+		for(std::uint64_t op = 0; op < ops; ++op)
+		{
+			// Allocate more often below the target fill, free more often above it.
+			double fill = (double)heap.UsedBytes() / (double)heap.Capacity();
+			bool allocate = live.empty() || unit(rng) < (fill < 0.7 ? 0.75 : 0.25);
+
+			if(allocate)
+			{
+				std::uint64_t size = (std::uint64_t)std::exp2(log2Size(rng));
+				HeapSubAllocator::Allocation a;
+
+				Clock::time_point start = Clock::now();
+				bool ok = heap.Allocate(size, BufferAlignment, &a);
+				allocTime += Clock::now() - start;
+				++res.Allocations;
+
+				if(ok)
+				{
+					if(a.Offset % BufferAlignment != 0 || a.Size < size || a.Offset + a.Size > heap.Capacity())
+					{
+						fprintf(stderr, "op %llu: bad allocation\n", (unsigned long long)op);
+						return false;
+					}
+					live.push_back(a);
+				}
+				else
+				{
+					++res.Failures;
+					HeapSubAllocator::Stats s = heap.GetStats();
+					if(s.FreeBytes >= size)
+						++res.FragmentedFailures;
+				}
+			}
+			else
+			{
+				size_t i = std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+
+				Clock::time_point start = Clock::now();
+				heap.Free(live[i]);
+				freeTime += Clock::now() - start;
+				++res.Frees;
+
+				live[i] = live.back();
+				live.pop_back();
+			}
+
+			if(validate && !heap.Validate())
+			{
+				fprintf(stderr, "op %llu: heap failed validation\n", (unsigned long long)op);
+				return false;
+			}
+
+			double f = heap.GetStats().Fragmentation();
+			fragmentationSum += f;
+			res.PeakFragmentation = std::max(res.PeakFragmentation, f);
+		}
+
+		res.Ops = ops;
+		res.AllocateNs = res.Allocations != 0 ? Nanoseconds(allocTime) / res.Allocations : 0.0;
+		res.FreeNs = res.Frees != 0 ? Nanoseconds(freeTime) / res.Frees : 0.0;
+		res.MeanFragmentation = ops != 0 ? fragmentationSum / ops : 0.0;
+		res.Final = heap.GetStats();
+
+		// Giving everything back has to leave one free block.
+		for(const HeapSubAllocator::Allocation& a : live)
+			heap.Free(a);
+		HeapSubAllocator::Stats empty = heap.GetStats();
+		if(empty.FreeBlocks != 1 || empty.LargestFreeBlock != heap.Capacity() || !heap.Validate())
+		{
+			fprintf(stderr, "free space did not coalesce\n");
+			return false;
+		}
+		return true;
+	}
+
+	bool RunRing(std::uint64_t frames, unsigned int seed, RingResult& res)
+	{
+		// A frame's worth: object and pass constants, a particle vertex stream and an
+		// occasional texture region staged for a copy.
+		const std::uint64_t bytesPerFrame = 4 * 1024 * 1024;
+		FrameRingAllocator ring(bytesPerFrame * FramesInFlight);
+
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<int> objects(200, 1000);
+		std::uniform_int_distribution<std::uint64_t> constants(64, 512);
+		std::uniform_int_distribution<std::uint64_t> vertices(16 * 1024, 512 * 1024);
+		std::uniform_int_distribution<int> staging(0, 7);
+
+		Clock::duration allocTime{};
+		std::uint64_t offset;
+		for(std::uint64_t frame = 1; frame <= frames; ++frame)
+		{
+			// The frame resource about to be reused: its frame has finished.
+			if(frame > (std::uint64_t)FramesInFlight)
+				ring.Reclaim(frame - FramesInFlight);
+
+			Clock::time_point start = Clock::now();
+			int count = objects(rng);
+			for(int i = 0; i < count; ++i)
+				ring.Allocate(constants(rng), ConstantAlignment, &offset);
+			ring.Allocate(vertices(rng), ConstantAlignment, &offset);
+			if(staging(rng) == 0)
+				ring.Allocate(256 * 1024, StagingAlignment, &offset);
+			allocTime += Clock::now() - start;
+
+			ring.FinishFrame(frame);
+		}
+
+		res.Frames = frames;
+		res.Capacity = ring.Capacity();
+		res.Stats = ring.GetStats();
+		res.AllocateNs = res.Stats.Allocations != 0 ? Nanoseconds(allocTime) / res.Stats.Allocations : 0.0;
+		return true;
+	}
+
+	void WriteJson(FILE* out, std::uint64_t heapBytes, const HeapResult& h, const RingResult& r)
+	{
+		fprintf(out,
+			"{\n  \"heap\": { \"bytes\": %llu, \"ops\": %llu, \"allocations\": %llu, \"frees\": %llu, "
+			"\"failures\": %llu, \"fragmentedFailures\": %llu, \"allocateNs\": %.4g, \"freeNs\": %.4g, "
+			"\"meanFragmentation\": %.4f, \"peakFragmentation\": %.4f, \"finalUsedBytes\": %llu, "
+			"\"finalFreeBlocks\": %u, \"finalFragmentation\": %.4f },\n",
+			(unsigned long long)heapBytes, (unsigned long long)h.Ops, (unsigned long long)h.Allocations,
+			(unsigned long long)h.Frees, (unsigned long long)h.Failures, (unsigned long long)h.FragmentedFailures,
+			h.AllocateNs, h.FreeNs, h.MeanFragmentation, h.PeakFragmentation,
+			(unsigned long long)h.Final.UsedBytes, h.Final.FreeBlocks, h.Final.Fragmentation());
+		fprintf(out,
+			"  \"ring\": { \"frames\": %llu, \"capacity\": %llu, \"allocations\": %llu, \"allocateNs\": %.4g, "
+			"\"peakUsedBytes\": %llu, \"peakFrameBytes\": %llu, \"wastedBytes\": %llu, \"failures\": %llu }\n}\n",
+			(unsigned long long)r.Frames, (unsigned long long)r.Capacity,
+			(unsigned long long)r.Stats.Allocations, r.AllocateNs, (unsigned long long)r.Stats.PeakUsedBytes,
+			(unsigned long long)r.Stats.PeakFrameBytes, (unsigned long long)r.Stats.WastedBytes,
+			(unsigned long long)r.Stats.Failures);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::uint64_t heapMB = 256;
+	std::uint64_t ops = 1000000;
+	std::uint64_t frames = 10000;
+	unsigned int seed = 1;
+	bool validate = false;
+	const char* outPath = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--heap") == 0 && i + 1 < argc)
+			heapMB = (std::uint64_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--ops") == 0 && i + 1 < argc)
+			ops = (std::uint64_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = (std::uint64_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = (unsigned int)atoi(argv[++i]);
+		else if(strcmp(argv[i], "--validate") == 0)
+			validate = true;
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--heap MB] [--ops N] [--frames N] [--seed N] [--validate] "
+				"[--out file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const std::uint64_t heapBytes = heapMB * 1024 * 1024;
+
+	HeapResult heap;
+	if(!RunHeap(heapBytes, ops, seed, validate, heap))
+		return 1;
+	fprintf(stderr, "heap  alloc %6.1f ns  free %6.1f ns  fragmentation mean %.3f peak %.3f  "
+		"failed %llu/%llu (%llu with enough free bytes)\n",
+		heap.AllocateNs, heap.FreeNs, heap.MeanFragmentation, heap.PeakFragmentation,
+		(unsigned long long)heap.Failures, (unsigned long long)heap.Allocations,
+		(unsigned long long)heap.FragmentedFailures);
+
+	RingResult ring;
+	RunRing(frames, seed, ring);
+	fprintf(stderr, "ring  alloc %6.1f ns  peak %.2f of %.2f MB  wasted %.1f%%  failed %llu\n",
+		ring.AllocateNs, ring.Stats.PeakUsedBytes / 1048576.0, ring.Capacity / 1048576.0,
+		100.0 * ring.Stats.WastedBytes / std::max<std::uint64_t>(1, ring.Stats.AllocatedBytes + ring.Stats.WastedBytes),
+		(unsigned long long)ring.Stats.Failures);
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	WriteJson(out, heapBytes, heap, ring);
+
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
@@ -0,0 +1,195 @@
+//***************************************************************************************
+// MipGenBench.cpp
+//
+// Measures MipGenerator on a synthetic size x size surface (repeated over --slices
+// array slices) for each filter, linear and sRGB, on one thread and on a ThreadPool.
+// Throughput counts the texels of the top level.  Build it once more with
+// -DMIP_GENERATOR_NO_SIMD to compare against the scalar path.
+//
+// Built by the MipGenBench target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: MipGenBench [--size N] [--slices N] [--threads N] [--repeat N] [--out results.json]
+//***************************************************************************************
+
+#include "../Common/MipGenerator.h"
+#include "../Common/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct MipResult
+	{
+		std::string Name;
+		unsigned int Threads = 1;
+		std::uint64_t Texels = 0;
+		double Seconds = 0.0;
+		double MegatexelsPerSecond = 0.0;
+	};
+
+	// Keeps the best of repeat timed runs of generate(), after one warm-up.
+	template<typename F>
+	double BestOf(int repeat, F generate)
+	{
+		generate();
+		double best = 0.0;
+		for(int r = 0; r < repeat; ++r)
+		{
+			Clock::time_point start = Clock::now();
+			generate();
+			double s = std::chrono::duration<double>(Clock::now() - start).count();
+			if(r == 0 || s < best)
+				best = s;
+		}
+		return best;
+	}
+
+	void Finish(MipResult& res, double seconds)
+	{
+		res.Seconds = seconds;
+		res.MegatexelsPerSecond = seconds > 0.0 ? res.Texels / 1.0e6 / seconds : 0.0;
+		fprintf(stderr, "%-20s %2u threads %10.3f ms  %9.1f Mtexel/s\n",
+			res.Name.c_str(), res.Threads, seconds*1000.0, res.MegatexelsPerSecond);
+	}
+
+	void WriteJson(FILE* out, bool simd, const std::vector<MipResult>& results)
+	{
+		fprintf(out, "{\n  \"simd\": %s,\n  \"runs\": [\n", simd ? "true" : "false");
+		for(size_t i = 0; i < results.size(); ++i)
+		{
+			const MipResult& r = results[i];
+			fprintf(out,
+				"    { \"name\": \"%s\", \"threads\": %u, \"texels\": %llu, \"seconds\": %.9g, "
+				"\"megatexelsPerSecond\": %.6g }%s\n",
+				r.Name.c_str(), r.Threads, (unsigned long long)r.Texels, r.Seconds, r.MegatexelsPerSecond,
+				i + 1 < results.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* outPath = nullptr;
+	std::uint32_t size = 2048;
+	std::uint32_t slices = 1;
+	unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+	int repeat = 3;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			size = (std::uint32_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--slices") == 0 && i + 1 < argc)
+			slices = (std::uint32_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = (unsigned int)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--size N] [--slices N] [--threads N] [--repeat N] [--out file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+#if defined(MIP_GENERATOR_NO_SIMD)
+	const bool simd = false;
+#else
+	const bool simd = true;
+#endif
+
+	// Smooth gradients with noise on top, so no filter sees a flat surface.
+	std::mt19937 rng(1);
+	MipImage top;
+	top.Width = size;
+	top.Height = size;
+	top.Pixels.resize((size_t)size*size*4);
+	for(std::uint32_t y = 0; y < size; ++y)
+	{
+		for(std::uint32_t x = 0; x < size; ++x)
+		{
+			std::uint8_t* p = top.Pixels.data() + ((size_t)y*size + x)*4;
+			p[0] = (std::uint8_t)(x*255 / size);
+			p[1] = (std::uint8_t)(y*255 / size);
+			p[2] = (std::uint8_t)rng();
+			p[3] = 255;
+		}
+	}
+
+	struct Filter
+	{
+		const char* Name;
+		MipFilter Filter;
+	};
+	const Filter filters[] =
+	{
+		{ "box", MipFilter::Box },
+		{ "kaiser", MipFilter::Kaiser },
+		{ "lanczos", MipFilter::Lanczos },
+	};
+
+	ThreadPool pool(std::max(1u, threads - 1));
+
+	std::vector<unsigned int> threadCounts = { 1 };
+	if(threads > 1)
+		threadCounts.push_back(threads);
+
+	std::vector<MipResult> results;
+	for(const Filter& f : filters)
+	{
+		for(int srgb = 0; srgb < 2; ++srgb)
+		{
+			for(unsigned int t : threadCounts)
+			{
+				MipOptions options;
+				options.Filter = f.Filter;
+				options.SRGB = srgb != 0;
+
+				MipResult res;
+				res.Name = std::string(f.Name) + (srgb ? " srgb" : "");
+				res.Threads = t;
+				res.Texels = (std::uint64_t)size*size*slices;
+				// Only the top levels survive between runs, so the copy is not timed.
+				std::vector<std::vector<MipImage>> chains(slices, std::vector<MipImage>(1, top));
+				Finish(res, BestOf(repeat, [&]()
+				{
+					for(std::vector<MipImage>& chain : chains)
+						chain.resize(1);
+					GenerateMips(chains, options, t > 1 ? &pool : nullptr);
+				}));
+				results.push_back(res);
+			}
+		}
+	}
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	WriteJson(out, simd, results);
+
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
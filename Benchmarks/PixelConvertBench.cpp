@@ -0,0 +1,241 @@
+//***************************************************************************************
+// PixelConvertBench.cpp
+//
+// Throughput of each PixelConvert kernel over a buffer larger than the caches, in
+// megapixels and gigabytes (read plus written) per second.  The kernels run on the
+// path PixelConvertPath() reports; build this file and PixelConvert.cpp once more
+// with -DPIXEL_CONVERT_NO_SIMD for the scalar baseline, or with -mavx2 / -mssse3 for
+// the wider paths.  ConvertDDSTextureData is timed too, converting a BGRA8 texture
+// with a full mip chain on a ThreadPool.
+//
+// Built by the PixelConvertBench target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: PixelConvertBench [--pixels N] [--repeat N] [--threads N] [--out results.json]
+//***************************************************************************************
+
+#include "../Common/PixelConvert.h"
+#include "../Common/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Kernel
+	{
+		const char* Name;
+		PixelRowFunction Function;
+		std::size_t SrcBytes;
+		std::size_t DstBytes;
+	};
+
+	struct KernelResult
+	{
+		std::string Name;
+		double Seconds = 0.0;
+		double MegapixelsPerSecond = 0.0;
+		double GigabytesPerSecond = 0.0;
+	};
+
+	double Seconds(Clock::time_point a, Clock::time_point b)
+	{
+		return std::chrono::duration<double>(b - a).count();
+	}
+
+	// Repeatable noise, so every run and every build converts the same pixels.
+	void FillNoise(std::vector<std::uint8_t>& bytes)
+	{
+		std::uint32_t state = 0x9E3779B9u;
+		for(std::uint8_t& b : bytes)
+		{
+			state = state*1664525u + 1013904223u;
+			b = (std::uint8_t)(state >> 24);
+		}
+	}
+
+	void WriteJson(FILE* out, std::size_t pixels, unsigned int threads, const std::vector<KernelResult>& results)
+	{
+		fprintf(out, "{\n  \"path\": \"%s\",\n  \"pixels\": %zu,\n  \"threads\": %u,\n  \"kernels\": [\n",
+			PixelConvertPath(), pixels, threads);
+		for(std::size_t i = 0; i < results.size(); ++i)
+		{
+			const KernelResult& r = results[i];
+			fprintf(out,
+				"    { \"name\": \"%s\", \"seconds\": %.9g, \"megapixelsPerSecond\": %.6g, "
+				"\"gigabytesPerSecond\": %.6g }%s\n",
+				r.Name.c_str(), r.Seconds, r.MegapixelsPerSecond, r.GigabytesPerSecond,
+				i + 1 < results.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::size_t pixels = 16u << 20;
+	int repeat = 5;
+	unsigned int threads = 0;
+	const char* outPath = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--pixels") == 0 && i + 1 < argc)
+			pixels = (std::size_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = (unsigned int)std::max(0, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--pixels N] [--repeat N] [--threads N] [--out file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const Kernel kernels[] =
+	{
+		{ "SwizzleRGBA8",            SwizzleRGBA8,            4, 4 },
+		{ "BGRX8ToRGBA8",            BGRX8ToRGBA8,            4, 4 },
+		{ "BGR8ToRGBA8",             BGR8ToRGBA8,             3, 4 },
+		{ "B5G6R5ToRGBA8",           B5G6R5ToRGBA8,           2, 4 },
+		{ "B5G5R5A1ToRGBA8",         B5G5R5A1ToRGBA8,         2, 4 },
+		{ "B4G4R4A4ToRGBA8",         B4G4R4A4ToRGBA8,         2, 4 },
+		{ "PremultiplyRGBA8",        PremultiplyRGBA8,        4, 4 },
+		{ "PremultiplySRGBA8",       PremultiplySRGBA8,       4, 4 },
+		{ "SRGBToLinearRGBA8",       SRGBToLinearRGBA8,       4, 16 },
+		{ "LinearToSRGBRGBA8",       LinearToSRGBRGBA8,       16, 4 },
+		{ "ReconstructNormalZRGBA8", ReconstructNormalZRGBA8, 4, 4 },
+	};
+
+	std::vector<std::uint8_t> src(pixels*16);
+	std::vector<std::uint8_t> dst(pixels*16);
+	FillNoise(src);
+
+	// The float input of LinearToSRGBRGBA8 is made from the noise, slightly out of
+	// range at both ends so the clamp is exercised.
+	std::vector<float> linear(pixels*4);
+	for(std::size_t i = 0; i < linear.size(); ++i)
+		linear[i] = src[i] / 250.0f - 0.01f;
+
+	ThreadPool pool(threads);
+	fprintf(stderr, "path %s, %zu pixels, %u threads\n", PixelConvertPath(), pixels, pool.ThreadCount());
+
+	std::vector<KernelResult> results;
+	auto report = [&](const char* name, double seconds, std::size_t count, std::size_t bytes)
+	{
+		KernelResult res;
+		res.Name = name;
+		res.Seconds = seconds;
+		res.MegapixelsPerSecond = seconds > 0.0 ? count / 1.0e6 / seconds : 0.0;
+		res.GigabytesPerSecond = seconds > 0.0 ? bytes / 1.0e9 / seconds : 0.0;
+		results.push_back(res);
+
+		fprintf(stderr, "%-26s %8.3f ms  %9.1f MP/s  %6.2f GB/s\n",
+			name, seconds*1000.0, res.MegapixelsPerSecond, res.GigabytesPerSecond);
+	};
+
+	for(const Kernel& kernel : kernels)
+	{
+		const void* in = kernel.Function == LinearToSRGBRGBA8 ?
+			static_cast<const void*>(linear.data()) : static_cast<const void*>(src.data());
+
+		// One untimed pass to touch the pages and build the colour tables.
+		kernel.Function(in, dst.data(), pixels);
+
+		double best = 0.0;
+		for(int r = 0; r < repeat; ++r)
+		{
+			Clock::time_point start = Clock::now();
+			kernel.Function(in, dst.data(), pixels);
+			double s = Seconds(start, Clock::now());
+			if(r == 0 || s < best)
+				best = s;
+		}
+		report(kernel.Name, best, pixels, pixels*(kernel.SrcBytes + kernel.DstBytes));
+	}
+
+	// A whole texture: square BGRA8 with every mip, converted and premultiplied.
+	{
+		std::uint32_t size = 1;
+		while((std::size_t)size*size*2 <= pixels)
+			size *= 2;
+
+		DDS_TEXTURE_INFO info = {};
+		info.width = size;
+		info.height = size;
+		info.depth = 1;
+		info.arraySize = 1;
+		info.format = DXGI_FORMAT_B8G8R8A8_UNORM;
+		info.dimension = DDS_DIMENSION_TEXTURE2D;
+		info.alphaMode = DDS_ALPHA_MODE_STRAIGHT;
+		while((size >> info.mipCount) > 0)
+			++info.mipCount;
+
+		std::vector<DDS_SUBRESOURCE> subresources;
+		std::size_t offset = 0;
+		for(std::uint32_t mip = 0; mip < info.mipCount; ++mip)
+		{
+			std::size_t w = std::max<std::size_t>(1, size >> mip);
+			subresources.push_back({ src.data() + offset, (intptr_t)(w*4), (intptr_t)(w*w*4) });
+			offset += w*w*4;
+		}
+		info.dataSize = offset;
+
+		PixelConvertOptions options;
+		options.PremultiplyAlpha = true;
+
+		// The first pass warms up and is not counted.
+		double best = 0.0;
+		for(int r = 0; r <= repeat; ++r)
+		{
+			DDS_TEXTURE_DATA data;
+			data.info = info;
+			data.subresources = subresources;
+
+			Clock::time_point start = Clock::now();
+			HRESULT hr = ConvertDDSTextureData(data, options, &pool);
+			double s = Seconds(start, Clock::now());
+			if(FAILED(hr))
+			{
+				fprintf(stderr, "ConvertDDSTextureData failed: 0x%08X\n", (unsigned int)hr);
+				return 1;
+			}
+
+			if(r == 1 || (r > 1 && s < best))
+				best = s;
+		}
+
+		// Counted per texel of the whole chain.
+		report("ConvertDDSTextureData", best, offset / 4, offset*2);
+	}
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	WriteJson(out, pixels, pool.ThreadCount(), results);
+
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
@@ -0,0 +1,247 @@
+//***************************************************************************************
+// ResidencySim.cpp
+//
+// Replays a texture access trace through ResidencyPolicy without a GPU and reports
+// what the budget cost: loads, reloads, reductions, evictions and bytes streamed.
+// The textures are the .dds files of a directory (by default Textures/), of which
+// only the headers are read.
+//
+// The trace is either a text file of "frame texture mip" lines (texture indexes the
+// sorted file list) or, by default, a synthetic walk: the textures are laid out on a
+// line, the camera drifts back and forth along it, and each frame draws the textures
+// within a view radius with a desired mip that grows with distance.
+//
+// Every Load is checked against the mips touched that frame: loading finer than any
+// draw asked for (say, a first touch in frame 0 planned at full resolution) is
+// counted and fails the run.
+//
+// Built by the ResidencySim target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: ResidencySim [--dir Textures] [--budget MB] [--frames N] [--seed N]
+//                     [--trace file.txt] [--out results.json]
+//***************************************************************************************
+
+#include "../Common/ResidencyPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	struct Access
+	{
+		std::uint64_t Frame;
+		std::uint32_t Texture;
+		std::uint32_t Mip;
+	};
+
+	bool ReadTrace(const char* path, std::uint32_t textureCount, std::vector<Access>& trace)
+	{
+		FILE* in = fopen(path, "r");
+		if(in == nullptr)
+			return false;
+
+		unsigned long long frame = 0;
+		unsigned int texture = 0;
+		unsigned int mip = 0;
+		while(fscanf(in, "%llu %u %u", &frame, &texture, &mip) == 3)
+		{
+			if(texture < textureCount)
+				trace.push_back({ frame, texture, mip });
+		}
+
+		fclose(in);
+		std::stable_sort(trace.begin(), trace.end(),
+			[](const Access& a, const Access& b) { return a.Frame < b.Frame; });
+		return true;
+	}
+
+	void MakeWalk(std::uint32_t textureCount, std::uint64_t frames, unsigned int seed, std::vector<Access>& trace)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> step(-0.25f, 0.35f);
+
+		const float radius = std::max(2.0f, textureCount / 6.0f);
+		float camera = 0.0f;
+		for(std::uint64_t frame = 0; frame < frames; ++frame)
+		{
+			camera += step(rng);
+			if(camera < 0.0f || camera > (float)textureCount)
+				camera = std::fmod(camera + textureCount, (float)textureCount);
+
+			for(std::uint32_t t = 0; t < textureCount; ++t)
+			{
+				float distance = std::fabs((float)t - camera);
+				if(distance > radius)
+					continue;
+
+				// One mip coarser per doubling of distance beyond one unit.
+				std::uint32_t mip = distance <= 1.0f ? 0 : (std::uint32_t)std::log2(distance);
+				trace.push_back({ frame, t, mip });
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string dir = "../Textures";
+	const char* tracePath = nullptr;
+	const char* outPath = nullptr;
+	double budgetMB = 16.0;
+	std::uint64_t frames = 2000;
+	unsigned int seed = 1;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+			dir = argv[++i];
+		else if(strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+			budgetMB = atof(argv[++i]);
+		else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = strtoull(argv[++i], nullptr, 10);
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = (unsigned int)atoi(argv[++i]);
+		else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+			tracePath = argv[++i];
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--dir Textures] [--budget MB] [--frames N] [--seed N] "
+				"[--trace file.txt] [--out file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<std::wstring> files;
+	std::error_code ec;
+	for(const auto& entry : std::filesystem::directory_iterator(dir, ec))
+	{
+		if(entry.is_regular_file() && entry.path().extension() == ".dds")
+			files.push_back(entry.path().wstring());
+	}
+	std::sort(files.begin(), files.end());
+
+	const std::uint64_t budget = (std::uint64_t)(budgetMB * 1024.0 * 1024.0);
+	ResidencyPolicy policy(budget);
+
+	std::uint64_t totalBytes = 0;
+	std::uint32_t textureCount = 0;
+	std::vector<std::uint32_t> mipCounts;
+	for(const std::wstring& file : files)
+	{
+		DDS_TEXTURE_INFO info;
+		if(FAILED(GetDDSTextureInfoFromFile(file.c_str(), &info)))
+			continue;
+
+		ResidencyPolicy::TextureId id = policy.Register(info);
+		totalBytes += policy.BytesForMips(id, 0);
+		mipCounts.push_back(info.mipCount);
+		++textureCount;
+	}
+
+	if(textureCount == 0)
+	{
+		fprintf(stderr, "no usable .dds files in %s\n", dir.c_str());
+		return 1;
+	}
+
+	std::vector<Access> trace;
+	if(tracePath != nullptr)
+	{
+		if(!ReadTrace(tracePath, textureCount, trace))
+		{
+			fprintf(stderr, "cannot read %s\n", tracePath);
+			return 1;
+		}
+	}
+	else
+	{
+		MakeWalk(textureCount, frames, seed, trace);
+	}
+
+	// Replay frame by frame: touch everything the frame draws, then plan.
+	std::uint64_t frameCount = 0;
+	std::uint64_t actionCount = 0;
+	std::uint64_t overBudget = 0;
+	std::uint64_t tooFine = 0;
+	std::vector<std::uint32_t> desired(textureCount, ResidencyPolicy::NotResident);
+	for(size_t i = 0; i < trace.size();)
+	{
+		const std::uint64_t frame = trace[i].Frame;
+		const size_t first = i;
+		for(; i < trace.size() && trace[i].Frame == frame; ++i)
+		{
+			const Access& a = trace[i];
+			policy.Touch(a.Texture, frame, a.Mip);
+
+			std::uint32_t mip = std::min(a.Mip, mipCounts[a.Texture] - 1);
+			desired[a.Texture] = std::min(desired[a.Texture], mip);
+		}
+
+		std::vector<ResidencyPolicy::Action> actions = policy.Plan(frame);
+		for(const ResidencyPolicy::Action& action : actions)
+		{
+			if(action.Kind == ResidencyPolicy::Action::Load && action.TopMip < desired[action.Id])
+				++tooFine;
+		}
+		actionCount += actions.size();
+
+		for(size_t j = first; j < i; ++j)
+			desired[trace[j].Texture] = ResidencyPolicy::NotResident;
+		if(policy.ResidentBytes() > policy.Budget())
+			++overBudget;
+		++frameCount;
+	}
+
+	const ResidencyPolicy::Stats& stats = policy.GetStats();
+	fprintf(stderr, "%u textures, %.1f MB total, budget %.1f MB, %llu frames\n",
+		textureCount, totalBytes / (1024.0*1024.0), budgetMB, (unsigned long long)frameCount);
+	fprintf(stderr, "loads %llu (reloads %llu), reductions %llu, evictions %llu, %.1f MB streamed\n",
+		(unsigned long long)stats.Loads, (unsigned long long)stats.Reloads,
+		(unsigned long long)stats.Reductions, (unsigned long long)stats.Evictions,
+		stats.BytesLoaded / (1024.0*1024.0));
+	if(tooFine != 0)
+		fprintf(stderr, "ERROR: %llu loads finer than any touch of their frame asked for\n", (unsigned long long)tooFine);
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	fprintf(out,
+		"{\n  \"textures\": %u,\n  \"textureBytes\": %llu,\n  \"budgetBytes\": %llu,\n"
+		"  \"frames\": %llu,\n  \"accesses\": %zu,\n  \"actions\": %llu,\n"
+		"  \"loads\": %llu,\n  \"reloads\": %llu,\n  \"reductions\": %llu,\n  \"evictions\": %llu,\n"
+		"  \"bytesLoaded\": %llu,\n  \"peakResidentBytes\": %llu,\n"
+		"  \"overBudgetFrames\": %llu,\n  \"framesEndingOverBudget\": %llu,\n"
+		"  \"loadsFinerThanAsked\": %llu\n}\n",
+		textureCount, (unsigned long long)totalBytes, (unsigned long long)budget,
+		(unsigned long long)frameCount, trace.size(), (unsigned long long)actionCount,
+		(unsigned long long)stats.Loads, (unsigned long long)stats.Reloads,
+		(unsigned long long)stats.Reductions, (unsigned long long)stats.Evictions,
+		(unsigned long long)stats.BytesLoaded, (unsigned long long)stats.PeakResidentBytes,
+		(unsigned long long)stats.OverBudgetFrames, (unsigned long long)overBudget,
+		(unsigned long long)tooFine);
+
+	if(out != stdout)
+		fclose(out);
+
+	return tooFine == 0 ? 0 : 1;
+}
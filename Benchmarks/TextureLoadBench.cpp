@@ -0,0 +1,265 @@
+//***************************************************************************************
+// TextureLoadBench.cpp
+//
+// Measures the CPU side of texture loading over a whole directory of .dds files (by
+// default the Textures/ folder): file I/O, header parsing and subresource layout via
+// LoadDDSTextureDataFromFile, followed by the row copy into a staging buffer in the
+// footprint layout the upload heap uses.  The direct modes instead read each row
+// straight into that layout with StageDDSTextureFromFile, so no copy of the file is
+// made.  Each load mode (heap copy, memory-mapped and the two direct variants) is run
+// on 1..N threads.  The page cache is warm after the first pass, so this measures
+// the loader rather than the disk.  With --archive, a TexPack archive of the
+// directory is mounted over it and every mode reads from the archive instead.
+//
+// Built by the TextureLoadBench target of the root CMakeLists.txt, from the portable core only.
+//
+// With --telemetry, TextureTelemetry records every load and its per-stage histograms
+// and events are written to the given file; compare the timings with a run without
+// it to see what recording costs.
+//
+// Usage: TextureLoadBench [--dir Textures] [--archive textures.pak] [--out results.json]
+//                         [--threads N] [--repeat N] [--telemetry stages.json]
+//***************************************************************************************
+
+#include "../Common/DDSTextureData.h"
+#include "../Common/TextureFootprint.h"
+#include "../Common/TextureTelemetry.h"
+#include "../Common/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct LoadResult
+	{
+		std::string Mode;
+		unsigned int Threads = 0;
+		double Seconds = 0.0;
+		double Speedup = 0.0;
+		double MegabytesPerSecond = 0.0;
+		double FilesPerSecond = 0.0;
+	};
+
+	double Seconds(Clock::time_point a, Clock::time_point b)
+	{
+		return std::chrono::duration<double>(b - a).count();
+	}
+
+	// Loads one texture and copies its pixels out the way the upload would.
+	// Returns the number of pixel bytes, or 0 if the file is not a usable DDS.
+	std::uint64_t LoadOne(const std::wstring& file, unsigned int loadFlags)
+	{
+		MemoryStagingSink staging;
+		DDS_STAGED_TEXTURE staged;
+		if(loadFlags & DDS_LOADER_DIRECT_TO_STAGING)
+		{
+			if(FAILED(StageDDSTextureFromFile(file.c_str(), staging, staged, 0, loadFlags)))
+				return 0;
+		}
+		else
+		{
+			DDS_TEXTURE_DATA data;
+			if(FAILED(LoadDDSTextureDataFromFile(file.c_str(), data, 0, loadFlags)) ||
+			   FAILED(StageDDSTextureData(data, staging, staged)))
+				return 0;
+		}
+
+		std::uint64_t total = 0;
+		for(const TEXTURE_FOOTPRINT& fp : staged.footprints)
+			total += fp.rowSizeInBytes * fp.numRows * fp.depth;
+
+		return total;
+	}
+
+	void WriteJson(FILE* out, size_t fileCount, std::uint64_t totalBytes, const std::vector<LoadResult>& results)
+	{
+		fprintf(out, "{\n  \"files\": %zu,\n  \"pixelBytes\": %llu,\n  \"runs\": [\n",
+			fileCount, (unsigned long long)totalBytes);
+		for(size_t i = 0; i < results.size(); ++i)
+		{
+			const LoadResult& r = results[i];
+			fprintf(out,
+				"    { \"mode\": \"%s\", \"threads\": %u, \"seconds\": %.9g, \"speedup\": %.4g, "
+				"\"megabytesPerSecond\": %.6g, \"filesPerSecond\": %.6g }%s\n",
+				r.Mode.c_str(), r.Threads, r.Seconds, r.Speedup, r.MegabytesPerSecond, r.FilesPerSecond,
+				i + 1 < results.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string dir = "../Textures";
+	const char* outPath = nullptr;
+	const char* archivePath = nullptr;
+	const char* telemetryPath = nullptr;
+	unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	int repeat = 5;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+			dir = argv[++i];
+		else if(strcmp(argv[i], "--archive") == 0 && i + 1 < argc)
+			archivePath = argv[++i];
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			maxThreads = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc)
+			telemetryPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--dir Textures] [--archive file.pak] [--out file.json] "
+				"[--threads N] [--repeat N] [--telemetry file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<std::wstring> files;
+	std::error_code ec;
+	for(const auto& entry : std::filesystem::directory_iterator(dir, ec))
+	{
+		if(entry.is_regular_file() && entry.path().extension() == ".dds")
+			files.push_back(entry.path().wstring());
+	}
+	std::sort(files.begin(), files.end());
+
+	if(files.empty())
+	{
+		fprintf(stderr, "no .dds files in %s\n", dir.c_str());
+		return 1;
+	}
+
+	if(archivePath != nullptr)
+	{
+		std::wstring archive = std::filesystem::path(archivePath).wstring();
+		if(FAILED(MountTextureArchive(archive.c_str(), std::filesystem::path(dir).wstring().c_str())))
+		{
+			fprintf(stderr, "cannot mount %s\n", archivePath);
+			return 1;
+		}
+	}
+
+	if(telemetryPath != nullptr)
+		TextureTelemetry::Enable();
+
+	struct Mode
+	{
+		const char* Name;
+		unsigned int Flags;
+	};
+	const Mode modes[] =
+	{
+		{ "read", DDS_LOADER_DEFAULT },
+		{ "mapped", DDS_LOADER_MEMORY_MAPPED },
+		{ "direct", DDS_LOADER_DIRECT_TO_STAGING },
+		{ "direct-mapped", DDS_LOADER_DIRECT_TO_STAGING | DDS_LOADER_MEMORY_MAPPED },
+	};
+
+	std::vector<unsigned int> counts;
+	for(unsigned int threads = 1; threads < maxThreads; threads *= 2)
+		counts.push_back(threads);
+	counts.push_back(maxThreads);
+
+	std::uint64_t totalBytes = 0;
+	std::vector<LoadResult> results;
+	for(const Mode& mode : modes)
+	{
+		double baseline = 0.0;
+		for(unsigned int threads : counts)
+		{
+			std::unique_ptr<ThreadPool> pool;
+			if(threads > 1)
+				pool.reset(new ThreadPool(threads - 1));
+
+			std::atomic<std::uint64_t> bytes(0);
+			auto loadAll = [&]()
+			{
+				bytes = 0;
+				auto load = [&](size_t i) { bytes += LoadOne(files[i], mode.Flags); };
+				if(pool)
+					pool->ParallelFor(files.size(), load);
+				else
+				{
+					for(size_t i = 0; i < files.size(); ++i)
+						load(i);
+				}
+			};
+
+			// Warm the page cache, then keep the best of the timed passes.
+			loadAll();
+			double best = 0.0;
+			for(int r = 0; r < repeat; ++r)
+			{
+				Clock::time_point start = Clock::now();
+				loadAll();
+				double s = Seconds(start, Clock::now());
+				if(r == 0 || s < best)
+					best = s;
+			}
+
+			totalBytes = bytes;
+			if(threads == 1)
+				baseline = best;
+
+			LoadResult res;
+			res.Mode = mode.Name;
+			res.Threads = threads;
+			res.Seconds = best;
+			res.Speedup = best > 0.0 ? baseline / best : 0.0;
+			res.MegabytesPerSecond = best > 0.0 ? (double)totalBytes / (1024.0*1024.0) / best : 0.0;
+			res.FilesPerSecond = best > 0.0 ? files.size() / best : 0.0;
+			results.push_back(res);
+
+			fprintf(stderr, "%-13s %3u threads  %8.3f ms  %9.1f MB/s\n",
+				mode.Name, threads, best*1000.0, res.MegabytesPerSecond);
+		}
+	}
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	WriteJson(out, files.size(), totalBytes, results);
+
+	if(out != stdout)
+		fclose(out);
+
+	if(telemetryPath != nullptr)
+	{
+		FILE* telemetry = fopen(telemetryPath, "w");
+		if(telemetry == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", telemetryPath);
+			return 1;
+		}
+		fputs(TextureTelemetry::FormatJson().c_str(), telemetry);
+		fclose(telemetry);
+	}
+
+	return 0;
+}
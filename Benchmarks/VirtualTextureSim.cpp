@@ -0,0 +1,294 @@
+//***************************************************************************************
+// VirtualTextureSim.cpp
+//
+// Drives VirtualTexturePageTable with simulated GPU feedback and reports how well the
+// tile cache kept up: hit rate, loads per frame, evictions and reloads.  The virtual
+// texture is one large terrain texture (by default 16384x16384 BC1 with a full mip
+// chain) seen by a camera flying over it; each frame a low resolution feedback buffer
+// is "rendered" by casting its pixels onto the ground, each asking for the tile and
+// mip its footprint needs, with a per-frame jitter as real feedback passes use.
+//
+// The actions are replayed onto a shadow of the physical cache and every request is
+// looked up afterwards, so a bookkeeping error (a load into an occupied slot, an
+// eviction of the wrong tile, a lookup that points at a tile not in its slot) is
+// counted and fails the run.
+//
+// Built by the VirtualTextureSim target of the root CMakeLists.txt, from the portable core only.
+//
+// Usage: VirtualTextureSim [--size N] [--format bc1|bc3|rgba8] [--budget MB]
+//                          [--frames N] [--speed texels] [--max-loads N] [--seed N]
+//                          [--out results.json]
+//***************************************************************************************
+
+#include "../Common/VirtualTexturePageTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	typedef VirtualTexturePageTable::Tile Tile;
+
+	// Feedback buffer size and horizontal field of view of the simulated camera.
+	const int FeedbackWidth = 80;
+	const int FeedbackHeight = 45;
+	const float HalfFov = 0.8f;
+	const float ScreenWidth = 1280.0f;
+
+	struct Camera
+	{
+		float X;
+		float Y;
+		float Heading;
+		float Height;
+	};
+
+	// A slow Lissajous path over the middle of the terrain, in texels.
+	Camera CameraAt(std::uint64_t frame, float size, float speed)
+	{
+		const float t = frame*speed / size;
+		Camera c;
+		c.X = size*(0.5f + 0.35f*std::sin(t*2.0f));
+		c.Y = size*(0.5f + 0.35f*std::sin(t*3.0f + 1.0f));
+		float dx = 2.0f*std::cos(t*2.0f);
+		float dy = 3.0f*std::cos(t*3.0f + 1.0f);
+		c.Heading = std::atan2(dy, dx);
+		c.Height = 64.0f;
+		return c;
+	}
+
+	// Casts the feedback pixels onto the ground plane and returns the tile and mip
+	// each one samples.
+	void RenderFeedback(const VirtualTexturePageTable& table, VirtualTexturePageTable::TextureId id,
+		const DDS_TEXTURE_INFO& info, std::uint32_t tileWidth, std::uint32_t tileHeight,
+		const Camera& c, std::mt19937& rng, std::vector<Tile>& requests)
+	{
+		std::uniform_real_distribution<float> jitter(0.0f, 1.0f);
+		const float cosH = std::cos(c.Heading);
+		const float sinH = std::sin(c.Heading);
+
+		requests.clear();
+		for(int py = 0; py < FeedbackHeight; ++py)
+		{
+			// Rows below the horizon, looking down at up to about 60 degrees.
+			float pitch = 0.01f + 1.0f*(py + jitter(rng)) / FeedbackHeight;
+			float distance = c.Height / std::tan(pitch);
+			for(int px = 0; px < FeedbackWidth; ++px)
+			{
+				float side = std::tan(HalfFov)*(2.0f*(px + jitter(rng)) / FeedbackWidth - 1.0f);
+				float u = c.X + distance*(cosH - side*sinH);
+				float v = c.Y + distance*(sinH + side*cosH);
+				if(u < 0.0f || v < 0.0f || u >= (float)info.width || v >= (float)info.height)
+					continue;
+
+				// Texels of mip 0 across one screen pixel, grazing angle included.
+				float slant = std::sqrt(distance*distance + c.Height*c.Height);
+				float footprint = slant*(2.0f*std::tan(HalfFov) / ScreenWidth) / std::max(std::sin(pitch), 0.05f);
+				std::uint32_t mip = footprint <= 1.0f ? 0 : (std::uint32_t)std::log2(footprint);
+				mip = std::min(mip, info.mipCount - 1);
+
+				Tile tile;
+				tile.Texture = id;
+				tile.Slice = 0;
+				tile.Mip = mip;
+				tile.X = (std::uint32_t)u >> mip;
+				tile.Y = (std::uint32_t)v >> mip;
+				tile.X /= tileWidth;
+				tile.Y /= tileHeight;
+				if(mip < table.FirstPackedMip(id))
+				{
+					tile.X = std::min(tile.X, table.TilesX(id, mip) - 1);
+					tile.Y = std::min(tile.Y, table.TilesY(id, mip) - 1);
+				}
+				requests.push_back(tile);
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::uint32_t size = 16384;
+	std::string formatName = "bc1";
+	double budgetMB = 64.0;
+	std::uint64_t frames = 3000;
+	float speed = 24.0f;
+	std::uint32_t maxLoads = 64;
+	unsigned int seed = 1;
+	const char* outPath = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			size = (std::uint32_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+			formatName = argv[++i];
+		else if(strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+			budgetMB = atof(argv[++i]);
+		else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = strtoull(argv[++i], nullptr, 10);
+		else if(strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+			speed = (float)atof(argv[++i]);
+		else if(strcmp(argv[i], "--max-loads") == 0 && i + 1 < argc)
+			maxLoads = (std::uint32_t)std::max(0, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = (unsigned int)atoi(argv[++i]);
+		else if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--size N] [--format bc1|bc3|rgba8] [--budget MB] [--frames N] "
+				"[--speed texels] [--max-loads N] [--seed N] [--out file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	DDS_TEXTURE_INFO info = {};
+	info.dimension = DDS_DIMENSION_TEXTURE2D;
+	info.width = size;
+	info.height = size;
+	info.depth = 1;
+	info.arraySize = 1;
+	info.format = formatName == "bc3" ? DXGI_FORMAT_BC3_UNORM :
+		formatName == "rgba8" ? DXGI_FORMAT_R8G8B8A8_UNORM : DXGI_FORMAT_BC1_UNORM;
+	for(std::uint32_t s = size; s > 0; s >>= 1)
+		++info.mipCount;
+
+	const std::uint64_t budget = (std::uint64_t)(budgetMB*1024.0*1024.0);
+	VirtualTexturePageTable table(budget);
+	VirtualTexturePageTable::TextureId id = 0;
+	HRESULT hr = table.Register(info, &id);
+	if(FAILED(hr))
+	{
+		fprintf(stderr, "cannot register a %ux%u %s texture: 0x%08X\n", size, size, formatName.c_str(), (unsigned int)hr);
+		return 1;
+	}
+
+	std::uint32_t tileWidth = 0;
+	std::uint32_t tileHeight = 0;
+	VirtualTexturePageTable::GetTileShape(info.format, &tileWidth, &tileHeight);
+
+	std::uint64_t totalTiles = 0;
+	for(std::uint32_t mip = 0; mip < table.FirstPackedMip(id); ++mip)
+		totalTiles += (std::uint64_t)table.TilesX(id, mip)*table.TilesY(id, mip);
+
+	// Shadow of the physical cache: which tile each slot holds, by the actions alone.
+	const std::uint64_t Empty = ~0ull;
+	auto keyOf = [](const Tile& t)
+	{
+		return (std::uint64_t)t.Mip << 40 | (std::uint64_t)t.Y << 20 | t.X;
+	};
+	std::vector<std::uint64_t> shadow(table.Capacity(), Empty);
+
+	std::mt19937 rng(seed);
+	std::vector<Tile> requests;
+	std::uint64_t errors = 0;
+	std::uint64_t maxLoadsInFrame = 0;
+	std::uint64_t fallbackLevels = 0;
+	std::uint64_t lookups = 0;
+	for(std::uint64_t frame = 1; frame <= frames; ++frame)
+	{
+		Camera camera = CameraAt(frame, (float)size, speed);
+		RenderFeedback(table, id, info, tileWidth, tileHeight, camera, rng, requests);
+
+		// What the shaders sampled this frame, while the missing tiles were on
+		// their way.
+		for(const Tile& t : requests)
+		{
+			if(t.Mip < table.FirstPackedMip(id))
+			{
+				fallbackLevels += table.Lookup(id, 0, t.Mip, t.X, t.Y).Mip - t.Mip;
+				++lookups;
+			}
+		}
+
+		table.ProcessFeedback(frame, requests.data(), requests.size());
+		std::vector<VirtualTexturePageTable::Action> actions = table.Update(frame, maxLoads);
+
+		std::uint64_t loads = 0;
+		for(const VirtualTexturePageTable::Action& a : actions)
+		{
+			if(a.Slot >= shadow.size())
+			{
+				++errors;
+				continue;
+			}
+
+			if(a.Kind == VirtualTexturePageTable::Action::Evict)
+			{
+				errors += shadow[a.Slot] != keyOf(a.Where);
+				shadow[a.Slot] = Empty;
+			}
+			else
+			{
+				errors += shadow[a.Slot] != Empty;
+				shadow[a.Slot] = keyOf(a.Where);
+				++loads;
+			}
+		}
+		maxLoadsInFrame = std::max(maxLoadsInFrame, loads);
+		errors += table.ResidentTiles() > table.Capacity();
+
+		// Every lookup must land on a slot holding a tile of the mip it names.
+		for(const Tile& t : requests)
+		{
+			VirtualTexturePageTable::PageEntry e = table.Lookup(id, 0, t.Mip, t.X, t.Y);
+			if(e.Slot != VirtualTexturePageTable::NotResident)
+			{
+				const std::uint64_t held = shadow[e.Slot];
+				errors += held == Empty || (held >> 40) != e.Mip;
+			}
+		}
+	}
+
+	const VirtualTexturePageTable::Stats& stats = table.GetStats();
+	const double hitRate = stats.Requests ? (double)stats.Hits / stats.Requests : 0.0;
+	const double meanFallback = lookups ? (double)fallbackLevels / lookups : 0.0;
+	fprintf(stderr, "%ux%u %s, %ux%u tiles, %llu tiles in %u mips, cache %u tiles (%.1f MB)\n",
+		size, size, formatName.c_str(), tileWidth, tileHeight, (unsigned long long)totalTiles,
+		table.FirstPackedMip(id), table.Capacity(), budgetMB);
+	fprintf(stderr, "%llu frames: hit rate %.2f%%, mean fallback %.3f mips, loads %llu (reloads %llu, "
+		"max %llu per frame), evictions %llu, deferred %llu, thrash frames %llu, errors %llu\n",
+		(unsigned long long)frames, hitRate*100.0, meanFallback, (unsigned long long)stats.Loads,
+		(unsigned long long)stats.Reloads, (unsigned long long)maxLoadsInFrame,
+		(unsigned long long)stats.Evictions, (unsigned long long)stats.DeferredLoads,
+		(unsigned long long)stats.ThrashFrames, (unsigned long long)errors);
+
+	FILE* out = stdout;
+	if(outPath != nullptr)
+	{
+		out = fopen(outPath, "w");
+		if(out == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", outPath);
+			return 1;
+		}
+	}
+
+	fprintf(out,
+		"{\n  \"size\": %u,\n  \"format\": \"%s\",\n  \"tileWidth\": %u,\n  \"tileHeight\": %u,\n"
+		"  \"tiles\": %llu,\n  \"packedTailBytes\": %llu,\n  \"budgetBytes\": %llu,\n  \"capacity\": %u,\n"
+		"  \"frames\": %llu,\n  \"requests\": %llu,\n  \"hitRate\": %.6g,\n  \"meanFallbackMips\": %.6g,\n"
+		"  \"loads\": %llu,\n  \"reloads\": %llu,\n  \"maxLoadsInFrame\": %llu,\n  \"evictions\": %llu,\n"
+		"  \"deferredLoads\": %llu,\n  \"thrashFrames\": %llu,\n  \"peakResidentTiles\": %u,\n"
+		"  \"errors\": %llu\n}\n",
+		size, formatName.c_str(), tileWidth, tileHeight, (unsigned long long)totalTiles,
+		(unsigned long long)table.PackedTailBytes(), (unsigned long long)budget, table.Capacity(),
+		(unsigned long long)frames, (unsigned long long)stats.Requests, hitRate, meanFallback,
+		(unsigned long long)stats.Loads, (unsigned long long)stats.Reloads, (unsigned long long)maxLoadsInFrame,
+		(unsigned long long)stats.Evictions, (unsigned long long)stats.DeferredLoads,
+		(unsigned long long)stats.ThrashFrames, stats.PeakResidentTiles, (unsigned long long)errors);
+
+	if(out != stdout)
+		fclose(out);
+
+	return errors != 0;
+}
@@ -0,0 +1,463 @@
+//***************************************************************************************
+// AsyncFileIO.cpp
+//***************************************************************************************
+
+#include "AsyncFileIO.h"
+#include "FileMapping.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ASYNC_FILE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+//---------------------------------------------------------------------------------------
+// AsyncFile
+//---------------------------------------------------------------------------------------
+
+AsyncFile::~AsyncFile()
+{
+	Close();
+}
+
+#if defined(_WIN32)
+
+HRESULT AsyncFile::Open(const wchar_t* fileName)
+{
+	Close();
+
+	if(fileName == nullptr)
+		return E_INVALIDARG;
+
+	HANDLE file = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size))
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		CloseHandle(file);
+		return hr;
+	}
+
+	mHandle = file;
+	mSize = (std::uint64_t)size.QuadPart;
+	mOpen = true;
+	return S_OK;
+}
+
+void AsyncFile::Close()
+{
+	if(mOpen)
+		CloseHandle(mHandle);
+
+	mHandle = nullptr;
+	mSize = 0;
+	mOpen = false;
+}
+
+#else
+
+HRESULT AsyncFile::Open(const wchar_t* fileName)
+{
+	Close();
+
+	if(fileName == nullptr)
+		return E_INVALIDARG;
+
+	int fd = open(WideToUtf8(fileName).c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return HResultFromErrno(errno);
+
+	struct stat st;
+	if(fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return E_FAIL;
+	}
+
+	// Whole files are read front to back.
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	mHandle = fd;
+	mSize = (std::uint64_t)st.st_size;
+	mOpen = true;
+	return S_OK;
+}
+
+void AsyncFile::Close()
+{
+	if(mOpen)
+		close(mHandle);
+
+	mHandle = -1;
+	mSize = 0;
+	mOpen = false;
+}
+
+#endif
+
+//---------------------------------------------------------------------------------------
+// AsyncFileIO
+//---------------------------------------------------------------------------------------
+
+bool AsyncFileIO::Queue(const AsyncReadRequest& request)
+{
+	if(mInFlight == mQueueDepth)
+		return false;
+
+	QueueRead(request);
+	++mInFlight;
+	return true;
+}
+
+std::size_t AsyncFileIO::Complete(AsyncReadResult* results, std::size_t maxResults, std::size_t minResults)
+{
+	minResults = std::min<std::size_t>(minResults, std::min<std::size_t>(maxResults, mInFlight));
+	std::size_t count = CompleteReads(results, maxResults, minResults);
+	mInFlight -= (std::uint32_t)count;
+	return count;
+}
+
+namespace
+{
+	//-----------------------------------------------------------------------------------
+	// Threads: one blocking positional read per worker at a time.
+	//-----------------------------------------------------------------------------------
+
+	class ThreadFileIO : public AsyncFileIO
+	{
+	public:
+		explicit ThreadFileIO(std::uint32_t queueDepth)
+			: AsyncFileIO(queueDepth)
+		{
+			for(std::uint32_t i = 0; i < queueDepth; ++i)
+				mThreads.emplace_back([this]() { WorkerLoop(); });
+		}
+
+		~ThreadFileIO()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mStopping = true;
+			}
+			mWorkReady.notify_all();
+
+			for(auto& t : mThreads)
+				t.join();
+		}
+
+		const char* Name()const override { return "threads"; }
+
+		HRESULT Submit() override
+		{
+			if(mBatch.empty())
+				return S_OK;
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mWork.insert(mWork.end(), mBatch.begin(), mBatch.end());
+			}
+			mBatch.clear();
+			mWorkReady.notify_all();
+			return S_OK;
+		}
+
+	protected:
+		void QueueRead(const AsyncReadRequest& request) override
+		{
+			mBatch.push_back(request);
+		}
+
+		std::size_t CompleteReads(AsyncReadResult* results, std::size_t maxResults, std::size_t minResults) override
+		{
+			// Reads queued since the last Submit count towards minResults, so they go
+			// to the workers before the wait, as the io_uring backend does.
+			Submit();
+
+			std::unique_lock<std::mutex> lock(mMutex);
+			mDoneReady.wait(lock, [&]() { return mDone.size() >= minResults; });
+
+			std::size_t count = std::min(maxResults, mDone.size());
+			std::copy(mDone.begin(), mDone.begin() + count, results);
+			mDone.erase(mDone.begin(), mDone.begin() + count);
+			return count;
+		}
+
+	private:
+		static AsyncReadResult Read(const AsyncReadRequest& request)
+		{
+			AsyncReadResult result;
+			result.Tag = request.Tag;
+
+			std::uint8_t* dst = static_cast<std::uint8_t*>(request.Buffer);
+			std::uint32_t done = 0;
+			while(done < request.Size)
+			{
+#if defined(_WIN32)
+				OVERLAPPED overlapped = {};
+				std::uint64_t offset = request.Offset + done;
+				overlapped.Offset = (DWORD)offset;
+				overlapped.OffsetHigh = (DWORD)(offset >> 32);
+				DWORD bytes = 0;
+				if(!ReadFile(request.File->Handle(), dst + done, request.Size - done, &bytes, &overlapped))
+				{
+					DWORD error = GetLastError();
+					if(error != ERROR_HANDLE_EOF)
+						result.Result = HRESULT_FROM_WIN32(error);
+					break;
+				}
+#else
+				ssize_t bytes = pread(request.File->Handle(), dst + done, request.Size - done,
+					(off_t)(request.Offset + done));
+				if(bytes < 0 && errno == EINTR)
+					continue;
+				if(bytes < 0)
+				{
+					result.Result = E_FAIL;
+					break;
+				}
+#endif
+				if(bytes == 0)
+					break;
+				done += (std::uint32_t)bytes;
+			}
+
+			result.BytesRead = done;
+			return result;
+		}
+
+		void WorkerLoop()
+		{
+			for(;;)
+			{
+				AsyncReadRequest request;
+				{
+					std::unique_lock<std::mutex> lock(mMutex);
+					mWorkReady.wait(lock, [this]() { return mStopping || !mWork.empty(); });
+					if(mStopping)
+						return;
+
+					request = mWork.front();
+					mWork.pop_front();
+				}
+
+				AsyncReadResult result = Read(request);
+
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					mDone.push_back(result);
+				}
+				mDoneReady.notify_one();
+			}
+		}
+
+		std::vector<AsyncReadRequest> mBatch;
+
+		std::mutex mMutex;
+		std::condition_variable mWorkReady;
+		std::condition_variable mDoneReady;
+		std::deque<AsyncReadRequest> mWork;
+		std::deque<AsyncReadResult> mDone;
+		bool mStopping = false;
+
+		std::vector<std::thread> mThreads;
+	};
+
+#if defined(ASYNC_FILE_IO_URING)
+
+	//-----------------------------------------------------------------------------------
+	// IoUring: one submission ring and one completion ring shared with the kernel.
+	// The application owns the SQ tail and the CQ head; the kernel owns the others.
+	//-----------------------------------------------------------------------------------
+
+	class UringFileIO : public AsyncFileIO
+	{
+	public:
+		explicit UringFileIO(std::uint32_t queueDepth)
+			: AsyncFileIO(queueDepth)
+		{
+		}
+
+		~UringFileIO()
+		{
+			if(mSqes != nullptr)
+				munmap(mSqes, mSqesSize);
+			if(mCqRing != nullptr && mCqRing != mSqRing)
+				munmap(mCqRing, mCqRingSize);
+			if(mSqRing != nullptr)
+				munmap(mSqRing, mSqRingSize);
+			if(mRing >= 0)
+				close(mRing);
+		}
+
+		bool Init()
+		{
+			io_uring_params params;
+			memset(&params, 0, sizeof(params));
+			mRing = (int)syscall(__NR_io_uring_setup, QueueDepth(), &params);
+			if(mRing < 0)
+				return false;
+
+			mSqRingSize = params.sq_off.array + params.sq_entries*sizeof(std::uint32_t);
+			mCqRingSize = params.cq_off.cqes + params.cq_entries*sizeof(io_uring_cqe);
+			const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if(singleMap)
+				mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+
+			mSqRing = Map(mSqRingSize, IORING_OFF_SQ_RING);
+			mCqRing = singleMap ? mSqRing : Map(mCqRingSize, IORING_OFF_CQ_RING);
+			mSqesSize = params.sq_entries*sizeof(io_uring_sqe);
+			mSqes = static_cast<io_uring_sqe*>(Map(mSqesSize, IORING_OFF_SQES));
+			if(mSqRing == nullptr || mCqRing == nullptr || mSqes == nullptr)
+				return false;
+
+			std::uint8_t* sq = static_cast<std::uint8_t*>(mSqRing);
+			mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			mSqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+			std::uint8_t* cq = static_cast<std::uint8_t*>(mCqRing);
+			mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			mCqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+			mCqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+			// QueueDepth() never exceeds the ring, so neither ring can overflow.
+			return params.sq_entries >= QueueDepth();
+		}
+
+		const char* Name()const override { return "io_uring"; }
+
+		HRESULT Submit() override
+		{
+			while(mUnsubmitted > 0)
+			{
+				int submitted = (int)syscall(__NR_io_uring_enter, mRing, mUnsubmitted, 0, 0, nullptr, 0);
+				if(submitted < 0)
+				{
+					if(errno == EINTR)
+						continue;
+					return E_FAIL;
+				}
+				mUnsubmitted -= (unsigned)submitted;
+			}
+			return S_OK;
+		}
+
+	protected:
+		void QueueRead(const AsyncReadRequest& request) override
+		{
+			const unsigned tail = *mSqTail;
+			const unsigned index = tail & mSqMask;
+
+			io_uring_sqe& sqe = mSqes[index];
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_READ;
+			sqe.fd = request.File->Handle();
+			sqe.off = request.Offset;
+			sqe.addr = (std::uint64_t)(uintptr_t)request.Buffer;
+			sqe.len = request.Size;
+			sqe.user_data = request.Tag;
+
+			mSqArray[index] = index;
+			__atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+			++mUnsubmitted;
+		}
+
+		std::size_t CompleteReads(AsyncReadResult* results, std::size_t maxResults, std::size_t minResults) override
+		{
+			std::size_t count = 0;
+			for(;;)
+			{
+				unsigned head = *mCqHead;
+				const unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+				for(; head != tail && count < maxResults; ++head, ++count)
+				{
+					const io_uring_cqe& cqe = mCqes[head & mCqMask];
+					results[count].Tag = cqe.user_data;
+					results[count].Result = cqe.res < 0 ? E_FAIL : S_OK;
+					results[count].BytesRead = cqe.res < 0 ? 0 : (std::uint32_t)cqe.res;
+				}
+				__atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+
+				if(count >= minResults)
+					return count;
+
+				// Anything a failed Submit left in the ring goes in with the wait.
+				int r = (int)syscall(__NR_io_uring_enter, mRing, mUnsubmitted, (unsigned)(minResults - count),
+					IORING_ENTER_GETEVENTS, nullptr, 0);
+				if(r >= 0)
+					mUnsubmitted -= (unsigned)r;
+				else if(errno != EINTR)
+					return count;
+			}
+		}
+
+	private:
+		void* Map(size_t size, off_t offset)
+		{
+			void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, offset);
+			return p == MAP_FAILED ? nullptr : p;
+		}
+
+		int mRing = -1;
+		void* mSqRing = nullptr;
+		void* mCqRing = nullptr;
+		size_t mSqRingSize = 0;
+		size_t mCqRingSize = 0;
+		io_uring_sqe* mSqes = nullptr;
+		size_t mSqesSize = 0;
+
+		unsigned* mSqTail = nullptr;
+		unsigned mSqMask = 0;
+		unsigned* mSqArray = nullptr;
+		unsigned* mCqHead = nullptr;
+		unsigned* mCqTail = nullptr;
+		unsigned mCqMask = 0;
+		io_uring_cqe* mCqes = nullptr;
+
+		unsigned mUnsubmitted = 0;
+	};
+
+#endif
+}
+
+std::unique_ptr<AsyncFileIO> CreateAsyncFileIO(std::uint32_t queueDepth, AsyncIOBackend backend)
+{
+	queueDepth = std::min<std::uint32_t>(std::max<std::uint32_t>(queueDepth, 1), 4096);
+
+#if defined(ASYNC_FILE_IO_URING)
+	if(backend == AsyncIOBackend::Default || backend == AsyncIOBackend::IoUring)
+	{
+		std::unique_ptr<UringFileIO> io(new UringFileIO(queueDepth));
+		if(io->Init())
+			return io;
+	}
+#endif
+
+	if(backend == AsyncIOBackend::IoUring)
+		return nullptr;
+
+	return std::unique_ptr<AsyncFileIO>(new ThreadFileIO(queueDepth));
+}
@@ -0,0 +1,123 @@
+//***************************************************************************************
+// AsyncFileIO.h
+//
+// Batched asynchronous file reads with an io_uring-shaped interface: reads are queued,
+// handed to the OS together by Submit(), and their completions reaped in whatever
+// order they finish.  Keeping many reads in flight is what lets an NVMe drive reach
+// its bandwidth, and the thread that submits is free to parse and stage the files
+// that have already arrived.
+//
+// Backends:
+//   IoUring  Linux io_uring through the raw system calls (no liburing needed).
+//            Unavailable when the kernel or a seccomp filter refuses io_uring_setup.
+//   Threads  Positional reads (pread / ReadFile at an offset) on a private set of
+//            threads, one per queue slot.  Works everywhere, and is the stand-in on
+//            Windows.
+// Default picks IoUring where it can be created and Threads otherwise.
+//
+// One thread drives an AsyncFileIO: Queue, Submit and Complete are not thread safe
+// with respect to each other.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "Platform.h"
+
+// A file opened for asynchronous reads.
+class AsyncFile
+{
+public:
+#if defined(_WIN32)
+	using NativeHandle = HANDLE;
+#else
+	using NativeHandle = int;
+#endif
+
+	AsyncFile() = default;
+	AsyncFile(const AsyncFile& rhs) = delete;
+	AsyncFile& operator=(const AsyncFile& rhs) = delete;
+	~AsyncFile();
+
+	HRESULT Open(const wchar_t* fileName);
+	void Close();
+
+	bool IsOpen()const { return mOpen; }
+	std::uint64_t Size()const { return mSize; }
+	NativeHandle Handle()const { return mHandle; }
+
+private:
+#if defined(_WIN32)
+	NativeHandle mHandle = nullptr;
+#else
+	NativeHandle mHandle = -1;
+#endif
+	std::uint64_t mSize = 0;
+	bool mOpen = false;
+};
+
+struct AsyncReadRequest
+{
+	const AsyncFile* File = nullptr;
+	std::uint64_t Offset = 0;
+	std::uint32_t Size = 0;
+	void* Buffer = nullptr;
+	std::uint64_t Tag = 0;		// Returned with the completion.
+};
+
+struct AsyncReadResult
+{
+	std::uint64_t Tag = 0;
+	HRESULT Result = S_OK;
+	std::uint32_t BytesRead = 0;	// Less than requested only at the end of the file.
+};
+
+enum class AsyncIOBackend
+{
+	Default,
+	IoUring,
+	Threads
+};
+
+class AsyncFileIO
+{
+public:
+	virtual ~AsyncFileIO() = default;
+
+	virtual const char* Name()const = 0;
+
+	// Reads that can be queued or running at once.
+	std::uint32_t QueueDepth()const { return mQueueDepth; }
+
+	// Reads queued or running whose completion has not been reaped yet.
+	std::uint32_t InFlight()const { return mInFlight; }
+
+	// Adds a read to the next batch.  Returns false, and queues nothing, when
+	// InFlight() == QueueDepth(); reap completions first.
+	bool Queue(const AsyncReadRequest& request);
+
+	// Starts every read queued since the last Submit.
+	virtual HRESULT Submit() = 0;
+
+	// Reaps up to maxResults completions, blocking until at least minResults have
+	// finished (or nothing is in flight).  Returns the number written to results,
+	// which is below minResults only if the backend itself has failed.
+	std::size_t Complete(AsyncReadResult* results, std::size_t maxResults, std::size_t minResults);
+
+protected:
+	explicit AsyncFileIO(std::uint32_t queueDepth) : mQueueDepth(queueDepth) {}
+
+	virtual void QueueRead(const AsyncReadRequest& request) = 0;
+	virtual std::size_t CompleteReads(AsyncReadResult* results, std::size_t maxResults, std::size_t minResults) = 0;
+
+private:
+	std::uint32_t mQueueDepth;
+	std::uint32_t mInFlight = 0;
+};
+
+// Returns nullptr if backend is not available on this system (never for Default or
+// Threads).
+std::unique_ptr<AsyncFileIO> CreateAsyncFileIO(std::uint32_t queueDepth,
+	AsyncIOBackend backend = AsyncIOBackend::Default);
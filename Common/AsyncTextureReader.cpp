@@ -0,0 +1,258 @@
+//***************************************************************************************
+// AsyncTextureReader.cpp
+//***************************************************************************************
+
+#include "AsyncTextureReader.h"
+#include "TextureArchive.h"
+#include "TextureTelemetry.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+using namespace DirectX;
+
+namespace
+{
+	struct PendingFile
+	{
+		AsyncFile File;
+		ArchivedFile Archived;
+		std::unique_ptr<std::uint8_t[]> Data;
+		std::uint64_t Size = 0;
+		std::uint64_t Issued = 0;		// Bytes queued so far.
+		std::uint32_t Outstanding = 0;	// Reads queued and not yet reaped.
+		HRESULT Result = S_OK;
+		std::uint64_t TelemetryId = 0;
+		std::uint64_t OpenedNs = 0;		// FileRead runs from Open to the last read.
+	};
+
+	struct ReadSlot
+	{
+		AsyncReadRequest Request;
+		std::size_t FileIndex = 0;
+	};
+}
+
+AsyncTextureReader::AsyncTextureReader(AsyncFileIO& io)
+	: mIO(io)
+{
+}
+
+void AsyncTextureReader::SetMaxSize(std::size_t maxsize)
+{
+	mMaxSize = maxsize;
+}
+
+void AsyncTextureReader::SetChunkSize(std::uint32_t chunkSize)
+{
+	mChunkSize = std::max<std::uint32_t>(chunkSize, 4096);
+}
+
+void AsyncTextureReader::Read(const std::vector<std::wstring>& fileNames, const Callback& onLoaded)
+{
+	const std::uint32_t depth = mIO.QueueDepth();
+
+	// A request's tag is its slot, which remembers what was asked for so that a short
+	// read can be continued.
+	std::vector<ReadSlot> slots(depth);
+	std::vector<std::uint32_t> freeSlots;
+	for(std::uint32_t i = depth; i > 0; --i)
+		freeSlots.push_back(i - 1);
+
+	std::vector<std::unique_ptr<PendingFile>> files(fileNames.size());
+	std::deque<ReadSlot> retries;
+	std::vector<std::size_t> ready;
+	std::vector<AsyncReadResult> results(depth);
+	std::size_t nextFile = 0;
+	std::size_t issuing = fileNames.size();
+	std::size_t delivered = 0;
+
+	// Buffers must outlive the reads into them, including when onLoaded throws.
+	struct Drain
+	{
+		AsyncFileIO& IO;
+		std::vector<std::unique_ptr<PendingFile>>& Files;
+		~Drain()
+		{
+			AsyncReadResult result;
+			while(IO.InFlight() > 0)
+			{
+				if(IO.Complete(&result, 1, 1) == 0)
+				{
+					// The backend has failed with reads outstanding; the kernel
+					// may still write to these buffers, so they are never freed.
+					for(auto& file : Files)
+						if(file)
+							file->Data.release();
+					return;
+				}
+			}
+		}
+	} drain{ mIO, files };
+
+	auto isDone = [](const PendingFile& f)
+	{
+		return f.Outstanding == 0 && (f.Issued == f.Size || FAILED(f.Result));
+	};
+
+	while(delivered < fileNames.size())
+	{
+		// Keep every slot busy: continue short reads first, then the rest of the file
+		// being issued, then open the next one.
+		while(!freeSlots.empty())
+		{
+			ReadSlot slot;
+			if(!retries.empty())
+			{
+				slot = retries.front();
+				retries.pop_front();
+			}
+			else
+			{
+				if(issuing < files.size() && (!files[issuing] || isDone(*files[issuing]) ||
+					files[issuing]->Issued == files[issuing]->Size))
+					issuing = files.size();
+
+				if(issuing == files.size())
+				{
+					if(nextFile == files.size())
+						break;
+
+					const std::size_t index = nextFile++;
+					files[index].reset(new PendingFile);
+					PendingFile& f = *files[index];
+					if(TextureTelemetry::IsEnabled())
+					{
+						f.TelemetryId = TextureTelemetry::FileId(fileNames[index].c_str());
+						f.OpenedNs = TextureTelemetry::NowNs();
+					}
+
+					if(FindArchivedFile(fileNames[index].c_str(), f.Archived))
+					{
+						ready.push_back(index);
+						continue;
+					}
+
+					f.Result = f.File.Open(fileNames[index].c_str());
+					if(SUCCEEDED(f.Result))
+					{
+						f.Size = f.File.Size();
+						if(f.Size > SIZE_MAX - 1)
+							f.Result = HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+						else
+						{
+							f.Data.reset(new (std::nothrow) std::uint8_t[f.Size ? (std::size_t)f.Size : 1]);
+							if(!f.Data)
+								f.Result = E_OUTOFMEMORY;
+						}
+					}
+
+					if(FAILED(f.Result) || f.Size == 0)
+					{
+						ready.push_back(index);
+						continue;
+					}
+					issuing = index;
+				}
+
+				PendingFile& f = *files[issuing];
+				slot.FileIndex = issuing;
+				slot.Request.File = &f.File;
+				slot.Request.Offset = f.Issued;
+				slot.Request.Size = (std::uint32_t)std::min<std::uint64_t>(mChunkSize, f.Size - f.Issued);
+				slot.Request.Buffer = f.Data.get() + f.Issued;
+				f.Issued += slot.Request.Size;
+				++f.Outstanding;
+			}
+
+			const std::uint32_t tag = freeSlots.back();
+			freeSlots.pop_back();
+			slot.Request.Tag = tag;
+			slots[tag] = slot;
+			mIO.Queue(slot.Request);
+		}
+
+		// A failed submission is retried by the next Complete.
+		mIO.Submit();
+
+		// Only wait for the device when there is nothing else to do.
+		std::size_t count = 0;
+		if(mIO.InFlight() > 0)
+		{
+			count = mIO.Complete(results.data(), results.size(), ready.empty() ? 1 : 0);
+			if(count == 0 && ready.empty())
+			{
+				// The backend is broken: fail every file not delivered yet.
+				for(std::size_t i = 0; i < files.size(); ++i)
+				{
+					if(i >= nextFile || files[i])
+					{
+						DDS_TEXTURE_DATA data;
+						onLoaded(i, E_FAIL, data);
+						++delivered;
+					}
+				}
+				return;
+			}
+		}
+
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			const std::uint32_t tag = (std::uint32_t)results[i].Tag;
+			const ReadSlot& slot = slots[tag];
+			PendingFile& f = *files[slot.FileIndex];
+			freeSlots.push_back(tag);
+			--f.Outstanding;
+
+			if(FAILED(results[i].Result))
+				f.Result = results[i].Result;
+			else if(results[i].BytesRead == 0 && slot.Request.Size > 0)
+				f.Result = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);	// File shrank since Open.
+			else if(results[i].BytesRead < slot.Request.Size && SUCCEEDED(f.Result))
+			{
+				ReadSlot rest = slot;
+				rest.Request.Offset += results[i].BytesRead;
+				rest.Request.Size -= results[i].BytesRead;
+				rest.Request.Buffer = static_cast<std::uint8_t*>(rest.Request.Buffer) + results[i].BytesRead;
+				retries.push_back(rest);
+				++f.Outstanding;
+			}
+
+			if(isDone(f))
+				ready.push_back(slot.FileIndex);
+		}
+
+		// Parse and hand over finished files while the queue works on the others.
+		for(std::size_t index : ready)
+		{
+			std::unique_ptr<PendingFile> f = std::move(files[index]);
+			DDS_TEXTURE_DATA data;
+			data.telemetryId = f->TelemetryId;
+			HRESULT hr = f->Result;
+			if(f->OpenedNs != 0)
+			{
+				TextureTelemetry::Record(f->TelemetryId, TextureLoadStage::FileRead, f->OpenedNs,
+					TextureTelemetry::NowNs() - f->OpenedNs, f->Archived.Archive ? 0 : f->Size);
+			}
+			if(SUCCEEDED(hr) && f->Archived.Archive)
+			{
+				data.archive = f->Archived.Archive;
+				data.fileSize = f->Archived.Size;
+				hr = LoadDDSTextureDataFromMemory(f->Archived.Data, f->Archived.Size, data, mMaxSize);
+			}
+			else if(SUCCEEDED(hr))
+			{
+				f->File.Close();
+				data.fileSize = (std::size_t)f->Size;
+				data.fileData = std::move(f->Data);
+				hr = LoadDDSTextureDataFromMemory(data.fileData.get(), data.fileSize, data, mMaxSize);
+			}
+
+			++delivered;
+			onLoaded(index, hr, data);
+		}
+		ready.clear();
+	}
+}
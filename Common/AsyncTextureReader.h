@@ -0,0 +1,47 @@
+//***************************************************************************************
+// AsyncTextureReader.h
+//
+// Reads a list of DDS files through an AsyncFileIO.  Each file is split into chunks
+// and the reads for as many files as fit are kept queued, so the device always has
+// QueueDepth() requests to work on.  Whenever a file's last chunk arrives it is laid
+// out with LoadDDSTextureDataFromMemory and handed to a callback on the calling
+// thread, while the reads for the files behind it are still in flight: header
+// parsing and upload staging overlap the I/O instead of waiting for it.
+//
+// Files in a mounted TextureArchive are already mapped and are delivered without any
+// I/O.
+//***************************************************************************************
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "AsyncFileIO.h"
+#include "DDSTextureData.h"
+
+class AsyncTextureReader
+{
+public:
+	// Called once per file, in completion order.  data may be moved from.
+	using Callback = std::function<void(std::size_t index, HRESULT result, DirectX::DDS_TEXTURE_DATA& data)>;
+
+	explicit AsyncTextureReader(AsyncFileIO& io);
+	AsyncTextureReader(const AsyncTextureReader& rhs) = delete;
+	AsyncTextureReader& operator=(const AsyncTextureReader& rhs) = delete;
+
+	// Same meaning as the LoadDDSTextureDataFromFile argument.
+	void SetMaxSize(std::size_t maxsize);
+
+	// Largest single read.  Big enough to amortize a request, small enough that one
+	// large texture does not occupy the whole queue.  1 MiB by default.
+	void SetChunkSize(std::uint32_t chunkSize);
+
+	// Reads every file and returns once onLoaded has been called for each of them.
+	void Read(const std::vector<std::wstring>& fileNames, const Callback& onLoaded);
+
+private:
+	AsyncFileIO& mIO;
+	std::size_t mMaxSize = 0;
+	std::uint32_t mChunkSize = 1u << 20;
+};
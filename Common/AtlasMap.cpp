@@ -0,0 +1,65 @@
+//***************************************************************************************
+// AtlasMap.cpp
+//***************************************************************************************
+
+#include "AtlasMap.h"
+#include <fstream>
+#include <sstream>
+
+using namespace DirectX;
+
+XMFLOAT4X4 AtlasRegion::Transform()const
+{
+	// Row vectors, as in the shaders: texC = mul(float4(uv, 0, 1), MatTransform).
+	XMMATRIX m = XMMatrixScaling(ScaleU, ScaleV, 1.0f)*XMMatrixTranslation(OffsetU, OffsetV, 0.0f);
+
+	XMFLOAT4X4 result;
+	XMStoreFloat4x4(&result, m);
+	return result;
+}
+
+bool AtlasMap::Load(const std::string& filename)
+{
+	std::ifstream fin(filename);
+	if(!fin)
+		return false;
+
+	std::vector<AtlasRegion> regions;
+	std::string line;
+	while(std::getline(fin, line))
+	{
+		size_t comment = line.find('#');
+		if(comment != std::string::npos)
+			line.erase(comment);
+
+		std::istringstream in(line);
+		AtlasRegion r;
+		if(!(in >> r.Name))
+			continue;
+
+		if(!(in >> r.Page >> r.ScaleU >> r.ScaleV >> r.OffsetU >> r.OffsetV >> r.X >> r.Y >> r.Width >> r.Height))
+			return false;
+
+		regions.push_back(r);
+	}
+
+	mRegions = std::move(regions);
+	return true;
+}
+
+const AtlasRegion* AtlasMap::Find(const std::string& name)const
+{
+	for(const AtlasRegion& r : mRegions)
+	{
+		if(r.Name == name)
+			return &r;
+	}
+	return nullptr;
+}
+
+void AtlasMap::Apply(const AtlasRegion& region, XMFLOAT4X4& matTransform)
+{
+	XMFLOAT4X4 atlas = region.Transform();
+	XMMATRIX m = XMLoadFloat4x4(&matTransform)*XMLoadFloat4x4(&atlas);
+	XMStoreFloat4x4(&matTransform, m);
+}
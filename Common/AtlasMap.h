@@ -0,0 +1,61 @@
+//***************************************************************************************
+// AtlasMap.h
+//
+// Reads the UV remap table TexAssemble writes next to an atlas.  Each region maps the
+// [0,1] texture coordinates a mesh was authored with onto its rectangle in one atlas
+// page, as a scale and an offset that fold into Material::MatTransform.
+//
+// The file is text, one region per line, '#' starting a comment:
+//   name page scaleU scaleV offsetU offsetV x y width height
+// page is the atlas texture's file name; x, y, width and height are the rectangle in
+// texels and are informational.
+//
+// Atlas regions cannot wrap, so a material whose MatTransform tiles its texture (scale
+// above 1) will sample its neighbours; keep tiling textures out of atlases.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+struct AtlasRegion
+{
+	std::string Name;
+	std::string Page;
+
+	float ScaleU = 1.0f;
+	float ScaleV = 1.0f;
+	float OffsetU = 0.0f;
+	float OffsetV = 0.0f;
+
+	std::uint32_t X = 0;
+	std::uint32_t Y = 0;
+	std::uint32_t Width = 0;
+	std::uint32_t Height = 0;
+
+	// Texture transform taking the region's [0,1] coordinates into the atlas.
+	DirectX::XMFLOAT4X4 Transform()const;
+};
+
+class AtlasMap
+{
+public:
+	// Replaces the regions with those in filename.  Returns false if the file cannot
+	// be read or a line is malformed.
+	bool Load(const std::string& filename);
+
+	const std::vector<AtlasRegion>& Regions()const { return mRegions; }
+
+	// nullptr if no region has that name.
+	const AtlasRegion* Find(const std::string& name)const;
+
+	// Post-multiplies matTransform by the region's transform, so any existing offset
+	// or rotation is applied first and the result lands inside the region.
+	static void Apply(const AtlasRegion& region, DirectX::XMFLOAT4X4& matTransform);
+
+private:
+	std::vector<AtlasRegion> mRegions;
+};
@@ -0,0 +1,736 @@
+//***************************************************************************************
+// BCDecode.cpp
+//
+// Follows the block layouts of the Direct3D 11 functional spec ("Block Compression").
+// BC1-BC5 palettes are built with integer rounding; BC7 interpolation is exact.
+//***************************************************************************************
+
+#include "BCDecode.h"
+#include <algorithm>
+#include <cstring>
+
+#if !defined(BC_DECODE_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define BC_DECODE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	inline std::uint32_t Read32(const std::uint8_t* p)
+	{
+		std::uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline std::uint64_t Read64(const std::uint8_t* p)
+	{
+		std::uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline std::uint32_t PackRGBA(std::uint32_t r, std::uint32_t g, std::uint32_t b, std::uint32_t a)
+	{
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	//
+	// BC1 colour half, shared by BC2 and BC3.
+	//
+
+	void ColorPalette(const std::uint8_t* block, bool allowPunchThrough, std::uint32_t pal[4])
+	{
+		std::uint32_t c0 = block[0] | (block[1] << 8);
+		std::uint32_t c1 = block[2] | (block[3] << 8);
+
+		// 5:6:5 to 8:8:8 by replicating the high bits.
+		std::uint32_t r0 = (c0 >> 11) & 31, g0 = (c0 >> 5) & 63, b0 = c0 & 31;
+		std::uint32_t r1 = (c1 >> 11) & 31, g1 = (c1 >> 5) & 63, b1 = c1 & 31;
+		r0 = (r0 << 3) | (r0 >> 2); g0 = (g0 << 2) | (g0 >> 4); b0 = (b0 << 3) | (b0 >> 2);
+		r1 = (r1 << 3) | (r1 >> 2); g1 = (g1 << 2) | (g1 >> 4); b1 = (b1 << 3) | (b1 >> 2);
+
+		pal[0] = PackRGBA(r0, g0, b0, 255);
+		pal[1] = PackRGBA(r1, g1, b1, 255);
+
+		if(c0 > c1 || !allowPunchThrough)
+		{
+			pal[2] = PackRGBA((2*r0 + r1 + 1) / 3, (2*g0 + g1 + 1) / 3, (2*b0 + b1 + 1) / 3, 255);
+			pal[3] = PackRGBA((r0 + 2*r1 + 1) / 3, (g0 + 2*g1 + 1) / 3, (b0 + 2*b1 + 1) / 3, 255);
+		}
+		else
+		{
+			pal[2] = PackRGBA((r0 + r1 + 1) / 2, (g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2, 255);
+			pal[3] = 0;
+		}
+	}
+
+	void DecodeColor(const std::uint8_t* block, bool allowPunchThrough, std::uint8_t* dst, std::size_t dstRowPitch)
+	{
+		std::uint32_t pal[4];
+		ColorPalette(block, allowPunchThrough, pal);
+		std::uint32_t bits = Read32(block + 4);
+
+#if BC_DECODE_SSE2
+		const __m128i p0 = _mm_set1_epi32((int)pal[0]);
+		const __m128i p1 = _mm_set1_epi32((int)pal[1]);
+		const __m128i p2 = _mm_set1_epi32((int)pal[2]);
+		const __m128i p3 = _mm_set1_epi32((int)pal[3]);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		const __m128i three = _mm_set1_epi32(3);
+
+		// Each row is one byte of indices.  Multiplying it by 64, 16, 4, 1 lines
+		// texel i's two bits up at bit 6 of lane i.
+		const __m128i spread = _mm_setr_epi32(64, 16, 4, 1);
+
+		for(int row = 0; row < 4; ++row)
+		{
+			__m128i b = _mm_set1_epi32((int)((bits >> (8*row)) & 0xFF));
+			__m128i idx = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi16(b, spread), 6), three);
+
+			__m128i c = _mm_and_si128(_mm_cmpeq_epi32(idx, _mm_setzero_si128()), p0);
+			c = _mm_or_si128(c, _mm_and_si128(_mm_cmpeq_epi32(idx, one), p1));
+			c = _mm_or_si128(c, _mm_and_si128(_mm_cmpeq_epi32(idx, two), p2));
+			c = _mm_or_si128(c, _mm_and_si128(_mm_cmpeq_epi32(idx, three), p3));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + row*dstRowPitch), c);
+		}
+#else
+		for(int row = 0; row < 4; ++row)
+		{
+			std::uint32_t texels[4];
+			for(int x = 0; x < 4; ++x)
+				texels[x] = pal[(bits >> (2*(4*row + x))) & 3];
+			memcpy(dst + row*dstRowPitch, texels, sizeof(texels));
+		}
+#endif
+	}
+
+	//
+	// BC3/BC4/BC5 single channel half: two 8-bit endpoints and 3-bit indices.
+	//
+
+	void ChannelPalette(const std::uint8_t* block, bool isSigned, std::uint8_t pal[8])
+	{
+		int v[8];
+		int e0, e1, lo, hi;
+		if(isSigned)
+		{
+			// -128 and -127 both mean -1.
+			e0 = std::max(-127, (int)(std::int8_t)block[0]);
+			e1 = std::max(-127, (int)(std::int8_t)block[1]);
+			lo = -127;
+			hi = 127;
+		}
+		else
+		{
+			e0 = block[0];
+			e1 = block[1];
+			lo = 0;
+			hi = 255;
+		}
+
+		v[0] = e0;
+		v[1] = e1;
+		if(e0 > e1)
+		{
+			for(int i = 1; i < 7; ++i)
+				v[i + 1] = ((7 - i)*e0 + i*e1 + (((7 - i)*e0 + i*e1) >= 0 ? 3 : -3)) / 7;
+		}
+		else
+		{
+			for(int i = 1; i < 5; ++i)
+				v[i + 1] = ((5 - i)*e0 + i*e1 + (((5 - i)*e0 + i*e1) >= 0 ? 2 : -2)) / 5;
+			v[6] = lo;
+			v[7] = hi;
+		}
+
+		for(int i = 0; i < 8; ++i)
+			pal[i] = isSigned ? (std::uint8_t)(((v[i] + 127)*255 + 127) / 254) : (std::uint8_t)v[i];
+	}
+
+	// Decodes the 16 texels of one channel block in texel order.
+	void DecodeChannel(const std::uint8_t* block, bool isSigned, std::uint8_t out[16])
+	{
+		std::uint8_t pal[8];
+		ChannelPalette(block, isSigned, pal);
+
+		std::uint64_t bits = Read64(block) >> 16;
+		std::uint8_t idx[16];
+		for(int i = 0; i < 16; ++i)
+			idx[i] = (std::uint8_t)((bits >> (3*i)) & 7);
+
+#if BC_DECODE_SSE2
+		const __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx));
+		__m128i c = _mm_setzero_si128();
+		for(int k = 0; k < 8; ++k)
+		{
+			__m128i hit = _mm_cmpeq_epi8(indices, _mm_set1_epi8((char)k));
+			c = _mm_or_si128(c, _mm_and_si128(hit, _mm_set1_epi8((char)pal[k])));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), c);
+#else
+		for(int i = 0; i < 16; ++i)
+			out[i] = pal[idx[i]];
+#endif
+	}
+
+	// Replaces the alpha byte of the 16 texels at dst with alpha[].
+	void MergeAlpha(const std::uint8_t alpha[16], std::uint8_t* dst, std::size_t dstRowPitch)
+	{
+#if BC_DECODE_SSE2
+		const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i zero = _mm_setzero_si128();
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha));
+		for(int row = 0; row < 4; ++row)
+		{
+			// Widen 4 alpha bytes into the top byte of four 32-bit lanes.
+			__m128i a32 = _mm_unpacklo_epi16(zero, _mm_unpacklo_epi8(zero, a));
+			__m128i* p = reinterpret_cast<__m128i*>(dst + row*dstRowPitch);
+			_mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(_mm_loadu_si128(p), rgbMask), a32));
+			a = _mm_srli_si128(a, 4);
+		}
+#else
+		for(int row = 0; row < 4; ++row)
+		{
+			for(int x = 0; x < 4; ++x)
+				dst[row*dstRowPitch + 4*x + 3] = alpha[4*row + x];
+		}
+#endif
+	}
+
+	// Writes texels (r, g, blue, 255).
+	void StoreRG(const std::uint8_t r[16], const std::uint8_t g[16], std::uint8_t blue, std::uint8_t* dst, std::size_t dstRowPitch)
+	{
+#if BC_DECODE_SSE2
+		const __m128i ba = _mm_set1_epi16((short)(0xFF00 | blue));
+		__m128i rg = _mm_unpacklo_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(g)));
+		__m128i rgHi = _mm_unpackhi_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(g)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(rg, ba));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dstRowPitch), _mm_unpackhi_epi16(rg, ba));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2*dstRowPitch), _mm_unpacklo_epi16(rgHi, ba));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3*dstRowPitch), _mm_unpackhi_epi16(rgHi, ba));
+#else
+		for(int row = 0; row < 4; ++row)
+		{
+			for(int x = 0; x < 4; ++x)
+			{
+				std::uint8_t* t = dst + row*dstRowPitch + 4*x;
+				t[0] = r[4*row + x];
+				t[1] = g[4*row + x];
+				t[2] = blue;
+				t[3] = 255;
+			}
+		}
+#endif
+	}
+
+	//
+	// BC7.
+	//
+
+	struct BC7Mode
+	{
+		int Subsets;
+		int PartitionBits;
+		int RotationBits;
+		int IndexSelectionBits;
+		int ColorBits;
+		int AlphaBits;
+		int EndpointPBits;
+		int SharedPBits;
+		int IndexBits;
+		int Index2Bits;
+	};
+
+	const BC7Mode BC7Modes[8] =
+	{
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+	};
+
+	// Bit i set: texel i is in subset 1.
+	const std::uint16_t BC7Partition2[64] =
+	{
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+		0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+		0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+		0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+		0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+	};
+
+	const std::uint8_t BC7Partition3[64][16] =
+	{
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+		{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 },
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+		{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 },
+		{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+		{ 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+		{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 },
+		{ 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+		{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+		{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 },
+		{ 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+		{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 },
+		{ 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+		{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 },
+		{ 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+		{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 },
+		{ 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+		{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 },
+		{ 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 },
+		{ 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+		{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 },
+		{ 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 },
+		{ 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 },
+		{ 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 },
+		{ 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 },
+		{ 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+		{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 },
+		{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+		{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 },
+		{ 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 },
+		{ 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1 },
+		{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 },
+		{ 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 },
+	};
+
+	const std::uint8_t BC7Anchor2[64] =
+	{
+		15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15,
+		15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+		15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,
+		 6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15,
+	};
+
+	const std::uint8_t BC7Anchor3a[64] =
+	{
+		 3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,
+		 3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+		 8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,
+		 3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3,
+	};
+
+	const std::uint8_t BC7Anchor3b[64] =
+	{
+		15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8,
+		15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+		15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8,
+		15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8,
+	};
+
+	const std::uint8_t BC7Weights2[4] = { 0, 21, 43, 64 };
+	const std::uint8_t BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const std::uint8_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	class BitReader
+	{
+	public:
+		explicit BitReader(const std::uint8_t* block)
+		{
+			mLo = Read64(block);
+			mHi = Read64(block + 8);
+		}
+
+		std::uint32_t Read(int count)
+		{
+			std::uint32_t v = 0;
+			if(count > 0)
+			{
+				v = (std::uint32_t)(mLo & ((1ULL << count) - 1));
+				mLo = (mLo >> count) | (mHi << (64 - count));
+				mHi >>= count;
+			}
+			return v;
+		}
+
+	private:
+		std::uint64_t mLo;
+		std::uint64_t mHi;
+	};
+
+	const std::uint8_t* BC7WeightTable(int bits)
+	{
+		return bits == 2 ? BC7Weights2 : (bits == 3 ? BC7Weights3 : BC7Weights4);
+	}
+
+	int SubsetOf(int subsets, int partition, int texel)
+	{
+		if(subsets == 2)
+			return (BC7Partition2[partition] >> texel) & 1;
+		if(subsets == 3)
+			return BC7Partition3[partition][texel];
+		return 0;
+	}
+
+	bool IsAnchor(int subsets, int partition, int texel)
+	{
+		if(texel == 0)
+			return true;
+		if(subsets == 2)
+			return texel == BC7Anchor2[partition];
+		if(subsets == 3)
+			return texel == BC7Anchor3a[partition] || texel == BC7Anchor3b[partition];
+		return false;
+	}
+}
+
+void DecodeBC1Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch)
+{
+	DecodeColor(block, true, dst, dstRowPitch);
+}
+
+void DecodeBC2Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch)
+{
+	DecodeColor(block + 8, false, dst, dstRowPitch);
+
+	// Explicit 4-bit alpha, texel 0 in the low nibble of byte 0.
+	std::uint8_t alpha[16];
+#if BC_DECODE_SSE2
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	__m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+	__m128i lo = _mm_and_si128(v, nibble);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+	__m128i a = _mm_unpacklo_epi8(lo, hi);
+	a = _mm_or_si128(a, _mm_slli_epi16(a, 4));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(alpha), a);
+#else
+	for(int i = 0; i < 8; ++i)
+	{
+		alpha[2*i] = (std::uint8_t)((block[i] & 0x0F) * 17);
+		alpha[2*i + 1] = (std::uint8_t)((block[i] >> 4) * 17);
+	}
+#endif
+
+	MergeAlpha(alpha, dst, dstRowPitch);
+}
+
+void DecodeBC3Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch)
+{
+	DecodeColor(block + 8, false, dst, dstRowPitch);
+
+	std::uint8_t alpha[16];
+	DecodeChannel(block, false, alpha);
+	MergeAlpha(alpha, dst, dstRowPitch);
+}
+
+void DecodeBC4Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch, bool isSigned)
+{
+	static const std::uint8_t zero[16] = {};
+	static const std::uint8_t signedZero[16] = { 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128 };
+
+	std::uint8_t r[16];
+	DecodeChannel(block, isSigned, r);
+	StoreRG(r, isSigned ? signedZero : zero, isSigned ? 128 : 0, dst, dstRowPitch);
+}
+
+void DecodeBC5Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch, bool isSigned)
+{
+	std::uint8_t r[16];
+	std::uint8_t g[16];
+	DecodeChannel(block, isSigned, r);
+	DecodeChannel(block + 8, isSigned, g);
+	StoreRG(r, g, isSigned ? 128 : 0, dst, dstRowPitch);
+}
+
+void DecodeBC7Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch)
+{
+	int mode = 0;
+	while(mode < 8 && !(block[0] & (1 << mode)))
+		++mode;
+
+	if(mode == 8)
+	{
+		// Reserved encoding: transparent black.
+		for(int row = 0; row < 4; ++row)
+			memset(dst + row*dstRowPitch, 0, 16);
+		return;
+	}
+
+	const BC7Mode& m = BC7Modes[mode];
+	BitReader bits(block);
+	bits.Read(mode + 1);
+
+	int partition = (int)bits.Read(m.PartitionBits);
+	int rotation = (int)bits.Read(m.RotationBits);
+	int indexSelection = (int)bits.Read(m.IndexSelectionBits);
+
+	// Endpoints [subset*2 + end][channel], red of every endpoint first.
+	std::uint32_t ep[6][4] = {};
+	const int endpoints = m.Subsets * 2;
+	for(int c = 0; c < 3; ++c)
+	{
+		for(int e = 0; e < endpoints; ++e)
+			ep[e][c] = bits.Read(m.ColorBits);
+	}
+	for(int e = 0; e < endpoints; ++e)
+		ep[e][3] = bits.Read(m.AlphaBits);
+
+	int colorBits = m.ColorBits;
+	int alphaBits = m.AlphaBits;
+	if(m.EndpointPBits || m.SharedPBits)
+	{
+		std::uint32_t p[6];
+		for(int e = 0; e < endpoints; ++e)
+			p[e] = m.EndpointPBits ? bits.Read(1) : 0;
+		if(m.SharedPBits)
+		{
+			for(int s = 0; s < m.Subsets; ++s)
+				p[2*s] = p[2*s + 1] = bits.Read(1);
+		}
+
+		for(int e = 0; e < endpoints; ++e)
+		{
+			for(int c = 0; c < 3; ++c)
+				ep[e][c] = (ep[e][c] << 1) | p[e];
+			if(alphaBits)
+				ep[e][3] = (ep[e][3] << 1) | p[e];
+		}
+
+		++colorBits;
+		if(alphaBits)
+			++alphaBits;
+	}
+
+	// Expand to 8 bits by replicating the high bits.
+	for(int e = 0; e < endpoints; ++e)
+	{
+		for(int c = 0; c < 3; ++c)
+			ep[e][c] = (ep[e][c] << (8 - colorBits)) | (ep[e][c] >> (2*colorBits - 8));
+		ep[e][3] = alphaBits ? (ep[e][3] << (8 - alphaBits)) | (ep[e][3] >> (2*alphaBits - 8)) : 255;
+	}
+
+	std::uint32_t index[16];
+	for(int i = 0; i < 16; ++i)
+		index[i] = bits.Read(m.IndexBits - (IsAnchor(m.Subsets, partition, i) ? 1 : 0));
+
+	std::uint32_t index2[16] = {};
+	if(m.Index2Bits)
+	{
+		for(int i = 0; i < 16; ++i)
+			index2[i] = bits.Read(m.Index2Bits - (i == 0 ? 1 : 0));
+	}
+
+	// Mode 4 can swap which index set drives colour and which alpha.
+	const std::uint32_t* colorIndex = index;
+	const std::uint32_t* alphaIndex = m.Index2Bits ? index2 : index;
+	const std::uint8_t* colorWeights = BC7WeightTable(m.IndexBits);
+	const std::uint8_t* alphaWeights = BC7WeightTable(m.Index2Bits ? m.Index2Bits : m.IndexBits);
+	if(indexSelection)
+	{
+		std::swap(colorIndex, alphaIndex);
+		std::swap(colorWeights, alphaWeights);
+	}
+
+	for(int i = 0; i < 16; ++i)
+	{
+		int s = SubsetOf(m.Subsets, partition, i);
+		const std::uint32_t* e0 = ep[2*s];
+		const std::uint32_t* e1 = ep[2*s + 1];
+
+		std::uint32_t wc = colorWeights[colorIndex[i]];
+		std::uint32_t wa = alphaWeights[alphaIndex[i]];
+
+		std::uint32_t t[4];
+		for(int c = 0; c < 3; ++c)
+			t[c] = ((64 - wc)*e0[c] + wc*e1[c] + 32) >> 6;
+		t[3] = ((64 - wa)*e0[3] + wa*e1[3] + 32) >> 6;
+
+		if(rotation)
+			std::swap(t[3], t[rotation - 1]);
+
+		std::uint8_t* texel = dst + (i / 4)*dstRowPitch + (i % 4)*4;
+		for(int c = 0; c < 4; ++c)
+			texel[c] = (std::uint8_t)t[c];
+	}
+}
+
+bool IsDecodableBC(DXGI_FORMAT format)
+{
+	switch(format)
+	{
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+HRESULT DecodeBC(
+	DXGI_FORMAT format,
+	const DDS_SUBRESOURCE& src,
+	std::uint32_t width,
+	std::uint32_t height,
+	std::uint8_t* dst,
+	std::size_t dstRowPitch)
+{
+	if(src.pData == nullptr || dst == nullptr || dstRowPitch < (std::size_t)width*4)
+		return E_INVALIDARG;
+
+	if(!IsDecodableBC(format))
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	const std::size_t blockBytes = BitsPerPixel(format) * 2;
+	const std::uint32_t blocksWide = (width + 3) / 4;
+	const std::uint32_t blocksHigh = (height + 3) / 4;
+	if(src.rowPitch < (std::intptr_t)(blocksWide*blockBytes) ||
+		src.slicePitch < src.rowPitch*(std::intptr_t)blocksHigh)
+		return E_INVALIDARG;
+
+	const bool isSigned = format == DXGI_FORMAT_BC4_SNORM || format == DXGI_FORMAT_BC5_SNORM;
+
+	alignas(16) std::uint8_t edge[4*16];
+	for(std::uint32_t by = 0; by < blocksHigh; ++by)
+	{
+		const std::uint8_t* block = static_cast<const std::uint8_t*>(src.pData) + by*src.rowPitch;
+		for(std::uint32_t bx = 0; bx < blocksWide; ++bx, block += blockBytes)
+		{
+			const std::uint32_t x = bx*4;
+			const std::uint32_t y = by*4;
+			const bool inside = x + 4 <= width && y + 4 <= height;
+
+			// Whole blocks go straight to dst; edge blocks via a scratch block.
+			std::uint8_t* out = inside ? dst + y*dstRowPitch + x*4 : edge;
+			std::size_t pitch = inside ? dstRowPitch : 16;
+
+			switch(format)
+			{
+			case DXGI_FORMAT_BC1_TYPELESS:
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+				DecodeBC1Block(block, out, pitch);
+				break;
+
+			case DXGI_FORMAT_BC2_TYPELESS:
+			case DXGI_FORMAT_BC2_UNORM:
+			case DXGI_FORMAT_BC2_UNORM_SRGB:
+				DecodeBC2Block(block, out, pitch);
+				break;
+
+			case DXGI_FORMAT_BC3_TYPELESS:
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+				DecodeBC3Block(block, out, pitch);
+				break;
+
+			case DXGI_FORMAT_BC4_TYPELESS:
+			case DXGI_FORMAT_BC4_UNORM:
+			case DXGI_FORMAT_BC4_SNORM:
+				DecodeBC4Block(block, out, pitch, isSigned);
+				break;
+
+			case DXGI_FORMAT_BC5_TYPELESS:
+			case DXGI_FORMAT_BC5_UNORM:
+			case DXGI_FORMAT_BC5_SNORM:
+				DecodeBC5Block(block, out, pitch, isSigned);
+				break;
+
+			default:
+				DecodeBC7Block(block, out, pitch);
+				break;
+			}
+
+			if(!inside)
+			{
+				std::uint32_t w = std::min(4u, width - x);
+				std::uint32_t h = std::min(4u, height - y);
+				for(std::uint32_t row = 0; row < h; ++row)
+					memcpy(dst + (y + row)*dstRowPitch + x*4, edge + row*16, w*4);
+			}
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT DecodeBC(
+	const DDS_TEXTURE_DATA& data,
+	std::size_t index,
+	std::vector<std::uint8_t>& rgba,
+	std::uint32_t* width,
+	std::uint32_t* height)
+{
+	const DDS_TEXTURE_INFO& info = data.info;
+	if(index >= data.subresources.size() || info.mipCount == 0)
+		return E_INVALIDARG;
+
+	std::uint32_t mip = (std::uint32_t)(index % info.mipCount);
+	std::uint32_t w = std::max(1u, info.width >> mip);
+	std::uint32_t h = std::max(1u, info.height >> mip);
+
+	rgba.resize((std::size_t)w*h*4);
+	HRESULT hr = DecodeBC(info.format, data.subresources[index], w, h, rgba.data(), (std::size_t)w*4);
+	if(FAILED(hr))
+		return hr;
+
+	if(width)
+		*width = w;
+	if(height)
+		*height = h;
+
+	return S_OK;
+}
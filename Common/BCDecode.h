@@ -0,0 +1,55 @@
+//***************************************************************************************
+// BCDecode.h
+//
+// CPU decoders for the block-compressed formats the DDS loader hands to the GPU,
+// for thumbnails, image comparisons without a device and CPU-side alpha tests.
+// BC1-BC5 and BC7 decode to RGBA8; BC6H is HDR and is not handled.
+//
+// Texels are written as stored, so *_SRGB formats stay sRGB encoded.  BC4 and BC5
+// fill the missing channels as the GPU does (G = B = 0, A = 255).  Their SNORM
+// variants are remapped from [-1, 1] to [0, 255], so there the zeros read 128.
+//
+// Palette lookups and channel interleaving use SSE2 where available (all x64
+// targets); define BC_DECODE_NO_SIMD to build the scalar path.  BC7 is decoded
+// scalar since its bit fields vary per block.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DDSTextureData.h"
+
+// Block decoders.  Each reads one 8 or 16 byte block and writes its 4x4 texels as
+// four rows of 16 bytes, dstRowPitch apart.
+void DecodeBC1Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch);
+void DecodeBC2Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch);
+void DecodeBC3Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch);
+void DecodeBC4Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch, bool isSigned);
+void DecodeBC5Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch, bool isSigned);
+void DecodeBC7Block(const std::uint8_t* block, std::uint8_t* dst, std::size_t dstRowPitch);
+
+// True for the formats DecodeBC accepts.
+bool IsDecodableBC(DXGI_FORMAT format);
+
+// Decodes a width x height surface (one mip of one slice) to RGBA8.  dst must hold
+// height rows of dstRowPitch bytes, dstRowPitch >= width*4.  Blocks that overhang
+// the surface edge are clipped.
+HRESULT DecodeBC(
+	DXGI_FORMAT format,
+	const DirectX::DDS_SUBRESOURCE& src,
+	std::uint32_t width,
+	std::uint32_t height,
+	std::uint8_t* dst,
+	std::size_t dstRowPitch);
+
+// Decodes subresource index of a loaded texture (mip index % mipCount of slice
+// index / mipCount) into a tightly packed RGBA8 image.  Volume textures give their
+// first depth slice.
+HRESULT DecodeBC(
+	const DirectX::DDS_TEXTURE_DATA& data,
+	std::size_t index,
+	std::vector<std::uint8_t>& rgba,
+	std::uint32_t* width,
+	std::uint32_t* height);
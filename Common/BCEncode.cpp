@@ -0,0 +1,721 @@
+//***************************************************************************************
+// BCEncode.cpp
+//
+// The palettes are rebuilt here with exactly the arithmetic BCDecode uses, so index
+// selection sees the colours the decoder will produce.
+//***************************************************************************************
+
+#include "BCEncode.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	typedef std::uint8_t Block4x4[16][4];
+
+	void Gather(const std::uint8_t* rgba, std::size_t rowPitch, Block4x4 tex)
+	{
+		for(int row = 0; row < 4; ++row)
+			memcpy(tex[4*row], rgba + row*rowPitch, 16);
+	}
+
+	template<typename T>
+	T Clamp(T v, T lo, T hi)
+	{
+		return v < lo ? lo : (v > hi ? hi : v);
+	}
+
+	//
+	// Endpoint fitting shared by the colour and BC7 encoders.
+	//
+
+	// Fits a line through the texels selected by mask (dims channels) along their
+	// principal axis and returns its extent over the texels, clamped to [0, 255].
+	void FitLine(const Block4x4 tex, const bool mask[16], int dims, float lo[4], float hi[4])
+	{
+		float mean[4] = {};
+		int count = 0;
+		for(int i = 0; i < 16; ++i)
+		{
+			if(!mask[i])
+				continue;
+			for(int c = 0; c < dims; ++c)
+				mean[c] += tex[i][c];
+			++count;
+		}
+		for(int c = 0; c < dims; ++c)
+			mean[c] /= std::max(1, count);
+
+		float cov[4][4] = {};
+		for(int i = 0; i < 16; ++i)
+		{
+			if(!mask[i])
+				continue;
+			float d[4];
+			for(int c = 0; c < dims; ++c)
+				d[c] = tex[i][c] - mean[c];
+			for(int r = 0; r < dims; ++r)
+			{
+				for(int c = 0; c < dims; ++c)
+					cov[r][c] += d[r]*d[c];
+			}
+		}
+
+		// Power iteration from the channel with the largest spread.
+		int start = 0;
+		for(int c = 1; c < dims; ++c)
+		{
+			if(cov[c][c] > cov[start][start])
+				start = c;
+		}
+
+		float axis[4] = {};
+		for(int c = 0; c < dims; ++c)
+			axis[c] = cov[start][c];
+
+		for(int iter = 0; iter < 8; ++iter)
+		{
+			float next[4] = {};
+			float len = 0.0f;
+			for(int r = 0; r < dims; ++r)
+			{
+				for(int c = 0; c < dims; ++c)
+					next[r] += cov[r][c]*axis[c];
+				len += next[r]*next[r];
+			}
+
+			if(len < 1e-12f)
+				break;
+
+			len = 1.0f / std::sqrt(len);
+			for(int c = 0; c < dims; ++c)
+				axis[c] = next[c]*len;
+		}
+
+		float axisLen = 0.0f;
+		for(int c = 0; c < dims; ++c)
+			axisLen += axis[c]*axis[c];
+		if(axisLen < 1e-12f)
+		{
+			// Flat block: both ends at the mean.
+			for(int c = 0; c < dims; ++c)
+				lo[c] = hi[c] = mean[c];
+			return;
+		}
+		axisLen = 1.0f / std::sqrt(axisLen);
+		for(int c = 0; c < dims; ++c)
+			axis[c] *= axisLen;
+
+		float tmin = 0.0f;
+		float tmax = 0.0f;
+		for(int i = 0; i < 16; ++i)
+		{
+			if(!mask[i])
+				continue;
+			float t = 0.0f;
+			for(int c = 0; c < dims; ++c)
+				t += (tex[i][c] - mean[c])*axis[c];
+			tmin = std::min(tmin, t);
+			tmax = std::max(tmax, t);
+		}
+
+		for(int c = 0; c < dims; ++c)
+		{
+			lo[c] = Clamp(mean[c] + tmin*axis[c], 0.0f, 255.0f);
+			hi[c] = Clamp(mean[c] + tmax*axis[c], 0.0f, 255.0f);
+		}
+	}
+
+	// Least-squares endpoints for texels already assigned line positions t in [0, 1]
+	// (t < 0 skips a texel).  Returns false if the system is singular.
+	bool SolveEndpoints(const Block4x4 tex, const float t[16], int dims, float e0[4], float e1[4])
+	{
+		float a = 0.0f, b = 0.0f, c = 0.0f;
+		float x0[4] = {};
+		float x1[4] = {};
+		for(int i = 0; i < 16; ++i)
+		{
+			if(t[i] < 0.0f)
+				continue;
+			float s = 1.0f - t[i];
+			a += s*s;
+			b += s*t[i];
+			c += t[i]*t[i];
+			for(int k = 0; k < dims; ++k)
+			{
+				x0[k] += s*tex[i][k];
+				x1[k] += t[i]*tex[i][k];
+			}
+		}
+
+		float det = a*c - b*b;
+		if(std::fabs(det) < 1e-6f)
+			return false;
+
+		det = 1.0f / det;
+		for(int k = 0; k < dims; ++k)
+		{
+			e0[k] = Clamp((c*x0[k] - b*x1[k])*det, 0.0f, 255.0f);
+			e1[k] = Clamp((a*x1[k] - b*x0[k])*det, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	//
+	// BC1 colour half.
+	//
+
+	std::uint16_t To565(const float c[4])
+	{
+		int r = (int)(c[0]*31.0f/255.0f + 0.5f);
+		int g = (int)(c[1]*63.0f/255.0f + 0.5f);
+		int b = (int)(c[2]*31.0f/255.0f + 0.5f);
+		return (std::uint16_t)((Clamp(r, 0, 31) << 11) | (Clamp(g, 0, 63) << 5) | Clamp(b, 0, 31));
+	}
+
+	// Same palette as BCDecode's ColorPalette.  Returns the number of colour entries
+	// (3 when the fourth is transparent black).
+	int ColorPalette(std::uint16_t c0, std::uint16_t c1, bool allowPunchThrough, int pal[4][3])
+	{
+		int e[2][3];
+		const std::uint16_t ends[2] = { c0, c1 };
+		for(int k = 0; k < 2; ++k)
+		{
+			int r = (ends[k] >> 11) & 31, g = (ends[k] >> 5) & 63, b = ends[k] & 31;
+			e[k][0] = (r << 3) | (r >> 2);
+			e[k][1] = (g << 2) | (g >> 4);
+			e[k][2] = (b << 3) | (b >> 2);
+		}
+
+		for(int c = 0; c < 3; ++c)
+		{
+			pal[0][c] = e[0][c];
+			pal[1][c] = e[1][c];
+		}
+
+		if(c0 > c1 || !allowPunchThrough)
+		{
+			for(int c = 0; c < 3; ++c)
+			{
+				pal[2][c] = (2*e[0][c] + e[1][c] + 1) / 3;
+				pal[3][c] = (e[0][c] + 2*e[1][c] + 1) / 3;
+			}
+			return 4;
+		}
+
+		for(int c = 0; c < 3; ++c)
+		{
+			pal[2][c] = (e[0][c] + e[1][c] + 1) / 2;
+			pal[3][c] = 0;
+		}
+		return 3;
+	}
+
+	struct ColorFit
+	{
+		std::uint16_t C0;
+		std::uint16_t C1;
+		std::uint32_t Indices;
+		int Error;
+		int Colors;
+	};
+
+	// Orders the endpoints for the mode wanted and picks the nearest palette entry
+	// for every opaque texel; masked-out texels take the transparent entry.
+	ColorFit EvaluateColor(const Block4x4 tex, const bool mask[16], bool allowPunchThrough,
+		bool threeColor, std::uint16_t c0, std::uint16_t c1)
+	{
+		if(allowPunchThrough && ((threeColor && c0 > c1) || (!threeColor && c0 < c1)))
+			std::swap(c0, c1);
+
+		ColorFit fit = { c0, c1, 0, 0, 0 };
+		int pal[4][3];
+		fit.Colors = ColorPalette(c0, c1, allowPunchThrough, pal);
+
+		for(int i = 0; i < 16; ++i)
+		{
+			int best = 3;
+			if(mask[i])
+			{
+				int bestErr = 1 << 30;
+				for(int k = 0; k < fit.Colors; ++k)
+				{
+					int dr = tex[i][0] - pal[k][0];
+					int dg = tex[i][1] - pal[k][1];
+					int db = tex[i][2] - pal[k][2];
+					int err = dr*dr + dg*dg + db*db;
+					if(err < bestErr)
+					{
+						bestErr = err;
+						best = k;
+					}
+				}
+				fit.Error += bestErr;
+			}
+			fit.Indices |= (std::uint32_t)best << (2*i);
+		}
+
+		return fit;
+	}
+
+	void EncodeColor(const Block4x4 tex, bool allowPunchThrough, std::uint8_t* block)
+	{
+		bool mask[16];
+		int opaque = 0;
+		for(int i = 0; i < 16; ++i)
+		{
+			mask[i] = !allowPunchThrough || tex[i][3] >= 128;
+			opaque += mask[i] ? 1 : 0;
+		}
+
+		if(opaque == 0)
+		{
+			// Three colour mode with every texel transparent.
+			const std::uint8_t clear[8] = { 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+			memcpy(block, clear, 8);
+			return;
+		}
+
+		const bool threeColor = opaque < 16;
+
+		float lo[4], hi[4];
+		FitLine(tex, mask, 3, lo, hi);
+		ColorFit best = EvaluateColor(tex, mask, allowPunchThrough, threeColor, To565(hi), To565(lo));
+
+		// Refit the endpoints to the chosen indices.
+		for(int iter = 0; iter < 2 && best.Error > 0; ++iter)
+		{
+			static const float FourColorT[4] = { 0.0f, 1.0f, 1.0f/3.0f, 2.0f/3.0f };
+			static const float ThreeColorT[4] = { 0.0f, 1.0f, 0.5f, -1.0f };
+			const float* table = best.Colors == 4 ? FourColorT : ThreeColorT;
+
+			float t[16];
+			for(int i = 0; i < 16; ++i)
+				t[i] = mask[i] ? table[(best.Indices >> (2*i)) & 3] : -1.0f;
+
+			float e0[4], e1[4];
+			if(!SolveEndpoints(tex, t, 3, e0, e1))
+				break;
+
+			ColorFit fit = EvaluateColor(tex, mask, allowPunchThrough, threeColor, To565(e0), To565(e1));
+			if(fit.Error >= best.Error)
+				break;
+			best = fit;
+		}
+
+		block[0] = (std::uint8_t)(best.C0 & 0xFF);
+		block[1] = (std::uint8_t)(best.C0 >> 8);
+		block[2] = (std::uint8_t)(best.C1 & 0xFF);
+		block[3] = (std::uint8_t)(best.C1 >> 8);
+		memcpy(block + 4, &best.Indices, 4);
+	}
+
+	//
+	// BC4-style single channel block.
+	//
+
+	void ChannelPalette(int e0, int e1, int pal[8])
+	{
+		pal[0] = e0;
+		pal[1] = e1;
+		if(e0 > e1)
+		{
+			for(int i = 1; i < 7; ++i)
+				pal[i + 1] = ((7 - i)*e0 + i*e1 + 3) / 7;
+		}
+		else
+		{
+			for(int i = 1; i < 5; ++i)
+				pal[i + 1] = ((5 - i)*e0 + i*e1 + 2) / 5;
+			pal[6] = 0;
+			pal[7] = 255;
+		}
+	}
+
+	int ChannelIndices(const int v[16], int e0, int e1, std::uint64_t& bits)
+	{
+		int pal[8];
+		ChannelPalette(e0, e1, pal);
+
+		bits = 0;
+		int total = 0;
+		for(int i = 0; i < 16; ++i)
+		{
+			int best = 0;
+			int bestErr = 1 << 30;
+			for(int k = 0; k < 8; ++k)
+			{
+				int err = (v[i] - pal[k])*(v[i] - pal[k]);
+				if(err < bestErr)
+				{
+					bestErr = err;
+					best = k;
+				}
+			}
+			total += bestErr;
+			bits |= (std::uint64_t)best << (3*i);
+		}
+		return total;
+	}
+
+	void EncodeChannel(const Block4x4 tex, int channel, std::uint8_t* block)
+	{
+		int v[16];
+		int lo = 255, hi = 0;
+		int innerLo = 255, innerHi = 0;
+		for(int i = 0; i < 16; ++i)
+		{
+			v[i] = tex[i][channel];
+			lo = std::min(lo, v[i]);
+			hi = std::max(hi, v[i]);
+			if(v[i] != 0 && v[i] != 255)
+			{
+				innerLo = std::min(innerLo, v[i]);
+				innerHi = std::max(innerHi, v[i]);
+			}
+		}
+
+		// Eight interpolated values between the extremes...
+		std::uint64_t bits = 0;
+		int e0 = hi, e1 = lo;
+		int err = ChannelIndices(v, e0, e1, bits);
+
+		// ...or six between the inner values, with exact 0 and 255 available.
+		if(err > 0 && (lo == 0 || hi == 255))
+		{
+			if(innerLo > innerHi)
+				innerLo = innerHi = lo;
+
+			std::uint64_t bits6 = 0;
+			int err6 = ChannelIndices(v, innerLo, innerHi, bits6);
+			if(err6 < err)
+			{
+				e0 = innerLo;
+				e1 = innerHi;
+				bits = bits6;
+			}
+		}
+
+		block[0] = (std::uint8_t)e0;
+		block[1] = (std::uint8_t)e1;
+		for(int i = 0; i < 6; ++i)
+			block[2 + i] = (std::uint8_t)(bits >> (8*i));
+	}
+
+	//
+	// BC7 mode 6.
+	//
+
+	const int BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Fit
+	{
+		int Q[2][4];      // 7-bit endpoint values.
+		int P[2];         // Per-endpoint p-bits.
+		int Index[16];
+		int Error;
+	};
+
+	// Picks the 7-bit value and p-bit for one endpoint, nearest in all channels.
+	void QuantizeBC7Endpoint(const float e[4], int q[4], int& p)
+	{
+		int bestErr = 1 << 30;
+		for(int pbit = 0; pbit < 2; ++pbit)
+		{
+			int cand[4];
+			float err = 0.0f;
+			for(int c = 0; c < 4; ++c)
+			{
+				cand[c] = Clamp((int)std::floor((e[c] - pbit)*0.5f + 0.5f), 0, 127);
+				float d = (float)(2*cand[c] + pbit) - e[c];
+				err += d*d;
+			}
+			if((int)err < bestErr)
+			{
+				bestErr = (int)err;
+				p = pbit;
+				memcpy(q, cand, sizeof(cand));
+			}
+		}
+	}
+
+	void EvaluateBC7(const Block4x4 tex, BC7Fit& fit)
+	{
+		int e[2][4];
+		for(int k = 0; k < 2; ++k)
+		{
+			for(int c = 0; c < 4; ++c)
+				e[k][c] = 2*fit.Q[k][c] + fit.P[k];
+		}
+
+		int pal[16][4];
+		for(int w = 0; w < 16; ++w)
+		{
+			for(int c = 0; c < 4; ++c)
+				pal[w][c] = ((64 - BC7Weights4[w])*e[0][c] + BC7Weights4[w]*e[1][c] + 32) >> 6;
+		}
+
+		fit.Error = 0;
+		for(int i = 0; i < 16; ++i)
+		{
+			int best = 0;
+			int bestErr = 1 << 30;
+			for(int w = 0; w < 16; ++w)
+			{
+				int err = 0;
+				for(int c = 0; c < 4; ++c)
+					err += (tex[i][c] - pal[w][c])*(tex[i][c] - pal[w][c]);
+				if(err < bestErr)
+				{
+					bestErr = err;
+					best = w;
+				}
+			}
+			fit.Index[i] = best;
+			fit.Error += bestErr;
+		}
+	}
+
+	class BitWriter
+	{
+	public:
+		void Write(std::uint32_t value, int count)
+		{
+			std::uint64_t v = value & ((1ULL << count) - 1);
+			if(mPos < 64)
+			{
+				mLo |= v << mPos;
+				if(mPos + count > 64)
+					mHi |= v >> (64 - mPos);
+			}
+			else
+			{
+				mHi |= v << (mPos - 64);
+			}
+			mPos += count;
+		}
+
+		void Store(std::uint8_t* block)const
+		{
+			memcpy(block, &mLo, 8);
+			memcpy(block + 8, &mHi, 8);
+		}
+
+	private:
+		std::uint64_t mLo = 0;
+		std::uint64_t mHi = 0;
+		int mPos = 0;
+	};
+}
+
+void EncodeBC1Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block)
+{
+	Block4x4 tex;
+	Gather(rgba, rowPitch, tex);
+	EncodeColor(tex, true, block);
+}
+
+void EncodeBC3Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block)
+{
+	Block4x4 tex;
+	Gather(rgba, rowPitch, tex);
+	EncodeChannel(tex, 3, block);
+	EncodeColor(tex, false, block + 8);
+}
+
+void EncodeBC4Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block)
+{
+	Block4x4 tex;
+	Gather(rgba, rowPitch, tex);
+	EncodeChannel(tex, 0, block);
+}
+
+void EncodeBC5Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block)
+{
+	Block4x4 tex;
+	Gather(rgba, rowPitch, tex);
+	EncodeChannel(tex, 0, block);
+	EncodeChannel(tex, 1, block + 8);
+}
+
+void EncodeBC7Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block)
+{
+	Block4x4 tex;
+	Gather(rgba, rowPitch, tex);
+
+	bool all[16];
+	std::fill(all, all + 16, true);
+
+	float lo[4], hi[4];
+	FitLine(tex, all, 4, lo, hi);
+
+	BC7Fit best;
+	QuantizeBC7Endpoint(lo, best.Q[0], best.P[0]);
+	QuantizeBC7Endpoint(hi, best.Q[1], best.P[1]);
+	EvaluateBC7(tex, best);
+
+	for(int iter = 0; iter < 2 && best.Error > 0; ++iter)
+	{
+		float t[16];
+		for(int i = 0; i < 16; ++i)
+			t[i] = BC7Weights4[best.Index[i]] / 64.0f;
+
+		float e0[4], e1[4];
+		if(!SolveEndpoints(tex, t, 4, e0, e1))
+			break;
+
+		BC7Fit fit;
+		QuantizeBC7Endpoint(e0, fit.Q[0], fit.P[0]);
+		QuantizeBC7Endpoint(e1, fit.Q[1], fit.P[1]);
+		EvaluateBC7(tex, fit);
+		if(fit.Error >= best.Error)
+			break;
+		best = fit;
+	}
+
+	// Texel 0 is the anchor and stores its index without the top bit, so that bit
+	// must be clear: swap the endpoints and mirror the indices if it is not.
+	if(best.Index[0] & 8)
+	{
+		for(int c = 0; c < 4; ++c)
+			std::swap(best.Q[0][c], best.Q[1][c]);
+		std::swap(best.P[0], best.P[1]);
+		for(int i = 0; i < 16; ++i)
+			best.Index[i] = 15 - best.Index[i];
+	}
+
+	BitWriter bits;
+	bits.Write(1 << 6, 7);
+	for(int c = 0; c < 4; ++c)
+	{
+		bits.Write(best.Q[0][c], 7);
+		bits.Write(best.Q[1][c], 7);
+	}
+	bits.Write(best.P[0], 1);
+	bits.Write(best.P[1], 1);
+	for(int i = 0; i < 16; ++i)
+		bits.Write(best.Index[i], i == 0 ? 3 : 4);
+
+	bits.Store(block);
+}
+
+bool IsEncodableBC(DXGI_FORMAT format)
+{
+	switch(format)
+	{
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+HRESULT EncodeBC(
+	DXGI_FORMAT format,
+	const std::uint8_t* rgba,
+	std::uint32_t width,
+	std::uint32_t height,
+	std::size_t rowPitch,
+	std::uint8_t* dst,
+	std::size_t dstRowPitch,
+	ThreadPool* pool)
+{
+	if(rgba == nullptr || dst == nullptr || width == 0 || height == 0 || rowPitch < (std::size_t)width*4)
+		return E_INVALIDARG;
+
+	void (*encode)(const std::uint8_t*, std::size_t, std::uint8_t*) = nullptr;
+	switch(format)
+	{
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		encode = EncodeBC1Block;
+		break;
+
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+		encode = EncodeBC3Block;
+		break;
+
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+		encode = EncodeBC4Block;
+		break;
+
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+		encode = EncodeBC5Block;
+		break;
+
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		encode = EncodeBC7Block;
+		break;
+
+	default:
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	}
+
+	const std::size_t blockBytes = BitsPerPixel(format) * 2;
+	const std::uint32_t blocksWide = (width + 3) / 4;
+	const std::uint32_t blocksHigh = (height + 3) / 4;
+	if(dstRowPitch < blocksWide*blockBytes)
+		return E_INVALIDARG;
+
+	auto encodeRow = [&](std::size_t by)
+	{
+		std::uint8_t* out = dst + by*dstRowPitch;
+		for(std::uint32_t bx = 0; bx < blocksWide; ++bx, out += blockBytes)
+		{
+			const std::uint32_t x = bx*4;
+			const std::uint32_t y = (std::uint32_t)by*4;
+			if(x + 4 <= width && y + 4 <= height)
+			{
+				encode(rgba + y*rowPitch + x*4, rowPitch, out);
+				continue;
+			}
+
+			// Edge block: repeat the last row and column.
+			std::uint8_t edge[4*16];
+			for(std::uint32_t row = 0; row < 4; ++row)
+			{
+				std::uint32_t sy = std::min(y + row, height - 1);
+				for(std::uint32_t col = 0; col < 4; ++col)
+				{
+					std::uint32_t sx = std::min(x + col, width - 1);
+					memcpy(edge + row*16 + col*4, rgba + sy*rowPitch + sx*4, 4);
+				}
+			}
+			encode(edge, 16, out);
+		}
+	};
+
+	if(pool != nullptr)
+		pool->ParallelFor(blocksHigh, encodeRow);
+	else
+	{
+		for(std::uint32_t by = 0; by < blocksHigh; ++by)
+			encodeRow(by);
+	}
+
+	return S_OK;
+}
@@ -0,0 +1,45 @@
+//***************************************************************************************
+// BCEncode.h
+//
+// CPU encoders for BC1, BC3, BC4, BC5 and BC7, used by the offline texture tools.
+// They read RGBA8 and produce blocks BCDecode and the GPU read back.
+//
+// Colour endpoints come from the principal axis of the block's texels and are then
+// refined by least squares against the chosen indices.  BC1 switches to its three
+// colour mode for blocks with texels below alpha 128, so cutouts survive.  BC7 uses
+// mode 6 only (one subset, RGBA, 4-bit indices): it is the simplest mode that
+// handles every block, at the cost of quality on blocks with two distinct colours.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "DDSFormat.h"
+
+class ThreadPool;
+
+// Block encoders.  Each reads the 4x4 texels at rgba (rows rowPitch bytes apart) and
+// writes one 8 or 16 byte block.  BC4 encodes red; BC5 red and green.
+void EncodeBC1Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block);
+void EncodeBC3Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block);
+void EncodeBC4Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block);
+void EncodeBC5Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block);
+void EncodeBC7Block(const std::uint8_t* rgba, std::size_t rowPitch, std::uint8_t* block);
+
+// True for the formats EncodeBC produces (the UNORM, UNORM_SRGB and TYPELESS
+// variants of BC1, BC3, BC4, BC5 and BC7).
+bool IsEncodableBC(DXGI_FORMAT format);
+
+// Encodes a width x height RGBA8 surface.  dst receives rows of blocks dstRowPitch
+// apart (GetSurfaceInfo's rowBytes when tightly packed).  Partial edge blocks repeat
+// the last row and column.  With a pool, block rows are encoded in parallel.
+HRESULT EncodeBC(
+	DXGI_FORMAT format,
+	const std::uint8_t* rgba,
+	std::uint32_t width,
+	std::uint32_t height,
+	std::size_t rowPitch,
+	std::uint8_t* dst,
+	std::size_t dstRowPitch,
+	ThreadPool* pool = nullptr);
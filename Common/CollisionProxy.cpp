@@ -0,0 +1,141 @@
+//***************************************************************************************
+// CollisionProxy.cpp
+//***************************************************************************************
+
+#include "CollisionProxy.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+const XMFLOAT3 BoundingKDop::Axes[BoundingKDop::AxisCount] =
+{
+	XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f),
+
+	XMFLOAT3(1.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, -1.0f, 0.0f),
+	XMFLOAT3(1.0f, 0.0f, 1.0f), XMFLOAT3(1.0f, 0.0f, -1.0f),
+	XMFLOAT3(0.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 1.0f, -1.0f),
+
+	XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(1.0f, 1.0f, -1.0f),
+	XMFLOAT3(1.0f, -1.0f, 1.0f), XMFLOAT3(1.0f, -1.0f, -1.0f)
+};
+
+namespace
+{
+	void BuildKDop(const XMFLOAT3* pts, size_t count, size_t stride, BoundingKDop& kdop)
+	{
+		for(int a = 0; a < BoundingKDop::AxisCount; ++a)
+		{
+			kdop.Min[a] = +FLT_MAX;
+			kdop.Max[a] = -FLT_MAX;
+		}
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			const XMFLOAT3& p = *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const std::uint8_t*>(pts) + i*stride);
+			for(int a = 0; a < BoundingKDop::AxisCount; ++a)
+			{
+				const XMFLOAT3& n = BoundingKDop::Axes[a];
+				float d = n.x*p.x + n.y*p.y + n.z*p.z;
+				kdop.Min[a] = std::min(kdop.Min[a], d);
+				kdop.Max[a] = std::max(kdop.Max[a], d);
+			}
+		}
+	}
+
+	// Fits a capsule along the longest axis of the oriented box.  The radius is the
+	// widest point from that axis; each end of the segment is pulled in as far as
+	// possible while its cap still contains every point.
+	void BuildCapsule(const XMFLOAT3* pts, size_t count, size_t stride,
+		const BoundingOrientedBox& obb, BoundingCapsule& capsule)
+	{
+		XMVECTOR q = XMLoadFloat4(&obb.Orientation);
+		XMVECTOR center = XMLoadFloat3(&obb.Center);
+
+		const float* ext = &obb.Extents.x;
+		int longest = 0;
+		if(ext[1] > ext[longest]) longest = 1;
+		if(ext[2] > ext[longest]) longest = 2;
+
+		XMVECTOR localAxis = XMVectorSet(longest == 0 ? 1.0f : 0.0f, longest == 1 ? 1.0f : 0.0f, longest == 2 ? 1.0f : 0.0f, 0.0f);
+		XMVECTOR axis = XMVector3Rotate(localAxis, q);
+
+		float radiusSq = 0.0f;
+		for(size_t i = 0; i < count; ++i)
+		{
+			XMVECTOR v = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const std::uint8_t*>(pts) + i*stride)) - center;
+			float s = XMVectorGetX(XMVector3Dot(v, axis));
+			float distSq = XMVectorGetX(XMVector3LengthSq(v - s*axis));
+			radiusSq = std::max(radiusSq, distSq);
+		}
+
+		float radius = sqrtf(radiusSq);
+		float lo = +FLT_MAX;
+		float hi = -FLT_MAX;
+		for(size_t i = 0; i < count; ++i)
+		{
+			XMVECTOR v = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const std::uint8_t*>(pts) + i*stride)) - center;
+			float s = XMVectorGetX(XMVector3Dot(v, axis));
+			float distSq = XMVectorGetX(XMVector3LengthSq(v - s*axis));
+			float reach = sqrtf(std::max(0.0f, radiusSq - distSq));
+
+			hi = std::max(hi, s - reach);
+			lo = std::min(lo, s + reach);
+		}
+
+		// Round shapes need no segment at all.
+		if(lo > hi)
+			lo = hi = 0.5f*(lo + hi);
+
+		XMStoreFloat3(&capsule.P0, center + lo*axis);
+		XMStoreFloat3(&capsule.P1, center + hi*axis);
+		capsule.Radius = radius;
+	}
+}
+
+std::shared_ptr<const CollisionProxy> CollisionProxy::Build(const GeometryGenerator::MeshData& meshData)
+{
+	auto proxy = std::make_shared<CollisionProxy>();
+
+	if(meshData.Vertices.empty())
+		return proxy;
+
+	const XMFLOAT3* pts = &meshData.Vertices[0].Position;
+	size_t count = meshData.Vertices.size();
+	size_t stride = sizeof(GeometryGenerator::Vertex);
+
+	proxy->Hull.Build(pts, count, stride);
+
+	// Every proxy is bounded by the hull, so fit them to its (usually far fewer)
+	// vertices when there is one.
+	if(!proxy->Hull.Empty())
+	{
+		pts = proxy->Hull.Vertices.data();
+		count = proxy->Hull.Vertices.size();
+		stride = sizeof(XMFLOAT3);
+	}
+
+	BoundingBox::CreateFromPoints(proxy->Aabb, count, pts, stride);
+	BoundingOrientedBox::CreateFromPoints(proxy->Obb, count, pts, stride);
+	BuildCapsule(pts, count, stride, proxy->Obb, proxy->Capsule);
+	BuildKDop(pts, count, stride, proxy->KDop);
+
+	return proxy;
+}
+
+std::vector<std::shared_ptr<const CollisionProxy>> CollisionProxy::BuildAll(
+	ThreadPool& pool,
+	const std::vector<const GeometryGenerator::MeshData*>& meshes)
+{
+	std::vector<std::shared_ptr<const CollisionProxy>> proxies(meshes.size());
+
+	pool.ParallelFor(meshes.size(), [&](size_t i)
+	{
+		if(meshes[i] != nullptr)
+			proxies[i] = Build(*meshes[i]);
+	});
+
+	return proxies;
+}
@@ -0,0 +1,62 @@
+//***************************************************************************************
+// CollisionProxy.h
+//
+// Simplified collision shapes computed from a GeometryGenerator::MeshData.  Physics
+// and culling code tests against these instead of the render triangles.  Proxies are
+// immutable once built and are shared between the submeshes that use them.
+//***************************************************************************************
+
+#pragma once
+
+#include <DirectXCollision.h>
+#include <memory>
+#include <vector>
+#include "ConvexHull.h"
+#include "GeometryGenerator.h"
+
+class ThreadPool;
+
+// Line segment P0-P1 swept by a sphere of the given radius.
+struct BoundingCapsule
+{
+	DirectX::XMFLOAT3 P0 = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 P1 = { 0.0f, 0.0f, 0.0f };
+	float Radius = 0.0f;
+};
+
+// 26-DOP: the slab [Min[i], Max[i]] along each of the 13 directions in Axes
+// (3 coordinate axes, 6 edge diagonals and 4 corner diagonals).  The directions
+// are not normalized, so the slabs are in units of the axis length.
+struct BoundingKDop
+{
+	static const int AxisCount = 13;
+	static const DirectX::XMFLOAT3 Axes[AxisCount];
+
+	float Min[AxisCount];
+	float Max[AxisCount];
+};
+
+struct CollisionProxy
+{
+	DirectX::BoundingBox Aabb;
+	DirectX::BoundingOrientedBox Obb;
+	BoundingCapsule Capsule;
+	BoundingKDop KDop;
+
+	// Empty if the mesh is flat (grids, quads), in which case the other
+	// proxies are built from the mesh vertices directly.
+	ConvexHull Hull;
+
+	///<summary>
+	/// Computes every proxy for one mesh.
+	///</summary>
+	static std::shared_ptr<const CollisionProxy> Build(const GeometryGenerator::MeshData& meshData);
+
+	///<summary>
+	/// Computes the proxies of a whole scene across the pool.  The result is
+	/// parallel to meshes.
+	///</summary>
+	static std::vector<std::shared_ptr<const CollisionProxy>> BuildAll(
+		ThreadPool& pool,
+		const std::vector<const GeometryGenerator::MeshData*>& meshes);
+};
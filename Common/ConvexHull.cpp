@@ -0,0 +1,346 @@
+//***************************************************************************************
+// ConvexHull.cpp
+//***************************************************************************************
+
+#include "ConvexHull.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+	struct HullFace
+	{
+		std::uint32_t V[3];
+
+		// Neighbor[e] shares the edge V[e] -> V[(e+1)%3] (in the opposite direction).
+		size_t Neighbor[3];
+
+		XMFLOAT3 Normal;
+		float Offset;
+		std::vector<std::uint32_t> Outside;
+		bool Alive = true;
+		std::uint32_t VisitTag = 0;
+	};
+
+	float PlaneDistance(const HullFace& f, const XMFLOAT3& p)
+	{
+		return f.Normal.x*p.x + f.Normal.y*p.y + f.Normal.z*p.z - f.Offset;
+	}
+
+	HullFace MakeFace(const std::vector<XMFLOAT3>& pts, std::uint32_t a, std::uint32_t b, std::uint32_t c)
+	{
+		HullFace f;
+		f.V[0] = a;
+		f.V[1] = b;
+		f.V[2] = c;
+		f.Neighbor[0] = f.Neighbor[1] = f.Neighbor[2] = SIZE_MAX;
+
+		XMVECTOR pa = XMLoadFloat3(&pts[a]);
+		XMVECTOR pb = XMLoadFloat3(&pts[b]);
+		XMVECTOR pc = XMLoadFloat3(&pts[c]);
+
+		// Same orientation rule as the generated meshes: cross(b-a, c-a) points out.
+		XMVECTOR n = XMVector3Normalize(XMVector3Cross(pb - pa, pc - pa));
+		XMStoreFloat3(&f.Normal, n);
+		f.Offset = XMVectorGetX(XMVector3Dot(n, pa));
+
+		return f;
+	}
+
+	std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b)
+	{
+		return ((std::uint64_t)a << 32) | b;
+	}
+
+	// Connects the faces in [firstFace, end) to each other through their shared edges.
+	void LinkFaces(std::vector<HullFace>& faces, size_t firstFace, std::unordered_map<std::uint64_t, size_t>& edges)
+	{
+		edges.clear();
+		for(size_t f = firstFace; f < faces.size(); ++f)
+		{
+			for(int e = 0; e < 3; ++e)
+				edges[EdgeKey(faces[f].V[e], faces[f].V[(e+1)%3])] = f;
+		}
+
+		for(size_t f = firstFace; f < faces.size(); ++f)
+		{
+			for(int e = 0; e < 3; ++e)
+			{
+				auto twin = edges.find(EdgeKey(faces[f].V[(e+1)%3], faces[f].V[e]));
+				if(twin != edges.end())
+					faces[f].Neighbor[e] = twin->second;
+			}
+		}
+	}
+
+	// Moves each candidate point onto the face it is farthest in front of.  Points
+	// that are behind every face are inside the hull and are dropped.
+	void AssignOutside(const std::vector<XMFLOAT3>& pts, const std::vector<std::uint32_t>& candidates,
+		std::vector<HullFace>& faces, size_t firstFace, float eps)
+	{
+		for(std::uint32_t p : candidates)
+		{
+			float bestDist = eps;
+			size_t bestFace = faces.size();
+			for(size_t f = firstFace; f < faces.size(); ++f)
+			{
+				float d = PlaneDistance(faces[f], pts[p]);
+				if(d > bestDist)
+				{
+					bestDist = d;
+					bestFace = f;
+				}
+			}
+
+			if(bestFace < faces.size())
+				faces[bestFace].Outside.push_back(p);
+		}
+	}
+}
+
+bool ConvexHull::Build(const XMFLOAT3* points, size_t count, size_t stride)
+{
+	Clear();
+
+	if(points == nullptr || count < 4)
+		return false;
+
+	std::vector<XMFLOAT3> pts(count);
+	for(size_t i = 0; i < count; ++i)
+		pts[i] = *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const std::uint8_t*>(points) + i*stride);
+
+	//
+	// Pick an initial tetrahedron from the extreme points.
+	//
+
+	std::uint32_t extremes[6] = { 0, 0, 0, 0, 0, 0 };
+	float maxAbs[3] = { 0.0f, 0.0f, 0.0f };
+	for(std::uint32_t i = 0; i < (std::uint32_t)count; ++i)
+	{
+		const float* p = &pts[i].x;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			if(p[axis] < (&pts[extremes[2*axis]].x)[axis])
+				extremes[2*axis] = i;
+			if(p[axis] > (&pts[extremes[2*axis+1]].x)[axis])
+				extremes[2*axis+1] = i;
+
+			maxAbs[axis] = std::max(maxAbs[axis], fabsf(p[axis]));
+		}
+	}
+
+	// Tolerance scaled to the magnitude of the input, as in the original quickhull paper.
+	const float eps = 3.0f*FLT_EPSILON*(maxAbs[0] + maxAbs[1] + maxAbs[2]);
+
+	std::uint32_t i0 = 0, i1 = 0;
+	float bestDist = -1.0f;
+	for(int a = 0; a < 6; ++a)
+	{
+		for(int b = a + 1; b < 6; ++b)
+		{
+			XMVECTOR d = XMLoadFloat3(&pts[extremes[a]]) - XMLoadFloat3(&pts[extremes[b]]);
+			float lenSq = XMVectorGetX(XMVector3LengthSq(d));
+			if(lenSq > bestDist)
+			{
+				bestDist = lenSq;
+				i0 = extremes[a];
+				i1 = extremes[b];
+			}
+		}
+	}
+
+	if(bestDist <= eps*eps)
+		return false;
+
+	XMVECTOR p0 = XMLoadFloat3(&pts[i0]);
+	XMVECTOR lineDir = XMVector3Normalize(XMLoadFloat3(&pts[i1]) - p0);
+
+	std::uint32_t i2 = 0;
+	bestDist = -1.0f;
+	for(std::uint32_t i = 0; i < (std::uint32_t)count; ++i)
+	{
+		float d = XMVectorGetX(XMVector3LengthSq(XMVector3Cross(XMLoadFloat3(&pts[i]) - p0, lineDir)));
+		if(d > bestDist)
+		{
+			bestDist = d;
+			i2 = i;
+		}
+	}
+
+	if(bestDist <= eps*eps)
+		return false;
+
+	HullFace base = MakeFace(pts, i0, i1, i2);
+
+	std::uint32_t i3 = 0;
+	bestDist = -1.0f;
+	for(std::uint32_t i = 0; i < (std::uint32_t)count; ++i)
+	{
+		float d = fabsf(PlaneDistance(base, pts[i]));
+		if(d > bestDist)
+		{
+			bestDist = d;
+			i3 = i;
+		}
+	}
+
+	if(bestDist <= eps)
+		return false;
+
+	// Orient the tetrahedron so that every face looks away from its centroid.
+	XMFLOAT3 centroid;
+	XMStoreFloat3(&centroid, 0.25f*(XMLoadFloat3(&pts[i0]) + XMLoadFloat3(&pts[i1]) +
+		XMLoadFloat3(&pts[i2]) + XMLoadFloat3(&pts[i3])));
+
+	const std::uint32_t tet[4][3] =
+	{
+		{ i0, i1, i2 }, { i0, i3, i1 }, { i1, i3, i2 }, { i2, i3, i0 }
+	};
+
+	std::vector<HullFace> faces;
+	for(int f = 0; f < 4; ++f)
+	{
+		HullFace face = MakeFace(pts, tet[f][0], tet[f][1], tet[f][2]);
+		if(PlaneDistance(face, centroid) > 0.0f)
+			face = MakeFace(pts, tet[f][0], tet[f][2], tet[f][1]);
+
+		faces.push_back(face);
+	}
+
+	std::unordered_map<std::uint64_t, size_t> edgeMap;
+	LinkFaces(faces, 0, edgeMap);
+
+	std::vector<std::uint32_t> candidates;
+	candidates.reserve(count);
+	for(std::uint32_t i = 0; i < (std::uint32_t)count; ++i)
+	{
+		if(i != i0 && i != i1 && i != i2 && i != i3)
+			candidates.push_back(i);
+	}
+	AssignOutside(pts, candidates, faces, 0, eps);
+
+	//
+	// Grow the hull.  Outside points are only ever handed to newly created faces,
+	// which are appended, so a single forward pass visits every face that can
+	// still have work.
+	//
+
+	struct HorizonEdge
+	{
+		std::uint32_t A, B;
+		size_t Outer;
+	};
+
+	std::vector<size_t> stack;
+	std::vector<HorizonEdge> horizon;
+	std::uint32_t tag = 0;
+
+	for(size_t fi = 0; fi < faces.size(); ++fi)
+	{
+		if(!faces[fi].Alive || faces[fi].Outside.empty())
+			continue;
+
+		// The eye point is the farthest outside point of this face.
+		std::uint32_t eye = faces[fi].Outside[0];
+		float eyeDist = PlaneDistance(faces[fi], pts[eye]);
+		for(std::uint32_t p : faces[fi].Outside)
+		{
+			float d = PlaneDistance(faces[fi], pts[p]);
+			if(d > eyeDist)
+			{
+				eyeDist = d;
+				eye = p;
+			}
+		}
+
+		// Flood out from this face over every face the eye can see.  Each edge
+		// from a visible face to a hidden one is on the horizon.  The visible
+		// faces are removed and their outside points orphaned.
+		++tag;
+		candidates.clear();
+		horizon.clear();
+		stack.assign(1, fi);
+		faces[fi].VisitTag = tag;
+		while(!stack.empty())
+		{
+			size_t f = stack.back();
+			stack.pop_back();
+
+			faces[f].Alive = false;
+			for(std::uint32_t p : faces[f].Outside)
+			{
+				if(p != eye)
+					candidates.push_back(p);
+			}
+			faces[f].Outside.clear();
+			faces[f].Outside.shrink_to_fit();
+
+			for(int e = 0; e < 3; ++e)
+			{
+				size_t n = faces[f].Neighbor[e];
+				if(n >= faces.size() || faces[n].VisitTag == tag)
+					continue;
+
+				if(PlaneDistance(faces[n], pts[eye]) > eps)
+				{
+					faces[n].VisitTag = tag;
+					stack.push_back(n);
+				}
+				else
+				{
+					horizon.push_back({ faces[f].V[e], faces[f].V[(e+1)%3], n });
+				}
+			}
+		}
+
+		// Cone the horizon to the eye point.
+		size_t firstNew = faces.size();
+		for(const HorizonEdge& edge : horizon)
+		{
+			HullFace face = MakeFace(pts, edge.A, edge.B, eye);
+			face.Neighbor[0] = edge.Outer;
+
+			// Point the outer face back at its new neighbor.
+			HullFace& outer = faces[edge.Outer];
+			for(int e = 0; e < 3; ++e)
+			{
+				if(outer.V[e] == edge.B && outer.V[(e+1)%3] == edge.A)
+					outer.Neighbor[e] = faces.size();
+			}
+
+			faces.push_back(face);
+		}
+
+		LinkFaces(faces, firstNew, edgeMap);
+		AssignOutside(pts, candidates, faces, firstNew, eps);
+	}
+
+	//
+	// Compact the surviving faces into an indexed triangle list.
+	//
+
+	std::vector<std::uint32_t> remap(count, UINT32_MAX);
+	for(const HullFace& face : faces)
+	{
+		if(!face.Alive)
+			continue;
+
+		for(int e = 0; e < 3; ++e)
+		{
+			std::uint32_t v = face.V[e];
+			if(remap[v] == UINT32_MAX)
+			{
+				remap[v] = (std::uint32_t)Vertices.size();
+				Vertices.push_back(pts[v]);
+			}
+			Indices.push_back(remap[v]);
+		}
+	}
+
+	return !Indices.empty();
+}
@@ -0,0 +1,38 @@
+//***************************************************************************************
+// ConvexHull.h
+//
+// 3D convex hull built with the quickhull algorithm.  The hull is stored as an
+// indexed triangle list whose winding matches GeometryGenerator (outward facing),
+// so it can be drawn directly for debugging.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+#include <vector>
+
+class ConvexHull
+{
+public:
+	std::vector<DirectX::XMFLOAT3> Vertices;
+	std::vector<std::uint32_t> Indices;
+
+	///<summary>
+	/// Builds the hull of count points, read stride bytes apart starting at points.
+	/// Returns false (and leaves the hull empty) when the points are coplanar,
+	/// collinear or coincident and so do not enclose any volume.
+	///</summary>
+	bool Build(const DirectX::XMFLOAT3* points, size_t count, size_t stride = sizeof(DirectX::XMFLOAT3));
+
+	bool Empty()const
+	{
+		return Indices.empty();
+	}
+
+	void Clear()
+	{
+		Vertices.clear();
+		Indices.clear();
+	}
+};
@@ -0,0 +1,138 @@
+//--------------------------------------------------------------------------------------
+// File: DDSFormat.h
+//
+// DXGI format and DDS surface queries used by DDSTextureLoader and the texture tools.
+// Nothing here touches Direct3D, so it is part of the portable core (see Platform.h).
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "DDS.h"
+
+#include <stdio.h>
+
+namespace DirectX
+{
+    enum DDS_ALPHA_MODE
+    {
+        DDS_ALPHA_MODE_UNKNOWN       = 0,
+        DDS_ALPHA_MODE_STRAIGHT      = 1,
+        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+        DDS_ALPHA_MODE_OPAQUE        = 3,
+        DDS_ALPHA_MODE_CUSTOM        = 4,
+    };
+
+    // Returns the bits per pixel of fmt, or 0 for formats the loader does not handle.
+    size_t BitsPerPixel( _In_ DXGI_FORMAT fmt );
+
+    // Byte size, row pitch and row count of a width x height surface of fmt.  Block
+    // compressed formats count rows of 4x4 blocks.  Any output may be null.
+    void GetSurfaceInfo( _In_ size_t width,
+                         _In_ size_t height,
+                         _In_ DXGI_FORMAT fmt,
+                         _Out_opt_ size_t* outNumBytes,
+                         _Out_opt_ size_t* outRowBytes,
+                         _Out_opt_ size_t* outNumRows );
+
+    // Width and height in texels of the blocks fmt is stored in: 4x4 for the BC
+    // formats, 2x1 for the packed 4:2:2 formats and 1x1 otherwise.  Returns false for
+    // the planar video formats, which have no single block size.
+    bool GetBlockSize( _In_ DXGI_FORMAT fmt,
+                       _Out_ size_t* blockWidth,
+                       _Out_ size_t* blockHeight );
+
+    // Maps a legacy (non-DX10) pixel format to DXGI, or DXGI_FORMAT_UNKNOWN.
+    DXGI_FORMAT GetDXGIFormat( const DDS_PIXELFORMAT& ddpf );
+
+    // Returns the _SRGB variant of format, or format itself if there is none.
+    DXGI_FORMAT MakeSRGB( _In_ DXGI_FORMAT format );
+
+    // True for the _SRGB formats, whose colour channels sample through the sRGB curve.
+    bool IsSRGB( _In_ DXGI_FORMAT format );
+
+    // Reads the alpha mode from the DX10 extension header or the DXT2/DXT4 FourCC.
+    DDS_ALPHA_MODE GetAlphaMode( _In_ const DDS_HEADER* header );
+
+    // Everything the headers say about a texture, resolved the same way the loader
+    // resolves them (legacy formats mapped to DXGI, cube maps counted as 6 faces).
+    struct DDS_TEXTURE_INFO
+    {
+        DDS_RESOURCE_DIMENSION dimension;
+        DXGI_FORMAT            format;
+        uint32_t               width;
+        uint32_t               height;
+        uint32_t               depth;
+        uint32_t               mipCount;
+        uint32_t               arraySize;
+        bool                   isCubeMap;
+        DDS_ALPHA_MODE         alphaMode;
+        uint64_t               dataSize;    // pixel bytes for every subresource, per GetSurfaceInfo
+        uint32_t               dataOffset;  // where the pixels start in the file
+    };
+
+    // Largest prefix of a DDS file the probe needs: magic, DDS_HEADER and DDS_HEADER_DXT10.
+    const size_t DDS_MAX_HEADER_SIZE = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+
+    // Direct3D feature level 11+ resource limits (D3D12_REQ_*).  DDS metadata beyond
+    // what the hardware is required to support is not trusted.
+    const uint32_t DDS_MAX_MIP_LEVELS       = 15;
+    const uint32_t DDS_MAX_TEXTURE1D_SIZE   = 16384;
+    const uint32_t DDS_MAX_TEXTURE2D_SIZE   = 16384;
+    const uint32_t DDS_MAX_TEXTURECUBE_SIZE = 16384;
+    const uint32_t DDS_MAX_TEXTURE3D_SIZE   = 2048;
+    const uint32_t DDS_MAX_ARRAY_SIZE       = 2048;
+
+    // Checks info against the limits above: non-zero extents within the bounds of its
+    // dimension, and no more mips than the full chain of its largest extent.  Every
+    // size computed from a checked info fits in 64 bits.
+    HRESULT ValidateDDSTextureInfo( _In_ const DDS_TEXTURE_INFO& info );
+
+    // One mip of an array slice as a DDS file stores it: the mips of each slice are
+    // back to back, and so are the depth slices of each mip.
+    struct DDS_MIP_LAYOUT
+    {
+        uint64_t offset;        // from the start of the array slice
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        uint32_t rowBytes;
+        uint32_t numRows;
+        uint64_t sliceBytes;    // one depth slice, per GetSurfaceInfo
+    };
+
+    // Lays out the info.mipCount mips of one array slice of a validated info in a
+    // single pass.  sliceStride receives the size of a whole array slice, so array
+    // slice j, mip i starts at j * sliceStride + mips[i].offset.  Fails with
+    // ERROR_ARITHMETIC_OVERFLOW if a mip does not fit in size_t.
+    HRESULT GetDDSMipLayout( _In_ const DDS_TEXTURE_INFO& info,
+                             _Out_writes_(DDS_MAX_MIP_LEVELS) DDS_MIP_LAYOUT* mips,
+                             _Out_ uint64_t* sliceStride );
+
+    // Describes a DDS image from its first bytes.  ddsDataSize only has to cover the
+    // headers; the pixel data is not touched.  The result has passed
+    // ValidateDDSTextureInfo.
+    HRESULT GetDDSTextureInfoFromMemory( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                         _In_ size_t ddsDataSize,
+                                         _Out_ DDS_TEXTURE_INFO* info );
+
+    // Reads at most DDS_MAX_HEADER_SIZE bytes at the current position of file and
+    // describes them as GetDDSTextureInfoFromMemory does.  A file without the DX10
+    // extension is shorter than that; the short read is fine.
+    HRESULT GetDDSTextureInfoFromStream( _In_ FILE* file,
+                                         _Out_ DDS_TEXTURE_INFO* info );
+
+    // Describes a DDS file with a single read of at most DDS_MAX_HEADER_SIZE bytes, or
+    // from a mounted TextureArchive without any read.
+    HRESULT GetDDSTextureInfoFromFile( _In_z_ const wchar_t* fileName,
+                                       _Out_ DDS_TEXTURE_INFO* info );
+}
@@ -0,0 +1,287 @@
+//--------------------------------------------------------------------------------------
+// File: DDSTextureData.cpp
+//
+// CPU half of DDS loading.  See DDSTextureData.h.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "DDSTextureData.h"
+#include "TextureTelemetry.h"
+
+#include <algorithm>
+#include <new>
+#include <stdio.h>
+
+using namespace DirectX;
+
+namespace
+{
+
+// The part of LayoutDDSSubresources shared with LoadDDSTextureDataFromMemory: sizes
+// the mips of one array slice once, checks the whole image against bitSize and drops
+// the mips larger than maxsize from info.  mips and sliceStride keep describing the
+// file as stored; the kept mips are mips[skipMip..].
+HRESULT LayoutMips( DDS_TEXTURE_INFO& info,
+                    size_t bitSize,
+                    size_t maxsize,
+                    DDS_MIP_LAYOUT* mips,
+                    uint64_t& sliceStride,
+                    uint32_t& skipMip )
+{
+    HRESULT hr = GetDDSMipLayout( info, mips, &sliceStride );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    // sliceStride * arraySize cannot overflow for a validated info, but divide so the
+    // check does not depend on that.
+    if ( sliceStride > bitSize / info.arraySize )
+    {
+        return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+    }
+
+    // Mips larger than maxsize are skipped in every slice.
+    skipMip = 0;
+    if ( maxsize && info.mipCount > 1 )
+    {
+        while ( skipMip < info.mipCount &&
+                ( mips[ skipMip ].width > maxsize || mips[ skipMip ].height > maxsize ||
+                  mips[ skipMip ].depth > maxsize ) )
+        {
+            ++skipMip;
+        }
+    }
+
+    if ( skipMip == info.mipCount )
+    {
+        return E_FAIL;
+    }
+
+    info.width = mips[ skipMip ].width;
+    info.height = mips[ skipMip ].height;
+    info.depth = mips[ skipMip ].depth;
+    info.mipCount -= skipMip;
+
+    return S_OK;
+}
+
+HRESULT ReadWholeFile( const wchar_t* fileName, DDS_TEXTURE_DATA& data )
+{
+    FILE* file = nullptr;
+    HRESULT hr = OpenFileForRead( fileName, &file );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    long size = -1;
+    if ( fseek( file, 0, SEEK_END ) == 0 )
+    {
+        size = ftell( file );
+    }
+
+    if ( size < 0 || fseek( file, 0, SEEK_SET ) != 0 )
+    {
+        hr = E_FAIL;
+    }
+    else
+    {
+        data.fileSize = static_cast<size_t>( size );
+        data.fileData.reset( new (std::nothrow) uint8_t[ data.fileSize ? data.fileSize : 1 ] );
+        if ( !data.fileData )
+        {
+            hr = E_OUTOFMEMORY;
+        }
+        else if ( fread( data.fileData.get(), 1, data.fileSize, file ) != data.fileSize )
+        {
+            hr = HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+        }
+    }
+
+    fclose( file );
+    return hr;
+}
+
+}
+
+
+//--------------------------------------------------------------------------------------
+// Validates info and sizes every mip once; the array slices repeat the same chain,
+// so a single bounds check of the whole image against bitSize covers every
+// subresource and nothing downstream needs to check again.
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LayoutDDSSubresources( DDS_TEXTURE_INFO& info,
+                                        size_t bitSize,
+                                        size_t maxsize,
+                                        std::vector<size_t>& offsets )
+{
+    offsets.clear();
+
+    DDS_MIP_LAYOUT mips[ DDS_MAX_MIP_LEVELS ];
+    uint64_t sliceStride = 0;
+    uint32_t skipMip = 0;
+    HRESULT hr = LayoutMips( info, bitSize, maxsize, mips, sliceStride, skipMip );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    offsets.resize( size_t( info.mipCount ) * info.arraySize );
+    size_t index = 0;
+    for ( uint32_t j = 0; j < info.arraySize; ++j )
+    {
+        const size_t slice = static_cast<size_t>( sliceStride * j );
+        for ( uint32_t i = 0; i < info.mipCount; ++i )
+        {
+            offsets[ index++ ] = slice + static_cast<size_t>( mips[ skipMip + i ].offset );
+        }
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadDDSTextureDataFromMemory( const uint8_t* ddsData,
+                                               size_t ddsDataSize,
+                                               DDS_TEXTURE_DATA& data,
+                                               size_t maxsize )
+{
+    data.subresources.clear();
+
+    ScopedTextureLoadTimer timer( data.telemetryId, TextureLoadStage::HeaderParse );
+
+    HRESULT hr = GetDDSTextureInfoFromMemory( ddsData, ddsDataSize, &data.info );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    DDS_TEXTURE_INFO& info = data.info;
+    DDS_MIP_LAYOUT mips[ DDS_MAX_MIP_LEVELS ];
+    uint64_t sliceStride = 0;
+    uint32_t skipMip = 0;
+    hr = LayoutMips( info, ddsDataSize - info.dataOffset, maxsize, mips, sliceStride, skipMip );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    // Everything below is in bounds: no per-subresource checks.
+    const uint8_t* bitData = ddsData + info.dataOffset;
+    data.subresources.resize( size_t( info.mipCount ) * info.arraySize );
+    DDS_SUBRESOURCE* sub = data.subresources.data();
+    for ( uint32_t j = 0; j < info.arraySize; ++j )
+    {
+        const uint8_t* slice = bitData + static_cast<size_t>( sliceStride * j );
+        for ( uint32_t i = skipMip; i < skipMip + info.mipCount; ++i, ++sub )
+        {
+            sub->pData = slice + static_cast<size_t>( mips[ i ].offset );
+            sub->rowPitch = static_cast<intptr_t>( mips[ i ].rowBytes );
+            sub->slicePitch = static_cast<intptr_t>( mips[ i ].sliceBytes );
+        }
+    }
+
+    timer.SetBytes( info.dataOffset );
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadDDSTextureDataFromFile( const wchar_t* fileName,
+                                             DDS_TEXTURE_DATA& data,
+                                             size_t maxsize,
+                                             unsigned int loadFlags )
+{
+    data.subresources.clear();
+    data.mapping.Close();
+    data.fileData.reset();
+    data.archive.reset();
+    data.fileSize = 0;
+    data.telemetryId = 0;
+
+    if ( !fileName )
+    {
+        return E_INVALIDARG;
+    }
+
+    if ( TextureTelemetry::IsEnabled() )
+    {
+        data.telemetryId = TextureTelemetry::FileId( fileName );
+    }
+
+    // Mounted archives are already mapped, so an archived file costs no I/O call.
+    ArchivedFile archived;
+    if ( FindArchivedFile( fileName, archived ) )
+    {
+        data.archive = archived.Archive;
+        data.fileSize = archived.Size;
+        return LoadDDSTextureDataFromMemory( archived.Data, archived.Size, data, maxsize );
+    }
+
+    HRESULT hr = S_OK;
+    const uint8_t* ddsData = nullptr;
+    {
+        ScopedTextureLoadTimer timer( data.telemetryId, TextureLoadStage::FileRead );
+        if ( loadFlags & DDS_LOADER_MEMORY_MAPPED )
+        {
+            hr = data.mapping.Open( fileName );
+            ddsData = data.mapping.Data();
+            data.fileSize = data.mapping.Size();
+        }
+        else
+        {
+            hr = ReadWholeFile( fileName, data );
+            ddsData = data.fileData.get();
+        }
+        timer.SetBytes( data.fileSize );
+    }
+
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    return LoadDDSTextureDataFromMemory( ddsData, data.fileSize, data, maxsize );
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::DropTopMips( DDS_TEXTURE_DATA& data, uint32_t count )
+{
+    DDS_TEXTURE_INFO& info = data.info;
+    count = std::min( count, info.mipCount - 1 );
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    // Subresources are mip-major within each slice (depth does not multiply them).
+    std::vector<DDS_SUBRESOURCE> kept;
+    kept.reserve( size_t( info.mipCount - count ) * info.arraySize );
+    for ( size_t slice = 0; slice < info.arraySize; ++slice )
+    {
+        auto first = data.subresources.begin() + slice * info.mipCount;
+        kept.insert( kept.end(), first + count, first + info.mipCount );
+    }
+
+    data.subresources.swap( kept );
+    info.width = std::max<uint32_t>( 1, info.width >> count );
+    info.height = std::max<uint32_t>( 1, info.height >> count );
+    info.depth = std::max<uint32_t>( 1, info.depth >> count );
+    info.mipCount -= count;
+}
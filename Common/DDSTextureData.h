@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------------------
+// File: DDSTextureData.h
+//
+// CPU half of DDS loading: reads (or maps) a file, validates it and lays out the
+// subresources in the order Direct3D expects, without touching a device.  This is
+// the part of a load that can run on worker threads; the D3D12 half in
+// DDSTextureLoader only creates the resources and records the upload.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "DDSFormat.h"
+#include "FileMapping.h"
+#include "TextureArchive.h"
+
+namespace DirectX
+{
+    enum DDS_LOADER_FLAGS
+    {
+        DDS_LOADER_DEFAULT       = 0,
+        DDS_LOADER_MEMORY_MAPPED = 0x1,  // Map the file instead of reading it into a heap copy
+        DDS_LOADER_DIRECT_TO_STAGING = 0x2,  // Read rows straight into the upload heap (see TextureFootprint.h)
+    };
+
+    // One mip of one array slice.  Same layout as D3D12_SUBRESOURCE_DATA.
+    struct DDS_SUBRESOURCE
+    {
+        const void* pData;
+        intptr_t    rowPitch;
+        intptr_t    slicePitch;
+    };
+
+    struct DDS_TEXTURE_DATA
+    {
+        // Describes what will be created, so mips dropped by maxsize are already
+        // gone from width/height/depth/mipCount.
+        DDS_TEXTURE_INFO info;
+
+        // mipCount * arraySize entries, mips of slice 0 first.  They point into
+        // mapping, fileData or archive, so the struct must outlive the upload.
+        std::vector<DDS_SUBRESOURCE> subresources;
+
+        FileMapping mapping;
+        std::unique_ptr<uint8_t[]> fileData;
+        std::shared_ptr<const TextureArchive> archive;  // set when read from a mounted archive
+        size_t fileSize;
+
+        // Tags this load's TextureTelemetry events; 0 unless recording was on.
+        uint64_t telemetryId;
+
+        DDS_TEXTURE_DATA() : info(), fileSize(0), telemetryId(0) {}
+    };
+
+    // Reads and lays out a DDS file, from a mounted TextureArchive if one holds it.
+    // Safe to call from any thread.
+    HRESULT LoadDDSTextureDataFromFile( _In_z_ const wchar_t* fileName,
+                                        _Out_ DDS_TEXTURE_DATA& data,
+                                        _In_ size_t maxsize = 0,
+                                        _In_ unsigned int loadFlags = DDS_LOADER_DEFAULT );
+
+    // Removes the count finest mips from a loaded texture, as if it had been loaded with
+    // a smaller maxsize.  At least one mip is always kept.
+    void DropTopMips( _Inout_ DDS_TEXTURE_DATA& data, _In_ uint32_t count );
+
+    // The part of a load that only needs the headers: checks info against the Direct3D
+    // limits, drops the mips larger than maxsize from it and returns where each
+    // remaining subresource starts, relative to info.dataOffset, in the order of
+    // DDS_TEXTURE_DATA::subresources.  bitSize is the pixel data present in the file.
+    HRESULT LayoutDDSSubresources( _Inout_ DDS_TEXTURE_INFO& info,
+                                   _In_ size_t bitSize,
+                                   _In_ size_t maxsize,
+                                   _Out_ std::vector<size_t>& offsets );
+
+    // Lays out a DDS image already in memory.  The subresources point into ddsData.
+    HRESULT LoadDDSTextureDataFromMemory( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                          _In_ size_t ddsDataSize,
+                                          _Out_ DDS_TEXTURE_DATA& data,
+                                          _In_ size_t maxsize = 0 );
+}
@@ -44,17 +44,11 @@
 #define _Use_decl_annotations_
 #endif
 
+#include "DDSTextureData.h"
+#include "TextureFootprint.h"
+
 namespace DirectX
 {
-    enum DDS_ALPHA_MODE
-    {
-        DDS_ALPHA_MODE_UNKNOWN       = 0,
-        DDS_ALPHA_MODE_STRAIGHT      = 1,
-        DDS_ALPHA_MODE_PREMULTIPLIED = 2,
-        DDS_ALPHA_MODE_OPAQUE        = 3,
-        DDS_ALPHA_MODE_CUSTOM        = 4,
-    };
-
     // Standard version
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
@@ -89,9 +83,31 @@ namespace DirectX
 		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
 		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap,
 		                               _In_ size_t maxsize = 0,
-		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+		                               _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr,
+		                               _In_ unsigned int loadFlags = DDS_LOADER_DEFAULT
 		                               );
 
+	// Second half of a split load: creates the texture described by data (see
+	// LoadDDSTextureDataFromFile) and records its upload on cmdList.  data must stay
+	// alive until this returns; the upload heap must live until the GPU has copied it.
+	HRESULT CreateDDSTextureFromData12(_In_ ID3D12Device* device,
+		                               _In_ ID3D12GraphicsCommandList* cmdList,
+		                               _In_ const DDS_TEXTURE_DATA& data,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		                               _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& textureUploadHeap
+		                               );
+
+	// Checks footprints planned on the CPU (see GetTextureFootprints) against the
+	// layout GetCopyableFootprints reports for texture, offsets taken relative to the
+	// first footprint.  Returns E_UNEXPECTED if they disagree, so a copy is never
+	// recorded with the wrong offsets or pitches.
+	HRESULT ValidateTextureFootprints12(_In_ ID3D12Device* device,
+		                                _In_ ID3D12Resource* texture,
+		                                _In_reads_(numSubresources) const TEXTURE_FOOTPRINT* footprints,
+		                                _In_ UINT numSubresources,
+		                                _In_ uint64_t totalBytes
+		                                );
+
     // Standard version with optional auto-gen mipmap support
     HRESULT CreateDDSTextureFromMemory( _In_ ID3D11Device* d3dDevice,
                                         _In_opt_ ID3D11DeviceContext* d3dContext,
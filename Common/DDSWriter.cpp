@@ -0,0 +1,239 @@
+//--------------------------------------------------------------------------------------
+// File: DDSWriter.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "DDSWriter.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+#include <string.h>
+
+using namespace DirectX;
+
+namespace
+{
+
+// DDS_HEADER::flags and caps bits (DDSD_* and DDSCAPS_*).
+const uint32_t DDSD_CAPS        = 0x00000001;
+const uint32_t DDSD_PIXELFORMAT = 0x00001000;
+const uint32_t DDSD_MIPMAPCOUNT = 0x00020000;
+const uint32_t DDSD_PITCH       = 0x00000008;
+const uint32_t DDSD_LINEARSIZE  = 0x00080000;
+const uint32_t DDSCAPS_COMPLEX  = 0x00000008;
+const uint32_t DDSCAPS_TEXTURE  = 0x00001000;
+const uint32_t DDSCAPS_MIPMAP   = 0x00400000;
+const uint32_t DDSCAPS2_VOLUME  = 0x00200000;
+
+bool IsCompressed( DXGI_FORMAT fmt )
+{
+    return ( fmt >= DXGI_FORMAT_BC1_TYPELESS && fmt <= DXGI_FORMAT_BC5_SNORM ) ||
+           ( fmt >= DXGI_FORMAT_BC6H_TYPELESS && fmt <= DXGI_FORMAT_BC7_UNORM_SRGB );
+}
+
+FILE* OpenForWrite( const wchar_t* fileName )
+{
+#if defined(_WIN32)
+    FILE* file = nullptr;
+    if ( _wfopen_s( &file, fileName, L"wb" ) != 0 )
+    {
+        file = nullptr;
+    }
+    return file;
+#else
+    return fopen( WideToUtf8( fileName ).c_str(), "wb" );
+#endif
+}
+
+void RemoveFile( const wchar_t* fileName )
+{
+#if defined(_WIN32)
+    _wremove( fileName );
+#else
+    remove( WideToUtf8( fileName ).c_str() );
+#endif
+}
+
+bool ReplaceFile( const wchar_t* from, const wchar_t* to )
+{
+#if defined(_WIN32)
+    return MoveFileExW( from, to, MOVEFILE_REPLACE_EXISTING ) != 0;
+#else
+    return rename( WideToUtf8( from ).c_str(), WideToUtf8( to ).c_str() ) == 0;
+#endif
+}
+
+HRESULT WriteHeaders( FILE* file, const DDS_TEXTURE_INFO& info )
+{
+    size_t numBytes = 0;
+    size_t rowBytes = 0;
+    GetSurfaceInfo( info.width, info.height, info.format, &numBytes, &rowBytes, nullptr );
+
+    DDS_HEADER header = {};
+    header.size = sizeof(DDS_HEADER);
+    header.flags = DDSD_CAPS | DDS_HEIGHT | DDS_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+    header.height = info.height;
+    header.width = info.width;
+    header.depth = 1;
+    header.mipMapCount = info.mipCount;
+    header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+    header.ddspf.flags = DDS_FOURCC;
+    header.ddspf.fourCC = MAKEFOURCC( 'D', 'X', '1', '0' );
+    header.caps = DDSCAPS_TEXTURE;
+
+    if ( IsCompressed( info.format ) )
+    {
+        header.flags |= DDSD_LINEARSIZE;
+        header.pitchOrLinearSize = static_cast<uint32_t>( numBytes );
+    }
+    else
+    {
+        header.flags |= DDSD_PITCH;
+        header.pitchOrLinearSize = static_cast<uint32_t>( rowBytes );
+    }
+
+    if ( info.mipCount > 1 )
+    {
+        header.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+
+    DDS_HEADER_DXT10 ext = {};
+    ext.dxgiFormat = info.format;
+    ext.resourceDimension = info.dimension;
+    ext.arraySize = info.arraySize;
+    ext.miscFlags2 = info.alphaMode;
+
+    if ( info.dimension == DDS_DIMENSION_TEXTURE3D )
+    {
+        header.flags |= DDS_HEADER_FLAGS_VOLUME;
+        header.depth = info.depth;
+        header.caps |= DDSCAPS_COMPLEX;
+        header.caps2 = DDSCAPS2_VOLUME;
+    }
+    else if ( info.isCubeMap )
+    {
+        // The loader counts faces; the file counts cubes.
+        header.caps |= DDSCAPS_COMPLEX;
+        header.caps2 = DDS_CUBEMAP_ALLFACES;
+        ext.miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+        ext.arraySize = info.arraySize / 6;
+    }
+
+    if ( info.arraySize > 1 )
+    {
+        header.caps |= DDSCAPS_COMPLEX;
+    }
+
+    const uint32_t magic = DDS_MAGIC;
+    if ( fwrite( &magic, sizeof(magic), 1, file ) != 1 ||
+         fwrite( &header, sizeof(header), 1, file ) != 1 ||
+         fwrite( &ext, sizeof(ext), 1, file ) != 1 )
+    {
+        return HRESULT_FROM_WIN32( ERROR_WRITE_FAULT );
+    }
+
+    return S_OK;
+}
+
+HRESULT WriteSubresources( FILE* file, const DDS_TEXTURE_INFO& info, const DDS_SUBRESOURCE* subresources )
+{
+    for ( size_t slice = 0; slice < info.arraySize; ++slice )
+    {
+        size_t w = info.width;
+        size_t h = info.height;
+        size_t d = info.depth;
+        for ( size_t mip = 0; mip < info.mipCount; ++mip )
+        {
+            const DDS_SUBRESOURCE& sub = subresources[ slice * info.mipCount + mip ];
+
+            size_t rowBytes = 0;
+            size_t numRows = 0;
+            GetSurfaceInfo( w, h, info.format, nullptr, &rowBytes, &numRows );
+            if ( !sub.pData || size_t( sub.rowPitch ) < rowBytes )
+            {
+                return E_INVALIDARG;
+            }
+
+            // Rows one at a time, since the source pitch may carry padding.
+            for ( size_t z = 0; z < d; ++z )
+            {
+                auto src = static_cast<const uint8_t*>( sub.pData ) + z * sub.slicePitch;
+                for ( size_t row = 0; row < numRows; ++row, src += sub.rowPitch )
+                {
+                    if ( fwrite( src, 1, rowBytes, file ) != rowBytes )
+                    {
+                        return HRESULT_FROM_WIN32( ERROR_WRITE_FAULT );
+                    }
+                }
+            }
+
+            w = std::max<size_t>( 1, w >> 1 );
+            h = std::max<size_t>( 1, h >> 1 );
+            d = std::max<size_t>( 1, d >> 1 );
+        }
+    }
+
+    return S_OK;
+}
+
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::SaveDDSTextureToFile( const wchar_t* fileName,
+                                       const DDS_TEXTURE_INFO& info,
+                                       const DDS_SUBRESOURCE* subresources,
+                                       size_t count )
+{
+    if ( !fileName || !subresources || !info.mipCount || !info.arraySize ||
+         count != size_t( info.mipCount ) * info.arraySize || !BitsPerPixel( info.format ) )
+    {
+        return E_INVALIDARG;
+    }
+
+    if ( info.isCubeMap && ( info.arraySize % 6 ) != 0 )
+    {
+        return E_INVALIDARG;
+    }
+
+    std::wstring tempName = std::wstring( fileName ) + L".tmp";
+    FILE* file = OpenForWrite( tempName.c_str() );
+    if ( !file )
+    {
+        return HRESULT_FROM_WIN32( ERROR_FILE_NOT_FOUND );
+    }
+
+    HRESULT hr = WriteHeaders( file, info );
+    if ( SUCCEEDED(hr) )
+    {
+        hr = WriteSubresources( file, info, subresources );
+    }
+
+    if ( fclose( file ) != 0 && SUCCEEDED(hr) )
+    {
+        hr = HRESULT_FROM_WIN32( ERROR_WRITE_FAULT );
+    }
+
+    if ( SUCCEEDED(hr) && !ReplaceFile( tempName.c_str(), fileName ) )
+    {
+        hr = HRESULT_FROM_WIN32( ERROR_WRITE_FAULT );
+    }
+
+    if ( FAILED(hr) )
+    {
+        RemoveFile( tempName.c_str() );
+    }
+
+    return hr;
+}
@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------------------------
+// File: DDSWriter.h
+//
+// Writes DDS files that DDSTextureLoader reads back, for the offline texture tools.
+// Files always carry the DX10 extension header so sRGB, BC7 and array sizes are
+// explicit.  Portable core.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "DDSTextureData.h"
+
+namespace DirectX
+{
+    // Writes a texture described by info.  subresources holds mipCount * arraySize
+    // entries, mips of slice 0 first, as DDS_TEXTURE_DATA lays them out; rows may be
+    // padded beyond what the format needs.  The file is written under a temporary
+    // name and renamed into place, so an interrupted write never leaves a truncated
+    // file behind.  dataSize and dataOffset in info are ignored.
+    HRESULT SaveDDSTextureToFile( _In_z_ const wchar_t* fileName,
+                                  _In_ const DDS_TEXTURE_INFO& info,
+                                  _In_reads_(count) const DDS_SUBRESOURCE* subresources,
+                                  _In_ size_t count );
+}
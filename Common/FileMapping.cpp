@@ -0,0 +1,252 @@
+//***************************************************************************************
+// FileMapping.cpp
+//***************************************************************************************
+
+#include "FileMapping.h"
+#include <utility>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FileMapping::FileMapping(FileMapping&& rhs) noexcept
+{
+	*this = std::move(rhs);
+}
+
+FileMapping& FileMapping::operator=(FileMapping&& rhs) noexcept
+{
+	if(this != &rhs)
+	{
+		Close();
+
+		std::swap(mData, rhs.mData);
+		std::swap(mSize, rhs.mSize);
+		std::swap(mOpen, rhs.mOpen);
+#if defined(_WIN32)
+		std::swap(mFile, rhs.mFile);
+		std::swap(mMapping, rhs.mMapping);
+#endif
+	}
+
+	return *this;
+}
+
+FileMapping::~FileMapping()
+{
+	Close();
+}
+
+#if defined(_WIN32)
+
+HRESULT FileMapping::Open(const wchar_t* fileName)
+{
+	Close();
+
+	if(fileName == nullptr)
+		return E_INVALIDARG;
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+	HANDLE file = CreateFile2(fileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+#else
+	HANDLE file = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+#endif
+	if(file == INVALID_HANDLE_VALUE)
+		return HRESULT_FROM_WIN32(GetLastError());
+
+	LARGE_INTEGER fileSize = {};
+	if(!GetFileSizeEx(file, &fileSize))
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		CloseHandle(file);
+		return hr;
+	}
+
+	if(sizeof(size_t) < 8 && fileSize.HighPart > 0)
+	{
+		CloseHandle(file);
+		return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+	}
+
+	mFile = file;
+	mSize = (size_t)fileSize.QuadPart;
+	mOpen = true;
+
+	// CreateFileMapping rejects empty files.
+	if(mSize == 0)
+		return S_OK;
+
+	mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mMapping == nullptr)
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		return hr;
+	}
+
+	mData = static_cast<const std::uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if(mData == nullptr)
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		return hr;
+	}
+
+	return S_OK;
+}
+
+void FileMapping::Close()
+{
+	if(mData != nullptr)
+		UnmapViewOfFile(mData);
+	if(mMapping != nullptr)
+		CloseHandle(mMapping);
+	if(mFile != nullptr)
+		CloseHandle(mFile);
+
+	mData = nullptr;
+	mMapping = nullptr;
+	mFile = nullptr;
+	mSize = 0;
+	mOpen = false;
+}
+
+#else
+
+HRESULT FileMapping::Open(const wchar_t* fileName)
+{
+	Close();
+
+	if(fileName == nullptr)
+		return E_INVALIDARG;
+
+	int fd = open(WideToUtf8(fileName).c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return HResultFromErrno(errno);
+
+	// mmap cannot map a directory; report it as OpenFileForRead does.
+	struct stat st;
+	int err = (fstat(fd, &st) != 0) ? errno : (S_ISREG(st.st_mode) ? 0 : EISDIR);
+	if(err != 0)
+	{
+		close(fd);
+		return HResultFromErrno(err);
+	}
+
+	mSize = (size_t)st.st_size;
+	mOpen = true;
+
+	if(mSize > 0)
+	{
+		void* view = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(view == MAP_FAILED)
+		{
+			close(fd);
+			Close();
+			return E_FAIL;
+		}
+
+		// Loaders walk the file front to back once.
+		madvise(view, mSize, MADV_SEQUENTIAL);
+		mData = static_cast<const std::uint8_t*>(view);
+	}
+
+	// The mapping keeps its own reference to the file.
+	close(fd);
+
+	return S_OK;
+}
+
+void FileMapping::Close()
+{
+	if(mData != nullptr)
+		munmap(const_cast<std::uint8_t*>(mData), mSize);
+
+	mData = nullptr;
+	mSize = 0;
+	mOpen = false;
+}
+
+#endif
+
+std::string WideToUtf8(const wchar_t* str)
+{
+	std::string out;
+	if(str == nullptr)
+		return out;
+
+	for(; *str != 0; ++str)
+	{
+		std::uint32_t c = (std::uint32_t)*str;
+
+		// wchar_t is UTF-16 on Windows.
+		if(sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF && str[1] >= 0xDC00 && str[1] <= 0xDFFF)
+		{
+			c = 0x10000 + ((c - 0xD800) << 10) + ((std::uint32_t)str[1] - 0xDC00);
+			++str;
+		}
+
+		if(c < 0x80)
+		{
+			out += (char)c;
+		}
+		else if(c < 0x800)
+		{
+			out += (char)(0xC0 | (c >> 6));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+		else if(c < 0x10000)
+		{
+			out += (char)(0xE0 | (c >> 12));
+			out += (char)(0x80 | ((c >> 6) & 0x3F));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			out += (char)(0xF0 | (c >> 18));
+			out += (char)(0x80 | ((c >> 12) & 0x3F));
+			out += (char)(0x80 | ((c >> 6) & 0x3F));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+	}
+
+	return out;
+}
+
+HRESULT OpenFileForRead(const wchar_t* fileName, FILE** file)
+{
+	if(fileName == nullptr || file == nullptr)
+		return E_INVALIDARG;
+
+	*file = nullptr;
+
+#if defined(_WIN32)
+	errno_t err = _wfopen_s(file, fileName, L"rb");
+	if(err != 0)
+	{
+		*file = nullptr;
+		return HResultFromErrno(err);
+	}
+#else
+	FILE* f = fopen(WideToUtf8(fileName).c_str(), "rb");
+	if(f == nullptr)
+		return HResultFromErrno(errno);
+
+	// fopen opens a directory here, and the first read then fails.
+	struct stat st;
+	int err = (fstat(fileno(f), &st) != 0) ? errno : (S_ISREG(st.st_mode) ? 0 : EISDIR);
+	if(err != 0)
+	{
+		fclose(f);
+		return HResultFromErrno(err);
+	}
+	*file = f;
+#endif
+
+	return S_OK;
+}
@@ -0,0 +1,53 @@
+//***************************************************************************************
+// FileMapping.h
+//
+// Read-only view of a whole file through the OS page cache (MapViewOfFile on Windows,
+// mmap elsewhere).  Loaders parse straight out of Data() instead of reading the file
+// into a heap buffer first.  Pointers into the view are valid until Close() or the
+// mapping is destroyed.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "Platform.h"
+
+class FileMapping
+{
+public:
+	FileMapping() = default;
+	FileMapping(const FileMapping& rhs) = delete;
+	FileMapping& operator=(const FileMapping& rhs) = delete;
+	FileMapping(FileMapping&& rhs) noexcept;
+	FileMapping& operator=(FileMapping&& rhs) noexcept;
+	~FileMapping();
+
+	// Maps the file read-only.  An empty file opens successfully with a null Data().
+	HRESULT Open(const wchar_t* fileName);
+	void Close();
+
+	bool IsOpen()const { return mOpen; }
+	const std::uint8_t* Data()const { return mData; }
+	std::size_t Size()const { return mSize; }
+
+private:
+	const std::uint8_t* mData = nullptr;
+	std::size_t mSize = 0;
+	bool mOpen = false;
+
+#if defined(_WIN32)
+	HANDLE mFile = nullptr;
+	HANDLE mMapping = nullptr;
+#endif
+};
+
+// File names are wchar_t throughout Common.  POSIX file APIs take UTF-8.
+std::string WideToUtf8(const wchar_t* str);
+
+// Opens fileName for binary reading with stdio.  Failures map to the same HRESULTs
+// on every platform (see HResultFromErrno); anything but a regular file is refused
+// with access denied, as _wfopen_s refuses a directory on Windows.
+HRESULT OpenFileForRead(const wchar_t* fileName, FILE** file);
@@ -0,0 +1,344 @@
+//***************************************************************************************
+// FileWatcher.cpp
+//***************************************************************************************
+
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// Every regular file in the directory, for an overflow.
+	void ListFiles(const std::wstring& directory, std::vector<std::wstring>& names)
+	{
+		std::error_code ec;
+		for(const auto& entry : fs::directory_iterator(directory, ec))
+		{
+			if(entry.is_regular_file(ec))
+				names.push_back(entry.path().filename().wstring());
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------
+// FileWatcher
+//---------------------------------------------------------------------------------------
+
+FileWatcher::FileWatcher(const std::wstring& directory)
+	: mDirectory(NormalizePath(directory))
+{
+}
+
+std::wstring FileWatcher::NormalizePath(const std::wstring& path)
+{
+	std::error_code ec;
+	fs::path absolute = fs::absolute(fs::path(path), ec);
+	if(ec)
+		absolute = fs::path(path);
+
+	std::wstring normal = absolute.lexically_normal().wstring();
+	while(normal.size() > 1 && (normal.back() == L'/' || normal.back() == L'\\'))
+		normal.pop_back();
+	return normal;
+}
+
+std::vector<std::wstring> FileWatcher::Poll()
+{
+	const Clock::time_point now = Clock::now();
+
+	std::vector<std::wstring> names;
+	bool overflow = false;
+	ReadChanges(names, overflow);
+	if(overflow)
+		ListFiles(mDirectory, names);
+
+	// Each new change restarts the file's settle time.
+	for(const std::wstring& name : names)
+		mUnsettled[name] = now;
+
+	std::vector<std::wstring> settled;
+	for(auto it = mUnsettled.begin(); it != mUnsettled.end();)
+	{
+		if(now - it->second >= mSettle)
+		{
+			settled.push_back((fs::path(mDirectory) / it->first).wstring());
+			it = mUnsettled.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	std::sort(settled.begin(), settled.end());
+	return settled;
+}
+
+namespace
+{
+	//-----------------------------------------------------------------------------------
+	// Polling: size and modification time of every file, a few times a second.
+	//-----------------------------------------------------------------------------------
+
+	class PollingFileWatcher : public FileWatcher
+	{
+	public:
+		explicit PollingFileWatcher(const std::wstring& directory)
+			: FileWatcher(directory)
+		{
+			Scan(nullptr);
+		}
+
+		const char* Name()const override { return "polling"; }
+
+	protected:
+		void ReadChanges(std::vector<std::wstring>& names, bool& overflow) override
+		{
+			overflow = false;
+
+			Clock::time_point now = Clock::now();
+			if(now - mLastScan < ScanInterval)
+				return;
+			mLastScan = now;
+
+			Scan(&names);
+		}
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr std::chrono::milliseconds ScanInterval{ 200 };
+
+		struct FileState
+		{
+			std::uintmax_t Size;
+			fs::file_time_type WriteTime;
+		};
+
+		// Records the state of every file; with names, also lists the ones that
+		// are new or differ from the last scan.
+		void Scan(std::vector<std::wstring>* names)
+		{
+			std::unordered_map<std::wstring, FileState> files;
+			std::error_code ec;
+			for(const auto& entry : fs::directory_iterator(Directory(), ec))
+			{
+				std::error_code fileEc;
+				if(!entry.is_regular_file(fileEc))
+					continue;
+
+				FileState state = { entry.file_size(fileEc), entry.last_write_time(fileEc) };
+				if(fileEc)
+					continue;
+
+				std::wstring name = entry.path().filename().wstring();
+				if(names != nullptr)
+				{
+					auto it = mFiles.find(name);
+					if(it == mFiles.end() || it->second.Size != state.Size || it->second.WriteTime != state.WriteTime)
+						names->push_back(name);
+				}
+				files.emplace(std::move(name), state);
+			}
+			mFiles.swap(files);
+		}
+
+		std::unordered_map<std::wstring, FileState> mFiles;
+		Clock::time_point mLastScan = Clock::now();
+	};
+
+#if defined(__linux__)
+
+	//-----------------------------------------------------------------------------------
+	// inotify.
+	//-----------------------------------------------------------------------------------
+
+	class InotifyFileWatcher : public FileWatcher
+	{
+	public:
+		explicit InotifyFileWatcher(const std::wstring& directory)
+			: FileWatcher(directory)
+		{
+		}
+
+		~InotifyFileWatcher()
+		{
+			if(mFd >= 0)
+				close(mFd);
+		}
+
+		bool Init()
+		{
+			mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if(mFd < 0)
+				return false;
+
+			std::string path = fs::path(Directory()).u8string();
+			return inotify_add_watch(mFd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0;
+		}
+
+		const char* Name()const override { return "inotify"; }
+
+	protected:
+		void ReadChanges(std::vector<std::wstring>& names, bool& overflow) override
+		{
+			overflow = false;
+
+			alignas(inotify_event) char buffer[16384];
+			for(;;)
+			{
+				ssize_t bytes = read(mFd, buffer, sizeof(buffer));
+				if(bytes <= 0)
+				{
+					if(bytes < 0 && errno == EINTR)
+						continue;
+					break;
+				}
+
+				for(ssize_t offset = 0; offset < bytes;)
+				{
+					const inotify_event* e = reinterpret_cast<const inotify_event*>(buffer + offset);
+					offset += sizeof(inotify_event) + e->len;
+
+					if(e->mask & IN_Q_OVERFLOW)
+						overflow = true;
+					else if(e->len > 0 && !(e->mask & IN_ISDIR))
+						names.push_back(fs::u8path(e->name).wstring());
+				}
+			}
+		}
+
+	private:
+		int mFd = -1;
+	};
+
+#elif defined(_WIN32)
+
+	//-----------------------------------------------------------------------------------
+	// ReadDirectoryChangesW, overlapped and checked without waiting.
+	//-----------------------------------------------------------------------------------
+
+	class Win32FileWatcher : public FileWatcher
+	{
+	public:
+		explicit Win32FileWatcher(const std::wstring& directory)
+			: FileWatcher(directory)
+		{
+		}
+
+		~Win32FileWatcher()
+		{
+			if(mDirectoryHandle != INVALID_HANDLE_VALUE)
+			{
+				CancelIoEx(mDirectoryHandle, &mOverlapped);
+				DWORD bytes = 0;
+				GetOverlappedResult(mDirectoryHandle, &mOverlapped, &bytes, TRUE);
+				CloseHandle(mDirectoryHandle);
+			}
+			if(mOverlapped.hEvent != nullptr)
+				CloseHandle(mOverlapped.hEvent);
+		}
+
+		bool Init()
+		{
+			mDirectoryHandle = CreateFileW(Directory().c_str(), FILE_LIST_DIRECTORY,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+				FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+			if(mDirectoryHandle == INVALID_HANDLE_VALUE)
+				return false;
+
+			mOverlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+			return mOverlapped.hEvent != nullptr && Issue();
+		}
+
+		const char* Name()const override { return "ReadDirectoryChangesW"; }
+
+	protected:
+		void ReadChanges(std::vector<std::wstring>& names, bool& overflow) override
+		{
+			overflow = false;
+
+			DWORD bytes = 0;
+			if(!GetOverlappedResult(mDirectoryHandle, &mOverlapped, &bytes, FALSE))
+			{
+				if(GetLastError() == ERROR_IO_INCOMPLETE)
+					return;
+				overflow = true;
+			}
+			else if(bytes == 0)
+			{
+				// The buffer overflowed and the changes were dropped.
+				overflow = true;
+			}
+			else
+			{
+				for(DWORD offset = 0;;)
+				{
+					const FILE_NOTIFY_INFORMATION* info =
+						reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(mBuffer + offset);
+					if(info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+						info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+						names.emplace_back(info->FileName, info->FileNameLength / sizeof(wchar_t));
+
+					if(info->NextEntryOffset == 0)
+						break;
+					offset += info->NextEntryOffset;
+				}
+			}
+
+			ResetEvent(mOverlapped.hEvent);
+			Issue();
+		}
+
+	private:
+		bool Issue()
+		{
+			return ReadDirectoryChangesW(mDirectoryHandle, mBuffer, sizeof(mBuffer), FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+				nullptr, &mOverlapped, nullptr) != FALSE;
+		}
+
+		HANDLE mDirectoryHandle = INVALID_HANDLE_VALUE;
+		OVERLAPPED mOverlapped = {};
+		alignas(DWORD) BYTE mBuffer[65536];
+	};
+
+#endif
+}
+
+std::unique_ptr<FileWatcher> CreateFileWatcher(const wchar_t* directory, FileWatchBackend backend)
+{
+	std::error_code ec;
+	if(directory == nullptr || !fs::is_directory(fs::path(directory), ec))
+		return nullptr;
+
+#if defined(__linux__)
+	if(backend != FileWatchBackend::Polling)
+	{
+		std::unique_ptr<InotifyFileWatcher> watcher(new InotifyFileWatcher(directory));
+		if(watcher->Init())
+			return watcher;
+	}
+#elif defined(_WIN32)
+	if(backend != FileWatchBackend::Polling)
+	{
+		std::unique_ptr<Win32FileWatcher> watcher(new Win32FileWatcher(directory));
+		if(watcher->Init())
+			return watcher;
+	}
+#endif
+
+	if(backend == FileWatchBackend::Native)
+		return nullptr;
+
+	return std::unique_ptr<FileWatcher>(new PollingFileWatcher(directory));
+}
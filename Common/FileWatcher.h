@@ -0,0 +1,82 @@
+//***************************************************************************************
+// FileWatcher.h
+//
+// Reports files in one directory (not its subdirectories) that have been written,
+// created or renamed into it, for hot reloading.  Poll() never blocks, so it can be
+// called once a frame.
+//
+// Backends:
+//   Native   inotify on Linux (IN_CLOSE_WRITE and IN_MOVED_TO, so a file is only
+//            reported once its writer has closed it or an atomic save has renamed it
+//            into place) and ReadDirectoryChangesW on Windows.
+//   Polling  Compares the size and modification time of every file a few times a
+//            second.  Works everywhere.
+// Default picks Native where it can be created and Polling otherwise.
+//
+// Editors often save in several steps, so a change is only reported once the file has
+// been quiet for the settle time.  If the OS drops events (its queue overflowed),
+// every file in the directory is reported.
+//
+// One thread drives a FileWatcher.
+//***************************************************************************************
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Platform.h"
+
+enum class FileWatchBackend
+{
+	Default,
+	Native,
+	Polling
+};
+
+class FileWatcher
+{
+public:
+	FileWatcher(const FileWatcher& rhs) = delete;
+	FileWatcher& operator=(const FileWatcher& rhs) = delete;
+	virtual ~FileWatcher() = default;
+
+	virtual const char* Name()const = 0;
+
+	// The watched directory as an absolute, normalized path.
+	const std::wstring& Directory()const { return mDirectory; }
+
+	// How long a file must go without further changes before it is reported.
+	// 50 ms by default.
+	void SetSettleTime(std::chrono::milliseconds settle) { mSettle = settle; }
+
+	// The files changed since the last call that have settled, as absolute paths in
+	// the same form as Directory(), each once, sorted.
+	std::vector<std::wstring> Poll();
+
+	// The same form for any path, so callers can match their own file names
+	// against what Poll() returns.
+	static std::wstring NormalizePath(const std::wstring& path);
+
+protected:
+	explicit FileWatcher(const std::wstring& directory);
+
+	// Appends the names, relative to the directory, of the files the backend has
+	// seen change since the last call.  Sets overflow if events were lost.
+	virtual void ReadChanges(std::vector<std::wstring>& names, bool& overflow) = 0;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	std::wstring mDirectory;
+	std::chrono::milliseconds mSettle{ 50 };
+	std::unordered_map<std::wstring, Clock::time_point> mUnsettled;
+};
+
+// Returns nullptr if the directory cannot be watched, or if backend is Native and
+// this system has no native backend.
+std::unique_ptr<FileWatcher> CreateFileWatcher(const wchar_t* directory,
+	FileWatchBackend backend = FileWatchBackend::Default);
@@ -0,0 +1,82 @@
+//***************************************************************************************
+// FrameRingAllocator.cpp
+//***************************************************************************************
+
+#include "FrameRingAllocator.h"
+#include <algorithm>
+
+FrameRingAllocator::FrameRingAllocator(std::uint64_t capacity)
+	: mCapacity(capacity)
+{
+}
+
+bool FrameRingAllocator::Allocate(std::uint64_t size, std::uint64_t alignment, std::uint64_t* offset)
+{
+	if(offset == nullptr || alignment == 0 || (alignment & (alignment - 1)) != 0)
+		return false;
+
+	// An empty ring starts again from the beginning, so one allocation can use all of
+	// it.  Frames still pending are empty too, so their ends move with it.
+	if(mUsed == 0 && mHead != 0)
+	{
+		mHead = 0;
+		mTail = 0;
+		for(Frame& f : mFrames)
+			f.End = 0;
+	}
+
+	std::uint64_t aligned = (mHead + alignment - 1) & ~(alignment - 1);
+	std::uint64_t start;
+	std::uint64_t consumed;
+
+	// Free space is [head, tail) once the head has wrapped behind the tail, and
+	// [head, capacity) followed by [0, tail) otherwise.
+	bool wrapped = mHead < mTail || (mHead == mTail && mUsed != 0);
+	std::uint64_t limit = wrapped ? mTail : mCapacity;
+	if(aligned <= limit && size <= limit - aligned)
+	{
+		start = aligned;
+		consumed = aligned + size - mHead;
+	}
+	else if(!wrapped && size <= mTail)
+	{
+		start = 0;
+		consumed = mCapacity - mHead + size;
+	}
+	else
+	{
+		++mStats.Failures;
+		return false;
+	}
+
+	mHead = start + size;
+	mUsed += consumed;
+	mCurrentBytes += consumed;
+
+	++mStats.Allocations;
+	mStats.AllocatedBytes += size;
+	mStats.WastedBytes += consumed - size;
+	mStats.PeakUsedBytes = std::max(mStats.PeakUsedBytes, mUsed);
+
+	*offset = start;
+	return true;
+}
+
+void FrameRingAllocator::FinishFrame(std::uint64_t fenceValue)
+{
+	mFrames.push_back({ fenceValue, mHead, mCurrentBytes });
+
+	mStats.FrameBytes = mCurrentBytes;
+	mStats.PeakFrameBytes = std::max(mStats.PeakFrameBytes, mCurrentBytes);
+	mCurrentBytes = 0;
+}
+
+void FrameRingAllocator::Reclaim(std::uint64_t completedFence)
+{
+	while(!mFrames.empty() && mFrames.front().FenceValue <= completedFence)
+	{
+		mTail = mFrames.front().End;
+		mUsed -= mFrames.front().Bytes;
+		mFrames.pop_front();
+	}
+}
@@ -0,0 +1,67 @@
+//***************************************************************************************
+// FrameRingAllocator.h
+//
+// Offset bookkeeping for a ring buffer of per-frame transient data.  Allocations are
+// handed out linearly from the head; at the end of a frame FinishFrame() tags every
+// byte allocated since the last call with the fence value the queue signals once
+// that frame has run, and Reclaim() moves the tail past the frames whose fence has
+// completed.  Nothing is freed individually.
+//
+// An allocation that does not fit before the end of the ring wraps to offset 0 and
+// the skipped bytes are charged to the current frame.  The class only deals in
+// offsets; FrameUploadAllocator puts it over a persistently mapped upload buffer.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+class FrameRingAllocator
+{
+public:
+	struct Stats
+	{
+		std::uint64_t Allocations = 0;
+		std::uint64_t AllocatedBytes = 0;  // requested sizes, without padding
+		std::uint64_t WastedBytes = 0;     // alignment padding and bytes skipped at a wrap
+		std::uint64_t Failures = 0;        // allocations that did not fit
+		std::uint64_t PeakUsedBytes = 0;
+		std::uint64_t FrameBytes = 0;      // used by the last finished frame
+		std::uint64_t PeakFrameBytes = 0;
+	};
+
+	explicit FrameRingAllocator(std::uint64_t capacity);
+
+	// Returns false, leaving the ring unchanged, when size bytes at alignment (a
+	// power of two) do not fit in the space the pending frames leave free.
+	bool Allocate(std::uint64_t size, std::uint64_t alignment, std::uint64_t* offset);
+
+	// Closes the current frame: its bytes are reclaimed once fenceValue completes.
+	void FinishFrame(std::uint64_t fenceValue);
+
+	// Releases every finished frame whose fence value is <= completedFence.
+	void Reclaim(std::uint64_t completedFence);
+
+	std::uint64_t Capacity()const { return mCapacity; }
+	std::uint64_t UsedBytes()const { return mUsed; }
+	std::uint64_t FreeBytes()const { return mCapacity - mUsed; }
+	std::size_t PendingFrames()const { return mFrames.size(); }
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	struct Frame
+	{
+		std::uint64_t FenceValue;
+		std::uint64_t End;    // head when the frame finished
+		std::uint64_t Bytes;  // everything the frame consumed, padding included
+	};
+
+	std::uint64_t mCapacity;
+	std::uint64_t mHead = 0;
+	std::uint64_t mTail = 0;
+	std::uint64_t mUsed = 0;
+	std::uint64_t mCurrentBytes = 0;
+	std::deque<Frame> mFrames;
+	Stats mStats;
+};
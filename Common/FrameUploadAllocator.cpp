@@ -0,0 +1,125 @@
+//***************************************************************************************
+// FrameUploadAllocator.cpp
+//***************************************************************************************
+
+#include "FrameUploadAllocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+FrameUploadAllocator::FrameUploadAllocator(ID3D12Device* device, UINT64 bytesPerFrame, UINT frameCount)
+	: md3dDevice(device), mRing(bytesPerFrame * frameCount)
+{
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(std::max<UINT64>(mRing.Capacity(), 1)),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&mBuffer)));
+
+	// Upload heaps are write-combined: write to the mapping, never read from it.
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(mBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mMappedData)));
+	mGpuAddress = mBuffer->GetGPUVirtualAddress();
+}
+
+FrameUploadAllocator::~FrameUploadAllocator()
+{
+	if(mBuffer != nullptr)
+		mBuffer->Unmap(0, nullptr);
+
+	mMappedData = nullptr;
+}
+
+void FrameUploadAllocator::BeginFrame(std::uint64_t completedFence)
+{
+	mRing.Reclaim(completedFence);
+
+	mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(),
+		[completedFence](const RetiredBuffer& r) { return r.FenceValue <= completedFence; }), mRetired.end());
+}
+
+void FrameUploadAllocator::EndFrame(std::uint64_t fenceValue)
+{
+	mRing.FinishFrame(fenceValue);
+
+	for(ComPtr<ID3D12Resource>& buffer : mOverflow)
+		mRetired.push_back({ std::move(buffer), fenceValue });
+	mOverflow.clear();
+}
+
+HRESULT FrameUploadAllocator::TryAllocate(UINT64 size, UINT64 alignment, Allocation& allocation)
+{
+	allocation = Allocation();
+
+	std::uint64_t offset = 0;
+	if(mRing.Allocate(size, alignment, &offset))
+	{
+		allocation.CpuAddress = mMappedData + offset;
+		allocation.GpuAddress = mGpuAddress + offset;
+		allocation.Resource = mBuffer.Get();
+		allocation.Offset = offset;
+		allocation.Size = size;
+		return S_OK;
+	}
+
+	// Buffers are 64 KiB aligned, which covers every alignment asked for here.
+	ComPtr<ID3D12Resource> buffer;
+	HRESULT hr = md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(std::max<UINT64>(size, 1)),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&buffer));
+	if(FAILED(hr))
+		return hr;
+
+	// Left mapped until it is released.
+	CD3DX12_RANGE readRange(0, 0);
+	void* mapped = nullptr;
+	hr = buffer->Map(0, &readRange, &mapped);
+	if(FAILED(hr))
+		return hr;
+
+	allocation.CpuAddress = static_cast<BYTE*>(mapped);
+	allocation.GpuAddress = buffer->GetGPUVirtualAddress();
+	allocation.Resource = buffer.Get();
+	allocation.Size = size;
+
+	mOverflow.push_back(std::move(buffer));
+	++mStats.OverflowBuffers;
+	mStats.OverflowBytes += size;
+	return S_OK;
+}
+
+FrameUploadAllocator::Allocation FrameUploadAllocator::Allocate(UINT64 size, UINT64 alignment)
+{
+	Allocation a;
+	ThrowIfFailed(TryAllocate(size, alignment, a));
+	return a;
+}
+
+FrameUploadAllocator::Allocation FrameUploadAllocator::Copy(const void* data, UINT64 size, UINT64 alignment)
+{
+	Allocation a = Allocate(size, alignment);
+	memcpy(a.CpuAddress, data, (size_t)size);
+	return a;
+}
+
+void FrameUploadAllocator::CopyToBuffer(
+	ID3D12GraphicsCommandList* cmdList,
+	ID3D12Resource* dst,
+	UINT64 dstOffset,
+	const void* data,
+	UINT64 size,
+	D3D12_RESOURCE_STATES stateAfter)
+{
+	Allocation staging = Copy(data, size, 16);
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(dst,
+		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
+	cmdList->CopyBufferRegion(dst, dstOffset, staging.Resource, staging.Offset, size);
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(dst,
+		D3D12_RESOURCE_STATE_COPY_DEST, stateAfter));
+}
@@ -0,0 +1,123 @@
+//***************************************************************************************
+// FrameUploadAllocator.h
+//
+// Per-frame transient data (constants, dynamic vertices, staging for copies) carved
+// out of one large upload buffer that stays mapped for its whole life, instead of an
+// UploadBuffer per type.  Allocations are linear and 256-byte aligned by default, so
+// any of them can back a constant buffer view; they stay valid until the frame they
+// were made in has finished on the GPU and are then reclaimed all at once.
+//
+// The buffer holds frameCount (by default gNumFrameResources) frames of
+// bytesPerFrame.  Each frame:
+//
+//   1. BeginFrame() with the completed fence value, once the frame resource about
+//      to be reused has finished (the usual wait on its fence).
+//   2. Allocate() / Copy() as needed while recording.
+//   3. EndFrame() with the fence value the queue signals for that frame.
+//
+// An allocation that does not fit in the free part of the ring gets a committed
+// upload buffer of its own, released with the frame it was made in.  Size
+// bytesPerFrame for the busiest frame so that stays rare; Stats counts them.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "FrameRingAllocator.h"
+
+class FrameUploadAllocator
+{
+public:
+	struct Allocation
+	{
+		BYTE* CpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+		ID3D12Resource* Resource = nullptr;
+		UINT64 Offset = 0;              // within Resource, for CopyBufferRegion and friends
+		UINT64 Size = 0;
+	};
+
+	struct Stats
+	{
+		std::uint64_t OverflowBuffers = 0;  // allocations that did not fit in the ring
+		std::uint64_t OverflowBytes = 0;
+	};
+
+	FrameUploadAllocator(ID3D12Device* device, UINT64 bytesPerFrame, UINT frameCount = gNumFrameResources);
+	FrameUploadAllocator(const FrameUploadAllocator& rhs) = delete;
+	FrameUploadAllocator& operator=(const FrameUploadAllocator& rhs) = delete;
+	~FrameUploadAllocator();
+
+	// Releases the space of every frame whose fence value is <= completedFence.
+	void BeginFrame(std::uint64_t completedFence);
+
+	// Tags everything allocated since BeginFrame with fenceValue.
+	void EndFrame(std::uint64_t fenceValue);
+
+	// alignment must be a power of two: 256 for constant buffers, 512 for texture
+	// copies (D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT).  Throws DxException if an
+	// overflow buffer cannot be created.
+	Allocation Allocate(UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+	// Same as Allocate, but returns the error instead of throwing.
+	HRESULT TryAllocate(UINT64 size, UINT64 alignment, Allocation& allocation);
+
+	// Allocates and copies size bytes of data in one go.
+	Allocation Copy(const void* data, UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+	// Stages size bytes of data and records their copy into dst at dstOffset on
+	// cmdList.  dst must be in D3D12_RESOURCE_STATE_COMMON and ends up in stateAfter.
+	void CopyToBuffer(
+		ID3D12GraphicsCommandList* cmdList,
+		ID3D12Resource* dst,
+		UINT64 dstOffset,
+		const void* data,
+		UINT64 size,
+		D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// One constant buffer's worth, padded to 256 bytes; bind with
+	// SetGraphicsRootConstantBufferView(slot, AllocateConstants(c)).
+	template<typename T>
+	D3D12_GPU_VIRTUAL_ADDRESS AllocateConstants(const T& constants)
+	{
+		Allocation a = Allocate(d3dUtil::CalcConstantBufferByteSize(sizeof(T)));
+		memcpy(a.CpuAddress, &constants, sizeof(T));
+		return a.GpuAddress;
+	}
+
+	// Copies a vertex stream for this frame only.
+	template<typename T>
+	D3D12_VERTEX_BUFFER_VIEW AllocateVertices(const T* vertices, UINT count)
+	{
+		Allocation a = Copy(vertices, (UINT64)sizeof(T) * count);
+
+		D3D12_VERTEX_BUFFER_VIEW vbv;
+		vbv.BufferLocation = a.GpuAddress;
+		vbv.StrideInBytes = sizeof(T);
+		vbv.SizeInBytes = (UINT)a.Size;
+		return vbv;
+	}
+
+	ID3D12Resource* Resource()const { return mBuffer.Get(); }
+	ID3D12Device* Device()const { return md3dDevice; }
+	const FrameRingAllocator& Ring()const { return mRing; }
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	struct RetiredBuffer
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		std::uint64_t FenceValue;
+	};
+
+	ID3D12Device* md3dDevice;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mBuffer;
+	BYTE* mMappedData = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS mGpuAddress = 0;
+	FrameRingAllocator mRing;
+
+	// Overflow buffers of the current frame, and of finished frames still in flight.
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mOverflow;
+	std::vector<RetiredBuffer> mRetired;
+	Stats mStats;
+};
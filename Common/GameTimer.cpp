@@ -2,15 +2,47 @@
 // GameTimer.cpp by Frank Luna (C) 2011 All Rights Reserved.
 //***************************************************************************************
 
-#include <windows.h>
 #include "GameTimer.h"
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+namespace
+{
+	// Raw counter reads.  The performance counter on Windows, and a steady
+	// nanosecond clock everywhere else.
+	std::int64_t QueryCounter()
+	{
+#if defined(_WIN32)
+		LARGE_INTEGER count;
+		QueryPerformanceCounter(&count);
+		return count.QuadPart;
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	std::int64_t QueryCounterFrequency()
+	{
+#if defined(_WIN32)
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency(&freq);
+		return freq.QuadPart;
+#else
+		return 1000000000;
+#endif
+	}
+}
+
 GameTimer::GameTimer()
 : mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0), 
   mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
 {
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
+	std::int64_t countsPerSec = QueryCounterFrequency();
 	mSecondsPerCount = 1.0 / (double)countsPerSec;
 }
 
@@ -55,8 +87,7 @@ float GameTimer::DeltaTime()const
 
 void GameTimer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	std::int64_t currTime = QueryCounter();
 
 	mBaseTime = currTime;
 	mPrevTime = currTime;
@@ -66,8 +97,7 @@ void GameTimer::Reset()
 
 void GameTimer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	std::int64_t startTime = QueryCounter();
 
 
 	// Accumulate the time elapsed between stop and start pairs.
@@ -90,8 +120,7 @@ void GameTimer::Stop()
 {
 	if( !mStopped )
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+		std::int64_t currTime = QueryCounter();
 
 		mStopTime = currTime;
 		mStopped  = true;
@@ -106,8 +135,7 @@ void GameTimer::Tick()
 		return;
 	}
 
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	std::int64_t currTime = QueryCounter();
 	mCurrTime = currTime;
 
 	// Time difference between this frame and the previous.
@@ -128,15 +128,17 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	meshData.Vertices.resize(0);
 	meshData.Indices32.resize(0);
 
-	//       v1
-	//       *
-	//      / \
-	//     /   \
-	//  m0*-----*m1
-	//   / \   / \
-	//  /   \ /   \
-	// *-----*-----*
-	// v0    m2     v2
+	/*
+	       v1
+	       *
+	      / \
+	     /   \
+	  m0*-----*m1
+	   / \   / \
+	  /   \ /   \
+	 *-----*-----*
+	 v0    m2     v2
+	*/
 
 	uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
 	for(uint32 i = 0; i < numTris; ++i)
@@ -1091,8 +1093,10 @@ GeometryGenerator::MeshData GeometryGenerator::CreateTorus(float innerRadius, fl
 {
 	MeshData meshData;
 
-	float phiStep = XM_2PI / sliceCount;
-	float thetaStep = XM_2PI / stackCount;
+	// phi walks around the tube (one ring per stack) and theta walks around the
+	// y-axis (one vertex per slice).
+	float phiStep = XM_2PI / stackCount;
+	float thetaStep = XM_2PI / sliceCount;
 
 	for (uint32 i = 0; i <= stackCount; ++i)
 	{
@@ -1140,4 +1144,87 @@ GeometryGenerator::MeshData GeometryGenerator::CreateTorus(float innerRadius, fl
 	}
 
 	return meshData;
-}
\ No newline at end of file
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, const AdaptiveTessellation& tess)
+{
+	float tol = ChordTolerance(2.0f*radius, tess);
+
+	// Slices sweep a full circle of the given radius; stacks sweep half of one.
+	uint32 sliceCount = ArcSegmentCount(radius, XM_2PI, tol, 3, tess);
+	uint32 stackCount = ArcSegmentCount(radius, XM_PI, tol, 2, tess);
+
+	return CreateSphere(radius, sliceCount, stackCount);
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateCylinder(float bottomRadius, float topRadius, float height, const AdaptiveTessellation& tess)
+{
+	float maxRadius = std::max(bottomRadius, topRadius);
+	float tol = ChordTolerance(sqrtf(4.0f*maxRadius*maxRadius + height*height), tess);
+
+	// The side is a ruled surface: every line of constant theta is straight, so
+	// one stack already has zero chord error along y.
+	uint32 sliceCount = ArcSegmentCount(maxRadius, XM_2PI, tol, 3, tess);
+
+	return CreateCylinder(bottomRadius, topRadius, height, sliceCount, 1);
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateCone(float radius, float topRadius, float bottomRadius, float height, const AdaptiveTessellation& tess)
+{
+	float maxRadius = std::max(radius, bottomRadius);
+	float tol = ChordTolerance(sqrtf(4.0f*maxRadius*maxRadius + height*height), tess);
+
+	// Like the cylinder, the lateral surface is straight from base to apex.
+	uint32 sliceCount = ArcSegmentCount(maxRadius, XM_2PI, tol, 3, tess);
+
+	return CreateCone(radius, topRadius, bottomRadius, height, sliceCount, 1);
+}
+
+GeometryGenerator::MeshData GeometryGenerator::CreateTorus(float innerRadius, float outerRadius, const AdaptiveTessellation& tess)
+{
+	float tol = ChordTolerance(2.0f*(outerRadius + innerRadius), tess);
+
+	// innerRadius is the radius of the tube and outerRadius the distance from the
+	// y-axis to the tube center.  The widest ring around the y-axis is on the
+	// outside of the tube, so it sets the slice count.
+	uint32 sliceCount = ArcSegmentCount(outerRadius + innerRadius, XM_2PI, tol, 3, tess);
+	uint32 stackCount = ArcSegmentCount(innerRadius, XM_2PI, tol, 3, tess);
+
+	return CreateTorus(innerRadius, outerRadius, sliceCount, stackCount);
+}
+
+float GeometryGenerator::ChordTolerance(float boundingDiameter, const AdaptiveTessellation& tess)
+{
+	// Convert the pixel error into object space: one pixel covers
+	// boundingDiameter/ScreenSize units when the shape fills ScreenSize pixels.
+	if(tess.ScreenSize <= 0.0f)
+		return tess.MaxChordError;
+
+	return tess.MaxChordError * boundingDiameter / tess.ScreenSize;
+}
+
+GeometryGenerator::uint32 GeometryGenerator::ArcSegmentCount(float radius, float arcAngle, float tolerance, uint32 minSegments, const AdaptiveTessellation& tess)
+{
+	uint32 lo = std::max(minSegments, tess.MinSegments);
+	uint32 hi = std::max(lo, tess.MaxSegments);
+
+	if(radius <= 0.0f || tolerance <= 0.0f)
+		return hi;
+
+	// A chord spanning angle a on a circle of radius r deviates from the arc by
+	// the sagitta r*(1 - cos(a/2)).  Solve for the largest a within tolerance and
+	// take the fewest equal segments that are no wider than that.
+	float ratio = 1.0f - tolerance/radius;
+	if(ratio <= -1.0f)
+		return lo;
+
+	float maxAngle = 2.0f*acosf(ratio);
+	if(maxAngle <= 0.0f)
+		return hi;
+
+	float n = ceilf(arcAngle/maxAngle);
+	if(n >= (float)hi)
+		return hi;
+
+	return std::max(lo, (uint32)n);
+}
@@ -74,6 +74,20 @@ public:
 		std::vector<uint16> mIndices16;
 	};
 
+	///<summary>
+	/// Error budget for the adaptive Create* overloads.  MaxChordError is the largest
+	/// allowed distance, in pixels, between the true surface and its triangles when
+	/// the shape's bounding diameter covers ScreenSize pixels.  A ScreenSize <= 0
+	/// means MaxChordError is already in object-space units.
+	///</summary>
+	struct AdaptiveTessellation
+	{
+		float MaxChordError = 0.5f;
+		float ScreenSize = 512.0f;
+		uint32 MinSegments = 3;
+		uint32 MaxSegments = 512;
+	};
+
 	///<summary>
 	/// Creates a box centered at the origin with the given dimensions, where each
     /// face has m rows and n columns of vertices.
@@ -122,10 +136,23 @@ public:
 
 	MeshData CreateTorus(float innerRadius, float outerRadius, uint32 sliceCount, uint32 stackCount);
 
+	///<summary>
+	/// Adaptive versions of the parametric shapes.  The slice and stack counts are
+	/// chosen per parametric direction as the fewest segments that keep the chord
+	/// error within the budget, so straight directions (the side of a cylinder or
+	/// cone) get a single stack while curved directions get as many as they need.
+	///</summary>
+    MeshData CreateSphere(float radius, const AdaptiveTessellation& tess);
+    MeshData CreateCylinder(float bottomRadius, float topRadius, float height, const AdaptiveTessellation& tess);
+	MeshData CreateCone(float radius, float topRadius, float bottomRadius, float height, const AdaptiveTessellation& tess);
+	MeshData CreateTorus(float innerRadius, float outerRadius, const AdaptiveTessellation& tess);
+
 	void Subdivide(MeshData& meshData);
 private:
 	
     Vertex MidPoint(const Vertex& v0, const Vertex& v1);
+    float ChordTolerance(float boundingDiameter, const AdaptiveTessellation& tess);
+    uint32 ArcSegmentCount(float radius, float arcAngle, float tolerance, uint32 minSegments, const AdaptiveTessellation& tess);
     void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
     void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
     void BuildConeBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
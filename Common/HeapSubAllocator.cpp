@@ -0,0 +1,403 @@
+//***************************************************************************************
+// HeapSubAllocator.cpp
+//***************************************************************************************
+
+#include "HeapSubAllocator.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Index of the lowest and highest set bit; x must not be 0.
+	int LowestBit(std::uint64_t x)
+	{
+#if defined(_MSC_VER)
+		unsigned long i;
+		_BitScanForward64(&i, x);
+		return (int)i;
+#else
+		return __builtin_ctzll(x);
+#endif
+	}
+
+	int HighestBit(std::uint64_t x)
+	{
+#if defined(_MSC_VER)
+		unsigned long i;
+		_BitScanReverse64(&i, x);
+		return (int)i;
+#else
+		return 63 - __builtin_clzll(x);
+#endif
+	}
+}
+
+const std::uint32_t HeapSubAllocator::InvalidBlock;
+
+HeapSubAllocator::HeapSubAllocator(std::uint64_t capacity, std::uint64_t granularity)
+{
+	if(granularity == 0)
+		granularity = 1;
+	mGranularityShift = HighestBit(granularity);
+	if((granularity & (granularity - 1)) != 0)
+		++mGranularityShift;
+	mGranularity = std::uint64_t(1) << mGranularityShift;
+	mCapacity = capacity & ~(mGranularity - 1);
+
+	for(int fl = 0; fl < FlCount; ++fl)
+	{
+		for(int sl = 0; sl < SlCount; ++sl)
+			mFreeLists[fl][sl] = InvalidBlock;
+	}
+
+	if(mCapacity != 0)
+	{
+		std::uint32_t b = NewBlock();
+		mBlocks[b].Offset = 0;
+		mBlocks[b].Size = mCapacity;
+		InsertFree(b);
+	}
+}
+
+void HeapSubAllocator::MapInsert(std::uint64_t units, int* fl, int* sl)
+{
+	// Sizes below SlCount granules get one class each; above that, each power of
+	// two is split into SlCount classes.
+	if(units < (std::uint64_t)SlCount)
+	{
+		*fl = 0;
+		*sl = (int)units;
+		return;
+	}
+
+	int f = HighestBit(units);
+	*fl = f - SlBits + 1;
+	*sl = (int)(units >> (f - SlBits)) - SlCount;
+}
+
+bool HeapSubAllocator::MapSearch(std::uint64_t units, int* fl, int* sl)
+{
+	// Round up to the next class boundary so any block in the class found fits.
+	if(units >= (std::uint64_t)SlCount)
+	{
+		std::uint64_t round = (std::uint64_t(1) << (HighestBit(units) - SlBits)) - 1;
+		if(units + round < units)
+			return false;
+		units += round;
+	}
+
+	MapInsert(units, fl, sl);
+	return *fl < FlCount;
+}
+
+std::uint32_t HeapSubAllocator::NewBlock()
+{
+	if(!mUnusedBlocks.empty())
+	{
+		std::uint32_t b = mUnusedBlocks.back();
+		mUnusedBlocks.pop_back();
+		mBlocks[b] = Block();
+		return b;
+	}
+
+	mBlocks.push_back(Block());
+	return (std::uint32_t)(mBlocks.size() - 1);
+}
+
+void HeapSubAllocator::InsertFree(std::uint32_t b)
+{
+	int fl, sl;
+	MapInsert(mBlocks[b].Size >> mGranularityShift, &fl, &sl);
+
+	std::uint32_t head = mFreeLists[fl][sl];
+	mBlocks[b].IsFree = true;
+	mBlocks[b].PrevFree = InvalidBlock;
+	mBlocks[b].NextFree = head;
+	if(head != InvalidBlock)
+		mBlocks[head].PrevFree = b;
+	mFreeLists[fl][sl] = b;
+
+	mFlBitmap |= std::uint64_t(1) << fl;
+	mSlBitmap[fl] |= 1u << sl;
+	++mFreeBlocks;
+}
+
+void HeapSubAllocator::RemoveFree(std::uint32_t b)
+{
+	int fl, sl;
+	MapInsert(mBlocks[b].Size >> mGranularityShift, &fl, &sl);
+
+	Block& block = mBlocks[b];
+	if(block.PrevFree != InvalidBlock)
+		mBlocks[block.PrevFree].NextFree = block.NextFree;
+	else
+		mFreeLists[fl][sl] = block.NextFree;
+	if(block.NextFree != InvalidBlock)
+		mBlocks[block.NextFree].PrevFree = block.PrevFree;
+
+	block.IsFree = false;
+	block.PrevFree = InvalidBlock;
+	block.NextFree = InvalidBlock;
+
+	if(mFreeLists[fl][sl] == InvalidBlock)
+	{
+		mSlBitmap[fl] &= ~(1u << sl);
+		if(mSlBitmap[fl] == 0)
+			mFlBitmap &= ~(std::uint64_t(1) << fl);
+	}
+	--mFreeBlocks;
+}
+
+std::uint32_t HeapSubAllocator::FindFree(std::uint64_t units)const
+{
+	int fl, sl;
+	if(MapSearch(units, &fl, &sl))
+	{
+		std::uint32_t slMap = mSlBitmap[fl] & (~0u << sl);
+		if(slMap == 0)
+		{
+			std::uint64_t flMap = fl + 1 < 64 ? mFlBitmap & (~std::uint64_t(0) << (fl + 1)) : 0;
+			if(flMap != 0)
+			{
+				fl = LowestBit(flMap);
+				slMap = mSlBitmap[fl];
+			}
+		}
+		if(slMap != 0)
+			return mFreeLists[fl][LowestBit(slMap)];
+	}
+
+	// The class units falls in may still hold a block large enough; rounding up
+	// skipped it.  Worth a look before giving up.
+	MapInsert(units, &fl, &sl);
+	if(fl >= FlCount)
+		return InvalidBlock;
+	for(std::uint32_t b = mFreeLists[fl][sl]; b != InvalidBlock; b = mBlocks[b].NextFree)
+	{
+		if((mBlocks[b].Size >> mGranularityShift) >= units)
+			return b;
+	}
+	return InvalidBlock;
+}
+
+std::uint32_t HeapSubAllocator::SplitFront(std::uint32_t b, std::uint64_t units)
+{
+	std::uint32_t n = NewBlock();
+	Block& block = mBlocks[b];
+	Block& front = mBlocks[n];
+
+	front.Offset = block.Offset;
+	front.Size = units << mGranularityShift;
+	front.PrevPhys = block.PrevPhys;
+	front.NextPhys = b;
+	if(block.PrevPhys != InvalidBlock)
+		mBlocks[block.PrevPhys].NextPhys = n;
+
+	block.PrevPhys = n;
+	block.Offset += front.Size;
+	block.Size -= front.Size;
+	return n;
+}
+
+bool HeapSubAllocator::Allocate(std::uint64_t size, std::uint64_t alignment, Allocation* alloc)
+{
+	if(alloc == nullptr || (alignment & (alignment - 1)) != 0 || size > mCapacity)
+		return false;
+	*alloc = Allocation();
+
+	if(alignment < mGranularity)
+		alignment = mGranularity;
+
+	std::uint64_t units = (size + mGranularity - 1) >> mGranularityShift;
+	if(units == 0)
+		units = 1;
+
+	// Ask for enough that the block can be aligned whatever its offset.
+	std::uint64_t slack = (alignment - mGranularity) >> mGranularityShift;
+	std::uint32_t b = FindFree(units + slack);
+	if(b == InvalidBlock && slack != 0)
+	{
+		// A block of the plain size may happen to be aligned already.
+		b = FindFree(units);
+		if(b != InvalidBlock && (mBlocks[b].Offset & (alignment - 1)) != 0)
+			b = InvalidBlock;
+	}
+	if(b == InvalidBlock)
+		return false;
+
+	RemoveFree(b);
+
+	std::uint64_t padding = ((mBlocks[b].Offset + alignment - 1) & ~(alignment - 1)) - mBlocks[b].Offset;
+	if(padding != 0)
+	{
+		// The block before b is in use (free blocks never touch), so the padding
+		// becomes a free block of its own.
+		InsertFree(SplitFront(b, padding >> mGranularityShift));
+	}
+
+	std::uint32_t used = b;
+	if((mBlocks[b].Size >> mGranularityShift) > units)
+	{
+		used = SplitFront(b, units);
+		InsertFree(b);
+	}
+
+	mUsed += mBlocks[used].Size;
+	++mAllocations;
+
+	alloc->Offset = mBlocks[used].Offset;
+	alloc->Size = mBlocks[used].Size;
+	alloc->Block = used;
+	return true;
+}
+
+void HeapSubAllocator::Free(const Allocation& alloc)
+{
+	std::uint32_t b = alloc.Block;
+	if(b >= mBlocks.size() || mBlocks[b].IsFree || mBlocks[b].Size == 0 ||
+		mBlocks[b].Offset != alloc.Offset)
+		return;
+
+	mUsed -= mBlocks[b].Size;
+	--mAllocations;
+
+	std::uint32_t prev = mBlocks[b].PrevPhys;
+	if(prev != InvalidBlock && mBlocks[prev].IsFree)
+	{
+		RemoveFree(prev);
+		mBlocks[b].Offset = mBlocks[prev].Offset;
+		mBlocks[b].Size += mBlocks[prev].Size;
+		mBlocks[b].PrevPhys = mBlocks[prev].PrevPhys;
+		if(mBlocks[b].PrevPhys != InvalidBlock)
+			mBlocks[mBlocks[b].PrevPhys].NextPhys = b;
+
+		mBlocks[prev] = Block();
+		mUnusedBlocks.push_back(prev);
+	}
+
+	std::uint32_t next = mBlocks[b].NextPhys;
+	if(next != InvalidBlock && mBlocks[next].IsFree)
+	{
+		RemoveFree(next);
+		mBlocks[b].Size += mBlocks[next].Size;
+		mBlocks[b].NextPhys = mBlocks[next].NextPhys;
+		if(mBlocks[b].NextPhys != InvalidBlock)
+			mBlocks[mBlocks[b].NextPhys].PrevPhys = b;
+
+		mBlocks[next] = Block();
+		mUnusedBlocks.push_back(next);
+	}
+
+	InsertFree(b);
+}
+
+HeapSubAllocator::Stats HeapSubAllocator::GetStats()const
+{
+	Stats s;
+	s.Capacity = mCapacity;
+	s.UsedBytes = mUsed;
+	s.FreeBytes = mCapacity - mUsed;
+	s.Allocations = mAllocations;
+	s.FreeBlocks = mFreeBlocks;
+
+	// The largest free block is in the highest non-empty class.
+	if(mFlBitmap != 0)
+	{
+		int fl = HighestBit(mFlBitmap);
+		int sl = HighestBit(mSlBitmap[fl]);
+		for(std::uint32_t b = mFreeLists[fl][sl]; b != InvalidBlock; b = mBlocks[b].NextFree)
+		{
+			if(mBlocks[b].Size > s.LargestFreeBlock)
+				s.LargestFreeBlock = mBlocks[b].Size;
+		}
+	}
+	return s;
+}
+
+bool HeapSubAllocator::Validate()const
+{
+	// Address order: the blocks tile [0, capacity) and no two free ones touch.
+	std::uint32_t first = InvalidBlock;
+	std::size_t live = 0;
+	for(std::uint32_t b = 0; b < mBlocks.size(); ++b)
+	{
+		if(mBlocks[b].Size == 0)
+			continue;
+		++live;
+		if(mBlocks[b].PrevPhys == InvalidBlock)
+		{
+			if(first != InvalidBlock)
+				return false;
+			first = b;
+		}
+	}
+	if(live + mUnusedBlocks.size() != mBlocks.size())
+		return false;
+	if(mCapacity == 0)
+		return live == 0;
+
+	std::uint64_t offset = 0;
+	std::uint64_t used = 0;
+	std::uint32_t allocations = 0;
+	std::uint32_t freeBlocks = 0;
+	std::size_t walked = 0;
+	bool prevFree = false;
+	for(std::uint32_t b = first; b != InvalidBlock; b = mBlocks[b].NextPhys)
+	{
+		const Block& block = mBlocks[b];
+		if(block.Offset != offset || block.Size == 0 || (block.Size & (mGranularity - 1)) != 0)
+			return false;
+		if(block.NextPhys != InvalidBlock && mBlocks[block.NextPhys].PrevPhys != b)
+			return false;
+		if(block.IsFree && prevFree)
+			return false;
+
+		if(block.IsFree)
+		{
+			++freeBlocks;
+		}
+		else
+		{
+			used += block.Size;
+			++allocations;
+		}
+		prevFree = block.IsFree;
+		offset += block.Size;
+		if(++walked > live)
+			return false;
+	}
+	if(offset != mCapacity || walked != live || used != mUsed || allocations != mAllocations ||
+		freeBlocks != mFreeBlocks)
+		return false;
+
+	// Size classes: every free block is listed once, in its own class, and the
+	// bitmaps mark exactly the non-empty lists.
+	std::uint32_t listed = 0;
+	for(int fl = 0; fl < FlCount; ++fl)
+	{
+		if(((mFlBitmap >> fl) & 1) != (mSlBitmap[fl] != 0 ? 1u : 0u))
+			return false;
+
+		for(int sl = 0; sl < SlCount; ++sl)
+		{
+			std::uint32_t head = mFreeLists[fl][sl];
+			if(((mSlBitmap[fl] >> sl) & 1) != (head != InvalidBlock ? 1u : 0u))
+				return false;
+
+			std::uint32_t prev = InvalidBlock;
+			for(std::uint32_t b = head; b != InvalidBlock; b = mBlocks[b].NextFree)
+			{
+				int f, s;
+				MapInsert(mBlocks[b].Size >> mGranularityShift, &f, &s);
+				if(!mBlocks[b].IsFree || f != fl || s != sl || mBlocks[b].PrevFree != prev)
+					return false;
+				if(++listed > mFreeBlocks)
+					return false;
+				prev = b;
+			}
+		}
+	}
+	return listed == mFreeBlocks;
+}
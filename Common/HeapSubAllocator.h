@@ -0,0 +1,113 @@
+//***************************************************************************************
+// HeapSubAllocator.h
+//
+// Two-level segregated fit (TLSF) allocator for ranges of one large heap.  Free
+// blocks are kept in lists by size class: a power of two, split into 16 linear
+// steps, with a bitmap over each level so finding a block that fits and freeing one
+// are constant time.  A freed block is merged with its free neighbours straight
+// away, so the heap never holds two adjacent free blocks.
+//
+// Only offsets are handed out; no memory is touched.  PlacedBufferAllocator uses it
+// to place buffers in ID3D12Heaps, and it runs on its own in the benchmarks.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class HeapSubAllocator
+{
+public:
+	// Block index meaning "no allocation".
+	static const std::uint32_t InvalidBlock = 0xFFFFFFFF;
+
+	struct Allocation
+	{
+		std::uint64_t Offset = 0;
+		std::uint64_t Size = 0;                 // rounded up to the granularity
+		std::uint32_t Block = InvalidBlock;
+	};
+
+	struct Stats
+	{
+		std::uint64_t Capacity = 0;
+		std::uint64_t UsedBytes = 0;
+		std::uint64_t FreeBytes = 0;
+		std::uint64_t LargestFreeBlock = 0;
+		std::uint32_t Allocations = 0;
+		std::uint32_t FreeBlocks = 0;
+
+		// 0 when all free space is one block, approaching 1 as it splinters: the
+		// share of free bytes that a request for the largest free block cannot use.
+		double Fragmentation()const
+		{
+			return FreeBytes == 0 ? 0.0 : 1.0 - (double)LargestFreeBlock / (double)FreeBytes;
+		}
+	};
+
+	// Manages [0, capacity).  Every offset and size is a multiple of granularity (a
+	// power of two); capacity is rounded down to one.
+	HeapSubAllocator(std::uint64_t capacity, std::uint64_t granularity = 256);
+
+	// Finds size bytes at alignment (a power of two, at least the granularity is
+	// used).  Returns false, changing nothing, when no free block can hold them.
+	bool Allocate(std::uint64_t size, std::uint64_t alignment, Allocation* alloc);
+
+	// Returns an allocation and merges it with its free neighbours.
+	void Free(const Allocation& alloc);
+
+	Stats GetStats()const;
+
+	// Walks every block and checks the lists, bitmaps and counters against them.
+	bool Validate()const;
+
+	std::uint64_t Capacity()const { return mCapacity; }
+	std::uint64_t Granularity()const { return mGranularity; }
+	std::uint64_t UsedBytes()const { return mUsed; }
+	std::uint32_t AllocationCount()const { return mAllocations; }
+
+private:
+	static const int SlBits = 4;
+	static const int SlCount = 1 << SlBits;
+	static const int FlCount = 64 - SlBits;
+
+	struct Block
+	{
+		std::uint64_t Offset = 0;
+		std::uint64_t Size = 0;
+		std::uint32_t PrevPhys = InvalidBlock;  // neighbours in address order
+		std::uint32_t NextPhys = InvalidBlock;
+		std::uint32_t PrevFree = InvalidBlock;  // links in its size class list
+		std::uint32_t NextFree = InvalidBlock;
+		bool IsFree = false;
+	};
+
+	// Size class of a free block of units granules, and the first class whose
+	// blocks all hold at least units.
+	static void MapInsert(std::uint64_t units, int* fl, int* sl);
+	static bool MapSearch(std::uint64_t units, int* fl, int* sl);
+
+	std::uint32_t NewBlock();
+	void InsertFree(std::uint32_t b);
+	void RemoveFree(std::uint32_t b);
+	std::uint32_t FindFree(std::uint64_t units)const;
+
+	// Cuts the first units granules off block b into a block of its own, which is
+	// returned; the rest stays in b.
+	std::uint32_t SplitFront(std::uint32_t b, std::uint64_t units);
+
+	std::uint64_t mCapacity;
+	std::uint64_t mGranularity;
+	int mGranularityShift = 0;
+	std::uint64_t mUsed = 0;
+	std::uint32_t mAllocations = 0;
+	std::uint32_t mFreeBlocks = 0;
+
+	std::vector<Block> mBlocks;
+	std::vector<std::uint32_t> mUnusedBlocks;
+
+	std::uint64_t mFlBitmap = 0;
+	std::uint32_t mSlBitmap[FlCount] = {};
+	std::uint32_t mFreeLists[FlCount][SlCount];
+};
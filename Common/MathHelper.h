@@ -6,9 +6,10 @@
 
 #pragma once
 
-#include <Windows.h>
 #include <DirectXMath.h>
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
 
 class MathHelper
 {
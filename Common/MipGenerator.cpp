@@ -0,0 +1,597 @@
+//***************************************************************************************
+// MipGenerator.cpp
+//
+// Levels are kept in float between steps, so a long chain is not re-quantized at
+// every halving.  Each texel is four floats, which makes it one SSE register.
+//***************************************************************************************
+
+#include "MipGenerator.h"
+#include "BCDecode.h"
+#include "BCEncode.h"
+#include "PixelConvert.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if !defined(MIP_GENERATOR_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define MIP_GENERATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	// Rows per task when a level is split across the pool.
+	const std::uint32_t BandRows = 16;
+
+	//
+	// Colour space.
+	//
+
+	float SRGBToLinear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSRGB(float c)
+	{
+		return c <= 0.0031308f ? c*12.92f : 1.055f*std::pow(c, 1.0f / 2.4f) - 0.055f;
+	}
+
+	const std::uint32_t LinearTableSize = 65536;
+
+	struct ColourTables
+	{
+		float UnormToFloat[256];
+		float SRGBToLinear[256];
+
+		// Indexed by a linear value in [0,1] scaled to LinearTableSize - 1.  Fine
+		// enough that the darkest sRGB steps (about 3e-4 linear apart) stay distinct.
+		std::uint8_t LinearToSRGB[LinearTableSize];
+
+		ColourTables()
+		{
+			for(int i = 0; i < 256; ++i)
+			{
+				UnormToFloat[i] = i / 255.0f;
+				SRGBToLinear[i] = ::SRGBToLinear(i / 255.0f);
+			}
+			for(std::uint32_t i = 0; i < LinearTableSize; ++i)
+				LinearToSRGB[i] = (std::uint8_t)(::LinearToSRGB(i / float(LinearTableSize - 1))*255.0f + 0.5f);
+		}
+	};
+
+	const ColourTables& Tables()
+	{
+		static const ColourTables tables;
+		return tables;
+	}
+
+	//
+	// Filter kernels, as functions of distance in destination texels.
+	//
+
+	const float KernelRadius = 3.0f;
+	const float KaiserAlpha = 4.0f;
+
+	float Sinc(float x)
+	{
+		if(std::fabs(x) < 1e-6f)
+			return 1.0f;
+		const float px = 3.14159265f*x;
+		return std::sin(px) / px;
+	}
+
+	// Zeroth order modified Bessel function of the first kind, by its power series.
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		const float q = x*x*0.25f;
+		for(int k = 1; k < 32; ++k)
+		{
+			term *= q / float(k*k);
+			sum += term;
+			if(term < sum*1e-7f)
+				break;
+		}
+		return sum;
+	}
+
+	float Kernel(MipFilter filter, float t)
+	{
+		t = std::fabs(t);
+		if(t >= KernelRadius)
+			return 0.0f;
+
+		if(filter == MipFilter::Kaiser)
+		{
+			const float r = t / KernelRadius;
+			return Sinc(t)*BesselI0(KaiserAlpha*std::sqrt(1.0f - r*r)) / BesselI0(KaiserAlpha);
+		}
+		return Sinc(t)*Sinc(t / KernelRadius);
+	}
+
+	// Source texels and weights for each destination texel along one axis.
+	struct FilterTable
+	{
+		struct Tap
+		{
+			std::uint32_t Index;
+			float Weight;
+		};
+
+		std::vector<std::uint32_t> First;  // taps of texel x are [First[x], First[x + 1])
+		std::vector<Tap> Taps;
+	};
+
+	FilterTable BuildFilterTable(MipFilter filter, std::uint32_t srcSize, std::uint32_t dstSize, bool wrap)
+	{
+		FilterTable table;
+		table.First.reserve(dstSize + 1);
+
+		auto address = [&](int i)
+		{
+			if(wrap)
+				return (std::uint32_t)(((i % (int)srcSize) + (int)srcSize) % (int)srcSize);
+			return (std::uint32_t)std::min(std::max(i, 0), (int)srcSize - 1);
+		};
+
+		const float scale = float(srcSize) / float(dstSize);
+		for(std::uint32_t x = 0; x < dstSize; ++x)
+		{
+			const std::size_t first = table.Taps.size();
+			table.First.push_back((std::uint32_t)first);
+
+			if(filter == MipFilter::Box)
+			{
+				// Area of each source texel inside the destination texel's footprint.
+				const float lo = x*scale;
+				const float hi = (x + 1)*scale;
+				for(int i = (int)std::floor(lo); i < (int)std::ceil(hi); ++i)
+				{
+					float w = std::min(float(i + 1), hi) - std::max(float(i), lo);
+					if(w > 1e-6f)
+						table.Taps.push_back({ address(i), w });
+				}
+			}
+			else
+			{
+				const float centre = (x + 0.5f)*scale;
+				const float radius = KernelRadius*scale;
+				for(int i = (int)std::floor(centre - radius); i <= (int)std::ceil(centre + radius); ++i)
+				{
+					float w = Kernel(filter, (i + 0.5f - centre) / scale);
+					if(std::fabs(w) > 1e-6f)
+						table.Taps.push_back({ address(i), w });
+				}
+			}
+
+			float sum = 0.0f;
+			for(std::size_t t = first; t < table.Taps.size(); ++t)
+				sum += table.Taps[t].Weight;
+			for(std::size_t t = first; t < table.Taps.size(); ++t)
+				table.Taps[t].Weight /= sum;
+		}
+		table.First.push_back((std::uint32_t)table.Taps.size());
+
+		return table;
+	}
+
+	//
+	// Float levels.
+	//
+
+	struct FloatImage
+	{
+		std::uint32_t Width = 0;
+		std::uint32_t Height = 0;
+		std::vector<float> Texels;  // RGBA per texel
+
+		void Resize(std::uint32_t width, std::uint32_t height)
+		{
+			Width = width;
+			Height = height;
+			Texels.resize((std::size_t)width*height*4);
+		}
+
+		float* Row(std::uint32_t y) { return Texels.data() + (std::size_t)y*Width*4; }
+		const float* Row(std::uint32_t y)const { return Texels.data() + (std::size_t)y*Width*4; }
+	};
+
+	// Widens one row of RGBA8 to float, through the sRGB curve if needed.
+	void ToFloatRow(const std::uint8_t* in, std::uint32_t width, const MipOptions& options, float* out)
+	{
+		const ColourTables& tables = Tables();
+		const float* colour = options.SRGB && !options.NormalMap ? tables.SRGBToLinear : tables.UnormToFloat;
+		for(std::uint32_t x = 0; x < width; ++x)
+		{
+			out[4*x + 0] = colour[in[4*x + 0]];
+			out[4*x + 1] = colour[in[4*x + 1]];
+			out[4*x + 2] = colour[in[4*x + 2]];
+			out[4*x + 3] = tables.UnormToFloat[in[4*x + 3]];
+		}
+	}
+
+	// Horizontal pass over one row.
+	void FilterRow(const float* in, const FilterTable& table, std::uint32_t dstWidth, float* out)
+	{
+		for(std::uint32_t x = 0; x < dstWidth; ++x)
+		{
+			const FilterTable::Tap* tap = table.Taps.data() + table.First[x];
+			const FilterTable::Tap* end = table.Taps.data() + table.First[x + 1];
+#if MIP_GENERATOR_SSE2
+			__m128 sum = _mm_setzero_ps();
+			for(; tap != end; ++tap)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tap->Weight), _mm_loadu_ps(in + 4*tap->Index)));
+			_mm_storeu_ps(out + 4*x, sum);
+#else
+			float sum[4] = {};
+			for(; tap != end; ++tap)
+			{
+				for(int c = 0; c < 4; ++c)
+					sum[c] += tap->Weight*in[4*tap->Index + c];
+			}
+			memcpy(out + 4*x, sum, sizeof(sum));
+#endif
+		}
+	}
+
+	// Vertical pass: rows [y0, y1) of dst, clamped to [0,1] so ringing does not build
+	// up down the chain.  Source row needed[k] has been filtered horizontally into
+	// row k of filtered.  The sums for a run of columns stay in registers across all
+	// the taps.
+	void FilterColumns(const std::vector<std::uint32_t>& needed, const float* filtered, const FilterTable& table,
+		FloatImage& dst, std::uint32_t y0, std::uint32_t y1)
+	{
+		const std::size_t floats = (std::size_t)dst.Width*4;
+		std::vector<const float*> in;
+		std::vector<float> weights;
+		for(std::uint32_t y = y0; y < y1; ++y)
+		{
+			in.clear();
+			weights.clear();
+			for(std::uint32_t t = table.First[y]; t < table.First[y + 1]; ++t)
+			{
+				std::size_t k = std::lower_bound(needed.begin(), needed.end(), table.Taps[t].Index) - needed.begin();
+				in.push_back(filtered + k*floats);
+				weights.push_back(table.Taps[t].Weight);
+			}
+			const std::size_t taps = in.size();
+
+			float* out = dst.Row(y);
+			std::size_t i = 0;
+#if MIP_GENERATOR_SSE2
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			for(; i + 8 <= floats; i += 8)
+			{
+				__m128 a = _mm_setzero_ps();
+				__m128 b = _mm_setzero_ps();
+				for(std::size_t t = 0; t < taps; ++t)
+				{
+					const __m128 w = _mm_set1_ps(weights[t]);
+					a = _mm_add_ps(a, _mm_mul_ps(w, _mm_loadu_ps(in[t] + i)));
+					b = _mm_add_ps(b, _mm_mul_ps(w, _mm_loadu_ps(in[t] + i + 4)));
+				}
+				_mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(a, zero), one));
+				_mm_storeu_ps(out + i + 4, _mm_min_ps(_mm_max_ps(b, zero), one));
+			}
+#endif
+			for(; i < floats; ++i)
+			{
+				float sum = 0.0f;
+				for(std::size_t t = 0; t < taps; ++t)
+					sum += weights[t]*in[t][i];
+				out[i] = std::min(std::max(sum, 0.0f), 1.0f);
+			}
+		}
+	}
+
+	void Renormalize(FloatImage& image, std::uint32_t y0, std::uint32_t y1)
+	{
+		for(std::uint32_t y = y0; y < y1; ++y)
+		{
+			float* row = image.Row(y);
+			for(std::uint32_t x = 0; x < image.Width; ++x)
+			{
+				float* n = row + 4*x;
+				float vx = 2.0f*n[0] - 1.0f;
+				float vy = 2.0f*n[1] - 1.0f;
+				float vz = 2.0f*n[2] - 1.0f;
+				float len = std::sqrt(vx*vx + vy*vy + vz*vz);
+				if(len < 1e-6f)
+					continue;
+
+				len = 0.5f / len;
+				n[0] = vx*len + 0.5f;
+				n[1] = vy*len + 0.5f;
+				n[2] = vz*len + 0.5f;
+			}
+		}
+	}
+
+	void ToBytes(const FloatImage& src, const MipOptions& options, MipImage& dst, std::uint32_t y0, std::uint32_t y1)
+	{
+		const ColourTables& tables = Tables();
+		const bool srgb = options.SRGB && !options.NormalMap;
+		const float scale = srgb ? float(LinearTableSize - 1) : 255.0f;
+
+		for(std::uint32_t y = y0; y < y1; ++y)
+		{
+			const float* in = src.Row(y);
+			std::uint8_t* out = dst.Pixels.data() + (std::size_t)y*dst.Width*4;
+			for(std::uint32_t x = 0; x < src.Width; ++x)
+			{
+				int q[4];
+#if MIP_GENERATOR_SSE2
+				const __m128 scales = _mm_setr_ps(scale, scale, scale, 255.0f);
+				__m128i v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + 4*x), scales), _mm_set1_ps(0.5f)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(q), v);
+#else
+				for(int c = 0; c < 4; ++c)
+					q[c] = (int)(in[4*x + c]*(c == 3 ? 255.0f : scale) + 0.5f);
+#endif
+				for(int c = 0; c < 3; ++c)
+					out[4*x + c] = srgb ? tables.LinearToSRGB[q[c]] : (std::uint8_t)q[c];
+				out[4*x + 3] = (std::uint8_t)q[3];
+			}
+		}
+	}
+
+	// Runs fn(slice, y0, y1) over bands of height rows in every slice.
+	template<typename F>
+	void ForEachBand(ThreadPool* pool, std::size_t slices, std::uint32_t height, F&& fn)
+	{
+		const std::uint32_t bands = (height + BandRows - 1) / BandRows;
+		auto run = [&](std::size_t task)
+		{
+			std::size_t slice = task / bands;
+			std::uint32_t y0 = std::uint32_t(task % bands)*BandRows;
+			fn(slice, y0, std::min(y0 + BandRows, height));
+		};
+
+		if(pool)
+			pool->ParallelFor(slices*bands, run);
+		else
+		{
+			for(std::size_t task = 0; task < slices*bands; ++task)
+				run(task);
+		}
+	}
+
+	bool IsRGBA8(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	}
+
+	bool IsBGRA8(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
+			format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+	}
+}
+
+std::uint32_t FullMipCount(std::uint32_t width, std::uint32_t height)
+{
+	std::uint32_t count = 1;
+	while(width > 1 || height > 1)
+	{
+		width = std::max(1u, width >> 1);
+		height = std::max(1u, height >> 1);
+		++count;
+	}
+	return count;
+}
+
+HRESULT GenerateMips(
+	std::vector<std::vector<MipImage>>& chains,
+	const MipOptions& options,
+	ThreadPool* pool)
+{
+	if(chains.empty() || chains[0].empty())
+		return E_INVALIDARG;
+
+	const std::uint32_t width = chains[0][0].Width;
+	const std::uint32_t height = chains[0][0].Height;
+	for(const std::vector<MipImage>& chain : chains)
+	{
+		if(chain.size() != 1 || chain[0].Width != width || chain[0].Height != height ||
+			chain[0].Pixels.size() != (std::size_t)width*height*4 || width == 0 || height == 0)
+		{
+			return E_INVALIDARG;
+		}
+	}
+
+	const std::uint32_t fullCount = FullMipCount(width, height);
+	const std::uint32_t mipCount = options.MipCount ? std::min(options.MipCount, fullCount) : fullCount;
+	const std::size_t slices = chains.size();
+
+	// current holds the level above the one being built, except for the top level,
+	// which is widened a row at a time as it is read.  Each band of output rows
+	// filters just the source rows its taps reach, so the horizontal pass never
+	// needs a whole-level buffer; neighbouring bands recompute a few shared rows.
+	std::vector<FloatImage> current(slices);
+	std::vector<FloatImage> next(slices);
+
+	std::uint32_t srcWidth = width;
+	std::uint32_t srcHeight = height;
+	for(std::uint32_t mip = 1; mip < mipCount; ++mip)
+	{
+		const std::uint32_t dstWidth = std::max(1u, srcWidth >> 1);
+		const std::uint32_t dstHeight = std::max(1u, srcHeight >> 1);
+
+		const FilterTable horizontal = BuildFilterTable(options.Filter, srcWidth, dstWidth, options.Wrap);
+		const FilterTable vertical = BuildFilterTable(options.Filter, srcHeight, dstHeight, options.Wrap);
+
+		for(std::size_t s = 0; s < slices; ++s)
+		{
+			next[s].Resize(dstWidth, dstHeight);
+
+			MipImage level;
+			level.Width = dstWidth;
+			level.Height = dstHeight;
+			level.Pixels.resize((std::size_t)dstWidth*dstHeight*4);
+			chains[s].push_back(std::move(level));
+		}
+
+		ForEachBand(pool, slices, dstHeight, [&](std::size_t s, std::uint32_t y0, std::uint32_t y1)
+		{
+			std::vector<std::uint32_t> needed;
+			for(std::uint32_t t = vertical.First[y0]; t < vertical.First[y1]; ++t)
+				needed.push_back(vertical.Taps[t].Index);
+			std::sort(needed.begin(), needed.end());
+			needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+			const std::size_t floats = (std::size_t)dstWidth*4;
+			std::vector<float> filtered(needed.size()*floats);
+			std::vector<float> widened(mip == 1 ? (std::size_t)srcWidth*4 : 0);
+			for(std::size_t k = 0; k < needed.size(); ++k)
+			{
+				const float* in = nullptr;
+				if(mip == 1)
+				{
+					ToFloatRow(chains[s][0].Pixels.data() + (std::size_t)needed[k]*srcWidth*4, srcWidth, options, widened.data());
+					in = widened.data();
+				}
+				else
+					in = current[s].Row(needed[k]);
+
+				FilterRow(in, horizontal, dstWidth, filtered.data() + k*floats);
+			}
+
+			FilterColumns(needed, filtered.data(), vertical, next[s], y0, y1);
+			if(options.NormalMap)
+				Renormalize(next[s], y0, y1);
+			ToBytes(next[s], options, chains[s][mip], y0, y1);
+		});
+
+		current.swap(next);
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+	}
+
+	return S_OK;
+}
+
+HRESULT GenerateMissingMips(
+	DDS_TEXTURE_DATA& data,
+	const MipOptions& options,
+	ThreadPool* pool)
+{
+	DDS_TEXTURE_INFO& info = data.info;
+	if(info.mipCount > 1)
+		return S_FALSE;
+
+	if(info.dimension != DDS_DIMENSION_TEXTURE2D || data.subresources.size() != info.arraySize)
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	const DXGI_FORMAT format = info.format;
+	const bool compressed = IsDecodableBC(format);
+	if(compressed ? !IsEncodableBC(format) : !(IsRGBA8(format) || IsBGRA8(format)))
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+
+	MipOptions opt = options;
+	opt.SRGB = opt.SRGB || IsSRGB(format);
+
+	// BCDecode leaves blue at 0 for BC5, so a two-channel normal map gets its z back
+	// before filtering.
+	const bool rebuildZ = opt.NormalMap && (format == DXGI_FORMAT_BC5_UNORM || format == DXGI_FORMAT_BC5_TYPELESS);
+
+	std::vector<std::vector<MipImage>> chains(info.arraySize);
+	for(std::uint32_t slice = 0; slice < info.arraySize; ++slice)
+	{
+		MipImage& top = chains[slice].emplace_back();
+		top.Width = info.width;
+		top.Height = info.height;
+		top.Pixels.resize((std::size_t)info.width*info.height*4);
+
+		const DDS_SUBRESOURCE& src = data.subresources[slice];
+		if(compressed)
+		{
+			HRESULT hr = DecodeBC(format, src, info.width, info.height, top.Pixels.data(), (std::size_t)info.width*4);
+			if(FAILED(hr))
+				return hr;
+		}
+		else
+		{
+			for(std::uint32_t y = 0; y < info.height; ++y)
+			{
+				const std::uint8_t* in = static_cast<const std::uint8_t*>(src.pData) + y*src.rowPitch;
+				std::uint8_t* out = top.Pixels.data() + (std::size_t)y*info.width*4;
+				if(format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+					BGRX8ToRGBA8(in, out, info.width);
+				else if(IsBGRA8(format))
+					SwizzleRGBA8(in, out, info.width);
+				else
+					memcpy(out, in, (std::size_t)info.width*4);
+			}
+		}
+
+		if(rebuildZ)
+			ReconstructNormalZRGBA8(top.Pixels.data(), top.Pixels.data(), top.Pixels.size() / 4);
+	}
+
+	HRESULT hr = GenerateMips(chains, opt, pool);
+	if(FAILED(hr))
+		return hr;
+
+	// Lay the new chain out the way the loader does: mips of slice 0 first.
+	const std::uint32_t mipCount = (std::uint32_t)chains[0].size();
+	std::vector<size_t> offsets;
+	size_t total = 0;
+	for(std::uint32_t slice = 0; slice < info.arraySize; ++slice)
+	{
+		for(std::uint32_t mip = 0; mip < mipCount; ++mip)
+		{
+			size_t numBytes = 0;
+			GetSurfaceInfo(chains[slice][mip].Width, chains[slice][mip].Height, format, &numBytes, nullptr, nullptr);
+			offsets.push_back(total);
+			total += numBytes;
+		}
+	}
+
+	std::unique_ptr<uint8_t[]> pixels(new (std::nothrow) uint8_t[total]);
+	if(!pixels)
+		return E_OUTOFMEMORY;
+
+	std::vector<DDS_SUBRESOURCE> subresources;
+	for(std::uint32_t slice = 0; slice < info.arraySize; ++slice)
+	{
+		for(std::uint32_t mip = 0; mip < mipCount; ++mip)
+		{
+			const MipImage& level = chains[slice][mip];
+			size_t numBytes = 0;
+			size_t rowBytes = 0;
+			GetSurfaceInfo(level.Width, level.Height, format, &numBytes, &rowBytes, nullptr);
+
+			uint8_t* dst = pixels.get() + offsets[subresources.size()];
+			if(compressed)
+			{
+				hr = EncodeBC(format, level.Pixels.data(), level.Width, level.Height, (std::size_t)level.Width*4,
+					dst, rowBytes, pool);
+				if(FAILED(hr))
+					return hr;
+			}
+			else
+			{
+				memcpy(dst, level.Pixels.data(), numBytes);
+				if(IsBGRA8(format))
+					SwizzleRGBA8(dst, dst, numBytes / 4);
+			}
+
+			subresources.push_back({ dst, (intptr_t)rowBytes, (intptr_t)numBytes });
+		}
+	}
+
+	data.subresources.swap(subresources);
+	data.fileData = std::move(pixels);
+	data.fileSize = total;
+	data.mapping = FileMapping();
+	data.archive.reset();
+	info.mipCount = mipCount;
+	info.dataSize = total;
+	return S_OK;
+}
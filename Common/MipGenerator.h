@@ -0,0 +1,83 @@
+//***************************************************************************************
+// MipGenerator.h
+//
+// CPU mip chain generation for RGBA8 surfaces, for the cooker and for DDS files that
+// arrive with a single mip.
+//
+// Each level is resampled from the one above it by a separable filter evaluated in
+// float.  Box weights texels by the area they share with the destination texel, so it
+// is the classic 2x2 average on even sizes and still exact on odd ones.  Kaiser
+// (windowed sinc, alpha 4) and Lanczos-3 span three destination texels each side and
+// keep more detail at the cost of mild ringing, which is clamped.
+//
+// sRGB texels are converted to linear before filtering and back afterwards, so dark
+// and bright texels average to the correct brightness.  Alpha is always linear.
+// Normal maps are filtered as vectors and renormalized at every level.
+//
+// Levels depend on the level above them, so the work spread across a ThreadPool is
+// every array slice times bands of rows within a level.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "DDSTextureData.h"
+
+class ThreadPool;
+
+enum class MipFilter
+{
+	Box,
+	Kaiser,
+	Lanczos
+};
+
+struct MipOptions
+{
+	MipFilter Filter = MipFilter::Box;
+
+	// The colour channels are sRGB encoded.
+	bool SRGB = false;
+
+	// RGB holds a unit vector mapped to [0,1], as in *_nmap.dds.
+	bool NormalMap = false;
+
+	// Sample across the opposite edge instead of clamping, for tiling textures.
+	bool Wrap = false;
+
+	// Levels wanted including the top one; 0 for the full chain.
+	std::uint32_t MipCount = 0;
+};
+
+// One RGBA8 level, rows tightly packed, top row first.
+struct MipImage
+{
+	std::uint32_t Width = 0;
+	std::uint32_t Height = 0;
+	std::vector<std::uint8_t> Pixels;
+};
+
+// Levels in a full chain down to 1x1.
+std::uint32_t FullMipCount(std::uint32_t width, std::uint32_t height);
+
+// chains holds one chain per array slice (or cube face), each with its top level
+// filled in; all top levels must be the same size.  Appends the remaining levels.
+HRESULT GenerateMips(
+	std::vector<std::vector<MipImage>>& chains,
+	const MipOptions& options,
+	ThreadPool* pool = nullptr);
+
+// Fills in the mip chain of a loaded 2D texture (array or cube) that has only its
+// top level, in place: data then owns the new pixels and no longer needs its file.
+// Handles R8G8B8A8, B8G8R8A8 and B8G8R8X8 (UNORM and UNORM_SRGB), and the block-
+// compressed formats both BCDecode and BCEncode support, which are decoded,
+// filtered and re-encoded.  sRGB formats filter in linear space whatever
+// options.SRGB says.  Returns S_FALSE if data already has more than one mip.
+//
+// Do not pass the pool whose worker is running this call: ParallelFor would wait on
+// helpers queued behind the caller.
+HRESULT GenerateMissingMips(
+	DirectX::DDS_TEXTURE_DATA& data,
+	const MipOptions& options,
+	ThreadPool* pool = nullptr);
@@ -0,0 +1,71 @@
+//***************************************************************************************
+// NormalMap.cpp
+//***************************************************************************************
+
+#include "NormalMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	bool LoadNormal(const std::uint8_t* texel, double n[3])
+	{
+		double lengthSq = 0.0;
+		for(int c = 0; c < 3; ++c)
+		{
+			n[c] = texel[c]*(2.0 / 255.0) - 1.0;
+			lengthSq += n[c]*n[c];
+		}
+		if(lengthSq < 1e-8)
+			return false;
+
+		double scale = 1.0 / std::sqrt(lengthSq);
+		for(int c = 0; c < 3; ++c)
+			n[c] *= scale;
+		return true;
+	}
+}
+
+NormalMapEncoding GetNormalMapEncoding(DXGI_FORMAT format)
+{
+	switch(format)
+	{
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_R8G8_TYPELESS:
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_R8G8_SNORM:
+	case DXGI_FORMAT_R16G16_TYPELESS:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_SNORM:
+		return NormalMapEncoding::XY;
+	default:
+		return NormalMapEncoding::XYZ;
+	}
+}
+
+NormalMapError MeasureNormalMapError(const std::uint8_t* reference, const std::uint8_t* test, std::size_t count)
+{
+	const double degrees = 180.0 / 3.14159265358979323846;
+
+	NormalMapError error;
+	double sum = 0.0;
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		double a[3], b[3];
+		if(!LoadNormal(reference + 4*i, a) || !LoadNormal(test + 4*i, b))
+			continue;
+
+		double cosine = std::min(std::max(a[0]*b[0] + a[1]*b[1] + a[2]*b[2], -1.0), 1.0);
+		double angle = std::acos(cosine)*degrees;
+		sum += angle;
+		error.MaxDegrees = std::max(error.MaxDegrees, angle);
+		++error.Count;
+	}
+
+	if(error.Count > 0)
+		error.MeanDegrees = sum / error.Count;
+	return error;
+}
@@ -0,0 +1,43 @@
+//***************************************************************************************
+// NormalMap.h
+//
+// How a normal map stores its normals, and a check of how far a compressed copy
+// strays from its source.
+//
+// The *_nmap.dds sources keep the whole vector in RGB (XYZ).  TexCook cooks normal
+// maps to BC5, a quarter of the size of the 32-bit originals, which keeps only x and
+// y in two channels (XY); the shader rebuilds z, which is never negative in tangent
+// space:
+//
+//   float3 n;
+//   n.xy = gNormalMap.Sample(gsamAnisotropicWrap, uv).rg*2.0f - 1.0f;
+//   n.z = sqrt(saturate(1.0f - dot(n.xy, n.xy)));
+//
+// ReconstructNormalZRGBA8 (PixelConvert.h) is the CPU reference for that code.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Platform.h"
+
+enum class NormalMapEncoding : std::uint32_t
+{
+	XYZ = 0,
+	XY = 1
+};
+
+// XY for the two-channel formats (BC5, R8G8, R16G16), XYZ otherwise.
+NormalMapEncoding GetNormalMapEncoding(DXGI_FORMAT format);
+
+struct NormalMapError
+{
+	double MeanDegrees = 0.0;
+	double MaxDegrees = 0.0;
+	std::size_t Count = 0;      // texels compared; zero-length normals are skipped
+};
+
+// Angle between the normals of two RGBA8 images of count texels each, xyz in RGB
+// mapped to [0,1].  Both are renormalized first.
+NormalMapError MeasureNormalMapError(const std::uint8_t* reference, const std::uint8_t* test, std::size_t count);
@@ -0,0 +1,746 @@
+//***************************************************************************************
+// PixelConvert.cpp
+//
+// Each kernel runs its widest compiled path over as many pixels as it can, then the
+// next narrower one, and finishes the row in scalar code, so any count is handled
+// and the tails match the SIMD results exactly.
+//***************************************************************************************
+
+#include "PixelConvert.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+#if !defined(PIXEL_CONVERT_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define PIXEL_CONVERT_SSE2 1
+#include <emmintrin.h>
+#if defined(__SSSE3__) || defined(__AVX__)
+#define PIXEL_CONVERT_SSSE3 1
+#include <tmmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define PIXEL_CONVERT_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	//
+	// Colour space tables.
+	//
+
+	const std::uint32_t LinearTableSize = 65536;
+
+	struct ColourTables
+	{
+		// sRGB -> linear for the colour channels, then byte -> [0,1] for alpha, so
+		// one gather index serves a whole pixel.
+		float ToLinear[512];
+
+		// Indexed by a linear value in [0,1] scaled to LinearTableSize - 1.
+		std::uint8_t ToSRGB[LinearTableSize];
+
+		ColourTables()
+		{
+			for(int i = 0; i < 256; ++i)
+			{
+				float c = i / 255.0f;
+				ToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				ToLinear[256 + i] = c;
+			}
+			for(std::uint32_t i = 0; i < LinearTableSize; ++i)
+			{
+				float c = i / float(LinearTableSize - 1);
+				float s = c <= 0.0031308f ? c*12.92f : 1.055f*std::pow(c, 1.0f / 2.4f) - 0.055f;
+				ToSRGB[i] = (std::uint8_t)(s*255.0f + 0.5f);
+			}
+		}
+	};
+
+	const ColourTables& Tables()
+	{
+		static const ColourTables tables;
+		return tables;
+	}
+
+	std::uint8_t EncodeSRGB(const ColourTables& tables, float linear)
+	{
+		linear = std::min(std::max(linear, 0.0f), 1.0f);
+		return tables.ToSRGB[(std::uint32_t)(linear*(LinearTableSize - 1) + 0.5f)];
+	}
+
+	std::uint16_t Load16(const std::uint8_t* p)
+	{
+		return (std::uint16_t)(p[0] | (p[1] << 8));
+	}
+
+	// round(c*a/255) without a divide; exact for all byte inputs.
+	std::uint8_t MulDiv255(std::uint32_t c, std::uint32_t a)
+	{
+		std::uint32_t x = c*a + 128;
+		return (std::uint8_t)((x + (x >> 8)) >> 8);
+	}
+
+#if PIXEL_CONVERT_SSE2
+	// Same rounding on 16-bit lanes.
+	__m128i MulDiv255(__m128i c, __m128i a)
+	{
+		__m128i x = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+	}
+
+	// Alpha of each pixel in the colour lanes and 255 in the alpha lane, for two
+	// pixels widened to 16 bits.
+	__m128i AlphaMultiplier(__m128i px)
+	{
+		__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, 0xFF), 0xFF);
+		const __m128i alphaLane = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+		return _mm_or_si128(_mm_andnot_si128(alphaLane, a), _mm_and_si128(alphaLane, _mm_set1_epi16(255)));
+	}
+
+	__m128i SwapRB(__m128i v)
+	{
+#if PIXEL_CONVERT_SSSE3
+		return _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+#else
+		const __m128i rb = _mm_set1_epi32(0x00FF00FF);
+		__m128i swapped = _mm_and_si128(v, rb);
+		swapped = _mm_or_si128(_mm_slli_epi32(swapped, 16), _mm_srli_epi32(swapped, 16));
+		return _mm_or_si128(_mm_andnot_si128(rb, v), swapped);
+#endif
+	}
+
+	// Interleaves 16-bit r|g<<8 and b|a<<8 lanes into eight RGBA8 pixels.
+	void StoreRGBA8(std::uint8_t* out, __m128i rg, __m128i ba)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(rg, ba));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi16(rg, ba));
+	}
+#endif
+
+#if PIXEL_CONVERT_AVX2
+	__m256i MulDiv255(__m256i c, __m256i a)
+	{
+		__m256i x = _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+	}
+
+	__m256i AlphaMultiplier(__m256i px)
+	{
+		__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, 0xFF), 0xFF);
+		const __m256i alphaLane = _mm256_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1);
+		return _mm256_or_si256(_mm256_andnot_si256(alphaLane, a), _mm256_and_si256(alphaLane, _mm256_set1_epi16(255)));
+	}
+
+	__m256i SwapRB(__m256i v)
+	{
+		return _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+	}
+
+	// As StoreRGBA8, for sixteen pixels.  The unpacks work within 128-bit lanes, so
+	// the halves are put back in pixel order before storing.
+	void StoreRGBA8(std::uint8_t* out, __m256i rg, __m256i ba)
+	{
+		__m256i lo = _mm256_unpacklo_epi16(rg, ba);
+		__m256i hi = _mm256_unpackhi_epi16(rg, ba);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+#endif
+
+	//
+	// Format table.
+	//
+
+	struct FormatConversion
+	{
+		DXGI_FORMAT Source;
+		DXGI_FORMAT Target;
+		PixelRowFunction Convert;
+		bool HasAlpha;
+	};
+
+	const FormatConversion Conversions[] =
+	{
+		{ DXGI_FORMAT_B8G8R8A8_UNORM,      DXGI_FORMAT_R8G8B8A8_UNORM,      SwizzleRGBA8,    true },
+		{ DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, SwizzleRGBA8,    true },
+		{ DXGI_FORMAT_B8G8R8X8_UNORM,      DXGI_FORMAT_R8G8B8A8_UNORM,      BGRX8ToRGBA8,    false },
+		{ DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, BGRX8ToRGBA8,    false },
+		{ DXGI_FORMAT_B5G6R5_UNORM,        DXGI_FORMAT_R8G8B8A8_UNORM,      B5G6R5ToRGBA8,   false },
+		{ DXGI_FORMAT_B5G5R5A1_UNORM,      DXGI_FORMAT_R8G8B8A8_UNORM,      B5G5R5A1ToRGBA8, true },
+		{ DXGI_FORMAT_B4G4R4A4_UNORM,      DXGI_FORMAT_R8G8B8A8_UNORM,      B4G4R4A4ToRGBA8, true },
+	};
+
+	const FormatConversion* FindConversion(DXGI_FORMAT format)
+	{
+		for(const FormatConversion& c : Conversions)
+		{
+			if(c.Source == format)
+				return &c;
+		}
+		return nullptr;
+	}
+
+	bool IsStraightAlpha(DDS_ALPHA_MODE mode)
+	{
+		return mode == DDS_ALPHA_MODE_UNKNOWN || mode == DDS_ALPHA_MODE_STRAIGHT;
+	}
+}
+
+void SwizzleRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_AVX2
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4*i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4*i), SwapRB(v));
+	}
+#endif
+#if PIXEL_CONVERT_SSE2
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4*i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4*i), SwapRB(v));
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		std::uint8_t r = in[4*i + 2];
+		std::uint8_t b = in[4*i];
+		out[4*i] = r;
+		out[4*i + 1] = in[4*i + 1];
+		out[4*i + 2] = b;
+		out[4*i + 3] = in[4*i + 3];
+	}
+}
+
+void BGRX8ToRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_AVX2
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4*i));
+		v = _mm256_or_si256(SwapRB(v), _mm256_set1_epi32((int)0xFF000000));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4*i), v);
+	}
+#endif
+#if PIXEL_CONVERT_SSE2
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4*i));
+		v = _mm_or_si128(SwapRB(v), _mm_set1_epi32((int)0xFF000000));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4*i), v);
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		std::uint8_t r = in[4*i + 2];
+		std::uint8_t b = in[4*i];
+		out[4*i] = r;
+		out[4*i + 1] = in[4*i + 1];
+		out[4*i + 2] = b;
+		out[4*i + 3] = 255;
+	}
+}
+
+void BGR8ToRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+
+	// Each 16-byte load uses 12 bytes, so the loops stop while a full load still
+	// fits in the row.
+#if PIXEL_CONVERT_AVX2
+	const __m256i expand256 = _mm256_setr_epi8(
+		2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+		2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	for(; i + 10 <= count; i += 8)
+	{
+		__m256i v = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 3*i))),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 3*i + 12)), 1);
+		v = _mm256_or_si256(_mm256_shuffle_epi8(v, expand256), _mm256_set1_epi32((int)0xFF000000));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4*i), v);
+	}
+#endif
+#if PIXEL_CONVERT_SSSE3
+	const __m128i expand = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	for(; i + 6 <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 3*i));
+		v = _mm_or_si128(_mm_shuffle_epi8(v, expand), _mm_set1_epi32((int)0xFF000000));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4*i), v);
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		out[4*i] = in[3*i + 2];
+		out[4*i + 1] = in[3*i + 1];
+		out[4*i + 2] = in[3*i];
+		out[4*i + 3] = 255;
+	}
+}
+
+void B5G6R5ToRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_AVX2
+	for(; i + 16 <= count; i += 16)
+	{
+		__m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2*i));
+		__m256i r = _mm256_srli_epi16(p, 11);
+		__m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 5), _mm256_set1_epi16(0x3F));
+		__m256i b = _mm256_and_si256(p, _mm256_set1_epi16(0x1F));
+		r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+		g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+		b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+		StoreRGBA8(out + 4*i, _mm256_or_si256(r, _mm256_slli_epi16(g, 8)),
+			_mm256_or_si256(b, _mm256_set1_epi16((short)0xFF00)));
+	}
+#endif
+#if PIXEL_CONVERT_SSE2
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2*i));
+		__m128i r = _mm_srli_epi16(p, 11);
+		__m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), _mm_set1_epi16(0x3F));
+		__m128i b = _mm_and_si128(p, _mm_set1_epi16(0x1F));
+		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+		g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+		StoreRGBA8(out + 4*i, _mm_or_si128(r, _mm_slli_epi16(g, 8)),
+			_mm_or_si128(b, _mm_set1_epi16((short)0xFF00)));
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		std::uint32_t p = Load16(in + 2*i);
+		std::uint32_t r = p >> 11;
+		std::uint32_t g = (p >> 5) & 0x3F;
+		std::uint32_t b = p & 0x1F;
+		out[4*i] = (std::uint8_t)((r << 3) | (r >> 2));
+		out[4*i + 1] = (std::uint8_t)((g << 2) | (g >> 4));
+		out[4*i + 2] = (std::uint8_t)((b << 3) | (b >> 2));
+		out[4*i + 3] = 255;
+	}
+}
+
+void B5G5R5A1ToRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_AVX2
+	for(; i + 16 <= count; i += 16)
+	{
+		__m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2*i));
+		const __m256i five = _mm256_set1_epi16(0x1F);
+		__m256i r = _mm256_and_si256(_mm256_srli_epi16(p, 10), five);
+		__m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 5), five);
+		__m256i b = _mm256_and_si256(p, five);
+		__m256i a = _mm256_slli_epi16(_mm256_srai_epi16(p, 15), 8);
+		r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+		g = _mm256_or_si256(_mm256_slli_epi16(g, 3), _mm256_srli_epi16(g, 2));
+		b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+		StoreRGBA8(out + 4*i, _mm256_or_si256(r, _mm256_slli_epi16(g, 8)), _mm256_or_si256(b, a));
+	}
+#endif
+#if PIXEL_CONVERT_SSE2
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2*i));
+		const __m128i five = _mm_set1_epi16(0x1F);
+		__m128i r = _mm_and_si128(_mm_srli_epi16(p, 10), five);
+		__m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), five);
+		__m128i b = _mm_and_si128(p, five);
+		__m128i a = _mm_slli_epi16(_mm_srai_epi16(p, 15), 8);
+		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+		g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+		StoreRGBA8(out + 4*i, _mm_or_si128(r, _mm_slli_epi16(g, 8)), _mm_or_si128(b, a));
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		std::uint32_t p = Load16(in + 2*i);
+		std::uint32_t r = (p >> 10) & 0x1F;
+		std::uint32_t g = (p >> 5) & 0x1F;
+		std::uint32_t b = p & 0x1F;
+		out[4*i] = (std::uint8_t)((r << 3) | (r >> 2));
+		out[4*i + 1] = (std::uint8_t)((g << 3) | (g >> 2));
+		out[4*i + 2] = (std::uint8_t)((b << 3) | (b >> 2));
+		out[4*i + 3] = (p & 0x8000) ? 255 : 0;
+	}
+}
+
+void B4G4R4A4ToRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_AVX2
+	for(; i + 16 <= count; i += 16)
+	{
+		__m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2*i));
+		const __m256i nibble = _mm256_set1_epi16(0x0F);
+		__m256i b = _mm256_and_si256(p, nibble);
+		__m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 4), nibble);
+		__m256i r = _mm256_and_si256(_mm256_srli_epi16(p, 8), nibble);
+		__m256i a = _mm256_srli_epi16(p, 12);
+		// c * 17 spreads a nibble over the byte.
+		const __m256i seventeen = _mm256_set1_epi16(17);
+		StoreRGBA8(out + 4*i,
+			_mm256_or_si256(_mm256_mullo_epi16(r, seventeen), _mm256_slli_epi16(_mm256_mullo_epi16(g, seventeen), 8)),
+			_mm256_or_si256(_mm256_mullo_epi16(b, seventeen), _mm256_slli_epi16(_mm256_mullo_epi16(a, seventeen), 8)));
+	}
+#endif
+#if PIXEL_CONVERT_SSE2
+	for(; i + 8 <= count; i += 8)
+	{
+		__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2*i));
+		const __m128i nibble = _mm_set1_epi16(0x0F);
+		__m128i b = _mm_and_si128(p, nibble);
+		__m128i g = _mm_and_si128(_mm_srli_epi16(p, 4), nibble);
+		__m128i r = _mm_and_si128(_mm_srli_epi16(p, 8), nibble);
+		__m128i a = _mm_srli_epi16(p, 12);
+		const __m128i seventeen = _mm_set1_epi16(17);
+		StoreRGBA8(out + 4*i,
+			_mm_or_si128(_mm_mullo_epi16(r, seventeen), _mm_slli_epi16(_mm_mullo_epi16(g, seventeen), 8)),
+			_mm_or_si128(_mm_mullo_epi16(b, seventeen), _mm_slli_epi16(_mm_mullo_epi16(a, seventeen), 8)));
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		std::uint32_t p = Load16(in + 2*i);
+		out[4*i] = (std::uint8_t)(((p >> 8) & 0x0F)*17);
+		out[4*i + 1] = (std::uint8_t)(((p >> 4) & 0x0F)*17);
+		out[4*i + 2] = (std::uint8_t)((p & 0x0F)*17);
+		out[4*i + 3] = (std::uint8_t)((p >> 12)*17);
+	}
+}
+
+void PremultiplyRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_AVX2
+	const __m256i zero256 = _mm256_setzero_si256();
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4*i));
+		__m256i lo = _mm256_unpacklo_epi8(v, zero256);
+		__m256i hi = _mm256_unpackhi_epi8(v, zero256);
+		lo = MulDiv255(lo, AlphaMultiplier(lo));
+		hi = MulDiv255(hi, AlphaMultiplier(hi));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4*i), _mm256_packus_epi16(lo, hi));
+	}
+#endif
+#if PIXEL_CONVERT_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4*i));
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		lo = MulDiv255(lo, AlphaMultiplier(lo));
+		hi = MulDiv255(hi, AlphaMultiplier(hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4*i), _mm_packus_epi16(lo, hi));
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		std::uint32_t a = in[4*i + 3];
+		out[4*i] = MulDiv255(in[4*i], a);
+		out[4*i + 1] = MulDiv255(in[4*i + 1], a);
+		out[4*i + 2] = MulDiv255(in[4*i + 2], a);
+		out[4*i + 3] = (std::uint8_t)a;
+	}
+}
+
+void PremultiplySRGBA8(const void* src, void* dst, std::size_t count)
+{
+	// Two table lookups per channel; nothing for SIMD to speed up.
+	const ColourTables& tables = Tables();
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const std::uint8_t a = in[4*i + 3];
+		const float scale = tables.ToLinear[256 + a];
+		for(int c = 0; c < 3; ++c)
+			out[4*i + c] = EncodeSRGB(tables, tables.ToLinear[in[4*i + c]]*scale);
+		out[4*i + 3] = a;
+	}
+}
+
+void SRGBToLinearRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const ColourTables& tables = Tables();
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	float* out = static_cast<float*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_AVX2
+	// Two pixels per gather; alpha indexes the second half of the table.
+	const __m256i alphaOffset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+	for(; i + 2 <= count; i += 2)
+	{
+		__m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + 4*i));
+		__m256i index = _mm256_add_epi32(_mm256_cvtepu8_epi32(bytes), alphaOffset);
+		_mm256_storeu_ps(out + 4*i, _mm256_i32gather_ps(tables.ToLinear, index, 4));
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		out[4*i] = tables.ToLinear[in[4*i]];
+		out[4*i + 1] = tables.ToLinear[in[4*i + 1]];
+		out[4*i + 2] = tables.ToLinear[in[4*i + 2]];
+		out[4*i + 3] = tables.ToLinear[256 + in[4*i + 3]];
+	}
+}
+
+void LinearToSRGBRGBA8(const void* src, void* dst, std::size_t count)
+{
+	const ColourTables& tables = Tables();
+	const float* in = static_cast<const float*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_SSE2
+	// Clamp, scale and round in SIMD; the curve itself is a table lookup.
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_setr_ps(LinearTableSize - 1.0f, LinearTableSize - 1.0f, LinearTableSize - 1.0f, 255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	alignas(16) std::int32_t index[4];
+	for(; i < count; ++i)
+	{
+		__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + 4*i), zero), one);
+		_mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half)));
+		out[4*i] = tables.ToSRGB[index[0]];
+		out[4*i + 1] = tables.ToSRGB[index[1]];
+		out[4*i + 2] = tables.ToSRGB[index[2]];
+		out[4*i + 3] = (std::uint8_t)index[3];
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		out[4*i] = EncodeSRGB(tables, in[4*i]);
+		out[4*i + 1] = EncodeSRGB(tables, in[4*i + 1]);
+		out[4*i + 2] = EncodeSRGB(tables, in[4*i + 2]);
+		out[4*i + 3] = (std::uint8_t)(std::min(std::max(in[4*i + 3], 0.0f), 1.0f)*255.0f + 0.5f);
+	}
+}
+
+void ReconstructNormalZRGBA8(const void* src, void* dst, std::size_t count)
+{
+	// Every path evaluates the same float expression in the same order, so they round
+	// alike.
+	const std::uint8_t* in = static_cast<const std::uint8_t*>(src);
+	std::uint8_t* out = static_cast<std::uint8_t*>(dst);
+	std::size_t i = 0;
+#if PIXEL_CONVERT_AVX2
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4*i));
+		const __m256i byteMask = _mm256_set1_epi32(0xFF);
+		__m256 nx = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(v, byteMask)),
+			_mm256_set1_ps(2.0f / 255.0f)), _mm256_set1_ps(1.0f));
+		__m256 ny = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 8), byteMask)),
+			_mm256_set1_ps(2.0f / 255.0f)), _mm256_set1_ps(1.0f));
+		__m256 zz = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(nx, nx)), _mm256_mul_ps(ny, ny));
+		__m256 nz = _mm256_sqrt_ps(_mm256_max_ps(zz, _mm256_setzero_ps()));
+		__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nz, _mm256_set1_ps(127.5f)), _mm256_set1_ps(127.5f)),
+			_mm256_set1_ps(0.5f));
+		__m256i z = _mm256_slli_epi32(_mm256_cvttps_epi32(b), 16);
+		v = _mm256_or_si256(_mm256_andnot_si256(_mm256_set1_epi32(0x00FF0000), v), z);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4*i), v);
+	}
+#endif
+#if PIXEL_CONVERT_SSE2
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4*i));
+		const __m128i byteMask = _mm_set1_epi32(0xFF);
+		__m128 nx = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v, byteMask)),
+			_mm_set1_ps(2.0f / 255.0f)), _mm_set1_ps(1.0f));
+		__m128 ny = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8), byteMask)),
+			_mm_set1_ps(2.0f / 255.0f)), _mm_set1_ps(1.0f));
+		__m128 zz = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(nx, nx)), _mm_mul_ps(ny, ny));
+		__m128 nz = _mm_sqrt_ps(_mm_max_ps(zz, _mm_setzero_ps()));
+		__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nz, _mm_set1_ps(127.5f)), _mm_set1_ps(127.5f)), _mm_set1_ps(0.5f));
+		__m128i z = _mm_slli_epi32(_mm_cvttps_epi32(b), 16);
+		v = _mm_or_si128(_mm_andnot_si128(_mm_set1_epi32(0x00FF0000), v), z);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4*i), v);
+	}
+#endif
+	for(; i < count; ++i)
+	{
+		float nx = in[4*i]*(2.0f / 255.0f) - 1.0f;
+		float ny = in[4*i + 1]*(2.0f / 255.0f) - 1.0f;
+		float nz = std::sqrt(std::max(1.0f - nx*nx - ny*ny, 0.0f));
+		out[4*i] = in[4*i];
+		out[4*i + 1] = in[4*i + 1];
+		out[4*i + 2] = (std::uint8_t)(nz*127.5f + 127.5f + 0.5f);
+		out[4*i + 3] = in[4*i + 3];
+	}
+}
+
+const char* PixelConvertPath()
+{
+#if PIXEL_CONVERT_AVX2
+	return "avx2";
+#elif PIXEL_CONVERT_SSSE3
+	return "ssse3";
+#elif PIXEL_CONVERT_SSE2
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+DXGI_FORMAT GetConvertedFormat(DXGI_FORMAT format, const PixelConvertOptions& options)
+{
+	const FormatConversion* conversion = FindConversion(format);
+	return (options.ToRGBA8 && conversion != nullptr) ? conversion->Target : format;
+}
+
+HRESULT ConvertDDSTextureData(
+	DDS_TEXTURE_DATA& data,
+	const PixelConvertOptions& options,
+	ThreadPool* pool)
+{
+	DDS_TEXTURE_INFO& info = data.info;
+	const DXGI_FORMAT source = info.format;
+	const DXGI_FORMAT target = GetConvertedFormat(source, options);
+	const FormatConversion* conversion = target != source ? FindConversion(source) : nullptr;
+
+	// Premultiplication runs on the RGBA8 result (or on BGRA8 left as it is: the
+	// colour channels are treated alike).
+	const bool rgba8 = target == DXGI_FORMAT_R8G8B8A8_UNORM || target == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ||
+		target == DXGI_FORMAT_B8G8R8A8_UNORM || target == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+	const bool hasAlpha = conversion != nullptr ? conversion->HasAlpha : rgba8;
+	PixelRowFunction premultiply = nullptr;
+	if(options.PremultiplyAlpha && rgba8 && hasAlpha && IsStraightAlpha(info.alphaMode))
+		premultiply = IsSRGB(target) ? PremultiplySRGBA8 : PremultiplyRGBA8;
+
+	if(conversion == nullptr && premultiply == nullptr)
+		return S_FALSE;
+
+	if(data.subresources.size() != size_t(info.mipCount)*info.arraySize)
+		return E_INVALIDARG;
+
+	// One job per depth slice of every subresource; the new pixels keep the DDS
+	// layout, tightly packed.
+	struct Job
+	{
+		const std::uint8_t* Src;
+		intptr_t SrcRowPitch;
+		std::uint8_t* Dst;
+		size_t DstRowPitch;
+		std::uint32_t Width;
+		std::uint32_t Height;
+	};
+
+	std::vector<Job> jobs;
+	std::vector<DDS_SUBRESOURCE> subresources(data.subresources.size());
+	size_t total = 0;
+	for(int pass = 0; pass < 2; ++pass)
+	{
+		std::unique_ptr<std::uint8_t[]> pixels;
+		if(pass == 1)
+		{
+			pixels.reset(new (std::nothrow) std::uint8_t[total ? total : 1]);
+			if(!pixels)
+				return E_OUTOFMEMORY;
+		}
+
+		size_t offset = 0;
+		for(size_t index = 0; index < data.subresources.size(); ++index)
+		{
+			const std::uint32_t mip = std::uint32_t(index % info.mipCount);
+			const std::uint32_t w = std::max<std::uint32_t>(1, info.width >> mip);
+			const std::uint32_t h = std::max<std::uint32_t>(1, info.height >> mip);
+			const std::uint32_t d = std::max<std::uint32_t>(1, info.depth >> mip);
+
+			size_t numBytes = 0;
+			size_t rowBytes = 0;
+			GetSurfaceInfo(w, h, target, &numBytes, &rowBytes, nullptr);
+
+			if(pass == 1)
+			{
+				const DDS_SUBRESOURCE& src = data.subresources[index];
+				for(std::uint32_t z = 0; z < d; ++z)
+				{
+					Job job;
+					job.Src = static_cast<const std::uint8_t*>(src.pData) + z*src.slicePitch;
+					job.SrcRowPitch = src.rowPitch;
+					job.Dst = pixels.get() + offset + z*numBytes;
+					job.DstRowPitch = rowBytes;
+					job.Width = w;
+					job.Height = h;
+					jobs.push_back(job);
+				}
+				subresources[index] = { pixels.get() + offset, (intptr_t)rowBytes, (intptr_t)numBytes };
+			}
+
+			offset += numBytes*d;
+		}
+		total = offset;
+
+		if(pass == 1)
+		{
+			auto run = [&](size_t j)
+			{
+				const Job& job = jobs[j];
+				for(std::uint32_t y = 0; y < job.Height; ++y)
+				{
+					const std::uint8_t* in = job.Src + y*job.SrcRowPitch;
+					std::uint8_t* out = job.Dst + y*job.DstRowPitch;
+					if(conversion != nullptr)
+					{
+						conversion->Convert(in, out, job.Width);
+						in = out;
+					}
+					if(premultiply != nullptr)
+						premultiply(in, out, job.Width);
+				}
+			};
+
+			if(pool != nullptr && jobs.size() > 1)
+				pool->ParallelFor(jobs.size(), run);
+			else
+			{
+				for(size_t j = 0; j < jobs.size(); ++j)
+					run(j);
+			}
+
+			data.subresources.swap(subresources);
+			data.fileData = std::move(pixels);
+		}
+	}
+
+	data.fileSize = total;
+	data.mapping = FileMapping();
+	data.archive.reset();
+	info.format = target;
+	info.dataSize = total;
+	if(premultiply != nullptr)
+		info.alphaMode = DDS_ALPHA_MODE_PREMULTIPLIED;
+	return S_OK;
+}
@@ -0,0 +1,90 @@
+//***************************************************************************************
+// PixelConvert.h
+//
+// Row kernels for the pixel conversions between what files store and what the GPU
+// should sample: BGRA/RGBA swizzles, 24-bit BGR rows from BMP files, the 16-bit
+// B5G6R5, B5G5R5A1 and B4G4R4A4 formats (optional on some hardware), sRGB <-> linear,
+// premultiplied alpha and the z of two-channel normal maps.
+//
+// The kernels have AVX2 paths (built with /arch:AVX2 or -mavx2), SSE paths and a
+// scalar fallback, chosen when the file is compiled.  The swizzles use SSSE3 pshufb
+// where the compiler targets it and SSE2 shifts otherwise; 24-bit rows need SSSE3 to
+// vectorize at all.  The sRGB curves are table lookups: SRGBToLinearRGBA8 gathers on
+// AVX2, and PremultiplySRGBA8 is scalar everywhere.  Define PIXEL_CONVERT_NO_SIMD to
+// build the scalar fallback alone.  All paths produce the same bytes.
+//
+// ConvertDDSTextureData applies them to a loaded texture, keyed by its DXGI_FORMAT.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "DDSTextureData.h"
+
+class ThreadPool;
+
+// Converts count pixels from src to dst.  src and dst may be equal when the pixel
+// size does not change; otherwise they must not overlap.
+using PixelRowFunction = void (*)(const void* src, void* dst, std::size_t count);
+
+// RGBA8 <-> BGRA8 (the same swap both ways).
+void SwizzleRGBA8(const void* src, void* dst, std::size_t count);
+
+// BGRX8 -> RGBA8 with alpha 255.
+void BGRX8ToRGBA8(const void* src, void* dst, std::size_t count);
+
+// 24-bit BGR (BMP rows) -> RGBA8 with alpha 255.
+void BGR8ToRGBA8(const void* src, void* dst, std::size_t count);
+
+// 16-bit formats -> RGBA8, replicating the high bits into the low ones so that full
+// scale maps to 255.
+void B5G6R5ToRGBA8(const void* src, void* dst, std::size_t count);
+void B5G5R5A1ToRGBA8(const void* src, void* dst, std::size_t count);
+void B4G4R4A4ToRGBA8(const void* src, void* dst, std::size_t count);
+
+// Straight alpha RGBA8 -> premultiplied, rounding c*a/255 to nearest.
+void PremultiplyRGBA8(const void* src, void* dst, std::size_t count);
+
+// The same for sRGB colour: multiplied in linear space and re-encoded.
+void PremultiplySRGBA8(const void* src, void* dst, std::size_t count);
+
+// sRGB RGBA8 -> linear RGBA32F (alpha stays linear, scaled to [0,1]).
+void SRGBToLinearRGBA8(const void* src, void* dst, std::size_t count);
+
+// Linear RGBA32F -> sRGB RGBA8, clamped to [0,1] and rounded to nearest.
+void LinearToSRGBRGBA8(const void* src, void* dst, std::size_t count);
+
+// Two-channel normal map (x in R, y in G, as BCDecode leaves BC5) -> RGBA8 with
+// z = sqrt(1 - x^2 - y^2) rebuilt into B; R, G and A are copied.  The CPU reference
+// for the shader-side reconstruction (see NormalMap.h).
+void ReconstructNormalZRGBA8(const void* src, void* dst, std::size_t count);
+
+// The instruction set the kernels were compiled for: "avx2", "ssse3", "sse2" or
+// "scalar".
+const char* PixelConvertPath();
+
+struct PixelConvertOptions
+{
+	// BGRA, BGRX and the 16-bit formats become R8G8B8A8 (keeping _SRGB), so the
+	// texture does not depend on optional format support or on a swizzle in the
+	// shader.
+	bool ToRGBA8 = true;
+
+	// Straight alpha is multiplied into the colour channels of RGBA8 results and the
+	// texture is marked DDS_ALPHA_MODE_PREMULTIPLIED.  Textures already premultiplied
+	// or opaque are left alone.
+	bool PremultiplyAlpha = false;
+};
+
+// The format a texture of format ends up in under options; format itself when no
+// conversion applies.
+DXGI_FORMAT GetConvertedFormat(DXGI_FORMAT format, const PixelConvertOptions& options);
+
+// Converts every subresource of a loaded texture to GetConvertedFormat, in place:
+// data then owns the new pixels and no longer needs its file.  Returns S_FALSE if
+// nothing applies to its format and alpha mode.
+HRESULT ConvertDDSTextureData(
+	DirectX::DDS_TEXTURE_DATA& data,
+	const PixelConvertOptions& options,
+	ThreadPool* pool = nullptr);
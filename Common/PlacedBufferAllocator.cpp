@@ -0,0 +1,144 @@
+//***************************************************************************************
+// PlacedBufferAllocator.cpp
+//***************************************************************************************
+
+#include "PlacedBufferAllocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+const std::uint32_t PlacedBufferAllocator::InvalidPage;
+
+PlacedBufferAllocator::PlacedBufferAllocator(ID3D12Device* device, UINT64 pageSize)
+	: md3dDevice(device),
+	mPageSize((pageSize + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~(UINT64)(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1))
+{
+}
+
+std::uint32_t PlacedBufferAllocator::CreatePage(UINT64 size, bool dedicated)
+{
+	// Buffer-only heaps work on resource heap tier 1 as well.
+	ComPtr<ID3D12Heap> heap;
+	ThrowIfFailed(md3dDevice->CreateHeap(
+		&CD3DX12_HEAP_DESC(size, D3D12_HEAP_TYPE_DEFAULT, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+			D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS),
+		IID_PPV_ARGS(heap.GetAddressOf())));
+
+	std::unique_ptr<Page> page(new Page{ heap, HeapSubAllocator(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT), dedicated });
+
+	for(std::uint32_t i = 0; i < mPages.size(); ++i)
+	{
+		if(mPages[i]->Heap == nullptr)
+		{
+			mPages[i] = std::move(page);
+			return i;
+		}
+	}
+
+	mPages.push_back(std::move(page));
+	return (std::uint32_t)(mPages.size() - 1);
+}
+
+PlacedBufferAllocator::PlacedBuffer PlacedBufferAllocator::CreateBuffer(
+	UINT64 byteSize,
+	D3D12_RESOURCE_STATES initialState,
+	D3D12_RESOURCE_FLAGS flags)
+{
+	CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(byteSize, flags);
+	D3D12_RESOURCE_ALLOCATION_INFO info = md3dDevice->GetResourceAllocationInfo(0, 1, &desc);
+
+	PlacedBuffer buffer;
+	for(std::uint32_t i = 0; i < mPages.size() && buffer.Page == InvalidPage; ++i)
+	{
+		Page& page = *mPages[i];
+		if(page.Heap != nullptr && !page.Dedicated &&
+			page.Allocator.Allocate(info.SizeInBytes, info.Alignment, &buffer.Range))
+			buffer.Page = i;
+	}
+
+	if(buffer.Page == InvalidPage)
+	{
+		bool dedicated = info.SizeInBytes > mPageSize;
+		std::uint32_t i = CreatePage(dedicated ? info.SizeInBytes : mPageSize, dedicated);
+		if(!mPages[i]->Allocator.Allocate(info.SizeInBytes, info.Alignment, &buffer.Range))
+			ThrowIfFailed(E_OUTOFMEMORY);
+		buffer.Page = i;
+	}
+
+	Page& page = *mPages[buffer.Page];
+	HRESULT hr = md3dDevice->CreatePlacedResource(
+		page.Heap.Get(),
+		buffer.Range.Offset,
+		&desc,
+		initialState,
+		nullptr,
+		IID_PPV_ARGS(buffer.Resource.GetAddressOf()));
+	if(FAILED(hr))
+	{
+		page.Allocator.Free(buffer.Range);
+		ThrowIfFailed(hr);
+	}
+
+	return buffer;
+}
+
+PlacedBufferAllocator::PlacedBuffer PlacedBufferAllocator::CreateDefaultBuffer(
+	ID3D12GraphicsCommandList* cmdList,
+	const void* initData,
+	UINT64 byteSize,
+	FrameUploadAllocator& upload)
+{
+	PlacedBuffer buffer = CreateBuffer(byteSize, D3D12_RESOURCE_STATE_COMMON);
+	upload.CopyToBuffer(cmdList, buffer.Resource.Get(), 0, initData, byteSize);
+	return buffer;
+}
+
+void PlacedBufferAllocator::Release(PlacedBuffer& buffer, std::uint64_t fenceValue)
+{
+	if(buffer.Page == InvalidPage)
+		return;
+
+	mPending.push_back({ buffer, fenceValue });
+	buffer = PlacedBuffer();
+}
+
+void PlacedBufferAllocator::Collect(std::uint64_t completedFence)
+{
+	auto done = std::partition(mPending.begin(), mPending.end(),
+		[completedFence](const PendingRelease& r) { return r.FenceValue > completedFence; });
+
+	for(auto it = done; it != mPending.end(); ++it)
+	{
+		// The resource goes before its range can be reused.
+		it->Buffer.Resource = nullptr;
+
+		Page& page = *mPages[it->Buffer.Page];
+		page.Allocator.Free(it->Buffer.Range);
+		if(page.Dedicated && page.Allocator.AllocationCount() == 0)
+			page.Heap = nullptr;
+	}
+
+	mPending.erase(done, mPending.end());
+}
+
+PlacedBufferAllocator::Stats PlacedBufferAllocator::GetStats()const
+{
+	Stats s;
+	UINT64 freeBytes = 0;
+	for(const std::unique_ptr<Page>& page : mPages)
+	{
+		if(page->Heap == nullptr)
+			continue;
+
+		HeapSubAllocator::Stats a = page->Allocator.GetStats();
+		++s.Pages;
+		s.HeapBytes += a.Capacity;
+		s.UsedBytes += a.UsedBytes;
+		s.Buffers += a.Allocations;
+		s.LargestFreeBlock = std::max(s.LargestFreeBlock, a.LargestFreeBlock);
+		freeBytes += a.FreeBytes;
+	}
+
+	s.PendingReleases = (UINT)mPending.size();
+	s.Fragmentation = freeBytes == 0 ? 0.0 : 1.0 - (double)s.LargestFreeBlock / (double)freeBytes;
+	return s;
+}
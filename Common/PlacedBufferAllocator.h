@@ -0,0 +1,97 @@
+//***************************************************************************************
+// PlacedBufferAllocator.h
+//
+// Default-heap buffers placed in a few large ID3D12Heaps rather than one committed
+// resource (and so one heap) each.  Every heap is a page managed by a
+// HeapSubAllocator; a buffer that fits in no page gets a new one, and a buffer
+// larger than a page gets a page of its own that is destroyed once it is freed.
+// Buffers are placed at D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, so each takes
+// at least 64 KiB.
+//
+// CreateDefaultBuffer stages its data through a FrameUploadAllocator, so a mesh
+// upload creates no upload resource either.  A buffer that outlives the app (e.g.
+// MeshGeometry::VertexBufferGPU) never has to be released; otherwise Release() it
+// with the fence of the last frame that uses it and Collect() frees its range
+// once that fence has completed.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "FrameUploadAllocator.h"
+#include "HeapSubAllocator.h"
+
+class PlacedBufferAllocator
+{
+public:
+	static const std::uint32_t InvalidPage = 0xFFFFFFFF;
+
+	struct PlacedBuffer
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		std::uint32_t Page = InvalidPage;
+		HeapSubAllocator::Allocation Range;
+	};
+
+	struct Stats
+	{
+		UINT Pages = 0;
+		UINT64 HeapBytes = 0;          // every page
+		UINT64 UsedBytes = 0;          // placed buffers, rounded up to 64 KiB
+		UINT Buffers = 0;              // including those still pending release
+		UINT PendingReleases = 0;      // released, waiting on their fence
+		UINT64 LargestFreeBlock = 0;
+		double Fragmentation = 0.0;    // over the free space of all pages, as HeapSubAllocator
+	};
+
+	explicit PlacedBufferAllocator(ID3D12Device* device, UINT64 pageSize = 64 * 1024 * 1024);
+	PlacedBufferAllocator(const PlacedBufferAllocator& rhs) = delete;
+	PlacedBufferAllocator& operator=(const PlacedBufferAllocator& rhs) = delete;
+
+	// A buffer of byteSize bytes placed in a default heap.
+	PlacedBuffer CreateBuffer(
+		UINT64 byteSize,
+		D3D12_RESOURCE_STATES initialState,
+		D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+
+	// Same as d3dUtil::CreateDefaultBuffer: records the copy of initData on cmdList
+	// and leaves the buffer in D3D12_RESOURCE_STATE_GENERIC_READ.  The data is
+	// staged in upload, which keeps it until the frame has run.
+	PlacedBuffer CreateDefaultBuffer(
+		ID3D12GraphicsCommandList* cmdList,
+		const void* initData,
+		UINT64 byteSize,
+		FrameUploadAllocator& upload);
+
+	// Hands buffer back once the GPU has passed fenceValue; buffer is emptied.
+	void Release(PlacedBuffer& buffer, std::uint64_t fenceValue);
+
+	// Frees the ranges of released buffers whose fence value is <= completedFence.
+	void Collect(std::uint64_t completedFence);
+
+	Stats GetStats()const;
+
+private:
+	struct Page
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> Heap;
+		HeapSubAllocator Allocator;
+		bool Dedicated;
+	};
+
+	struct PendingRelease
+	{
+		PlacedBuffer Buffer;
+		std::uint64_t FenceValue;
+	};
+
+	std::uint32_t CreatePage(UINT64 size, bool dedicated);
+
+	ID3D12Device* md3dDevice;
+	UINT64 mPageSize;
+
+	// Pages are never moved, so a buffer's Page index stays valid; a destroyed
+	// dedicated page leaves a null Heap behind for the next one to reuse.
+	std::vector<std::unique_ptr<Page>> mPages;
+	std::vector<PendingRelease> mPending;
+};
@@ -0,0 +1,140 @@
+//***************************************************************************************
+// Platform.h
+//
+// Minimal OS layer for the CPU-side parts of Common.  These only need HRESULT, the
+// SAL annotations and DXGI_FORMAT, so on Windows they come from the SDK and elsewhere
+// from the portable DirectX-Headers (wsl/winadapter.h and directx/dxgiformat.h)
+// together with the DirectXMath headers.
+//
+// The portable core is the CommonCore library of the root CMakeLists.txt, which the
+// tools and benchmarks link against; the Win32/D3D12 layer is CommonD3D12.
+// Nothing in the core may include d3dUtil.h, d3d12.h or <windows.h> directly.
+//***************************************************************************************
+
+#pragma once
+
+#if defined(_WIN32)
+
+#include <windows.h>
+#include <dxgiformat.h>
+
+#else
+
+#include <wsl/winadapter.h>
+#include <dxgiformat.h>
+
+// Win32 error codes the portable code reports through HRESULT_FROM_WIN32.
+#ifndef ERROR_FILE_NOT_FOUND
+#define ERROR_FILE_NOT_FOUND 2L
+#endif
+#ifndef ERROR_PATH_NOT_FOUND
+#define ERROR_PATH_NOT_FOUND 3L
+#endif
+#ifndef ERROR_TOO_MANY_OPEN_FILES
+#define ERROR_TOO_MANY_OPEN_FILES 4L
+#endif
+#ifndef ERROR_ACCESS_DENIED
+#define ERROR_ACCESS_DENIED 5L
+#endif
+#ifndef ERROR_INVALID_DATA
+#define ERROR_INVALID_DATA 13L
+#endif
+#ifndef ERROR_WRITE_FAULT
+#define ERROR_WRITE_FAULT 29L
+#endif
+#ifndef ERROR_HANDLE_EOF
+#define ERROR_HANDLE_EOF 38L
+#endif
+#ifndef ERROR_NOT_SUPPORTED
+#define ERROR_NOT_SUPPORTED 50L
+#endif
+#ifndef ERROR_INVALID_NAME
+#define ERROR_INVALID_NAME 123L
+#endif
+#ifndef ERROR_FILENAME_EXCED_RANGE
+#define ERROR_FILENAME_EXCED_RANGE 206L
+#endif
+#ifndef ERROR_ARITHMETIC_OVERFLOW
+#define ERROR_ARITHMETIC_OVERFLOW 534L
+#endif
+
+#ifndef HRESULT_FROM_WIN32
+#define HRESULT_FROM_WIN32(x) \
+    ((HRESULT)(x) <= 0 ? ((HRESULT)(x)) : ((HRESULT)(((x) & 0x0000FFFF) | (7 << 16) | 0x80000000)))
+#endif
+
+// SAL annotations are only checked by the Microsoft compiler.
+#ifndef _In_
+#define _In_
+#endif
+#ifndef _In_z_
+#define _In_z_
+#endif
+#ifndef _In_opt_
+#define _In_opt_
+#endif
+#ifndef _In_reads_
+#define _In_reads_(exp)
+#endif
+#ifndef _In_reads_opt_
+#define _In_reads_opt_(exp)
+#endif
+#ifndef _In_reads_bytes_
+#define _In_reads_bytes_(exp)
+#endif
+#ifndef _Inout_
+#define _Inout_
+#endif
+#ifndef _Out_
+#define _Out_
+#endif
+#ifndef _Out_opt_
+#define _Out_opt_
+#endif
+#ifndef _Out_writes_
+#define _Out_writes_(exp)
+#endif
+#ifndef _Out_writes_opt_
+#define _Out_writes_opt_(exp)
+#endif
+#ifndef _Out_writes_bytes_
+#define _Out_writes_bytes_(exp)
+#endif
+#ifndef _Outptr_opt_
+#define _Outptr_opt_
+#endif
+#ifndef _Analysis_assume_
+#define _Analysis_assume_(exp)
+#endif
+#ifndef _Use_decl_annotations_
+#define _Use_decl_annotations_
+#endif
+
+#ifndef UNREFERENCED_PARAMETER
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+#endif
+
+#endif
+
+#include <cerrno>
+
+// The HRESULT for an errno set by open, fopen or _wfopen_s, so a missing file, a
+// permission problem and a bad name are told apart the same way on every platform.
+inline HRESULT HResultFromErrno(int err)
+{
+	switch(err)
+	{
+	case 0:            return E_FAIL;
+	case ENOENT:       return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+	case ENOTDIR:      return HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND);
+	case EACCES:
+	case EPERM:
+	case EISDIR:       return HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED);
+	case EMFILE:
+	case ENFILE:       return HRESULT_FROM_WIN32(ERROR_TOO_MANY_OPEN_FILES);
+	case ENAMETOOLONG: return HRESULT_FROM_WIN32(ERROR_FILENAME_EXCED_RANGE);
+	case EINVAL:       return HRESULT_FROM_WIN32(ERROR_INVALID_NAME);
+	case ENOMEM:       return E_OUTOFMEMORY;
+	default:           return E_FAIL;
+	}
+}
@@ -0,0 +1,232 @@
+//***************************************************************************************
+// ResidencyPolicy.cpp
+//***************************************************************************************
+
+#include "ResidencyPolicy.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+ResidencyPolicy::ResidencyPolicy(std::uint64_t budgetBytes, std::uint32_t tailSize)
+	: mBudget(budgetBytes), mTailSize(tailSize)
+{
+}
+
+ResidencyPolicy::TextureId ResidencyPolicy::Register(const DDS_TEXTURE_INFO& info, int priority)
+{
+	Entry e;
+	e.Info = info;
+	e.Priority = priority;
+
+	std::uint32_t mipCount = std::max<std::uint32_t>(1, info.mipCount);
+	e.MipBytes.resize(mipCount);
+	e.TailMip = mipCount - 1;
+	for(std::uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		size_t w = std::max<size_t>(1, info.width >> mip);
+		size_t h = std::max<size_t>(1, info.height >> mip);
+		size_t d = std::max<size_t>(1, info.depth >> mip);
+
+		size_t numBytes = 0;
+		GetSurfaceInfo(w, h, info.format, &numBytes, nullptr, nullptr);
+		e.MipBytes[mip] = (std::uint64_t)numBytes * d * std::max<std::uint32_t>(1, info.arraySize);
+
+		if(mip < e.TailMip && w <= mTailSize && h <= mTailSize)
+			e.TailMip = mip;
+	}
+
+	mEntries.push_back(e);
+	return (TextureId)(mEntries.size() - 1);
+}
+
+void ResidencyPolicy::SetBudget(std::uint64_t budgetBytes)
+{
+	mBudget = budgetBytes;
+}
+
+void ResidencyPolicy::SetPriority(TextureId id, int priority)
+{
+	mEntries[id].Priority = priority;
+}
+
+void ResidencyPolicy::Touch(TextureId id, std::uint64_t frame, std::uint32_t desiredMip)
+{
+	Entry& e = mEntries[id];
+
+	// Several draws in one frame may want different mips; keep the finest.  The
+	// first touch ever takes its mip as is, even in frame 0.
+	if(!e.Used || e.LastUsedFrame != frame)
+		e.DesiredMip = desiredMip;
+	else
+		e.DesiredMip = std::min(e.DesiredMip, desiredMip);
+
+	e.DesiredMip = std::min<std::uint32_t>(e.DesiredMip, (std::uint32_t)e.MipBytes.size() - 1);
+	e.LastUsedFrame = frame;
+	e.Used = true;
+}
+
+std::uint64_t ResidencyPolicy::BytesForMips(TextureId id, std::uint32_t topMip)const
+{
+	const Entry& e = mEntries[id];
+
+	std::uint64_t bytes = 0;
+	for(std::uint32_t mip = topMip; mip < e.MipBytes.size(); ++mip)
+		bytes += e.MipBytes[mip];
+
+	return bytes;
+}
+
+std::uint32_t ResidencyPolicy::ResidentMip(TextureId id)const
+{
+	return mEntries[id].ResidentMip;
+}
+
+void ResidencyPolicy::SetResident(Entry& e, std::uint32_t topMip)
+{
+	TextureId id = (TextureId)(&e - mEntries.data());
+
+	if(e.ResidentMip != NotResident)
+		mResidentBytes -= BytesForMips(id, e.ResidentMip);
+
+	e.ResidentMip = topMip;
+
+	if(e.ResidentMip != NotResident)
+		mResidentBytes += BytesForMips(id, e.ResidentMip);
+
+	mStats.PeakResidentBytes = std::max(mStats.PeakResidentBytes, mResidentBytes);
+}
+
+std::vector<ResidencyPolicy::Action> ResidencyPolicy::Plan(std::uint64_t frame)
+{
+	std::vector<Action> actions;
+
+	//
+	// What this frame needs that is not already resident.
+	//
+
+	struct Want
+	{
+		TextureId Id;
+		std::uint32_t Mip;
+	};
+
+	std::vector<Want> wants;
+	std::uint64_t needed = 0;
+	for(TextureId id = 0; id < (TextureId)mEntries.size(); ++id)
+	{
+		const Entry& e = mEntries[id];
+		if(!e.Used || e.LastUsedFrame != frame || (e.ResidentMip != NotResident && e.ResidentMip <= e.DesiredMip))
+			continue;
+
+		wants.push_back({ id, e.DesiredMip });
+		needed += BytesForMips(id, e.DesiredMip);
+		if(e.ResidentMip != NotResident)
+			needed -= BytesForMips(id, e.ResidentMip);
+	}
+
+	if(mResidentBytes + needed > mBudget)
+	{
+		//
+		// Make room from what this frame does not use: lowest priority first,
+		// then least recently used.
+		//
+
+		std::vector<TextureId> victims;
+		for(TextureId id = 0; id < (TextureId)mEntries.size(); ++id)
+		{
+			if(mEntries[id].ResidentMip != NotResident && mEntries[id].LastUsedFrame != frame)
+				victims.push_back(id);
+		}
+
+		std::sort(victims.begin(), victims.end(), [this](TextureId a, TextureId b)
+		{
+			const Entry& ea = mEntries[a];
+			const Entry& eb = mEntries[b];
+			if(ea.Priority != eb.Priority)
+				return ea.Priority < eb.Priority;
+			return ea.LastUsedFrame < eb.LastUsedFrame;
+		});
+
+		auto overBudget = [&]() { return mResidentBytes + needed > mBudget; };
+
+		// Dropping the top mip frees three quarters of a texture, so try that
+		// on every victim before evicting any of them.
+		for(TextureId id : victims)
+		{
+			Entry& e = mEntries[id];
+			std::uint32_t top = e.ResidentMip;
+			std::uint64_t freed = 0;
+			while(mResidentBytes - freed + needed > mBudget && top < e.TailMip)
+			{
+				freed += e.MipBytes[top];
+				++top;
+			}
+
+			if(top != e.ResidentMip)
+			{
+				SetResident(e, top);
+				e.Dropped = true;
+				actions.push_back({ Action::Reduce, id, top });
+				++mStats.Reductions;
+			}
+
+			if(!overBudget())
+				break;
+		}
+
+		for(TextureId id : victims)
+		{
+			if(!overBudget())
+				break;
+
+			SetResident(mEntries[id], NotResident);
+			mEntries[id].Dropped = true;
+			actions.push_back({ Action::Evict, id, NotResident });
+			++mStats.Evictions;
+		}
+
+		// Still too much: the frame's working set alone does not fit.  Load
+		// coarser mips, lowest priority first, rather than go over.
+		if(overBudget())
+		{
+			++mStats.OverBudgetFrames;
+
+			std::sort(wants.begin(), wants.end(), [this](const Want& a, const Want& b)
+			{
+				return mEntries[a.Id].Priority < mEntries[b.Id].Priority;
+			});
+
+			for(Want& w : wants)
+			{
+				const Entry& e = mEntries[w.Id];
+				std::uint32_t coarsest = (e.ResidentMip != NotResident) ? e.ResidentMip : (std::uint32_t)e.MipBytes.size() - 1;
+				while(overBudget() && w.Mip < coarsest)
+				{
+					needed -= e.MipBytes[w.Mip];
+					++w.Mip;
+				}
+
+				if(!overBudget())
+					break;
+			}
+		}
+	}
+
+	for(const Want& w : wants)
+	{
+		Entry& e = mEntries[w.Id];
+		if(e.ResidentMip != NotResident && e.ResidentMip <= w.Mip)
+			continue;
+
+		if(e.Dropped)
+			++mStats.Reloads;
+		++mStats.Loads;
+		mStats.BytesLoaded += BytesForMips(w.Id, w.Mip);
+
+		SetResident(e, w.Mip);
+		e.Dropped = false;
+		actions.push_back({ Action::Load, w.Id, w.Mip });
+	}
+
+	return actions;
+}
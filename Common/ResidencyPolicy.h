@@ -0,0 +1,95 @@
+//***************************************************************************************
+// ResidencyPolicy.h
+//
+// Decides which textures should be in GPU memory under a byte budget.  It only does
+// bookkeeping, with no device, so it can be driven headlessly from a recorded or
+// simulated access trace; TextureResidency carries out its decisions on D3D12.
+//
+// Each frame the renderer Touch()es the textures it draws and the mip it wants.
+// Plan() then returns the loads needed for that frame, and if they do not fit, frees
+// room from the textures that were not used this frame.  Victims are taken lowest
+// priority first, then least recently used.  Each victim first loses its top mips
+// (down to its mip tail), and is evicted outright only when that is not enough.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "DDSFormat.h"
+
+class ResidencyPolicy
+{
+public:
+	typedef std::uint32_t TextureId;
+
+	// Mip index meaning "nothing resident".
+	static const std::uint32_t NotResident = 0xFFFFFFFF;
+
+	struct Action
+	{
+		enum Type { Load, Reduce, Evict };
+
+		Type Kind;
+		TextureId Id;
+
+		// Finest mip to keep resident after the action.  Unused for Evict.
+		std::uint32_t TopMip;
+	};
+
+	struct Stats
+	{
+		std::uint64_t Loads = 0;
+		std::uint64_t Reloads = 0;       // Loads of a texture that had been evicted or reduced.
+		std::uint64_t Reductions = 0;
+		std::uint64_t Evictions = 0;
+		std::uint64_t BytesLoaded = 0;
+		std::uint64_t PeakResidentBytes = 0;
+		std::uint64_t OverBudgetFrames = 0;  // Frames whose working set alone exceeded the budget.
+	};
+
+	// Mips no larger than tailSize are never dropped, only evicted with the texture.
+	explicit ResidencyPolicy(std::uint64_t budgetBytes, std::uint32_t tailSize = 64);
+
+	TextureId Register(const DirectX::DDS_TEXTURE_INFO& info, int priority = 0);
+
+	void SetBudget(std::uint64_t budgetBytes);
+	void SetPriority(TextureId id, int priority);
+
+	// Records that id is drawn this frame and wants desiredMip (0 is full resolution).
+	void Touch(TextureId id, std::uint64_t frame, std::uint32_t desiredMip = 0);
+
+	// The actions to carry out before drawing frame, evictions and reductions first.
+	// They count as done once returned.
+	std::vector<Action> Plan(std::uint64_t frame);
+
+	// Bytes of mips topMip..last over every array slice, by the GetSurfaceInfo math.
+	std::uint64_t BytesForMips(TextureId id, std::uint32_t topMip)const;
+
+	std::uint32_t ResidentMip(TextureId id)const;
+	std::uint64_t ResidentBytes()const { return mResidentBytes; }
+	std::uint64_t Budget()const { return mBudget; }
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	struct Entry
+	{
+		DirectX::DDS_TEXTURE_INFO Info;
+		std::vector<std::uint64_t> MipBytes;  // All slices of one mip.
+		int Priority = 0;
+		std::uint64_t LastUsedFrame = 0;
+		std::uint32_t DesiredMip = 0;
+		std::uint32_t ResidentMip = NotResident;
+		std::uint32_t TailMip = 0;           // Coarsest mip a reduction may go to.
+		bool Used = false;
+		bool Dropped = false;                // Reduced or evicted since its last load.
+	};
+
+	void SetResident(Entry& e, std::uint32_t topMip);
+
+	std::vector<Entry> mEntries;
+	std::uint64_t mBudget;
+	std::uint32_t mTailSize;
+	std::uint64_t mResidentBytes = 0;
+	Stats mStats;
+};
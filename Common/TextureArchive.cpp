@@ -0,0 +1,181 @@
+//***************************************************************************************
+// TextureArchive.cpp
+//***************************************************************************************
+
+#include "TextureArchive.h"
+#include "XXHash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	struct Mount
+	{
+		std::string Prefix;
+		std::shared_ptr<const TextureArchive> Archive;
+	};
+
+	std::mutex gMountLock;
+	std::vector<Mount> gMounts;
+}
+
+HRESULT TextureArchive::Open(const wchar_t* fileName)
+{
+	Close();
+
+	HRESULT hr = mMapping.Open(fileName);
+	if(FAILED(hr))
+		return hr;
+
+	const std::uint8_t* base = mMapping.Data();
+	const std::uint64_t size = mMapping.Size();
+
+	ArchiveHeader header;
+	if(size < sizeof(header))
+	{
+		Close();
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+	memcpy(&header, base, sizeof(header));
+
+	// Everything the index points at has to lie inside the file, so a truncated or
+	// corrupt archive fails here rather than when a texture is read.
+	const std::uint64_t indexBytes = (std::uint64_t)header.EntryCount*sizeof(ArchiveEntry);
+	bool valid = header.Magic == TEXTURE_ARCHIVE_MAGIC &&
+		header.Version == TEXTURE_ARCHIVE_VERSION &&
+		header.Alignment == TEXTURE_ARCHIVE_ALIGNMENT &&
+		header.IndexOffset >= sizeof(header) &&
+		header.IndexOffset % alignof(ArchiveEntry) == 0 &&
+		header.IndexOffset <= size && indexBytes <= size - header.IndexOffset &&
+		header.DataOffset >= header.IndexOffset + indexBytes && header.DataOffset <= size;
+
+	const ArchiveEntry* entries = reinterpret_cast<const ArchiveEntry*>(base + header.IndexOffset);
+	for(std::uint32_t i = 0; valid && i < header.EntryCount; ++i)
+	{
+		const ArchiveEntry& e = entries[i];
+		valid = e.Offset >= header.DataOffset && e.Offset % header.Alignment == 0 &&
+			e.Offset <= size && e.Size <= size - e.Offset &&
+			header.IndexOffset + indexBytes + e.NameOffset + e.NameLength <= header.DataOffset &&
+			(i == 0 || entries[i - 1].NameHash <= e.NameHash);
+	}
+
+	if(!valid)
+	{
+		Close();
+		return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+	}
+
+	mEntries = entries;
+	mEntryCount = header.EntryCount;
+	return S_OK;
+}
+
+void TextureArchive::Close()
+{
+	mMapping.Close();
+	mEntries = nullptr;
+	mEntryCount = 0;
+}
+
+std::string TextureArchive::EntryName(std::uint32_t i)const
+{
+	const char* names = reinterpret_cast<const char*>(mEntries + mEntryCount);
+	return std::string(names + mEntries[i].NameOffset, mEntries[i].NameLength);
+}
+
+bool TextureArchive::Find(const std::string& name, const std::uint8_t** data, std::size_t* size)const
+{
+	const std::uint64_t hash = XXH64(name.data(), name.size());
+	const ArchiveEntry* end = mEntries + mEntryCount;
+	const ArchiveEntry* e = std::lower_bound(mEntries, end, hash,
+		[](const ArchiveEntry& entry, std::uint64_t h) { return entry.NameHash < h; });
+
+	const char* names = reinterpret_cast<const char*>(end);
+	for(; e != end && e->NameHash == hash; ++e)
+	{
+		if(e->NameLength == name.size() && memcmp(names + e->NameOffset, name.data(), name.size()) == 0)
+		{
+			*data = mMapping.Data() + e->Offset;
+			*size = (std::size_t)e->Size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::string TextureArchive::NormalizeName(const std::string& name)
+{
+	std::string result;
+	result.reserve(name.size());
+	for(char c : name)
+	{
+		if(c == '\\')
+			c = '/';
+		else if(c >= 'A' && c <= 'Z')
+			c = (char)(c - 'A' + 'a');
+
+		if(c == '/' && !result.empty() && result.back() == '/')
+			continue;
+		result.push_back(c);
+	}
+
+	while(result.compare(0, 2, "./") == 0)
+		result.erase(0, 2);
+
+	return result;
+}
+
+HRESULT MountTextureArchive(const wchar_t* archiveFile, const wchar_t* directory)
+{
+	if(archiveFile == nullptr || directory == nullptr)
+		return E_INVALIDARG;
+
+	auto archive = std::make_shared<TextureArchive>();
+	HRESULT hr = archive->Open(archiveFile);
+	if(FAILED(hr))
+		return hr;
+
+	Mount mount;
+	mount.Prefix = TextureArchive::NormalizeName(WideToUtf8(directory));
+	if(!mount.Prefix.empty() && mount.Prefix.back() != '/')
+		mount.Prefix.push_back('/');
+	mount.Archive = std::move(archive);
+
+	std::lock_guard<std::mutex> lock(gMountLock);
+	gMounts.push_back(std::move(mount));
+	return S_OK;
+}
+
+void UnmountTextureArchives()
+{
+	std::lock_guard<std::mutex> lock(gMountLock);
+	gMounts.clear();
+}
+
+bool FindArchivedFile(const wchar_t* fileName, ArchivedFile& file)
+{
+	file = ArchivedFile();
+
+	std::lock_guard<std::mutex> lock(gMountLock);
+	if(gMounts.empty() || fileName == nullptr)
+		return false;
+
+	const std::string name = TextureArchive::NormalizeName(WideToUtf8(fileName));
+	for(auto it = gMounts.rbegin(); it != gMounts.rend(); ++it)
+	{
+		if(name.compare(0, it->Prefix.size(), it->Prefix) != 0)
+			continue;
+
+		if(it->Archive->Find(name.substr(it->Prefix.size()), &file.Data, &file.Size))
+		{
+			file.Archive = it->Archive;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,100 @@
+//***************************************************************************************
+// TextureArchive.h
+//
+// Read-only pack of cooked DDS files (written by Tools/TexPack).  One file holds
+// every texture: opening it replaces hundreds of open/stat/read calls with one open
+// and one mapping, and the pages are read in order as textures are used.
+//
+// Layout, little-endian:
+//   ArchiveHeader               at 0
+//   ArchiveEntry[EntryCount]    at IndexOffset, sorted by NameHash
+//   names                       UTF-8, referenced by NameOffset/NameLength
+//   payloads                    each at a multiple of 4 KiB, ready for mmap or
+//                               unbuffered I/O
+//
+// Names are paths relative to the packed directory, lower case with '/' separators,
+// and NameHash is their XXH64.
+//
+// Mounting an archive over a directory makes the DDS loader read files below that
+// directory from the archive instead: LoadDDSTextureDataFromFile,
+// GetDDSTextureInfoFromFile, StageDDSTextureFromFile and CreateDDSTextureFromFile12
+// all check the mounted archives first and fall back to the file system.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "FileMapping.h"
+
+#pragma pack(push, 1)
+struct ArchiveHeader
+{
+	std::uint32_t Magic;
+	std::uint32_t Version;
+	std::uint32_t EntryCount;
+	std::uint32_t Alignment;
+	std::uint64_t IndexOffset;
+	std::uint64_t DataOffset;
+};
+
+struct ArchiveEntry
+{
+	std::uint64_t NameHash;
+	std::uint64_t Offset;
+	std::uint64_t Size;
+	std::uint32_t NameOffset;
+	std::uint32_t NameLength;
+};
+#pragma pack(pop)
+
+const std::uint32_t TEXTURE_ARCHIVE_MAGIC = 0x52415854; // "TXAR"
+const std::uint32_t TEXTURE_ARCHIVE_VERSION = 1;
+const std::uint32_t TEXTURE_ARCHIVE_ALIGNMENT = 4096;
+
+class TextureArchive
+{
+public:
+	TextureArchive() = default;
+	TextureArchive(const TextureArchive& rhs) = delete;
+	TextureArchive& operator=(const TextureArchive& rhs) = delete;
+
+	// Maps the archive and validates its header and index.  Payloads are not touched.
+	HRESULT Open(const wchar_t* fileName);
+	void Close();
+
+	// Finds an entry by (already normalized) name.  data points into the mapping.
+	bool Find(const std::string& name, const std::uint8_t** data, std::size_t* size)const;
+
+	std::uint32_t EntryCount()const { return mEntryCount; }
+	const ArchiveEntry& Entry(std::uint32_t i)const { return mEntries[i]; }
+	std::string EntryName(std::uint32_t i)const;
+
+	// Lower case, '/' separators, no leading "./".
+	static std::string NormalizeName(const std::string& name);
+
+private:
+	FileMapping mMapping;
+	const ArchiveEntry* mEntries = nullptr;
+	std::uint32_t mEntryCount = 0;
+};
+
+// A file found in a mounted archive.  Archive keeps the mapping alive for as long as
+// anything still points into Data.
+struct ArchivedFile
+{
+	std::shared_ptr<const TextureArchive> Archive;
+	const std::uint8_t* Data = nullptr;
+	std::size_t Size = 0;
+};
+
+// Serves files below directory (as the loader will be asked for them, e.g.
+// L"../../Textures") from archiveFile.  Later mounts take precedence.  Thread safe,
+// but meant to be called at startup before loading starts.
+HRESULT MountTextureArchive(const wchar_t* archiveFile, const wchar_t* directory);
+void UnmountTextureArchives();
+
+// Looks fileName up in the mounted archives.
+bool FindArchivedFile(const wchar_t* fileName, ArchivedFile& file);
@@ -0,0 +1,184 @@
+//***************************************************************************************
+// TextureBatchLoader.cpp
+//***************************************************************************************
+
+#include "TextureBatchLoader.h"
+#include "AsyncTextureReader.h"
+
+using namespace DirectX;
+
+TextureBatchLoader::TextureBatchLoader(ThreadPool& pool)
+	: mPool(pool)
+{
+}
+
+void TextureBatchLoader::SetMaxSize(size_t maxsize)
+{
+	mMaxSize = maxsize;
+}
+
+void TextureBatchLoader::SetLoadFlags(unsigned int loadFlags)
+{
+	mLoadFlags = loadFlags;
+}
+
+void TextureBatchLoader::SetGenerateMips(bool generate, const MipOptions& options)
+{
+	mGenerateMips = generate;
+	mMipOptions = options;
+}
+
+void TextureBatchLoader::SetConvertPixels(bool convert, const PixelConvertOptions& options)
+{
+	mConvertPixels = convert;
+	mConvertOptions = options;
+}
+
+void TextureBatchLoader::SetAsyncIO(AsyncFileIO* io)
+{
+	mAsyncIO = io;
+}
+
+void TextureBatchLoader::SetUploadBatch(UploadBatch* batch)
+{
+	mUploadBatch = batch;
+}
+
+void TextureBatchLoader::CreateTexture(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	const DDS_TEXTURE_DATA& data,
+	Texture* tex)
+{
+	if(mUploadBatch != nullptr)
+	{
+		tex->UploadHeap = nullptr;
+		HRESULT hr = mUploadBatch->CreateDDSTextureFromData(data, tex->Resource);
+		if(FAILED(hr))
+			throw DxException(hr, L"UploadBatch::CreateDDSTextureFromData", tex->Filename, __LINE__);
+		return;
+	}
+
+	HRESULT hr = CreateDDSTextureFromData12(device, cmdList, data, tex->Resource, tex->UploadHeap);
+	if(FAILED(hr))
+		throw DxException(hr, L"CreateDDSTextureFromData12", tex->Filename, __LINE__);
+}
+
+void TextureBatchLoader::Load(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	const std::vector<Texture*>& textures)
+{
+	if(mAsyncIO != nullptr)
+	{
+		LoadAsync(device, cmdList, textures);
+		return;
+	}
+
+	struct ParsedTexture
+	{
+		DDS_TEXTURE_DATA Data;
+		HRESULT Result = E_FAIL;
+		const wchar_t* Function = L"LoadDDSTextureDataFromFile";
+	};
+
+	// Queue every file up front so the workers stay busy while this thread is
+	// creating resources for the ones that have already finished.
+	std::vector<std::future<std::unique_ptr<ParsedTexture>>> pending;
+	pending.reserve(textures.size());
+	for(Texture* tex : textures)
+	{
+		std::wstring filename = tex->Filename;
+		size_t maxsize = mMaxSize;
+		unsigned int loadFlags = mLoadFlags;
+		bool generateMips = mGenerateMips;
+		MipOptions mipOptions = mMipOptions;
+		mipOptions.NormalMap = mipOptions.NormalMap || filename.find(L"_nmap") != std::wstring::npos;
+		bool convertPixels = mConvertPixels;
+		PixelConvertOptions convertOptions = mConvertOptions;
+		convertOptions.PremultiplyAlpha = convertOptions.PremultiplyAlpha && filename.find(L"_nmap") == std::wstring::npos;
+
+		pending.push_back(mPool.Submit([filename, maxsize, loadFlags, generateMips, mipOptions, convertPixels, convertOptions]()
+		{
+			auto parsed = std::make_unique<ParsedTexture>();
+			parsed->Result = LoadDDSTextureDataFromFile(filename.c_str(), parsed->Data, maxsize, loadFlags);
+
+			if(SUCCEEDED(parsed->Result) && convertPixels)
+			{
+				HRESULT hr = ConvertDDSTextureData(parsed->Data, convertOptions);
+				if(FAILED(hr))
+				{
+					parsed->Result = hr;
+					parsed->Function = L"ConvertDDSTextureData";
+				}
+			}
+
+			// Already on a worker, so the chain is built without the pool.
+			if(SUCCEEDED(parsed->Result) && generateMips)
+			{
+				HRESULT hr = GenerateMissingMips(parsed->Data, mipOptions);
+				if(FAILED(hr) && hr != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
+				{
+					parsed->Result = hr;
+					parsed->Function = L"GenerateMissingMips";
+				}
+			}
+			return parsed;
+		}));
+	}
+
+	// Command lists are single threaded, so the uploads are recorded here, in order.
+	for(size_t i = 0; i < textures.size(); ++i)
+	{
+		std::unique_ptr<ParsedTexture> parsed = pending[i].get();
+		Texture* tex = textures[i];
+
+		if(FAILED(parsed->Result))
+			throw DxException(parsed->Result, parsed->Function, tex->Filename, __LINE__);
+
+		CreateTexture(device, cmdList, parsed->Data, tex);
+	}
+}
+
+void TextureBatchLoader::LoadAsync(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* cmdList,
+	const std::vector<Texture*>& textures)
+{
+	std::vector<std::wstring> filenames;
+	filenames.reserve(textures.size());
+	for(Texture* tex : textures)
+		filenames.push_back(tex->Filename);
+
+	AsyncTextureReader reader(*mAsyncIO);
+	reader.SetMaxSize(mMaxSize);
+
+	// Runs on this thread between completions, so the command list is safe to use;
+	// the reads for the remaining files carry on meanwhile.
+	reader.Read(filenames, [&](size_t index, HRESULT hr, DDS_TEXTURE_DATA& data)
+	{
+		Texture* tex = textures[index];
+		if(FAILED(hr))
+			throw DxException(hr, L"AsyncTextureReader::Read", tex->Filename, __LINE__);
+
+		if(mConvertPixels)
+		{
+			PixelConvertOptions convertOptions = mConvertOptions;
+			convertOptions.PremultiplyAlpha = convertOptions.PremultiplyAlpha && tex->Filename.find(L"_nmap") == std::wstring::npos;
+			hr = ConvertDDSTextureData(data, convertOptions, &mPool);
+			if(FAILED(hr))
+				throw DxException(hr, L"ConvertDDSTextureData", tex->Filename, __LINE__);
+		}
+
+		if(mGenerateMips)
+		{
+			MipOptions mipOptions = mMipOptions;
+			mipOptions.NormalMap = mipOptions.NormalMap || tex->Filename.find(L"_nmap") != std::wstring::npos;
+			hr = GenerateMissingMips(data, mipOptions, &mPool);
+			if(FAILED(hr) && hr != HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED))
+				throw DxException(hr, L"GenerateMissingMips", tex->Filename, __LINE__);
+		}
+
+		CreateTexture(device, cmdList, data, tex);
+	});
+}
@@ -0,0 +1,83 @@
+//***************************************************************************************
+// TextureBatchLoader.h
+//
+// Loads a list of textures at once.  File I/O, header parsing and subresource layout
+// run on a ThreadPool; the D3D12 resources are created and their uploads recorded on
+// one command list from the calling thread, in list order.  With an AsyncFileIO the
+// files are read by batched asynchronous I/O instead and recorded in the order they
+// arrive.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "AsyncFileIO.h"
+#include "MipGenerator.h"
+#include "PixelConvert.h"
+#include "ThreadPool.h"
+#include "UploadBatch.h"
+
+class TextureBatchLoader
+{
+public:
+	explicit TextureBatchLoader(ThreadPool& pool);
+	TextureBatchLoader(const TextureBatchLoader& rhs) = delete;
+	TextureBatchLoader& operator=(const TextureBatchLoader& rhs) = delete;
+
+	// Same meaning as the CreateDDSTextureFromFile12 arguments.
+	void SetMaxSize(size_t maxsize);
+	void SetLoadFlags(unsigned int loadFlags);
+
+	// Textures that arrive with a single mip get a full chain from MipGenerator on
+	// the worker threads, filtered with options (NormalMap is also set for files
+	// named *_nmap*).  Formats it cannot rebuild, such as BC2, load as they are.
+	// Off by default.
+	void SetGenerateMips(bool generate, const MipOptions& options = MipOptions());
+
+	// Runs ConvertDDSTextureData on the worker threads before mips are generated, so
+	// BGRA and 16-bit files reach the GPU as RGBA8 and, if asked, premultiplied.
+	// Files named *_nmap* are never premultiplied: their alpha is height.  Off by
+	// default.
+	void SetConvertPixels(bool convert, const PixelConvertOptions& options = PixelConvertOptions());
+
+	// Reads the files through io (see AsyncTextureReader) rather than on the pool;
+	// the pool then only helps MipGenerator.  Load flags do not apply to these
+	// reads.  io must outlive the loader; null restores the default.
+	void SetAsyncIO(AsyncFileIO* io);
+
+	// Stages the textures in batch instead of an upload heap each: UploadHeap is
+	// left null and nothing is recorded on cmdList until batch->Record.  batch must
+	// outlive the loader; null restores the default.
+	void SetUploadBatch(UploadBatch* batch);
+
+	// Fills in Resource and UploadHeap of every texture from its Filename.  The
+	// upload heaps must be kept until cmdList has executed (see SetUploadBatch).  Throws DxException
+	// naming the file on the first failure.
+	void Load(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		const std::vector<Texture*>& textures);
+
+private:
+	void LoadAsync(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		const std::vector<Texture*>& textures);
+
+	// Creates tex->Resource from data and stages or records its upload.
+	void CreateTexture(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* cmdList,
+		const DirectX::DDS_TEXTURE_DATA& data,
+		Texture* tex);
+
+	ThreadPool& mPool;
+	AsyncFileIO* mAsyncIO = nullptr;
+	UploadBatch* mUploadBatch = nullptr;
+	size_t mMaxSize = 0;
+	unsigned int mLoadFlags = DirectX::DDS_LOADER_MEMORY_MAPPED;
+	bool mGenerateMips = false;
+	MipOptions mMipOptions;
+	bool mConvertPixels = false;
+	PixelConvertOptions mConvertOptions;
+};
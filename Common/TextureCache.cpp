@@ -0,0 +1,154 @@
+//***************************************************************************************
+// TextureCache.cpp
+//***************************************************************************************
+
+#include "TextureCache.h"
+#include "XXHash.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// The subresources are contiguous in the file, so the pixel data is one span
+	// from the first to the end of the last (whose depth is that of the smallest mip).
+	void GetPixelSpan(const DDS_TEXTURE_DATA& data, const std::uint8_t*& begin, std::uint64_t& bytes)
+	{
+		const DDS_SUBRESOURCE& first = data.subresources.front();
+		const DDS_SUBRESOURCE& last = data.subresources.back();
+		std::uint32_t lastDepth = std::max<std::uint32_t>(1, data.info.depth >> (data.info.mipCount - 1));
+		begin = static_cast<const std::uint8_t*>(first.pData);
+		const std::uint8_t* end = static_cast<const std::uint8_t*>(last.pData) + last.slicePitch*lastDepth;
+		bytes = (std::uint64_t)(end - begin);
+	}
+}
+
+bool TextureCache::ContentKey::operator==(const ContentKey& rhs)const
+{
+	return Hash == rhs.Hash && Format == rhs.Format &&
+		Width == rhs.Width && Height == rhs.Height && Depth == rhs.Depth &&
+		MipCount == rhs.MipCount && ArraySize == rhs.ArraySize;
+}
+
+void TextureCache::Load(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, Texture& tex)
+{
+	++mStats.Requests;
+
+	auto file = mFileIndex.find(tex.Filename);
+	if(file != mFileIndex.end())
+	{
+		auto it = mEntries.find(file->second);
+		if(it != mEntries.end())
+		{
+			Entry& entry = it->second;
+			++entry.RefCount;
+			++mStats.FileHits;
+			mStats.DuplicateBytesAvoided += entry.Bytes;
+
+			tex.Resource = entry.Resource;
+			tex.UploadHeap = nullptr;
+			return;
+		}
+	}
+
+	DDS_TEXTURE_DATA data;
+	HRESULT hr = LoadDDSTextureDataFromFile(tex.Filename.c_str(), data, 0, DDS_LOADER_MEMORY_MAPPED);
+	if(FAILED(hr))
+		throw DxException(hr, L"LoadDDSTextureDataFromFile", tex.Filename, __LINE__);
+
+	const std::uint8_t* begin = nullptr;
+	std::uint64_t bytes = 0;
+	GetPixelSpan(data, begin, bytes);
+
+	ContentKey key;
+	key.Hash = XXH64(begin, (size_t)bytes);
+	key.Format = data.info.format;
+	key.Width = data.info.width;
+	key.Height = data.info.height;
+	key.Depth = data.info.depth;
+	key.MipCount = data.info.mipCount;
+	key.ArraySize = data.info.arraySize;
+
+	auto it = mEntries.find(key);
+	if(it != mEntries.end())
+	{
+		Entry& entry = it->second;
+		if(SameContents(entry, begin, bytes))
+		{
+			mFileIndex[tex.Filename] = key;
+
+			++entry.RefCount;
+			++mStats.ContentHits;
+			mStats.DuplicateBytesAvoided += bytes;
+
+			tex.Resource = entry.Resource;
+			tex.UploadHeap = nullptr;
+			return;
+		}
+
+		// Same key, different pixels: a hash collision, or the entry's file has
+		// changed since.  The texture gets a resource of its own that is not shared.
+		++mStats.Collisions;
+
+		hr = CreateDDSTextureFromData12(device, cmdList, data, tex.Resource, tex.UploadHeap);
+		if(FAILED(hr))
+			throw DxException(hr, L"CreateDDSTextureFromData12", tex.Filename, __LINE__);
+
+		mStats.BytesLoaded += bytes;
+		return;
+	}
+
+	hr = CreateDDSTextureFromData12(device, cmdList, data, tex.Resource, tex.UploadHeap);
+	if(FAILED(hr))
+		throw DxException(hr, L"CreateDDSTextureFromData12", tex.Filename, __LINE__);
+
+	Entry& entry = mEntries[key];
+	entry.Resource = tex.Resource;
+	entry.SourceFile = tex.Filename;
+	entry.Bytes = bytes;
+	entry.RefCount = 1;
+
+	mFileIndex[tex.Filename] = key;
+	mOwners[tex.Resource.Get()] = key;
+
+	++mStats.UniqueTextures;
+	mStats.BytesLoaded += bytes;
+}
+
+bool TextureCache::SameContents(const Entry& entry, const std::uint8_t* pixels, std::uint64_t bytes)const
+{
+	if(bytes != entry.Bytes)
+		return false;
+
+	DDS_TEXTURE_DATA source;
+	if(FAILED(LoadDDSTextureDataFromFile(entry.SourceFile.c_str(), source, 0, DDS_LOADER_MEMORY_MAPPED)))
+		return false;
+
+	const std::uint8_t* sourcePixels = nullptr;
+	std::uint64_t sourceBytes = 0;
+	GetPixelSpan(source, sourcePixels, sourceBytes);
+
+	return sourceBytes == bytes && memcmp(sourcePixels, pixels, (size_t)bytes) == 0;
+}
+
+void TextureCache::Release(Texture& tex)
+{
+	auto owner = mOwners.find(tex.Resource.Get());
+	if(owner != mOwners.end())
+	{
+		auto it = mEntries.find(owner->second);
+		if(it != mEntries.end() && --it->second.RefCount == 0)
+		{
+			mEntries.erase(it);
+			mOwners.erase(owner);
+			--mStats.UniqueTextures;
+		}
+	}
+
+	tex.Resource = nullptr;
+	tex.UploadHeap = nullptr;
+}
+
+void TextureCache::ClearFileIndex()
+{
+	mFileIndex.clear();
+}
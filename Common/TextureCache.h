@@ -0,0 +1,83 @@
+//***************************************************************************************
+// TextureCache.h
+//
+// Shares one GPU texture between every Texture whose image is the same.  Images are
+// keyed by an XXH64 of their pixel data together with the format and dimensions,
+// so the same file loaded under different names, byte-identical copies and images
+// that only differ in their DDS header all end up on one resource.  A hit on the key
+// is confirmed by comparing the pixels with those of the file the entry was loaded
+// from, so a hash collision never hands back the wrong image.  Entries are
+// reference counted and freed when the last Texture using them is released.
+//
+// Not thread safe; use it from the thread that records the uploads.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class TextureCache
+{
+public:
+	struct Stats
+	{
+		std::uint64_t Requests = 0;
+		std::uint64_t FileHits = 0;         // Filename already loaded; nothing read.
+		std::uint64_t ContentHits = 0;      // Different file with identical contents.
+		std::uint64_t UniqueTextures = 0;   // Live GPU textures.
+		std::uint64_t BytesLoaded = 0;      // Pixel bytes uploaded.
+		std::uint64_t DuplicateBytesAvoided = 0;
+		std::uint64_t Collisions = 0;       // Same key, different pixels; not shared.
+	};
+
+	TextureCache() = default;
+	TextureCache(const TextureCache& rhs) = delete;
+	TextureCache& operator=(const TextureCache& rhs) = delete;
+
+	// Fills tex.Resource (and tex.UploadHeap when a new upload was recorded) for
+	// tex.Filename.  Throws DxException on failure.
+	void Load(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, Texture& tex);
+
+	// Drops tex's reference and clears its resource pointers.
+	void Release(Texture& tex);
+
+	// Forgets which file maps to which image, e.g. after files change on disk.
+	// Live resources are kept.
+	void ClearFileIndex();
+
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	struct ContentKey
+	{
+		std::uint64_t Hash;
+		DXGI_FORMAT Format;
+		std::uint32_t Width, Height, Depth;
+		std::uint32_t MipCount, ArraySize;
+
+		bool operator==(const ContentKey& rhs)const;
+	};
+
+	struct ContentKeyHasher
+	{
+		size_t operator()(const ContentKey& key)const { return (size_t)key.Hash; }
+	};
+
+	struct Entry
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		std::wstring SourceFile;            // Re-read to confirm a content hit.
+		std::uint64_t Bytes = 0;
+		std::uint32_t RefCount = 0;
+	};
+
+	bool SameContents(const Entry& entry, const std::uint8_t* pixels, std::uint64_t bytes)const;
+
+	std::unordered_map<ContentKey, Entry, ContentKeyHasher> mEntries;
+	std::unordered_map<std::wstring, ContentKey> mFileIndex;
+
+	// Which entry each live Texture holds, by resource address.
+	std::unordered_map<ID3D12Resource*, ContentKey> mOwners;
+
+	Stats mStats;
+};
@@ -0,0 +1,434 @@
+//--------------------------------------------------------------------------------------
+// File: TextureFootprint.cpp
+//
+// CPU replica of GetCopyableFootprints and direct-to-staging DDS reads.  See
+// TextureFootprint.h.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#include "TextureFootprint.h"
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+using namespace DirectX;
+
+namespace
+{
+
+inline uint64_t AlignUp( uint64_t value, uint64_t alignment )
+{
+    return ( value + alignment - 1 ) & ~( alignment - 1 );
+}
+
+bool SeekTo( FILE* file, uint64_t offset )
+{
+#if defined(_WIN32)
+    return _fseeki64( file, static_cast<__int64>( offset ), SEEK_SET ) == 0;
+#else
+    return fseeko( file, static_cast<off_t>( offset ), SEEK_SET ) == 0;
+#endif
+}
+
+bool GetFileSize( FILE* file, uint64_t& size )
+{
+#if defined(_WIN32)
+    if ( _fseeki64( file, 0, SEEK_END ) != 0 )
+    {
+        return false;
+    }
+    const __int64 end = _ftelli64( file );
+#else
+    if ( fseeko( file, 0, SEEK_END ) != 0 )
+    {
+        return false;
+    }
+    const off_t end = ftello( file );
+#endif
+    if ( end < 0 )
+    {
+        return false;
+    }
+
+    size = static_cast<uint64_t>( end );
+    return true;
+}
+
+// Maps the sink for the whole texture described by staged.info.
+uint8_t* BeginStaging( StagingSink& sink, DDS_STAGED_TEXTURE& staged, HRESULT& hr )
+{
+    hr = GetTextureFootprints( staged.info, 0, staged.footprints, &staged.totalBytes );
+    if ( FAILED(hr) )
+    {
+        return nullptr;
+    }
+
+    uint8_t* base = sink.Map( staged.totalBytes );
+    if ( !base )
+    {
+        hr = E_OUTOFMEMORY;
+    }
+    return base;
+}
+
+// Reads one subresource from the file position into its footprint.  Rows that are
+// already pitch aligned arrive in a single read.
+bool ReadSubresource( FILE* file, const TEXTURE_FOOTPRINT& footprint, uint8_t* stagingBase )
+{
+    uint8_t* dst = stagingBase + footprint.offset;
+    const size_t rowSize = static_cast<size_t>( footprint.rowSizeInBytes );
+    const size_t rows = size_t( footprint.numRows ) * footprint.depth;
+
+    if ( rowSize == footprint.rowPitch )
+    {
+        return fread( dst, rowSize, rows, file ) == rows;
+    }
+
+    for ( size_t row = 0; row < rows; ++row )
+    {
+        if ( fread( dst, 1, rowSize, file ) != rowSize )
+        {
+            return false;
+        }
+        dst += footprint.rowPitch;
+    }
+    return true;
+}
+
+// Stages a whole DDS image that is already in memory.
+HRESULT StageFromMemory( const uint8_t* ddsData, size_t ddsDataSize, StagingSink& sink,
+                         DDS_STAGED_TEXTURE& staged, size_t maxsize )
+{
+    HRESULT hr = GetDDSTextureInfoFromMemory( ddsData, ddsDataSize, &staged.info );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+    if ( ddsDataSize < staged.info.dataOffset )
+    {
+        return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+    }
+
+    std::vector<size_t> offsets;
+    hr = LayoutDDSSubresources( staged.info, ddsDataSize - staged.info.dataOffset, maxsize, offsets );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    uint8_t* base = BeginStaging( sink, staged, hr );
+    if ( !base )
+    {
+        return hr;
+    }
+
+    const uint8_t* bitData = ddsData + staged.info.dataOffset;
+    for ( size_t i = 0; i < staged.footprints.size(); ++i )
+    {
+        const TEXTURE_FOOTPRINT& fp = staged.footprints[i];
+
+        DDS_SUBRESOURCE src;
+        src.pData = bitData + offsets[i];
+        src.rowPitch = static_cast<intptr_t>( fp.rowSizeInBytes );
+        src.slicePitch = static_cast<intptr_t>( fp.rowSizeInBytes * fp.numRows );
+        CopySubresourceToFootprint( src, fp, base );
+    }
+
+    sink.Unmap();
+    return S_OK;
+}
+
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetTextureFootprints( DXGI_FORMAT format,
+                                       uint32_t width,
+                                       uint32_t height,
+                                       uint32_t depth,
+                                       uint32_t mipCount,
+                                       uint32_t arraySize,
+                                       uint32_t firstSubresource,
+                                       uint32_t numSubresources,
+                                       uint64_t baseOffset,
+                                       TEXTURE_FOOTPRINT* footprints,
+                                       uint64_t* totalBytes )
+{
+    if ( totalBytes )
+    {
+        *totalBytes = 0;
+    }
+
+    if ( !width || !height || !depth || !mipCount || !arraySize ||
+         uint64_t( firstSubresource ) + numSubresources > uint64_t( mipCount ) * arraySize ||
+         ( baseOffset & ( TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1 ) ) )
+    {
+        return E_INVALIDARG;
+    }
+
+    size_t blockWidth = 0;
+    size_t blockHeight = 0;
+    if ( !GetBlockSize( format, &blockWidth, &blockHeight ) || !BitsPerPixel( format ) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+    }
+
+    uint64_t offset = 0;
+    uint64_t total = 0;
+    for ( uint32_t n = 0; n < numSubresources; ++n )
+    {
+        const uint32_t mip = ( firstSubresource + n ) % mipCount;
+        const size_t w = std::max<size_t>( 1, width >> mip );
+        const size_t h = std::max<size_t>( 1, height >> mip );
+        const size_t d = std::max<size_t>( 1, depth >> mip );
+
+        size_t rowBytes = 0;
+        size_t numRows = 0;
+        GetSurfaceInfo( w, h, format, nullptr, &rowBytes, &numRows );
+
+        const uint64_t rowPitch = AlignUp( rowBytes, TEXTURE_DATA_PITCH_ALIGNMENT );
+        if ( rowPitch > std::numeric_limits<uint32_t>::max() )
+        {
+            return E_INVALIDARG;
+        }
+
+        offset = AlignUp( offset, TEXTURE_DATA_PLACEMENT_ALIGNMENT );
+        if ( footprints )
+        {
+            TEXTURE_FOOTPRINT& fp = footprints[n];
+            fp.offset = baseOffset + offset;
+            fp.format = format;
+            fp.width = static_cast<uint32_t>( AlignUp( w, blockWidth ) );
+            fp.height = static_cast<uint32_t>( AlignUp( h, blockHeight ) );
+            fp.depth = static_cast<uint32_t>( d );
+            fp.rowPitch = static_cast<uint32_t>( rowPitch );
+            fp.numRows = static_cast<uint32_t>( numRows );
+            fp.rowSizeInBytes = rowBytes;
+        }
+
+        // The last row of a subresource needs no padding behind it.
+        const uint64_t rows = uint64_t( numRows ) * d;
+        total = offset + rowPitch * ( rows - 1 ) + rowBytes;
+        offset += rowPitch * rows;
+    }
+
+    if ( totalBytes )
+    {
+        *totalBytes = total;
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetTextureFootprints( const DDS_TEXTURE_INFO& info,
+                                       uint64_t baseOffset,
+                                       std::vector<TEXTURE_FOOTPRINT>& footprints,
+                                       uint64_t* totalBytes )
+{
+    const uint32_t numSubresources = info.mipCount * info.arraySize;
+    footprints.resize( numSubresources );
+
+    HRESULT hr = GetTextureFootprints( info.format,
+                                       info.width, info.height, info.depth,
+                                       info.mipCount, info.arraySize,
+                                       0, numSubresources,
+                                       baseOffset,
+                                       footprints.data(),
+                                       totalBytes );
+    if ( FAILED(hr) )
+    {
+        footprints.clear();
+    }
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::CopySubresourceToFootprint( const DDS_SUBRESOURCE& src,
+                                          const TEXTURE_FOOTPRINT& footprint,
+                                          uint8_t* stagingBase )
+{
+    const size_t rowSize = static_cast<size_t>( footprint.rowSizeInBytes );
+    const uint8_t* srcSlice = static_cast<const uint8_t*>( src.pData );
+    uint8_t* dst = stagingBase + footprint.offset;
+
+    for ( uint32_t z = 0; z < footprint.depth; ++z )
+    {
+        const uint8_t* srcRow = srcSlice;
+        for ( uint32_t row = 0; row < footprint.numRows; ++row )
+        {
+            memcpy( dst, srcRow, rowSize );
+            dst += footprint.rowPitch;
+            srcRow += src.rowPitch;
+        }
+        srcSlice += src.slicePitch;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+uint8_t* MemoryStagingSink::Map( uint64_t size )
+{
+    if ( size > std::numeric_limits<size_t>::max() )
+    {
+        return nullptr;
+    }
+
+    if ( !m_data || size > m_size )
+    {
+        m_data.reset( new (std::nothrow) uint8_t[ size ? static_cast<size_t>( size ) : 1 ] );
+        if ( !m_data )
+        {
+            m_size = 0;
+            return nullptr;
+        }
+    }
+
+    m_size = size;
+    return m_data.get();
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::StageDDSTextureData( const DDS_TEXTURE_DATA& data,
+                                      StagingSink& sink,
+                                      DDS_STAGED_TEXTURE& staged )
+{
+    staged.info = data.info;
+    staged.footprints.clear();
+    staged.totalBytes = 0;
+
+    if ( data.subresources.size() != size_t( data.info.mipCount ) * data.info.arraySize )
+    {
+        return E_INVALIDARG;
+    }
+
+    HRESULT hr = S_OK;
+    uint8_t* base = BeginStaging( sink, staged, hr );
+    if ( !base )
+    {
+        return hr;
+    }
+
+    for ( size_t i = 0; i < staged.footprints.size(); ++i )
+    {
+        CopySubresourceToFootprint( data.subresources[i], staged.footprints[i], base );
+    }
+
+    sink.Unmap();
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::StageDDSTextureFromFile( const wchar_t* fileName,
+                                          StagingSink& sink,
+                                          DDS_STAGED_TEXTURE& staged,
+                                          size_t maxsize,
+                                          unsigned int loadFlags )
+{
+    staged.info = DDS_TEXTURE_INFO();
+    staged.footprints.clear();
+    staged.totalBytes = 0;
+
+    if ( !fileName )
+    {
+        return E_INVALIDARG;
+    }
+
+    HRESULT hr = S_OK;
+    std::vector<size_t> offsets;
+
+    // Archived and mapped files are already in memory; rows are copied out of the
+    // page cache and that view is the only one of the file.
+    ArchivedFile archived;
+    if ( FindArchivedFile( fileName, archived ) )
+    {
+        return StageFromMemory( archived.Data, archived.Size, sink, staged, maxsize );
+    }
+
+    if ( loadFlags & DDS_LOADER_MEMORY_MAPPED )
+    {
+        FileMapping mapping;
+        hr = mapping.Open( fileName );
+        if ( FAILED(hr) )
+        {
+            return hr;
+        }
+
+        return StageFromMemory( mapping.Data(), mapping.Size(), sink, staged, maxsize );
+    }
+
+    FILE* file = nullptr;
+    hr = OpenFileForRead( fileName, &file );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    uint64_t fileSize = 0;
+    hr = GetDDSTextureInfoFromStream( file, &staged.info );
+    if ( SUCCEEDED(hr) && ( !GetFileSize( file, fileSize ) || fileSize < staged.info.dataOffset ) )
+    {
+        hr = HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+    }
+    if ( SUCCEEDED(hr) )
+    {
+        hr = LayoutDDSSubresources( staged.info,
+                                    static_cast<size_t>( fileSize - staged.info.dataOffset ),
+                                    maxsize,
+                                    offsets );
+    }
+
+    uint8_t* base = nullptr;
+    if ( SUCCEEDED(hr) )
+    {
+        base = BeginStaging( sink, staged, hr );
+    }
+
+    if ( base )
+    {
+        // Subresources are read in file order; only mips dropped by maxsize are skipped.
+        uint64_t position = std::numeric_limits<uint64_t>::max();
+        for ( size_t i = 0; i < staged.footprints.size() && SUCCEEDED(hr); ++i )
+        {
+            const TEXTURE_FOOTPRINT& fp = staged.footprints[i];
+            const uint64_t start = uint64_t( staged.info.dataOffset ) + offsets[i];
+            if ( start != position && !SeekTo( file, start ) )
+            {
+                hr = E_FAIL;
+            }
+            else if ( !ReadSubresource( file, fp, base ) )
+            {
+                hr = HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+            }
+
+            position = start + fp.rowSizeInBytes * fp.numRows * fp.depth;
+        }
+
+        sink.Unmap();
+    }
+
+    fclose( file );
+    return hr;
+}
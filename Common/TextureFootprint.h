@@ -0,0 +1,136 @@
+//--------------------------------------------------------------------------------------
+// File: TextureFootprint.h
+//
+// CPU replica of ID3D12Device::GetCopyableFootprints for the textures the DDS loader
+// creates.  Each subresource is placed at a 512 byte aligned offset with its rows
+// 256 bytes apart (D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT and
+// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT), in subresource order, exactly as the runtime
+// lays out a buffer for CopyTextureRegion.  Upload heaps can therefore be sized,
+// planned and filled before a device exists.
+//
+// A StagingSink is the memory the footprints are written into: an upload heap on
+// D3D12 (see DDSTextureLoader) or plain memory anywhere else.
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "DDSTextureData.h"
+
+namespace DirectX
+{
+    const uint32_t TEXTURE_DATA_PITCH_ALIGNMENT     = 256;  // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    const uint32_t TEXTURE_DATA_PLACEMENT_ALIGNMENT = 512;  // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+
+    // One subresource in a staging buffer.  offset, format, width, height, depth and
+    // rowPitch are D3D12_PLACED_SUBRESOURCE_FOOTPRINT; numRows and rowSizeInBytes are
+    // the other two outputs of GetCopyableFootprints.  width and height are rounded up
+    // to whole blocks, so a 2x2 BC1 mip has a 4x4 footprint.
+    struct TEXTURE_FOOTPRINT
+    {
+        uint64_t    offset;
+        DXGI_FORMAT format;
+        uint32_t    width;
+        uint32_t    height;
+        uint32_t    depth;
+        uint32_t    rowPitch;
+        uint32_t    numRows;
+        uint64_t    rowSizeInBytes;
+    };
+
+    // Footprints of subresources [firstSubresource, firstSubresource + numSubresources)
+    // of a texture with mips of slice 0 first, as D3D12CalcSubresource numbers them.
+    // baseOffset must be a multiple of TEXTURE_DATA_PLACEMENT_ALIGNMENT.  totalBytes
+    // receives the buffer size needed past baseOffset; like the runtime, it does not
+    // pad the last row of the last subresource.  Either output may be null.
+    HRESULT GetTextureFootprints( _In_ DXGI_FORMAT format,
+                                  _In_ uint32_t width,
+                                  _In_ uint32_t height,
+                                  _In_ uint32_t depth,
+                                  _In_ uint32_t mipCount,
+                                  _In_ uint32_t arraySize,
+                                  _In_ uint32_t firstSubresource,
+                                  _In_ uint32_t numSubresources,
+                                  _In_ uint64_t baseOffset,
+                                  _Out_writes_opt_(numSubresources) TEXTURE_FOOTPRINT* footprints,
+                                  _Out_opt_ uint64_t* totalBytes );
+
+    // Footprints of every subresource of a texture described by info.
+    HRESULT GetTextureFootprints( _In_ const DDS_TEXTURE_INFO& info,
+                                  _In_ uint64_t baseOffset,
+                                  _Out_ std::vector<TEXTURE_FOOTPRINT>& footprints,
+                                  _Out_opt_ uint64_t* totalBytes );
+
+    // Copies a tightly or loosely packed subresource into its footprint in a mapped
+    // staging buffer, row by row.  The same copy MemcpySubresource makes.
+    void CopySubresourceToFootprint( _In_ const DDS_SUBRESOURCE& src,
+                                     _In_ const TEXTURE_FOOTPRINT& footprint,
+                                     _Out_ uint8_t* stagingBase );
+
+    // Where the footprints of one texture are written.  Map returns at least size
+    // writable bytes (nullptr on failure) that stay valid until Unmap.  The memory may
+    // be write-combined, so callers only ever write it, and write it in order.
+    class StagingSink
+    {
+    public:
+        virtual ~StagingSink() {}
+
+        virtual uint8_t* Map( _In_ uint64_t size ) = 0;
+        virtual void Unmap() = 0;
+    };
+
+    // A StagingSink in ordinary memory, for planning, tools and tests without a device.
+    class MemoryStagingSink : public StagingSink
+    {
+    public:
+        uint8_t* Map( _In_ uint64_t size ) override;
+        void Unmap() override {}
+
+        const uint8_t* Data() const { return m_data.get(); }
+        uint64_t Size() const { return m_size; }
+
+    private:
+        std::unique_ptr<uint8_t[]> m_data;
+        uint64_t m_size = 0;
+    };
+
+    // A texture whose pixels are in a StagingSink, ready for one CopyTextureRegion per
+    // footprint.
+    struct DDS_STAGED_TEXTURE
+    {
+        DDS_TEXTURE_INFO info;
+        std::vector<TEXTURE_FOOTPRINT> footprints;
+        uint64_t totalBytes;
+
+        DDS_STAGED_TEXTURE() : info(), totalBytes(0) {}
+    };
+
+    // Lays a loaded texture out into sink, replacing GetRequiredIntermediateSize and
+    // UpdateSubresources on the CPU side.
+    HRESULT StageDDSTextureData( _In_ const DDS_TEXTURE_DATA& data,
+                                 _Inout_ StagingSink& sink,
+                                 _Out_ DDS_STAGED_TEXTURE& staged );
+
+    // Reads a DDS file straight into sink in its final layout: only the headers pass
+    // through a local buffer and every row is read (or, with DDS_LOADER_MEMORY_MAPPED,
+    // copied out of the page cache) directly to its place in the footprint.  Files in
+    // a mounted TextureArchive are copied out of its mapping.  maxsize drops mips as
+    // LoadDDSTextureDataFromFile does; dropped mips are never read.
+    HRESULT StageDDSTextureFromFile( _In_z_ const wchar_t* fileName,
+                                     _Inout_ StagingSink& sink,
+                                     _Out_ DDS_STAGED_TEXTURE& staged,
+                                     _In_ size_t maxsize = 0,
+                                     _In_ unsigned int loadFlags = DDS_LOADER_DEFAULT );
+}
@@ -0,0 +1,294 @@
+//***************************************************************************************
+// TextureHotReload.cpp
+//***************************************************************************************
+
+#include "TextureHotReload.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+TextureHotReload::TextureHotReload(ID3D12Device* device, ThreadPool& pool, std::unique_ptr<FileWatcher> watcher)
+	: md3dDevice(device), mPool(pool), mWatcher(std::move(watcher))
+{
+}
+
+void TextureHotReload::SetMaxSize(size_t maxsize)
+{
+	mMaxSize = maxsize;
+}
+
+void TextureHotReload::Watch(Texture& tex, D3D12_CPU_DESCRIPTOR_HANDLE srv, UINT srvCount, UINT srvDescriptorSize)
+{
+	// One slot would have to be rewritten while frames in flight read it.
+	if(srv.ptr != 0 && srvCount < 2)
+		ThrowIfFailed(E_INVALIDARG);
+
+	Target target = { &tex, srv, srvCount, srvDescriptorSize, 0,
+		std::vector<std::uint64_t>(srv.ptr != 0 ? srvCount : 0, 0) };
+
+	WatchedFile& file = mFiles[FileWatcher::NormalizePath(tex.Filename)];
+	for(Target& t : file.Targets)
+	{
+		if(t.Tex == &tex)
+		{
+			t = std::move(target);
+			return;
+		}
+	}
+	file.Targets.push_back(std::move(target));
+}
+
+UINT TextureHotReload::SrvSlot(const Texture& tex)const
+{
+	auto it = mFiles.find(FileWatcher::NormalizePath(tex.Filename));
+	if(it != mFiles.end())
+	{
+		for(const Target& t : it->second.Targets)
+		{
+			if(t.Tex == &tex)
+				return t.SrvSlot;
+		}
+	}
+	return 0;
+}
+
+void TextureHotReload::Unwatch(Texture& tex)
+{
+	auto it = mFiles.find(FileWatcher::NormalizePath(tex.Filename));
+	if(it == mFiles.end())
+		return;
+
+	std::vector<Target>& targets = it->second.Targets;
+	targets.erase(std::remove_if(targets.begin(), targets.end(),
+		[&tex](const Target& t) { return t.Tex == &tex; }), targets.end());
+
+	// A parse still in flight only holds its own copies, so the entry can go; a
+	// staged upload may still be running and is kept until its fence.
+	if(targets.empty())
+	{
+		if(it->second.Resource)
+			mRetired.push_back({ it->second.Resource, it->second.FenceValue });
+		if(it->second.UploadHeap)
+			mRetired.push_back({ it->second.UploadHeap, it->second.FenceValue });
+		mFiles.erase(it);
+	}
+}
+
+void TextureHotReload::StartParse(const std::wstring& filename, WatchedFile& file)
+{
+	size_t maxsize = mMaxSize;
+
+	// Read into a heap copy rather than mapping the file, so the editor that
+	// wrote it is never blocked from saving it again.
+	file.Parse = mPool.Submit([filename, maxsize]()
+	{
+		auto parsed = std::make_unique<ParsedTexture>();
+		parsed->Result = LoadDDSTextureDataFromFile(filename.c_str(), parsed->Data, maxsize, DDS_LOADER_DEFAULT);
+		return parsed;
+	});
+	file.Reparse = false;
+}
+
+void TextureHotReload::RecordFailure(const std::wstring& filename, HRESULT hr)
+{
+	++mStats.Failures;
+	mStats.LastError = hr;
+	mStats.LastFailedFile = filename;
+}
+
+UINT TextureHotReload::Update(ID3D12GraphicsCommandList* cmdList, std::uint64_t fenceValue)
+{
+	for(const std::wstring& changed : mWatcher->Poll())
+	{
+		auto it = mFiles.find(changed);
+		if(it == mFiles.end())
+			continue;
+
+		++mStats.Changes;
+		WatchedFile& file = it->second;
+		file.ChangedAt = Clock::now();
+		if(file.Parse.valid())
+			file.Reparse = true;
+		else
+			StartParse(changed, file);
+	}
+
+	UINT uploads = 0;
+	for(auto& entry : mFiles)
+	{
+		WatchedFile& file = entry.second;
+		if(!file.Parse.valid() ||
+			file.Parse.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			continue;
+
+		std::unique_ptr<ParsedTexture> parsed = file.Parse.get();
+
+		// The file changed again while it was being read; that read may be torn.
+		if(file.Reparse)
+		{
+			StartParse(entry.first, file);
+			continue;
+		}
+
+		if(FAILED(parsed->Result))
+		{
+			RecordFailure(entry.first, parsed->Result);
+			continue;
+		}
+
+		ComPtr<ID3D12Resource> resource;
+		ComPtr<ID3D12Resource> uploadHeap;
+		HRESULT hr = CreateDDSTextureFromData12(md3dDevice, cmdList, parsed->Data, resource, uploadHeap);
+		if(FAILED(hr))
+		{
+			RecordFailure(entry.first, hr);
+			continue;
+		}
+
+		// An earlier save that was never applied is superseded.
+		if(file.Resource)
+			mRetired.push_back({ file.Resource, file.FenceValue });
+		if(file.UploadHeap)
+			mRetired.push_back({ file.UploadHeap, file.FenceValue });
+
+		file.Resource = resource;
+		file.UploadHeap = uploadHeap;
+		file.IsCubeMap = parsed->Data.info.isCubeMap;
+		file.FenceValue = fenceValue;
+		++uploads;
+	}
+	return uploads;
+}
+
+UINT TextureHotReload::ReadyCount(std::uint64_t completedFence)const
+{
+	UINT count = 0;
+	for(const auto& entry : mFiles)
+	{
+		if(entry.second.Resource && entry.second.FenceValue <= completedFence)
+			++count;
+	}
+	return count;
+}
+
+int TextureHotReload::FreeSrvSlot(const Target& t, std::uint64_t completedFence)
+{
+	for(UINT i = 1; i < t.SrvCount; ++i)
+	{
+		UINT slot = (t.SrvSlot + i) % t.SrvCount;
+		if(t.SlotFences[slot] <= completedFence)
+			return (int)slot;
+	}
+	return -1;
+}
+
+UINT TextureHotReload::Apply(std::uint64_t completedFence, std::uint64_t retireFence)
+{
+	UINT applied = 0;
+	for(auto& entry : mFiles)
+	{
+		WatchedFile& file = entry.second;
+		if(!file.Resource || file.FenceValue > completedFence)
+			continue;
+
+		// All targets swap together, so wait until each has a slot to write.
+		bool slotsFree = std::all_of(file.Targets.begin(), file.Targets.end(),
+			[completedFence](const Target& t) { return t.Srv.ptr == 0 || FreeSrvSlot(t, completedFence) >= 0; });
+		if(!slotsFree)
+			continue;
+
+		for(Target& t : file.Targets)
+		{
+			if(t.Tex->Resource)
+				mRetired.push_back({ std::move(t.Tex->Resource), retireFence });
+			if(t.Tex->UploadHeap)
+				mRetired.push_back({ std::move(t.Tex->UploadHeap), retireFence });
+
+			t.Tex->Resource = file.Resource;
+			t.Tex->UploadHeap = nullptr;
+
+			if(t.Srv.ptr != 0)
+			{
+				UINT slot = (UINT)FreeSrvSlot(t, completedFence);
+				t.SlotFences[t.SrvSlot] = retireFence;
+				t.SrvSlot = slot;
+
+				D3D12_CPU_DESCRIPTOR_HANDLE srv = t.Srv;
+				srv.ptr += (SIZE_T)slot * t.SrvSize;
+				WriteSrv(file.Resource.Get(), file.IsCubeMap, srv);
+			}
+		}
+
+		file.Resource = nullptr;
+		file.UploadHeap = nullptr;
+
+		++mStats.Reloads;
+		mStats.LastReloadMs = std::chrono::duration<double, std::milli>(Clock::now() - file.ChangedAt).count();
+		++applied;
+	}
+
+	mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(),
+		[completedFence](const RetiredResource& r) { return r.FenceValue <= completedFence; }), mRetired.end());
+
+	return applied;
+}
+
+void TextureHotReload::WriteSrv(ID3D12Resource* resource, bool isCubeMap, D3D12_CPU_DESCRIPTOR_HANDLE srv)
+{
+	D3D12_RESOURCE_DESC desc = resource->GetDesc();
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = desc.Format;
+
+	switch(desc.Dimension)
+	{
+	case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
+		if(desc.DepthOrArraySize > 1)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
+			srvDesc.Texture1DArray.MipLevels = -1;
+			srvDesc.Texture1DArray.ArraySize = desc.DepthOrArraySize;
+		}
+		else
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
+			srvDesc.Texture1D.MipLevels = -1;
+		}
+		break;
+
+	case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+		srvDesc.Texture3D.MipLevels = -1;
+		break;
+
+	default:
+		if(isCubeMap && desc.DepthOrArraySize > 6)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
+			srvDesc.TextureCubeArray.MipLevels = -1;
+			srvDesc.TextureCubeArray.NumCubes = desc.DepthOrArraySize / 6;
+		}
+		else if(isCubeMap)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+			srvDesc.TextureCube.MipLevels = -1;
+		}
+		else if(desc.DepthOrArraySize > 1)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc.Texture2DArray.MipLevels = -1;
+			srvDesc.Texture2DArray.ArraySize = desc.DepthOrArraySize;
+		}
+		else
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels = -1;
+		}
+		break;
+	}
+
+	md3dDevice->CreateShaderResourceView(resource, &srvDesc, srv);
+}
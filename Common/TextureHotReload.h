@@ -0,0 +1,131 @@
+//***************************************************************************************
+// TextureHotReload.h
+//
+// Reloads textures whose files change on disk while the app runs.  A FileWatcher
+// reports the changed files; only those are reparsed (on a ThreadPool) and uploaded,
+// into new resources.  Once the upload has passed its fence, Apply() swaps the new
+// resource into the Texture and views it through another of the texture's SRV slots,
+// so frames still in flight keep reading the old descriptor and resource; both are
+// released once those frames have finished.  No queue flush is needed.
+//
+// A file that fails to load (half written, wrong format) leaves the old texture in
+// place and is counted in Stats; the next save tries again.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "FileWatcher.h"
+#include "ThreadPool.h"
+
+class TextureHotReload
+{
+public:
+	struct Stats
+	{
+		std::uint64_t Changes = 0;       // watched files reported changed
+		std::uint64_t Reloads = 0;       // textures swapped by Apply
+		std::uint64_t Failures = 0;      // reparses or uploads that failed
+		double LastReloadMs = 0.0;       // from the change being reported to its Apply
+		HRESULT LastError = S_OK;
+		std::wstring LastFailedFile;
+	};
+
+	// watcher must watch the directory the textures are loaded from.
+	TextureHotReload(ID3D12Device* device, ThreadPool& pool, std::unique_ptr<FileWatcher> watcher);
+	TextureHotReload(const TextureHotReload& rhs) = delete;
+	TextureHotReload& operator=(const TextureHotReload& rhs) = delete;
+
+	// Same meaning as the CreateDDSTextureFromFile12 argument.
+	void SetMaxSize(size_t maxsize);
+
+	// Reloads tex when tex.Filename changes.  srv, if non-null, is the first of
+	// srvCount (at least 2) consecutive descriptors, srvDescriptorSize apart; the
+	// first views tex.Resource now, and each reload writes the next free one.  Bind
+	// the one SrvSlot returns.  tex must stay alive until it is unwatched or the
+	// reloader is destroyed.
+	void Watch(Texture& tex, D3D12_CPU_DESCRIPTOR_HANDLE srv = D3D12_CPU_DESCRIPTOR_HANDLE{ 0 },
+		UINT srvCount = 2, UINT srvDescriptorSize = 0);
+	void Unwatch(Texture& tex);
+
+	// Index, from the srv passed to Watch, of the descriptor that views tex.Resource.
+	UINT SrvSlot(const Texture& tex)const;
+
+	// Polls the watcher, starts reparsing the changed files and records uploads for
+	// those that have finished.  fenceValue is the value the queue signals once
+	// cmdList has run.  Returns the number of uploads recorded.
+	UINT Update(ID3D12GraphicsCommandList* cmdList, std::uint64_t fenceValue);
+
+	// Textures whose upload has passed completedFence and can be applied.
+	UINT ReadyCount(std::uint64_t completedFence)const;
+
+	// Swaps in every texture whose upload has passed completedFence and writes its
+	// SRV into a free slot.  retireFence is the value the queue signals after the last
+	// frame that may still read the old texture, usually the one just submitted; its
+	// resource and SRV slot are kept until then.  A texture with no free slot waits
+	// for a later Apply.  Returns the number of textures swapped.
+	UINT Apply(std::uint64_t completedFence, std::uint64_t retireFence);
+
+	const Stats& GetStats()const { return mStats; }
+	const FileWatcher& Watcher()const { return *mWatcher; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct ParsedTexture
+	{
+		DirectX::DDS_TEXTURE_DATA Data;
+		HRESULT Result = E_FAIL;
+	};
+
+	struct Target
+	{
+		Texture* Tex;
+		D3D12_CPU_DESCRIPTOR_HANDLE Srv;         // first of SrvCount, SrvSize apart
+		UINT SrvCount;
+		UINT SrvSize;
+		UINT SrvSlot;                            // the one that views Tex->Resource
+		std::vector<std::uint64_t> SlotFences;   // last frame that may read each slot
+	};
+
+	struct WatchedFile
+	{
+		std::vector<Target> Targets;
+
+		std::future<std::unique_ptr<ParsedTexture>> Parse;
+		bool Reparse = false;            // changed again while being parsed
+		Clock::time_point ChangedAt;
+
+		// Uploaded but not applied yet.
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		Microsoft::WRL::ComPtr<ID3D12Resource> UploadHeap;
+		bool IsCubeMap = false;
+		std::uint64_t FenceValue = 0;
+	};
+
+	struct RetiredResource
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		std::uint64_t FenceValue;
+	};
+
+	static int FreeSrvSlot(const Target& t, std::uint64_t completedFence);
+
+	void StartParse(const std::wstring& filename, WatchedFile& file);
+	void RecordFailure(const std::wstring& filename, HRESULT hr);
+	void WriteSrv(ID3D12Resource* resource, bool isCubeMap, D3D12_CPU_DESCRIPTOR_HANDLE srv);
+
+	ID3D12Device* md3dDevice;
+	ThreadPool& mPool;
+	std::unique_ptr<FileWatcher> mWatcher;
+	size_t mMaxSize = 0;
+
+	// Keyed by FileWatcher::NormalizePath(Filename).
+	std::unordered_map<std::wstring, WatchedFile> mFiles;
+
+	// Staged resources replaced by a newer save before they were applied, whose
+	// uploads may still be running, and textures swapped out by Apply.
+	std::vector<RetiredResource> mRetired;
+
+	Stats mStats;
+};
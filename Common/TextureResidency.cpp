@@ -0,0 +1,157 @@
+//***************************************************************************************
+// TextureResidency.cpp
+//***************************************************************************************
+
+#include "TextureResidency.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+TextureResidency::TextureResidency(ID3D12Device* device, std::uint64_t budgetBytes)
+	: md3dDevice(device), mPolicy(budgetBytes)
+{
+}
+
+TextureResidency::TextureId TextureResidency::Register(Texture* tex, int priority)
+{
+	Slot slot;
+	slot.Tex = tex;
+
+	HRESULT hr = GetDDSTextureInfoFromFile(tex->Filename.c_str(), &slot.Info);
+	if(FAILED(hr))
+		throw DxException(hr, L"GetDDSTextureInfoFromFile", tex->Filename, __LINE__);
+
+	mSlots.push_back(slot);
+	return mPolicy.Register(slot.Info, priority);
+}
+
+void TextureResidency::Use(TextureId id, std::uint64_t frame, std::uint32_t desiredMip)
+{
+	mPolicy.Touch(id, frame, desiredMip);
+}
+
+std::vector<TextureResidency::TextureId> TextureResidency::Update(
+	ID3D12GraphicsCommandList* cmdList,
+	std::uint64_t frame,
+	std::uint64_t fenceValue,
+	std::uint64_t completedFence)
+{
+	mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(),
+		[completedFence](const RetiredResource& r) { return r.FenceValue <= completedFence; }),
+		mRetired.end());
+
+	mFenceValue = fenceValue;
+
+	std::vector<TextureId> changed;
+	for(const ResidencyPolicy::Action& action : mPolicy.Plan(frame))
+	{
+		Slot& slot = mSlots[action.Id];
+		switch(action.Kind)
+		{
+		case ResidencyPolicy::Action::Load:
+			Load(cmdList, action.Id, action.TopMip);
+			break;
+
+		case ResidencyPolicy::Action::Reduce:
+			Reduce(cmdList, action.Id, action.TopMip);
+			break;
+
+		case ResidencyPolicy::Action::Evict:
+			Retire(slot.Tex->Resource);
+			slot.Tex->Resource = nullptr;
+			slot.TopMip = ResidencyPolicy::NotResident;
+			break;
+		}
+
+		changed.push_back(action.Id);
+	}
+
+	return changed;
+}
+
+void TextureResidency::Load(ID3D12GraphicsCommandList* cmdList, TextureId id, std::uint32_t topMip)
+{
+	Slot& slot = mSlots[id];
+
+	DDS_TEXTURE_DATA data;
+	HRESULT hr = LoadDDSTextureDataFromFile(slot.Tex->Filename.c_str(), data, 0, DDS_LOADER_MEMORY_MAPPED);
+	if(FAILED(hr))
+		throw DxException(hr, L"LoadDDSTextureDataFromFile", slot.Tex->Filename, __LINE__);
+
+	DropTopMips(data, topMip);
+
+	// The frames still in flight may be sampling the old resource.
+	Retire(slot.Tex->Resource);
+
+	ComPtr<ID3D12Resource> uploadHeap;
+	hr = CreateDDSTextureFromData12(md3dDevice, cmdList, data, slot.Tex->Resource, uploadHeap);
+	if(FAILED(hr))
+		throw DxException(hr, L"CreateDDSTextureFromData12", slot.Tex->Filename, __LINE__);
+
+	Retire(uploadHeap);
+	slot.Tex->UploadHeap = nullptr;
+	slot.TopMip = topMip;
+}
+
+void TextureResidency::Reduce(ID3D12GraphicsCommandList* cmdList, TextureId id, std::uint32_t topMip)
+{
+	Slot& slot = mSlots[id];
+	const DDS_TEXTURE_INFO& info = slot.Info;
+
+	// The GPU copy below handles 2D textures, arrays and cubes; anything else
+	// takes the slow path through the file.
+	if(slot.Tex->Resource == nullptr || info.dimension != DDS_DIMENSION_TEXTURE2D ||
+		slot.TopMip == ResidencyPolicy::NotResident || topMip <= slot.TopMip)
+	{
+		Load(cmdList, id, topMip);
+		return;
+	}
+
+	const UINT oldMips = info.mipCount - slot.TopMip;
+	const UINT newMips = info.mipCount - topMip;
+	const UINT skip = topMip - slot.TopMip;
+
+	CD3DX12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+		info.format,
+		std::max(1u, info.width >> topMip),
+		std::max(1u, info.height >> topMip),
+		(UINT16)info.arraySize,
+		(UINT16)newMips);
+
+	ComPtr<ID3D12Resource> smaller;
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&texDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&smaller)));
+
+	ID3D12Resource* old = slot.Tex->Resource.Get();
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(old,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+	for(UINT slice = 0; slice < info.arraySize; ++slice)
+	{
+		for(UINT mip = 0; mip < newMips; ++mip)
+		{
+			CD3DX12_TEXTURE_COPY_LOCATION dst(smaller.Get(), D3D12CalcSubresource(mip, slice, 0, newMips, info.arraySize));
+			CD3DX12_TEXTURE_COPY_LOCATION src(old, D3D12CalcSubresource(mip + skip, slice, 0, oldMips, info.arraySize));
+			cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+		}
+	}
+
+	// The old resource is only retired, so it need not go back to its old state.
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(smaller.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+	Retire(slot.Tex->Resource);
+	slot.Tex->Resource = smaller;
+	slot.TopMip = topMip;
+}
+
+void TextureResidency::Retire(ComPtr<ID3D12Resource> resource)
+{
+	if(resource != nullptr)
+		mRetired.push_back({ resource, mFenceValue });
+}
@@ -0,0 +1,73 @@
+//***************************************************************************************
+// TextureResidency.h
+//
+// Keeps the textures of a scene inside a GPU memory budget.  ResidencyPolicy decides
+// what to load, shrink or evict from each frame's texture use; this class carries
+// the decisions out.  A texture is registered from its file header only and loaded
+// the first time it is used.  Shrinking a texture copies its remaining mips on the GPU
+// into a smaller resource; evicting it releases the resource.  Evicted or shrunk
+// textures are reloaded from disk when they are wanted again.
+//
+// Resources replaced this way are kept alive until the fence value of the frame that
+// last used them has completed.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "ResidencyPolicy.h"
+
+class TextureResidency
+{
+public:
+	typedef ResidencyPolicy::TextureId TextureId;
+
+	TextureResidency(ID3D12Device* device, std::uint64_t budgetBytes);
+	TextureResidency(const TextureResidency& rhs) = delete;
+	TextureResidency& operator=(const TextureResidency& rhs) = delete;
+
+	// Reads only tex.Filename's header.  tex must outlive the manager.
+	TextureId Register(Texture* tex, int priority = 0);
+
+	void SetBudget(std::uint64_t budgetBytes) { mPolicy.SetBudget(budgetBytes); }
+
+	// Call for every texture a frame draws, before Update.
+	void Use(TextureId id, std::uint64_t frame, std::uint32_t desiredMip = 0);
+
+	// Carries out the frame's plan on cmdList.  fenceValue is the value the queue
+	// signals after this frame and completedFence the last one the GPU finished.
+	// Returns the textures whose Resource changed (their SRVs must be rewritten
+	// with ResidentMip() dropped from the top); evicted textures have a null Resource.
+	std::vector<TextureId> Update(
+		ID3D12GraphicsCommandList* cmdList,
+		std::uint64_t frame,
+		std::uint64_t fenceValue,
+		std::uint64_t completedFence);
+
+	std::uint32_t ResidentMip(TextureId id)const { return mPolicy.ResidentMip(id); }
+	const ResidencyPolicy& Policy()const { return mPolicy; }
+
+private:
+	void Load(ID3D12GraphicsCommandList* cmdList, TextureId id, std::uint32_t topMip);
+	void Reduce(ID3D12GraphicsCommandList* cmdList, TextureId id, std::uint32_t topMip);
+	void Retire(Microsoft::WRL::ComPtr<ID3D12Resource> resource);
+
+	struct Slot
+	{
+		Texture* Tex;
+		DirectX::DDS_TEXTURE_INFO Info;
+		std::uint32_t TopMip = ResidencyPolicy::NotResident;
+	};
+
+	struct RetiredResource
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		std::uint64_t FenceValue;
+	};
+
+	ID3D12Device* md3dDevice;
+	ResidencyPolicy mPolicy;
+	std::vector<Slot> mSlots;
+	std::vector<RetiredResource> mRetired;
+	std::uint64_t mFenceValue = 0;
+};
@@ -0,0 +1,243 @@
+//***************************************************************************************
+// TextureStreamer.cpp
+//***************************************************************************************
+
+#include "TextureStreamer.h"
+#include "TextureFootprint.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+TextureStreamer::TextureStreamer(ID3D12Device* device, std::uint32_t tailSize)
+	: md3dDevice(device), mTailSize(tailSize)
+{
+}
+
+TextureStreamer::Handle TextureStreamer::Add(ID3D12GraphicsCommandList* cmdList, Texture& tex, std::uint64_t fenceValue)
+{
+	auto streamed = std::make_unique<StreamedTexture>();
+	DDS_TEXTURE_DATA& data = streamed->Data;
+
+	HRESULT hr = LoadDDSTextureDataFromFile(tex.Filename.c_str(), data, 0, DDS_LOADER_MEMORY_MAPPED);
+	if(FAILED(hr))
+		throw DxException(hr, L"LoadDDSTextureDataFromFile", tex.Filename, __LINE__);
+
+	if(data.info.dimension != DDS_DIMENSION_TEXTURE2D || data.info.mipCount == 1)
+	{
+		// Nothing to stream; upload the whole texture now.
+		ThrowIfFailed(CreateDDSTextureFromData12(md3dDevice, cmdList, data, tex.Resource, tex.UploadHeap));
+		mUploads.push_back({ tex.UploadHeap, fenceValue });
+
+		streamed->Resource = tex.Resource;
+		streamed->Data = DDS_TEXTURE_DATA();
+		mTextures.push_back(std::move(streamed));
+		return mTextures.size() - 1;
+	}
+
+	CD3DX12_RESOURCE_DESC texDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+		data.info.format,
+		data.info.width,
+		data.info.height,
+		(UINT16)data.info.arraySize,
+		(UINT16)data.info.mipCount);
+
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&texDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&streamed->Resource)));
+
+	// The tail starts at the first mip that fits in mTailSize.
+	std::uint32_t lastMip = data.info.mipCount - 1;
+	std::uint32_t tail = 0;
+	while(tail < lastMip &&
+		std::max(data.info.width >> tail, data.info.height >> tail) > mTailSize)
+	{
+		++tail;
+	}
+
+	UploadMips(cmdList, *streamed, tail, lastMip, fenceValue);
+
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(streamed->Resource.Get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+	streamed->ResidentMip = tail;
+	streamed->RequestedMip = 0;
+	for(std::uint32_t mip = 0; mip < tail; ++mip)
+		streamed->PendingBytes += MipBytes(*streamed, mip);
+
+	tex.Resource = streamed->Resource;
+	tex.UploadHeap = nullptr;
+
+	mTextures.push_back(std::move(streamed));
+	return mTextures.size() - 1;
+}
+
+void TextureStreamer::RequestLod(Handle h, float lod)
+{
+	StreamedTexture& tex = *mTextures[h];
+
+	// Trilinear filtering at lod reads floor(lod) as its finer mip.
+	std::uint32_t mipCount = std::max<std::uint32_t>(1, tex.Data.info.mipCount);
+	float mip = std::floor(std::max(lod, 0.0f));
+	tex.RequestedMip = std::min((std::uint32_t)mip, mipCount - 1);
+}
+
+std::vector<TextureStreamer::Handle> TextureStreamer::Update(
+	ID3D12GraphicsCommandList* cmdList,
+	std::uint64_t byteBudget,
+	std::uint64_t fenceValue,
+	std::uint64_t completedFence)
+{
+	mUploads.erase(std::remove_if(mUploads.begin(), mUploads.end(),
+		[completedFence](const RetiredUpload& u) { return u.FenceValue <= completedFence; }),
+		mUploads.end());
+
+	std::vector<Handle> changed;
+	std::uint64_t spent = 0;
+
+	// One mip per texture per pass, the texture furthest from its request first,
+	// so that a single large texture cannot take the whole budget.
+	for(;;)
+	{
+		Handle best = mTextures.size();
+		std::uint32_t bestDeficit = 0;
+		for(Handle h = 0; h < mTextures.size(); ++h)
+		{
+			const StreamedTexture& tex = *mTextures[h];
+			if(tex.ResidentMip <= tex.RequestedMip)
+				continue;
+
+			std::uint32_t deficit = tex.ResidentMip - tex.RequestedMip;
+			std::uint64_t bytes = MipBytes(tex, tex.ResidentMip - 1);
+			bool affordable = spent == 0 || spent + bytes <= byteBudget;
+			if(affordable && deficit > bestDeficit)
+			{
+				best = h;
+				bestDeficit = deficit;
+			}
+		}
+
+		if(best == mTextures.size())
+			break;
+
+		StreamedTexture& tex = *mTextures[best];
+		std::uint32_t mip = tex.ResidentMip - 1;
+
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(tex.Resource.Get(),
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+
+		spent += UploadMips(cmdList, tex, mip, mip, fenceValue);
+
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(tex.Resource.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+		tex.ResidentMip = mip;
+		tex.PendingBytes -= MipBytes(tex, mip);
+
+		if(std::find(changed.begin(), changed.end(), best) == changed.end())
+			changed.push_back(best);
+
+		// The upload buffer holds its own copy now; drop the file once nothing is left.
+		if(tex.ResidentMip == 0)
+		{
+			DDS_TEXTURE_INFO info = tex.Data.info;
+			tex.Data = DDS_TEXTURE_DATA();
+			tex.Data.info = info;
+		}
+
+		if(spent >= byteBudget)
+			break;
+	}
+
+	return changed;
+}
+
+std::uint32_t TextureStreamer::ResidentMip(Handle h)const
+{
+	return mTextures[h]->ResidentMip;
+}
+
+float TextureStreamer::MinLodClamp(Handle h)const
+{
+	return (float)mTextures[h]->ResidentMip;
+}
+
+bool TextureStreamer::IsFullyResident(Handle h)const
+{
+	return mTextures[h]->ResidentMip == 0;
+}
+
+std::uint64_t TextureStreamer::PendingBytes()const
+{
+	std::uint64_t total = 0;
+	for(const auto& tex : mTextures)
+		total += tex->PendingBytes;
+
+	return total;
+}
+
+std::uint64_t TextureStreamer::UploadMips(ID3D12GraphicsCommandList* cmdList, StreamedTexture& tex,
+	std::uint32_t firstMip, std::uint32_t lastMip, std::uint64_t fenceValue)
+{
+	const DDS_TEXTURE_INFO& info = tex.Data.info;
+	const UINT numMips = lastMip - firstMip + 1;
+
+	// Each array slice is a separate run of subresources; give each its own
+	// suitably aligned region of one upload buffer.
+	std::vector<UINT64> offsets(info.arraySize);
+	UINT64 totalSize = 0;
+	for(UINT slice = 0; slice < info.arraySize; ++slice)
+	{
+		UINT first = D3D12CalcSubresource(firstMip, slice, 0, info.mipCount, info.arraySize);
+		UINT64 sliceSize = 0;
+		ThrowIfFailed(GetTextureFootprints(info.format, info.width, info.height, info.depth,
+			info.mipCount, info.arraySize, first, numMips, 0, nullptr, &sliceSize));
+
+		offsets[slice] = totalSize;
+		totalSize += (sliceSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~(UINT64)(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+	}
+
+	ComPtr<ID3D12Resource> upload;
+	ThrowIfFailed(md3dDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(totalSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&upload)));
+
+	std::uint64_t bytes = 0;
+	std::vector<D3D12_SUBRESOURCE_DATA> srcData(numMips);
+	for(UINT slice = 0; slice < info.arraySize; ++slice)
+	{
+		UINT first = D3D12CalcSubresource(firstMip, slice, 0, info.mipCount, info.arraySize);
+		for(UINT i = 0; i < numMips; ++i)
+		{
+			const DDS_SUBRESOURCE& src = tex.Data.subresources[first + i];
+			srcData[i].pData = src.pData;
+			srcData[i].RowPitch = src.rowPitch;
+			srcData[i].SlicePitch = src.slicePitch;
+			bytes += src.slicePitch;
+		}
+
+		UpdateSubresources(cmdList, tex.Resource.Get(), upload.Get(), offsets[slice], first, numMips, srcData.data());
+	}
+
+	mUploads.push_back({ upload, fenceValue });
+
+	return bytes;
+}
+
+std::uint64_t TextureStreamer::MipBytes(const StreamedTexture& tex, std::uint32_t mip)const
+{
+	const DDS_TEXTURE_INFO& info = tex.Data.info;
+
+	size_t numBytes = 0;
+	GetSurfaceInfo(std::max(1u, info.width >> mip), std::max(1u, info.height >> mip),
+		info.format, &numBytes, nullptr, nullptr);
+
+	return (std::uint64_t)numBytes * info.arraySize;
+}
@@ -0,0 +1,85 @@
+//***************************************************************************************
+// TextureStreamer.h
+//
+// Progressive texture loading.  Add() creates a texture with its whole mip chain but
+// only uploads the mip tail (every mip no larger than TailSize), so the texture can
+// be bound straight away.  Update() then streams finer mips in, one whole mip level
+// at a time, most-starved texture first, until the per-frame byte budget is spent or
+// each texture reaches the LOD the renderer asked for.
+//
+// Mips that are not resident yet are hidden from the shaders through the SRV's
+// ResourceMinLODClamp: use MinLodClamp() when (re)creating the view.  The source file
+// stays mapped until the texture is fully resident.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+
+class TextureStreamer
+{
+public:
+	typedef size_t Handle;
+
+	explicit TextureStreamer(ID3D12Device* device, std::uint32_t tailSize = 128);
+	TextureStreamer(const TextureStreamer& rhs) = delete;
+	TextureStreamer& operator=(const TextureStreamer& rhs) = delete;
+
+	// Creates tex.Resource from tex.Filename and records the upload of its mip tail
+	// on cmdList.  fenceValue is the value the queue signals once cmdList has run.
+	// Textures that are not 2D (or 2D arrays/cubes) are uploaded whole.
+	Handle Add(ID3D12GraphicsCommandList* cmdList, Texture& tex, std::uint64_t fenceValue);
+
+	// The finest mip the renderer wants for this texture, e.g. from screen-space
+	// size or sampler feedback.  0 means full resolution.
+	void RequestLod(Handle h, float lod);
+
+	// Records uploads of finer mips, spending at most byteBudget bytes (but always
+	// at least one mip level so a small budget cannot stall streaming).  Upload
+	// buffers whose fence value is <= completedFence are released.  Returns the
+	// textures whose MinLodClamp changed, so their SRVs can be rewritten.
+	std::vector<Handle> Update(
+		ID3D12GraphicsCommandList* cmdList,
+		std::uint64_t byteBudget,
+		std::uint64_t fenceValue,
+		std::uint64_t completedFence);
+
+	// Finest mip currently uploaded.
+	std::uint32_t ResidentMip(Handle h)const;
+	float MinLodClamp(Handle h)const;
+
+	// True once every mip has been uploaded.
+	bool IsFullyResident(Handle h)const;
+
+	// Bytes still waiting to be streamed over every texture.
+	std::uint64_t PendingBytes()const;
+
+private:
+	struct StreamedTexture
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		DirectX::DDS_TEXTURE_DATA Data;
+		std::uint32_t ResidentMip = 0;
+		std::uint32_t RequestedMip = 0;
+		std::uint64_t PendingBytes = 0;
+	};
+
+	struct RetiredUpload
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+		std::uint64_t FenceValue;
+	};
+
+	// Uploads mips [firstMip, lastMip] of every array slice through one upload
+	// buffer.  Returns the number of source bytes copied.
+	std::uint64_t UploadMips(ID3D12GraphicsCommandList* cmdList, StreamedTexture& tex,
+		std::uint32_t firstMip, std::uint32_t lastMip, std::uint64_t fenceValue);
+
+	std::uint64_t MipBytes(const StreamedTexture& tex, std::uint32_t mip)const;
+
+	ID3D12Device* md3dDevice;
+	std::uint32_t mTailSize;
+
+	std::vector<std::unique_ptr<StreamedTexture>> mTextures;
+	std::vector<RetiredUpload> mUploads;
+};
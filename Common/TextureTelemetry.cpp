@@ -0,0 +1,361 @@
+//***************************************************************************************
+// TextureTelemetry.cpp
+//***************************************************************************************
+
+#include "TextureTelemetry.h"
+#include "FileMapping.h"
+#include "XXHash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+std::atomic<bool> TextureTelemetry::mEnabled(false);
+
+namespace
+{
+	const std::size_t StageCount = (std::size_t)TextureLoadStage::Count;
+
+	// A seqlock per slot: Seq is 0 while the slot is being written and index + 1 once
+	// it holds event number index, so readers can skip slots that are being
+	// overwritten.  The payload words are atomics so those racing reads are defined.
+	struct Slot
+	{
+		std::atomic<std::uint64_t> Seq{ 0 };
+		std::atomic<std::uint64_t> TextureId{ 0 };
+		std::atomic<std::uint64_t> StartNs{ 0 };
+		std::atomic<std::uint64_t> DurationNs{ 0 };
+		std::atomic<std::uint64_t> Bytes{ 0 };
+		std::atomic<std::uint64_t> StageAndThread{ 0 };
+	};
+
+	struct Ring
+	{
+		explicit Ring(std::size_t capacity)
+			: Slots(new Slot[capacity]), Mask(capacity - 1)
+		{
+		}
+
+		std::unique_ptr<Slot[]> Slots;
+		std::size_t Mask;
+		std::atomic<std::uint64_t> Head{ 0 };   // next event number
+		std::atomic<std::uint64_t> Floor{ 0 };  // first event number after a Reset
+	};
+
+	struct StageCounters
+	{
+		std::atomic<std::uint64_t> Count{ 0 };
+		std::atomic<std::uint64_t> TotalNs{ 0 };
+		std::atomic<std::uint64_t> MaxNs{ 0 };
+		std::atomic<std::uint64_t> TotalBytes{ 0 };
+		std::atomic<std::uint64_t> Buckets[TextureStageSummary::BucketCount] = {};
+	};
+
+	std::mutex gSetupMutex;
+	std::atomic<Ring*> gRing{ nullptr };
+	StageCounters gStages[StageCount];
+
+	std::mutex gNameMutex;
+	std::unordered_map<std::uint64_t, std::string> gNames;
+
+	std::atomic<std::uint32_t> gNextThread{ 0 };
+
+	std::uint32_t ThreadIndex()
+	{
+		thread_local std::uint32_t index = gNextThread.fetch_add(1, std::memory_order_relaxed);
+		return index;
+	}
+
+	int BucketOf(std::uint64_t ns)
+	{
+		int bucket = 0;
+		while(ns > 1 && bucket < TextureStageSummary::BucketCount - 1)
+		{
+			ns >>= 1;
+			++bucket;
+		}
+		return bucket;
+	}
+
+	void AppendJsonString(std::string& out, const std::string& s)
+	{
+		out += '"';
+		for(char c : s)
+		{
+			if(c == '"' || c == '\\')
+			{
+				out += '\\';
+				out += c;
+			}
+			else if((unsigned char)c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)(unsigned char)c);
+				out += escaped;
+			}
+			else
+			{
+				out += c;
+			}
+		}
+		out += '"';
+	}
+
+	void AppendCsvField(std::string& out, const std::string& s)
+	{
+		out += '"';
+		for(char c : s)
+		{
+			if(c == '"')
+				out += '"';
+			out += c;
+		}
+		out += '"';
+	}
+}
+
+std::uint64_t TextureStageSummary::PercentileNs(double p)const
+{
+	if(Count == 0)
+		return 0;
+
+	std::uint64_t rank = (std::uint64_t)(std::min(std::max(p, 0.0), 1.0) * (double)(Count - 1));
+	std::uint64_t seen = 0;
+	for(int i = 0; i < BucketCount; ++i)
+	{
+		seen += Buckets[i];
+		if(seen > rank)
+			return std::min(MaxNs, (std::uint64_t(2) << i) - 1);
+	}
+	return MaxNs;
+}
+
+void TextureTelemetry::Enable(std::size_t capacity)
+{
+	{
+		std::lock_guard<std::mutex> lock(gSetupMutex);
+		if(gRing.load(std::memory_order_relaxed) == nullptr)
+		{
+			std::size_t size = 1;
+			while(size < std::max<std::size_t>(capacity, 2))
+				size <<= 1;
+
+			// Lives until exit: recording threads may hold the pointer at any time.
+			gRing.store(new Ring(size), std::memory_order_release);
+		}
+	}
+	mEnabled.store(true, std::memory_order_relaxed);
+}
+
+void TextureTelemetry::Disable()
+{
+	mEnabled.store(false, std::memory_order_relaxed);
+}
+
+void TextureTelemetry::Reset()
+{
+	Ring* ring = gRing.load(std::memory_order_acquire);
+	if(ring != nullptr)
+		ring->Floor.store(ring->Head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	for(StageCounters& s : gStages)
+	{
+		s.Count.store(0, std::memory_order_relaxed);
+		s.TotalNs.store(0, std::memory_order_relaxed);
+		s.MaxNs.store(0, std::memory_order_relaxed);
+		s.TotalBytes.store(0, std::memory_order_relaxed);
+		for(auto& b : s.Buckets)
+			b.store(0, std::memory_order_relaxed);
+	}
+}
+
+std::uint64_t TextureTelemetry::NowNs()
+{
+	return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::uint64_t TextureTelemetry::FileId(const wchar_t* fileName)
+{
+	std::string name = WideToUtf8(fileName);
+	std::uint64_t id = XXH64(name.data(), name.size());
+	if(id == 0)
+		id = 1;
+
+	std::lock_guard<std::mutex> lock(gNameMutex);
+	gNames.emplace(id, std::move(name));
+	return id;
+}
+
+void TextureTelemetry::Record(std::uint64_t textureId, TextureLoadStage stage,
+	std::uint64_t startNs, std::uint64_t durationNs, std::uint64_t bytes)
+{
+	if((std::size_t)stage >= StageCount)
+		return;
+
+	StageCounters& counters = gStages[(std::size_t)stage];
+	counters.Count.fetch_add(1, std::memory_order_relaxed);
+	counters.TotalNs.fetch_add(durationNs, std::memory_order_relaxed);
+	counters.TotalBytes.fetch_add(bytes, std::memory_order_relaxed);
+	counters.Buckets[BucketOf(durationNs)].fetch_add(1, std::memory_order_relaxed);
+	std::uint64_t max = counters.MaxNs.load(std::memory_order_relaxed);
+	while(durationNs > max && !counters.MaxNs.compare_exchange_weak(max, durationNs, std::memory_order_relaxed))
+	{
+	}
+
+	Ring* ring = gRing.load(std::memory_order_acquire);
+	if(ring == nullptr)
+		return;
+
+	std::uint64_t index = ring->Head.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = ring->Slots[index & ring->Mask];
+
+	slot.Seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.TextureId.store(textureId, std::memory_order_relaxed);
+	slot.StartNs.store(startNs, std::memory_order_relaxed);
+	slot.DurationNs.store(durationNs, std::memory_order_relaxed);
+	slot.Bytes.store(bytes, std::memory_order_relaxed);
+	slot.StageAndThread.store((std::uint64_t)stage | ((std::uint64_t)ThreadIndex() << 8), std::memory_order_relaxed);
+	slot.Seq.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TextureLoadEvent> TextureTelemetry::Snapshot()
+{
+	std::vector<TextureLoadEvent> events;
+
+	Ring* ring = gRing.load(std::memory_order_acquire);
+	if(ring == nullptr)
+		return events;
+
+	std::uint64_t head = ring->Head.load(std::memory_order_acquire);
+	std::uint64_t capacity = (std::uint64_t)ring->Mask + 1;
+	std::uint64_t first = std::max(ring->Floor.load(std::memory_order_relaxed), head > capacity ? head - capacity : 0);
+
+	events.reserve((std::size_t)(head - first));
+	for(std::uint64_t index = first; index < head; ++index)
+	{
+		const Slot& slot = ring->Slots[index & ring->Mask];
+		if(slot.Seq.load(std::memory_order_acquire) != index + 1)
+			continue;
+
+		TextureLoadEvent e;
+		e.TextureId = slot.TextureId.load(std::memory_order_relaxed);
+		e.StartNs = slot.StartNs.load(std::memory_order_relaxed);
+		e.DurationNs = slot.DurationNs.load(std::memory_order_relaxed);
+		e.Bytes = slot.Bytes.load(std::memory_order_relaxed);
+		std::uint64_t stageAndThread = slot.StageAndThread.load(std::memory_order_relaxed);
+		e.Stage = (TextureLoadStage)(stageAndThread & 0xFF);
+		e.Thread = (std::uint32_t)(stageAndThread >> 8);
+
+		// Overwritten while it was being copied.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(slot.Seq.load(std::memory_order_relaxed) != index + 1)
+			continue;
+
+		events.push_back(e);
+	}
+	return events;
+}
+
+TextureStageSummary TextureTelemetry::Summary(TextureLoadStage stage)
+{
+	TextureStageSummary summary;
+	if((std::size_t)stage >= StageCount)
+		return summary;
+
+	const StageCounters& counters = gStages[(std::size_t)stage];
+	summary.Count = counters.Count.load(std::memory_order_relaxed);
+	summary.TotalNs = counters.TotalNs.load(std::memory_order_relaxed);
+	summary.MaxNs = counters.MaxNs.load(std::memory_order_relaxed);
+	summary.TotalBytes = counters.TotalBytes.load(std::memory_order_relaxed);
+	for(int i = 0; i < TextureStageSummary::BucketCount; ++i)
+		summary.Buckets[i] = counters.Buckets[i].load(std::memory_order_relaxed);
+	return summary;
+}
+
+const char* TextureTelemetry::StageName(TextureLoadStage stage)
+{
+	switch(stage)
+	{
+	case TextureLoadStage::FileRead:         return "FileRead";
+	case TextureLoadStage::HeaderParse:      return "HeaderParse";
+	case TextureLoadStage::SubresourceTable: return "SubresourceTable";
+	case TextureLoadStage::ResourceCreate:   return "ResourceCreate";
+	case TextureLoadStage::UploadHeapCreate: return "UploadHeapCreate";
+	case TextureLoadStage::UploadCopy:       return "UploadCopy";
+	default:                                 return "Unknown";
+	}
+}
+
+std::string TextureTelemetry::FileName(std::uint64_t textureId)
+{
+	if(textureId == 0)
+		return std::string();
+
+	std::lock_guard<std::mutex> lock(gNameMutex);
+	auto it = gNames.find(textureId);
+	return it != gNames.end() ? it->second : std::string();
+}
+
+std::string TextureTelemetry::FormatCsv()
+{
+	std::string out = "file,stage,thread,start_ns,duration_ns,bytes\n";
+	char line[160];
+	for(const TextureLoadEvent& e : Snapshot())
+	{
+		AppendCsvField(out, FileName(e.TextureId));
+		snprintf(line, sizeof(line), ",%s,%u,%llu,%llu,%llu\n", StageName(e.Stage), e.Thread,
+			(unsigned long long)e.StartNs, (unsigned long long)e.DurationNs, (unsigned long long)e.Bytes);
+		out += line;
+	}
+	return out;
+}
+
+std::string TextureTelemetry::FormatJson()
+{
+	std::string out = "{\n  \"stages\": [\n";
+	char buffer[256];
+	for(std::size_t s = 0; s < StageCount; ++s)
+	{
+		TextureLoadStage stage = (TextureLoadStage)s;
+		TextureStageSummary summary = Summary(stage);
+		snprintf(buffer, sizeof(buffer),
+			"    { \"stage\": \"%s\", \"count\": %llu, \"totalNs\": %llu, \"maxNs\": %llu, "
+			"\"p50Ns\": %llu, \"p99Ns\": %llu, \"totalBytes\": %llu, \"buckets\": [",
+			StageName(stage), (unsigned long long)summary.Count, (unsigned long long)summary.TotalNs,
+			(unsigned long long)summary.MaxNs, (unsigned long long)summary.PercentileNs(0.5),
+			(unsigned long long)summary.PercentileNs(0.99), (unsigned long long)summary.TotalBytes);
+		out += buffer;
+
+		// Trailing empty buckets are left out.
+		int used = TextureStageSummary::BucketCount;
+		while(used > 0 && summary.Buckets[used - 1] == 0)
+			--used;
+		for(int i = 0; i < used; ++i)
+		{
+			snprintf(buffer, sizeof(buffer), "%s%llu", i > 0 ? ", " : "", (unsigned long long)summary.Buckets[i]);
+			out += buffer;
+		}
+		out += s + 1 < StageCount ? "] },\n" : "] }\n";
+	}
+
+	out += "  ],\n  \"events\": [\n";
+	std::vector<TextureLoadEvent> events = Snapshot();
+	for(std::size_t i = 0; i < events.size(); ++i)
+	{
+		const TextureLoadEvent& e = events[i];
+		out += "    { \"file\": ";
+		AppendJsonString(out, FileName(e.TextureId));
+		snprintf(buffer, sizeof(buffer),
+			", \"stage\": \"%s\", \"thread\": %u, \"startNs\": %llu, \"durationNs\": %llu, \"bytes\": %llu }%s\n",
+			StageName(e.Stage), e.Thread, (unsigned long long)e.StartNs, (unsigned long long)e.DurationNs,
+			(unsigned long long)e.Bytes, i + 1 < events.size() ? "," : "");
+		out += buffer;
+	}
+	out += "  ]\n}\n";
+	return out;
+}
@@ -0,0 +1,147 @@
+//***************************************************************************************
+// TextureTelemetry.h
+//
+// Per-stage timing of texture loads, to tell whether slow loads are bound by I/O,
+// parsing or upload.  The DDS pipeline records one event per stage per texture:
+//
+//   FileRead          reading (or mapping) the file, LoadDDSTextureDataFromFile
+//   HeaderParse       header validation and subresource layout
+//   SubresourceTable  building the D3D12_SUBRESOURCE_DATA table
+//   ResourceCreate    creating the default-heap texture
+//   UploadHeapCreate  creating and mapping the upload heap
+//   UploadCopy        copying rows into the upload heap and recording the copy
+//
+// Files loaded with DDS_LOADER_MEMORY_MAPPED are only mapped in FileRead; their pages
+// are read from disk during UploadCopy.  For AsyncTextureReader, FileRead runs from
+// opening the file to its last read completing.  DDS_LOADER_DIRECT_TO_STAGING loads
+// read straight into the upload heap and are not broken down.
+//
+// Events go into a fixed-size ring buffer that any number of threads append to without
+// locks; the oldest events are overwritten.  Every event is also added to a per-stage
+// histogram of durations (power-of-two buckets) that does not wrap.  Recording is off
+// until Enable() is called and then costs one relaxed load per stage; define
+// NO_TEXTURE_TELEMETRY to compile the instrumentation out.
+//***************************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class TextureLoadStage : std::uint8_t
+{
+	FileRead,
+	HeaderParse,
+	SubresourceTable,
+	ResourceCreate,
+	UploadHeapCreate,
+	UploadCopy,
+	Count
+};
+
+struct TextureLoadEvent
+{
+	std::uint64_t TextureId;     // see TextureTelemetry::FileId; 0 for loads from memory
+	TextureLoadStage Stage;
+	std::uint32_t Thread;        // small per-thread index, in order of first use
+	std::uint64_t StartNs;       // since an arbitrary epoch, steady clock
+	std::uint64_t DurationNs;
+	std::uint64_t Bytes;
+};
+
+struct TextureStageSummary
+{
+	static const int BucketCount = 48;
+
+	std::uint64_t Count = 0;
+	std::uint64_t TotalNs = 0;
+	std::uint64_t MaxNs = 0;
+	std::uint64_t TotalBytes = 0;
+
+	// Buckets[i] counts durations in [2^i, 2^(i+1)) ns; bucket 0 also holds 0 ns.
+	std::uint64_t Buckets[BucketCount] = {};
+
+	// Upper bound of the bucket holding the p-th percentile, p in [0, 1].
+	std::uint64_t PercentileNs(double p)const;
+};
+
+class TextureTelemetry
+{
+public:
+	// Starts recording.  The ring buffer holds capacity events (rounded up to a power
+	// of two); it is allocated by the first call and keeps that size afterwards.
+	static void Enable(std::size_t capacity = 65536);
+	static void Disable();
+
+	static bool IsEnabled()
+	{
+#if defined(NO_TEXTURE_TELEMETRY)
+		return false;
+#else
+		return mEnabled.load(std::memory_order_relaxed);
+#endif
+	}
+
+	// Clears the ring buffer and histograms.  Events being recorded at the same time
+	// may survive it.
+	static void Reset();
+
+	static std::uint64_t NowNs();
+
+	// Hash of the file name that tags its events; the name is kept for the exports.
+	static std::uint64_t FileId(const wchar_t* fileName);
+
+	static void Record(std::uint64_t textureId, TextureLoadStage stage,
+		std::uint64_t startNs, std::uint64_t durationNs, std::uint64_t bytes);
+
+	// The events still in the ring buffer, oldest first.
+	static std::vector<TextureLoadEvent> Snapshot();
+	static TextureStageSummary Summary(TextureLoadStage stage);
+
+	static const char* StageName(TextureLoadStage stage);
+	static std::string FileName(std::uint64_t textureId);
+
+	// One line per event, with a header row.
+	static std::string FormatCsv();
+	// {"stages": [summary with histogram...], "events": [...]}.
+	static std::string FormatJson();
+
+private:
+	static std::atomic<bool> mEnabled;
+};
+
+// Times one stage from construction to destruction.  Reads the clock only if
+// recording was on when it was constructed.
+class ScopedTextureLoadTimer
+{
+public:
+	ScopedTextureLoadTimer(std::uint64_t textureId, TextureLoadStage stage, std::uint64_t bytes = 0)
+		: mTextureId(textureId), mStage(stage), mBytes(bytes)
+	{
+		if(TextureTelemetry::IsEnabled())
+			mStartNs = TextureTelemetry::NowNs() + 1;
+	}
+
+	ScopedTextureLoadTimer(const ScopedTextureLoadTimer& rhs) = delete;
+	ScopedTextureLoadTimer& operator=(const ScopedTextureLoadTimer& rhs) = delete;
+
+	~ScopedTextureLoadTimer()
+	{
+		if(mStartNs != 0)
+		{
+			std::uint64_t start = mStartNs - 1;
+			TextureTelemetry::Record(mTextureId, mStage, start, TextureTelemetry::NowNs() - start, mBytes);
+		}
+	}
+
+	// For stages that only learn their size once they have run.
+	void SetBytes(std::uint64_t bytes) { mBytes = bytes; }
+
+private:
+	std::uint64_t mTextureId;
+	TextureLoadStage mStage;
+	std::uint64_t mBytes;
+	std::uint64_t mStartNs = 0;  // start + 1, so 0 means not recording
+};
@@ -0,0 +1,150 @@
+//***************************************************************************************
+// ThreadPool.h
+//
+// Fixed-size worker pool used for load-time work that parallelizes across assets
+// (collision proxies, texture parsing, cooking).  Tasks are plain callables; results
+// come back through std::future.
+//***************************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// A threadCount of 0 uses one worker per hardware thread.
+	explicit ThreadPool(unsigned int threadCount = 0)
+	{
+		if(threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		for(unsigned int i = 0; i < threadCount; ++i)
+			mThreads.emplace_back([this]() { WorkerLoop(); });
+	}
+
+	ThreadPool(const ThreadPool& rhs) = delete;
+	ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+		mCondition.notify_all();
+
+		for(auto& t : mThreads)
+			t.join();
+	}
+
+	unsigned int ThreadCount()const
+	{
+		return (unsigned int)mThreads.size();
+	}
+
+	template<typename F>
+	auto Submit(F&& task) -> std::future<decltype(task())>
+	{
+		using R = decltype(task());
+
+		auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+		std::future<R> result = packaged->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mTasks.emplace([packaged]() { (*packaged)(); });
+		}
+		mCondition.notify_one();
+
+		return result;
+	}
+
+	// Calls fn(i) for every i in [0, count).  The calling thread takes part, so a
+	// pool of N - 1 workers keeps N threads busy; the call returns once every index
+	// has been processed.  The first exception thrown by fn is rethrown here.  Do not
+	// call this from inside a pool task.
+	template<typename F>
+	void ParallelFor(size_t count, F&& fn)
+	{
+		if(count == 0)
+			return;
+
+		std::atomic<size_t> next(0);
+		auto worker = [&]()
+		{
+			for(size_t i = next++; i < count; i = next++)
+				fn(i);
+		};
+
+		size_t helpers = std::min<size_t>(mThreads.size(), count - 1);
+
+		std::vector<std::future<void>> pending;
+		pending.reserve(helpers);
+		for(size_t i = 0; i < helpers; ++i)
+			pending.push_back(Submit(worker));
+
+		std::exception_ptr error;
+		try
+		{
+			worker();
+		}
+		catch(...)
+		{
+			error = std::current_exception();
+			next = count;
+		}
+
+		for(auto& f : pending)
+		{
+			try
+			{
+				f.get();
+			}
+			catch(...)
+			{
+				if(!error)
+					error = std::current_exception();
+			}
+		}
+
+		if(error)
+			std::rethrow_exception(error);
+	}
+
+private:
+	void WorkerLoop()
+	{
+		for(;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+				if(mStopping && mTasks.empty())
+					return;
+
+				task = std::move(mTasks.front());
+				mTasks.pop();
+			}
+
+			task();
+		}
+	}
+
+private:
+	std::vector<std::thread> mThreads;
+	std::queue<std::function<void()>> mTasks;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mStopping = false;
+};
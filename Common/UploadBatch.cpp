@@ -0,0 +1,243 @@
+//***************************************************************************************
+// UploadBatch.cpp
+//***************************************************************************************
+
+#include "UploadBatch.h"
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+// Lets StageDDSTextureFromFile and StageDDSTextureData write into the batch.
+class UploadBatch::Sink : public StagingSink
+{
+public:
+	explicit Sink(FrameUploadAllocator& upload) : mUpload(upload) {}
+
+	uint8_t* Map(uint64_t size) override
+	{
+		mResult = mUpload.TryAllocate(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, mStaging);
+		return SUCCEEDED(mResult) ? mStaging.CpuAddress : nullptr;
+	}
+
+	void Unmap() override
+	{
+	}
+
+	HRESULT Result()const { return mResult; }
+	const FrameUploadAllocator::Allocation& Staged()const { return mStaging; }
+
+private:
+	FrameUploadAllocator& mUpload;
+	FrameUploadAllocator::Allocation mStaging;
+	HRESULT mResult = S_OK;
+};
+
+UploadBatch::UploadBatch(ID3D12Device* device, UINT64 ringBytes)
+	: mUpload(device, ringBytes, 1)
+{
+}
+
+ComPtr<ID3D12Resource> UploadBatch::CreateDefaultBuffer(const void* initData, UINT64 byteSize)
+{
+	ComPtr<ID3D12Resource> defaultBuffer;
+	ThrowIfFailed(mUpload.Device()->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(defaultBuffer.GetAddressOf())));
+
+	CopyBuffer(defaultBuffer.Get(), 0, initData, byteSize);
+	return defaultBuffer;
+}
+
+void UploadBatch::CopyBuffer(
+	ID3D12Resource* dst,
+	UINT64 dstOffset,
+	const void* data,
+	UINT64 byteSize,
+	D3D12_RESOURCE_STATES stateAfter)
+{
+	// Checked before anything is staged, so a rejected copy takes no ring space.
+	auto state = mDstStates.find(dst);
+	if(state != mDstStates.end() && state->second != stateAfter)
+		ThrowIfFailed(E_INVALIDARG);
+
+	PendingCopy copy;
+	copy.Src = mUpload.Copy(data, byteSize, 16);
+	copy.Dst = dst;
+	copy.DstOffset = dstOffset;
+	copy.Size = byteSize;
+	AddCopy(std::move(copy), stateAfter);
+}
+
+void UploadBatch::AddCopy(PendingCopy&& copy, D3D12_RESOURCE_STATES stateAfter)
+{
+	mDstStates.emplace(copy.Dst.Get(), stateAfter);
+	mStats.StagedBytes += copy.Size;
+	mPending.push_back(std::move(copy));
+}
+
+HRESULT UploadBatch::CreateTexture(const DDS_STAGED_TEXTURE& staged, const FrameUploadAllocator::Allocation& src,
+	ComPtr<ID3D12Resource>& texture)
+{
+	const DDS_TEXTURE_INFO& info = staged.info;
+
+	CD3DX12_RESOURCE_DESC texDesc;
+	switch(info.dimension)
+	{
+	case DDS_DIMENSION_TEXTURE1D:
+		texDesc = CD3DX12_RESOURCE_DESC::Tex1D(info.format, info.width,
+			(UINT16)info.arraySize, (UINT16)info.mipCount);
+		break;
+	case DDS_DIMENSION_TEXTURE2D:
+		texDesc = CD3DX12_RESOURCE_DESC::Tex2D(info.format, info.width, info.height,
+			(UINT16)info.arraySize, (UINT16)info.mipCount);
+		break;
+	case DDS_DIMENSION_TEXTURE3D:
+		texDesc = CD3DX12_RESOURCE_DESC::Tex3D(info.format, info.width, info.height,
+			(UINT16)info.depth, (UINT16)info.mipCount);
+		break;
+	default:
+		return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	}
+
+	HRESULT hr = mUpload.Device()->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&texDesc,
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(&texture));
+	if(FAILED(hr))
+	{
+		texture = nullptr;
+		return hr;
+	}
+
+	hr = ValidateTextureFootprints12(mUpload.Device(), texture.Get(), staged.footprints.data(),
+		(UINT)staged.footprints.size(), staged.totalBytes);
+	if(FAILED(hr))
+	{
+		texture = nullptr;
+		return hr;
+	}
+
+	PendingCopy copy;
+	copy.Dst = texture;
+	copy.Src = src;
+	copy.Size = staged.totalBytes;
+	copy.Footprints = staged.footprints;
+	AddCopy(std::move(copy), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	return S_OK;
+}
+
+HRESULT UploadBatch::CreateDDSTextureFromFile(
+	const wchar_t* fileName,
+	ComPtr<ID3D12Resource>& texture,
+	size_t maxsize,
+	DDS_ALPHA_MODE* alphaMode,
+	unsigned int loadFlags)
+{
+	texture = nullptr;
+	if(alphaMode)
+		*alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+
+	if(fileName == nullptr)
+		return E_INVALIDARG;
+
+	Sink sink(mUpload);
+	DDS_STAGED_TEXTURE staged;
+	HRESULT hr = StageDDSTextureFromFile(fileName, sink, staged, maxsize, loadFlags);
+	if(FAILED(hr))
+		return FAILED(sink.Result()) ? sink.Result() : hr;
+
+	hr = CreateTexture(staged, sink.Staged(), texture);
+	if(SUCCEEDED(hr) && alphaMode)
+		*alphaMode = staged.info.alphaMode;
+	return hr;
+}
+
+HRESULT UploadBatch::CreateDDSTextureFromData(const DDS_TEXTURE_DATA& data, ComPtr<ID3D12Resource>& texture)
+{
+	texture = nullptr;
+
+	Sink sink(mUpload);
+	DDS_STAGED_TEXTURE staged;
+	HRESULT hr = StageDDSTextureData(data, sink, staged);
+	if(FAILED(hr))
+		return FAILED(sink.Result()) ? sink.Result() : hr;
+
+	return CreateTexture(staged, sink.Staged(), texture);
+}
+
+UINT UploadBatch::Record(ID3D12GraphicsCommandList* cmdList, std::uint64_t fenceValue)
+{
+	// Staging that is not part of a copy (a load that failed half way) goes with
+	// this batch too.
+	mUpload.EndFrame(fenceValue);
+
+	if(mPending.empty())
+		return 0;
+
+	// One transition per destination, however many copies it takes: the debug layer
+	// rejects a second transition of the same subresource in a batch.
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	barriers.reserve(mDstStates.size());
+	for(const auto& dst : mDstStates)
+	{
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(dst.first,
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST));
+	}
+	cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+
+	for(const PendingCopy& copy : mPending)
+	{
+		if(copy.Footprints.empty())
+		{
+			cmdList->CopyBufferRegion(copy.Dst.Get(), copy.DstOffset, copy.Src.Resource,
+				copy.Src.Offset, copy.Size);
+			continue;
+		}
+
+		const DXGI_FORMAT format = copy.Dst->GetDesc().Format;
+		for(UINT i = 0; i < (UINT)copy.Footprints.size(); ++i)
+		{
+			const TEXTURE_FOOTPRINT& fp = copy.Footprints[i];
+
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT placed;
+			placed.Offset = copy.Src.Offset + fp.offset;
+			placed.Footprint.Format = format;
+			placed.Footprint.Width = fp.width;
+			placed.Footprint.Height = fp.height;
+			placed.Footprint.Depth = fp.depth;
+			placed.Footprint.RowPitch = fp.rowPitch;
+
+			CD3DX12_TEXTURE_COPY_LOCATION dst(copy.Dst.Get(), i);
+			CD3DX12_TEXTURE_COPY_LOCATION src(copy.Src.Resource, placed);
+			cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+		}
+	}
+
+	barriers.clear();
+	for(const auto& dst : mDstStates)
+	{
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(dst.first,
+			D3D12_RESOURCE_STATE_COPY_DEST, dst.second));
+	}
+	cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+
+	UINT copies = (UINT)mPending.size();
+	mPending.clear();
+	mDstStates.clear();
+
+	++mStats.Batches;
+	mStats.Copies += copies;
+	return copies;
+}
+
+void UploadBatch::Release(std::uint64_t completedFence)
+{
+	mUpload.BeginFrame(completedFence);
+}
@@ -0,0 +1,109 @@
+//***************************************************************************************
+// UploadBatch.h
+//
+// Collects the uploads of a load phase (meshes, textures) and records them together.
+// The data is copied into the staging ring of a FrameUploadAllocator as each resource
+// is created; Record() then puts every pending copy on one command list, between a
+// single barrier batch into COPY_DEST and one out of it, one barrier per destination.
+// No upload resource is handed back to the caller: the staging space belongs to the
+// batch and is reclaimed by Release() once the fence the copies were recorded under
+// completes.
+//
+//   batch.CreateDDSTextureFromFile(L"bricks.dds", tex->Resource);
+//   geo->VertexBufferGPU = batch.CreateDefaultBuffer(vertices, vbByteSize);
+//   batch.Record(cmdList, fenceValue);      // then execute and signal fenceValue
+//   ...
+//   batch.Release(fence->GetCompletedValue());
+//
+// Each Record() is one frame of the allocator, so data that does not fit in the free
+// part of the ring goes to an overflow buffer released the same way (see
+// FrameUploadAllocator), and the ring size only affects how many resources are
+// created.
+//***************************************************************************************
+
+#pragma once
+
+#include "d3dUtil.h"
+#include "FrameUploadAllocator.h"
+#include "TextureFootprint.h"
+
+class UploadBatch
+{
+public:
+	struct Stats
+	{
+		std::uint64_t Batches = 0;          // Record calls with copies in them
+		std::uint64_t Copies = 0;           // resources uploaded
+		std::uint64_t StagedBytes = 0;
+	};
+
+	UploadBatch(ID3D12Device* device, UINT64 ringBytes = 64 * 1024 * 1024);
+	UploadBatch(const UploadBatch& rhs) = delete;
+	UploadBatch& operator=(const UploadBatch& rhs) = delete;
+
+	// Same as d3dUtil::CreateDefaultBuffer without the upload buffer: the buffer
+	// is in D3D12_RESOURCE_STATE_GENERIC_READ once the batch has run.
+	Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(const void* initData, UINT64 byteSize);
+
+	// Copies byteSize bytes of data into dst at dstOffset, e.g. a buffer from
+	// PlacedBufferAllocator.  dst must be in D3D12_RESOURCE_STATE_COMMON and ends up
+	// in stateAfter.  Several copies may go to one dst, but all with the same
+	// stateAfter; a different one throws DxException(E_INVALIDARG).
+	void CopyBuffer(
+		ID3D12Resource* dst,
+		UINT64 dstOffset,
+		const void* data,
+		UINT64 byteSize,
+		D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// Same as CreateDDSTextureFromFile12 and CreateDDSTextureFromData12 without the
+	// upload heap.  The file is read straight into the ring (see
+	// StageDDSTextureFromFile); data need only live until the call returns.
+	HRESULT CreateDDSTextureFromFile(
+		const wchar_t* fileName,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& texture,
+		size_t maxsize = 0,
+		DirectX::DDS_ALPHA_MODE* alphaMode = nullptr,
+		unsigned int loadFlags = DirectX::DDS_LOADER_DEFAULT);
+	HRESULT CreateDDSTextureFromData(
+		const DirectX::DDS_TEXTURE_DATA& data,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& texture);
+
+	// Records every pending copy on cmdList.  fenceValue is the value the queue
+	// signals once cmdList has run; the staging is kept until then.  Returns the
+	// number of resources uploaded.
+	UINT Record(ID3D12GraphicsCommandList* cmdList, std::uint64_t fenceValue);
+
+	// Frees the staging of every batch whose fence value is <= completedFence.
+	void Release(std::uint64_t completedFence);
+
+	UINT PendingCopies()const { return (UINT)mPending.size(); }
+	ID3D12Device* Device()const { return mUpload.Device(); }
+	const FrameUploadAllocator& Upload()const { return mUpload; }
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	class Sink;
+
+	struct PendingCopy
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Dst;
+		FrameUploadAllocator::Allocation Src;
+		UINT64 DstOffset = 0;
+		UINT64 Size = 0;
+		std::vector<DirectX::TEXTURE_FOOTPRINT> Footprints;  // empty for buffers
+	};
+
+	// Queues copy; its Dst must not already be pending with another stateAfter.
+	void AddCopy(PendingCopy&& copy, D3D12_RESOURCE_STATES stateAfter);
+	HRESULT CreateTexture(const DirectX::DDS_STAGED_TEXTURE& staged, const FrameUploadAllocator::Allocation& src,
+		Microsoft::WRL::ComPtr<ID3D12Resource>& texture);
+
+	FrameUploadAllocator mUpload;
+
+	std::vector<PendingCopy> mPending;
+
+	// The state each destination of mPending ends up in; one barrier each way.
+	std::unordered_map<ID3D12Resource*, D3D12_RESOURCE_STATES> mDstStates;
+	Stats mStats;
+};
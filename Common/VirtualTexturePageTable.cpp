@@ -0,0 +1,427 @@
+//***************************************************************************************
+// VirtualTexturePageTable.cpp
+//***************************************************************************************
+
+#include "VirtualTexturePageTable.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	// Tile keys pack texture:20 slice:12 mip:4 y:14 x:14.  The Direct3D limits keep
+	// every field in range: 16384 texels is at most 256 tiles of the narrowest shape.
+	const std::uint32_t MaxTextures = 1u << 20;
+
+	std::uint32_t CountTiles(std::uint32_t size, std::uint32_t tileSize)
+	{
+		return (size + tileSize - 1) / tileSize;
+	}
+}
+
+const std::uint32_t VirtualTexturePageTable::TileSizeInBytes;
+const std::uint32_t VirtualTexturePageTable::NotResident;
+
+VirtualTexturePageTable::VirtualTexturePageTable(std::uint64_t budgetBytes)
+{
+	SetBudget(budgetBytes);
+}
+
+bool VirtualTexturePageTable::GetTileShape(DXGI_FORMAT format, std::uint32_t* tileWidth, std::uint32_t* tileHeight)
+{
+	size_t blockWidth = 0;
+	size_t blockHeight = 0;
+	size_t bits = BitsPerPixel(format);
+	if(bits == 0 || !GetBlockSize(format, &blockWidth, &blockHeight))
+		return false;
+
+	// The standard shapes hold 64 KiB of elements (pixels, or blocks for the block
+	// formats), square or twice as wide as tall.
+	size_t elementBytes = bits*blockWidth*blockHeight / 8;
+	if(elementBytes == 0 || elementBytes > 16 || (elementBytes & (elementBytes - 1)) != 0 ||
+		bits*blockWidth*blockHeight % 8 != 0)
+		return false;
+
+	std::uint32_t log2Elements = 16;
+	for(size_t e = elementBytes; e > 1; e >>= 1)
+		--log2Elements;
+
+	*tileWidth = (1u << ((log2Elements + 1) / 2)) * (std::uint32_t)blockWidth;
+	*tileHeight = (1u << (log2Elements / 2)) * (std::uint32_t)blockHeight;
+	return true;
+}
+
+HRESULT VirtualTexturePageTable::Register(const DDS_TEXTURE_INFO& info, TextureId* id)
+{
+	if(id == nullptr)
+		return E_INVALIDARG;
+	*id = 0;
+
+	if(info.dimension != DDS_DIMENSION_TEXTURE2D)
+		return E_NOTIMPL;
+
+	HRESULT hr = ValidateDDSTextureInfo(info);
+	if(FAILED(hr))
+		return hr;
+
+	if(mTextures.size() >= MaxTextures)
+		return E_OUTOFMEMORY;
+
+	Texture t;
+	t.Info = info;
+	if(!GetTileShape(info.format, &t.TileWidth, &t.TileHeight))
+		return E_NOTIMPL;
+
+	// A mip is tiled while it covers at least one whole tile each way; the rest form
+	// the packed tail, which takes whole tiles of its own in every slice.
+	t.Mips.resize(info.mipCount);
+	t.FirstPackedMip = info.mipCount;
+	std::uint64_t tailBytes = 0;
+	for(std::uint32_t mip = 0; mip < info.mipCount; ++mip)
+	{
+		std::uint32_t w = std::max<std::uint32_t>(1, info.width >> mip);
+		std::uint32_t h = std::max<std::uint32_t>(1, info.height >> mip);
+		if(t.FirstPackedMip == info.mipCount && (w < t.TileWidth || h < t.TileHeight))
+			t.FirstPackedMip = mip;
+
+		if(mip >= t.FirstPackedMip)
+		{
+			size_t numBytes = 0;
+			GetSurfaceInfo(w, h, info.format, &numBytes, nullptr, nullptr);
+			tailBytes += numBytes;
+			continue;
+		}
+
+		MipTiles& m = t.Mips[mip];
+		m.TilesX = CountTiles(w, t.TileWidth);
+		m.TilesY = CountTiles(h, t.TileHeight);
+		m.FirstTile = t.TilesPerSlice;
+		t.TilesPerSlice += m.TilesX*m.TilesY;
+	}
+
+	t.Slots.assign(size_t(t.TilesPerSlice)*info.arraySize, NotResident);
+	t.Evicted.assign(t.Slots.size(), false);
+
+	std::uint64_t tailTiles = (tailBytes + TileSizeInBytes - 1) / TileSizeInBytes;
+	mTailBytes += tailTiles*TileSizeInBytes*info.arraySize;
+
+	mTextures.push_back(std::move(t));
+	*id = (TextureId)(mTextures.size() - 1);
+	return S_OK;
+}
+
+void VirtualTexturePageTable::SetBudget(std::uint64_t budgetBytes)
+{
+	std::uint64_t tiles = budgetBytes / TileSizeInBytes;
+	mCapacity = (std::uint32_t)std::min<std::uint64_t>(tiles, NotResident - 1);
+
+	// Growing takes effect at once; the slots past a smaller capacity are emptied
+	// by the next Update.
+	if(mCapacity > mSlots.size())
+	{
+		std::uint32_t first = (std::uint32_t)mSlots.size();
+		mSlots.resize(mCapacity);
+		for(std::uint32_t slot = mCapacity; slot-- > first;)
+			mFreeSlots.push_back(slot);
+	}
+}
+
+std::uint64_t VirtualTexturePageTable::Key(const Tile& tile)
+{
+	return (std::uint64_t)tile.Texture << 44 | (std::uint64_t)tile.Slice << 32 |
+		(std::uint64_t)tile.Mip << 28 | (std::uint64_t)tile.Y << 14 | tile.X;
+}
+
+VirtualTexturePageTable::Tile VirtualTexturePageTable::FromKey(std::uint64_t key)
+{
+	Tile tile;
+	tile.Texture = (TextureId)(key >> 44);
+	tile.Slice = (std::uint32_t)(key >> 32) & 0xFFF;
+	tile.Mip = (std::uint32_t)(key >> 28) & 0xF;
+	tile.Y = (std::uint32_t)(key >> 14) & 0x3FFF;
+	tile.X = (std::uint32_t)key & 0x3FFF;
+	return tile;
+}
+
+std::uint32_t VirtualTexturePageTable::TileIndex(const Tile& tile)const
+{
+	const Texture& t = mTextures[tile.Texture];
+	const MipTiles& m = t.Mips[tile.Mip];
+	return tile.Slice*t.TilesPerSlice + m.FirstTile + tile.Y*m.TilesX + tile.X;
+}
+
+bool VirtualTexturePageTable::Parent(Tile& tile)const
+{
+	// A mip with an odd size can end in a tile whose texels all land in the last
+	// tile of the next mip, hence the clamp.
+	const Texture& t = mTextures[tile.Texture];
+	if(++tile.Mip >= t.FirstPackedMip)
+		return false;
+	tile.X = std::min(tile.X / 2, t.Mips[tile.Mip].TilesX - 1);
+	tile.Y = std::min(tile.Y / 2, t.Mips[tile.Mip].TilesY - 1);
+	return true;
+}
+
+std::uint32_t& VirtualTexturePageTable::SlotOf(const Tile& tile)
+{
+	return mTextures[tile.Texture].Slots[TileIndex(tile)];
+}
+
+std::uint32_t VirtualTexturePageTable::SlotOf(const Tile& tile)const
+{
+	return mTextures[tile.Texture].Slots[TileIndex(tile)];
+}
+
+void VirtualTexturePageTable::Unlink(std::uint32_t slot)
+{
+	Slot& s = mSlots[slot];
+	if(s.Prev != NotResident)
+		mSlots[s.Prev].Next = s.Next;
+	else
+		mHead = s.Next;
+
+	if(s.Next != NotResident)
+		mSlots[s.Next].Prev = s.Prev;
+	else
+		mTail = s.Prev;
+
+	s.Prev = NotResident;
+	s.Next = NotResident;
+}
+
+void VirtualTexturePageTable::PushFront(std::uint32_t slot)
+{
+	Slot& s = mSlots[slot];
+	s.Prev = NotResident;
+	s.Next = mHead;
+	if(mHead != NotResident)
+		mSlots[mHead].Prev = slot;
+	else
+		mTail = slot;
+	mHead = slot;
+}
+
+void VirtualTexturePageTable::Evict(std::uint32_t slot, std::vector<Action>& actions)
+{
+	Slot& s = mSlots[slot];
+	const std::uint32_t index = TileIndex(s.Owner);
+	Texture& t = mTextures[s.Owner.Texture];
+	t.Slots[index] = NotResident;
+	t.Evicted[index] = true;
+
+	Unlink(slot);
+	s.Occupied = false;
+	--mResidentTiles;
+	++mStats.Evictions;
+	actions.push_back({ Action::Evict, s.Owner, slot });
+}
+
+void VirtualTexturePageTable::ProcessFeedback(std::uint64_t frame, const Tile* requests, std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		Tile tile = requests[i];
+		++mStats.Requests;
+
+		// Feedback is written by shaders; ignore anything out of range.
+		if(tile.Texture >= mTextures.size())
+			continue;
+		const Texture& t = mTextures[tile.Texture];
+		if(tile.Slice >= t.Info.arraySize || tile.Mip >= t.Info.mipCount)
+			continue;
+
+		if(tile.Mip >= t.FirstPackedMip)
+		{
+			++mStats.Hits;
+			continue;
+		}
+
+		if(tile.X >= t.Mips[tile.Mip].TilesX || tile.Y >= t.Mips[tile.Mip].TilesY)
+			continue;
+
+		// Walk up from the tile until one is resident: that is what the GPU samples
+		// meanwhile, so it is kept; everything finer is queued.
+		bool hit = true;
+		do
+		{
+			std::uint32_t slot = SlotOf(tile);
+			if(slot != NotResident)
+			{
+				mSlots[slot].LastUsedFrame = frame;
+				Unlink(slot);
+				PushFront(slot);
+				break;
+			}
+
+			hit = false;
+			auto inserted = mPending.insert({ Key(tile), Pending{ tile.Mip, 1, mRequestOrder } });
+			if(inserted.second)
+				++mRequestOrder;
+			else
+				++inserted.first->second.Count;
+		}
+		while(Parent(tile));
+
+		if(hit)
+			++mStats.Hits;
+	}
+}
+
+std::vector<VirtualTexturePageTable::Action> VirtualTexturePageTable::Update(std::uint64_t frame, std::uint32_t maxLoads)
+{
+	std::vector<Action> actions;
+
+	// Give back the slots past a smaller budget.
+	if(mSlots.size() > mCapacity)
+	{
+		for(std::uint32_t slot = mCapacity; slot < (std::uint32_t)mSlots.size(); ++slot)
+		{
+			if(mSlots[slot].Occupied)
+				Evict(slot, actions);
+		}
+		mSlots.resize(mCapacity);
+		mFreeSlots.erase(std::remove_if(mFreeSlots.begin(), mFreeSlots.end(),
+			[this](std::uint32_t slot) { return slot >= mCapacity; }), mFreeSlots.end());
+	}
+
+	// Coarsest mips first, so every region gets some detail before any gets all of
+	// it; then the most wanted, then first come.
+	std::vector<std::pair<std::uint64_t, Pending>> pending(mPending.begin(), mPending.end());
+	mPending.clear();
+	std::sort(pending.begin(), pending.end(), [](const auto& a, const auto& b)
+	{
+		if(a.second.Mip != b.second.Mip)
+			return a.second.Mip > b.second.Mip;
+		if(a.second.Count != b.second.Count)
+			return a.second.Count > b.second.Count;
+		return a.second.Order < b.second.Order;
+	});
+
+	std::size_t loaded = 0;
+	for(; loaded < pending.size(); ++loaded)
+	{
+		if(maxLoads != 0 && loaded == maxLoads)
+			break;
+
+		std::uint32_t slot = NotResident;
+		if(!mFreeSlots.empty())
+		{
+			slot = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+		else
+		{
+			// The list is in order of use, so if its tail was used this frame
+			// every slot was.
+			if(mTail == NotResident || mSlots[mTail].LastUsedFrame == frame)
+			{
+				++mStats.ThrashFrames;
+				break;
+			}
+			slot = mTail;
+			Evict(slot, actions);
+		}
+
+		const Tile tile = FromKey(pending[loaded].first);
+		const std::uint32_t index = TileIndex(tile);
+		Texture& t = mTextures[tile.Texture];
+		t.Slots[index] = slot;
+		if(t.Evicted[index])
+		{
+			++mStats.Reloads;
+			t.Evicted[index] = false;
+		}
+
+		Slot& s = mSlots[slot];
+		s.Owner = tile;
+		s.LastUsedFrame = frame;
+		s.Occupied = true;
+		PushFront(slot);
+
+		++mResidentTiles;
+		++mStats.Loads;
+		actions.push_back({ Action::Load, tile, slot });
+	}
+
+	mStats.DeferredLoads += pending.size() - loaded;
+	mStats.PeakResidentTiles = std::max(mStats.PeakResidentTiles, mResidentTiles);
+	return actions;
+}
+
+VirtualTexturePageTable::PageEntry VirtualTexturePageTable::Lookup(
+	TextureId id, std::uint32_t slice, std::uint32_t mip, std::uint32_t x, std::uint32_t y)const
+{
+	const Texture& t = mTextures[id];
+	Tile tile = { id, slice, mip, x, y };
+	if(mip < t.FirstPackedMip && (x >= t.Mips[mip].TilesX || y >= t.Mips[mip].TilesY))
+		return { NotResident, t.FirstPackedMip };
+
+	if(tile.Mip >= t.FirstPackedMip)
+		return { NotResident, t.FirstPackedMip };
+
+	do
+	{
+		std::uint32_t slot = SlotOf(tile);
+		if(slot != NotResident)
+			return { slot, tile.Mip };
+	}
+	while(Parent(tile));
+
+	return { NotResident, t.FirstPackedMip };
+}
+
+void VirtualTexturePageTable::FillPageTable(
+	TextureId id, std::uint32_t slice, std::uint32_t mip, std::vector<PageEntry>& entries)const
+{
+	const MipTiles& m = mTextures[id].Mips[mip];
+	entries.resize(size_t(m.TilesX)*m.TilesY);
+	for(std::uint32_t y = 0; y < m.TilesY; ++y)
+	{
+		for(std::uint32_t x = 0; x < m.TilesX; ++x)
+			entries[size_t(y)*m.TilesX + x] = Lookup(id, slice, mip, x, y);
+	}
+}
+
+HRESULT VirtualTexturePageTable::ReadTile(const DDS_TEXTURE_DATA& data, const Tile& tile, std::uint8_t* dst)
+{
+	const DDS_TEXTURE_INFO& info = data.info;
+	std::uint32_t tileWidth = 0;
+	std::uint32_t tileHeight = 0;
+	if(dst == nullptr || tile.Slice >= info.arraySize || tile.Mip >= info.mipCount ||
+		data.subresources.size() != size_t(info.mipCount)*info.arraySize)
+		return E_INVALIDARG;
+	if(!GetTileShape(info.format, &tileWidth, &tileHeight))
+		return E_NOTIMPL;
+
+	size_t blockWidth = 1;
+	size_t blockHeight = 1;
+	GetBlockSize(info.format, &blockWidth, &blockHeight);
+	const size_t elementBytes = BitsPerPixel(info.format)*blockWidth*blockHeight / 8;
+
+	const std::uint32_t w = std::max<std::uint32_t>(1, info.width >> tile.Mip);
+	const std::uint32_t h = std::max<std::uint32_t>(1, info.height >> tile.Mip);
+	size_t rowBytes = 0;
+	size_t numRows = 0;
+	GetSurfaceInfo(w, h, info.format, nullptr, &rowBytes, &numRows);
+
+	// In elements (blocks for the block formats) and rows of them.
+	const size_t tileRowBytes = tileWidth / blockWidth * elementBytes;
+	const size_t tileRows = tileHeight / blockHeight;
+	const size_t startByte = size_t(tile.X)*tileRowBytes;
+	const size_t startRow = size_t(tile.Y)*tileRows;
+	if(startByte >= rowBytes || startRow >= numRows)
+		return E_INVALIDARG;
+
+	const size_t copyBytes = std::min(tileRowBytes, rowBytes - startByte);
+	const size_t copyRows = std::min(tileRows, numRows - startRow);
+	if(copyBytes < tileRowBytes || copyRows < tileRows)
+		memset(dst, 0, TileSizeInBytes);
+
+	const DDS_SUBRESOURCE& src = data.subresources[tile.Mip + size_t(tile.Slice)*info.mipCount];
+	const std::uint8_t* base = static_cast<const std::uint8_t*>(src.pData) + startRow*src.rowPitch + startByte;
+	for(size_t row = 0; row < copyRows; ++row)
+		memcpy(dst + row*tileRowBytes, base + row*src.rowPitch, copyBytes);
+
+	return S_OK;
+}
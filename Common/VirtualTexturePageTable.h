@@ -0,0 +1,195 @@
+//***************************************************************************************
+// VirtualTexturePageTable.h
+//
+// Page table and physical tile cache for virtual (tiled) textures.  Every mip of a
+// registered texture is cut into 64 KiB tiles of the Direct3D 12 standard tile shape
+// for its format; a tile is streamed into one slot of a fixed-size physical cache
+// when the GPU asks for it and evicted least recently used when the cache is full.
+// Mips smaller than one tile make up the packed mip tail, which stays resident with
+// the texture and is not counted against the cache.
+//
+// Like ResidencyPolicy this only does bookkeeping, with no device, so it can be
+// driven headlessly from recorded or simulated feedback.  Each frame:
+//
+//   1. ProcessFeedback() with the tiles the GPU sampled or wanted (the readback of a
+//      feedback buffer, or a simulation of one).
+//   2. Update() returns the evictions and loads to carry out: unmap a slot, read the
+//      tile (ReadTile) into the slot and map it.
+//   3. Lookup() / FillPageTable() give the finest resident tile for any request,
+//      for the indirection texture the shaders sample.
+//
+// Tiles are numbered within the subresources the DDS loader creates (mips of slice 0
+// first, as D3D12CalcSubresource) and sized by the GetSurfaceInfo math.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "DDSTextureData.h"
+
+class VirtualTexturePageTable
+{
+public:
+	typedef std::uint32_t TextureId;
+
+	// D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES.
+	static const std::uint32_t TileSizeInBytes = 65536;
+
+	// Slot index meaning "not resident".
+	static const std::uint32_t NotResident = 0xFFFFFFFF;
+
+	struct Tile
+	{
+		TextureId Texture;
+		std::uint32_t Slice;
+		std::uint32_t Mip;
+		std::uint32_t X;
+		std::uint32_t Y;
+	};
+
+	struct Action
+	{
+		enum Type { Load, Evict };
+
+		Type Kind;
+		Tile Where;
+
+		// Physical slot the tile is loaded into or evicted from.
+		std::uint32_t Slot;
+	};
+
+	// Where a request is served from: the tile itself or the nearest coarser one.
+	// Slot is NotResident when only the packed mip tail covers it (Mip is then the
+	// first packed mip, or the mip count for a texture without a tail).
+	struct PageEntry
+	{
+		std::uint32_t Slot;
+		std::uint32_t Mip;
+	};
+
+	struct Stats
+	{
+		std::uint64_t Requests = 0;
+		std::uint64_t Hits = 0;            // Requests for a resident tile or the mip tail.
+		std::uint64_t Loads = 0;
+		std::uint64_t Reloads = 0;         // Loads of a tile that had been evicted.
+		std::uint64_t Evictions = 0;
+		std::uint64_t DeferredLoads = 0;   // Misses not loaded: over maxLoads or no slot free.
+		std::uint64_t ThrashFrames = 0;    // Frames that used every slot and still missed.
+		std::uint32_t PeakResidentTiles = 0;
+	};
+
+	// The cache holds budgetBytes / TileSizeInBytes tiles.
+	explicit VirtualTexturePageTable(std::uint64_t budgetBytes);
+
+	// Width and height in texels of a 64 KiB tile of format; false for formats that
+	// cannot be tiled (element sizes that are not a power of two, planar video).
+	static bool GetTileShape(DXGI_FORMAT format, std::uint32_t* tileWidth, std::uint32_t* tileHeight);
+
+	// Adds a 2D texture, array or cube map.  1D and volume textures, which have other
+	// tile shapes, and formats without a tile shape fail with E_NOTIMPL.
+	HRESULT Register(const DirectX::DDS_TEXTURE_INFO& info, TextureId* id);
+
+	// A smaller budget evicts the least recently used tiles at the next Update.
+	void SetBudget(std::uint64_t budgetBytes);
+
+	// Records GPU feedback for frame: each tile was sampled, or wanted and not
+	// found.  Resident tiles are marked used; missing ones are queued along with
+	// any missing coarser tiles that cover them, so the fallback sharpens mip by
+	// mip.  Requests for the packed mip tail always hit.
+	void ProcessFeedback(std::uint64_t frame, const Tile* requests, std::size_t count);
+
+	// The evictions and loads to carry out before drawing frame, at most maxLoads
+	// loads (0 for no limit), coarsest mips first.  Tiles used this frame are never
+	// evicted, except to fit a smaller budget.  The actions count as done once
+	// returned.  Requests not served are dropped: the GPU asks again next frame if
+	// it still wants them.
+	std::vector<Action> Update(std::uint64_t frame, std::uint32_t maxLoads = 0);
+
+	// The finest resident tile covering (mip, x, y) of a slice.
+	PageEntry Lookup(TextureId id, std::uint32_t slice, std::uint32_t mip, std::uint32_t x, std::uint32_t y)const;
+
+	// Lookup for every tile of one mip, row by row: TilesX(mip) * TilesY(mip) entries.
+	void FillPageTable(TextureId id, std::uint32_t slice, std::uint32_t mip, std::vector<PageEntry>& entries)const;
+
+	// Copies one tile of a loaded texture into dst (TileSizeInBytes), rows of the
+	// tile packed back to back and zero past the edge of the mip.  data must have
+	// the layout the texture was registered with.
+	static HRESULT ReadTile(const DirectX::DDS_TEXTURE_DATA& data, const Tile& tile, std::uint8_t* dst);
+
+	// Finest mip in the packed tail (mipCount when there is none), and the tile grid
+	// of a tiled mip.
+	std::uint32_t FirstPackedMip(TextureId id)const { return mTextures[id].FirstPackedMip; }
+	std::uint32_t TilesX(TextureId id, std::uint32_t mip)const { return mTextures[id].Mips[mip].TilesX; }
+	std::uint32_t TilesY(TextureId id, std::uint32_t mip)const { return mTextures[id].Mips[mip].TilesY; }
+
+	std::uint32_t Capacity()const { return mCapacity; }
+	std::uint32_t ResidentTiles()const { return mResidentTiles; }
+	std::uint64_t PackedTailBytes()const { return mTailBytes; }
+	std::size_t PendingRequests()const { return mPending.size(); }
+	const Stats& GetStats()const { return mStats; }
+
+private:
+	struct MipTiles
+	{
+		std::uint32_t TilesX = 0;
+		std::uint32_t TilesY = 0;
+		std::uint32_t FirstTile = 0;   // Index of tile (0, 0) in the slice's Slots.
+	};
+
+	struct Texture
+	{
+		DirectX::DDS_TEXTURE_INFO Info;
+		std::uint32_t TileWidth = 0;
+		std::uint32_t TileHeight = 0;
+		std::uint32_t FirstPackedMip = 0;
+		std::uint32_t TilesPerSlice = 0;
+		std::vector<MipTiles> Mips;
+		std::vector<std::uint32_t> Slots;  // Per tile of every slice; NotResident if absent.
+		std::vector<bool> Evicted;         // Per tile: loaded before and evicted since.
+	};
+
+	// A physical slot and its place in the LRU list (most recent at the head).
+	struct Slot
+	{
+		Tile Owner;
+		std::uint64_t LastUsedFrame = 0;
+		std::uint32_t Prev = NotResident;
+		std::uint32_t Next = NotResident;
+		bool Occupied = false;
+	};
+
+	struct Pending
+	{
+		std::uint32_t Mip;
+		std::uint32_t Count;
+		std::uint64_t Order;
+	};
+
+	static std::uint64_t Key(const Tile& tile);
+	static Tile FromKey(std::uint64_t key);
+	std::uint32_t& SlotOf(const Tile& tile);
+	std::uint32_t SlotOf(const Tile& tile)const;
+	std::uint32_t TileIndex(const Tile& tile)const;
+
+	// Steps tile to the one covering it in the next mip; false at the packed tail.
+	bool Parent(Tile& tile)const;
+
+	void Unlink(std::uint32_t slot);
+	void PushFront(std::uint32_t slot);
+	void Evict(std::uint32_t slot, std::vector<Action>& actions);
+
+	std::vector<Texture> mTextures;
+	std::vector<Slot> mSlots;
+	std::vector<std::uint32_t> mFreeSlots;
+	std::uint32_t mCapacity = 0;
+	std::uint32_t mResidentTiles = 0;
+	std::uint32_t mHead = NotResident;
+	std::uint32_t mTail = NotResident;
+	std::uint64_t mTailBytes = 0;
+	std::uint64_t mRequestOrder = 0;
+	std::unordered_map<std::uint64_t, Pending> mPending;
+	Stats mStats;
+};
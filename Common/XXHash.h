@@ -0,0 +1,14 @@
+//***************************************************************************************
+// XXHash.h
+//
+// XXH64 (https://github.com/Cyan4973/xxHash), used to key caches by content.  It
+// runs four independent 64-bit accumulators over 32-byte stripes, so the compiler
+// keeps them in registers and the hash runs at memory bandwidth.  Not cryptographic.
+//***************************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+std::uint64_t XXH64(const void* data, std::size_t size, std::uint64_t seed = 0);
@@ -24,6 +24,8 @@
 #include "d3dx12.h"
 #include "DDSTextureLoader.h"
 #include "MathHelper.h"
+#include "CollisionProxy.h"
+#include "NormalMap.h"
 
 extern const int gNumFrameResources;
 
@@ -151,6 +153,10 @@ struct SubmeshGeometry
 	// Bounding box of the geometry defined by this submesh. 
 	// This is used in later chapters of the book.
 	DirectX::BoundingBox Bounds;
+
+	// Hull and simplified shapes for physics and culling, built once at load time
+	// with CollisionProxy::BuildAll.  Null if the submesh has none.
+	std::shared_ptr<const CollisionProxy> Collision = nullptr;
 };
 
 struct MeshGeometry
@@ -260,6 +266,10 @@ struct MaterialConstants
 
 	// Used in texture mapping.
 	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
+
+	// Material::NormalEncoding, so one shader handles both kinds of normal map.
+	// Shaders whose cbuffer stops at MatTransform still read the fields above.
+	std::uint32_t NormalEncoding = 0;
 };
 
 // Simple struct to represent a material for our demos.  A production 3D engine
@@ -278,6 +288,10 @@ struct Material
 	// Index into SRV heap for normal texture.
 	int NormalSrvHeapIndex = -1;
 
+	// How that texture stores its normals; XY (BC5) needs z rebuilt in the shader.
+	// GetNormalMapEncoding(tex->Resource->GetDesc().Format) gives it for a loaded Texture.
+	NormalMapEncoding NormalEncoding = NormalMapEncoding::XYZ;
+
 	// Dirty flag indicating the material has changed and we need to update the constant buffer.
 	// Because we have a material constant buffer for each FrameResource, we have to apply the
 	// update to each FrameResource.  Thus, when we modify a material we should set 
@@ -0,0 +1,104 @@
+//***************************************************************************************
+// DDSFuzz.cpp
+//
+// libFuzzer harness for the DDS parser.  Every input goes through the whole CPU side
+// of a load: GetDDSTextureInfoFromMemory, LoadDDSTextureDataFromMemory at two mip
+// caps, DropTopMips, and StageDDSTextureData, which copies every row of every
+// subresource into the footprint layout.  The parser is only allowed to return an
+// error.  Every input sits in a heap buffer of exactly its size, so with
+// AddressSanitizer any read past its end, a header field as much as a row, is caught.
+//
+// Built by the DDSFuzz target of the root CMakeLists.txt; configure with clang and
+// -DDDS_FUZZ_LIBFUZZER=ON for the fuzzer, which also builds CommonCore (the parser)
+// with coverage and sanitizer instrumentation, then run it:
+//   mkdir -p corpus && ./DDSFuzz -max_len=65536 corpus ../Textures
+//
+// New inputs are written to the first directory, so keep Textures/ second.  Without
+// that option it is built with DDS_FUZZ_STANDALONE (any compiler) and replays the
+// files named on the command line, e.g. a crash file or the whole corpus.
+//***************************************************************************************
+
+#include "../Common/DDSTextureData.h"
+#include "../Common/TextureFootprint.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// Staging is padded to 256 byte rows; a tiny input can legitimately describe
+	// many tiny rows, so cap what one input may allocate.
+	const std::uint64_t MaxStagingBytes = 64ull << 20;
+
+	void Stage(const DDS_TEXTURE_DATA& data)
+	{
+		std::vector<TEXTURE_FOOTPRINT> footprints;
+		std::uint64_t totalBytes = 0;
+		if(FAILED(GetTextureFootprints(data.info, 0, footprints, &totalBytes)) || totalBytes > MaxStagingBytes)
+			return;
+
+		MemoryStagingSink staging;
+		DDS_STAGED_TEXTURE staged;
+		StageDDSTextureData(data, staging, staged);
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, size_t size)
+{
+	DDS_TEXTURE_INFO info;
+	if(FAILED(GetDDSTextureInfoFromMemory(data, size, &info)))
+		return 0;
+
+	DDS_TEXTURE_DATA full;
+	if(SUCCEEDED(LoadDDSTextureDataFromMemory(data, size, full)))
+	{
+		Stage(full);
+
+		DropTopMips(full, 1);
+		Stage(full);
+	}
+
+	// A mip cap taken from the input, so maxsize paths are explored too.
+	DDS_TEXTURE_DATA capped;
+	size_t maxsize = size_t(1) << (data[size - 1] & 15);
+	if(SUCCEEDED(LoadDDSTextureDataFromMemory(data, size, capped, maxsize)))
+		Stage(capped);
+
+	return 0;
+}
+
+#if defined(DDS_FUZZ_STANDALONE)
+
+int main(int argc, char* argv[])
+{
+	int failures = 0;
+	for(int i = 1; i < argc; ++i)
+	{
+		FILE* file = fopen(argv[i], "rb");
+		if(file == nullptr)
+		{
+			fprintf(stderr, "cannot open %s\n", argv[i]);
+			++failures;
+			continue;
+		}
+
+		std::vector<std::uint8_t> input;
+		std::uint8_t buffer[65536];
+		size_t count = 0;
+		while((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			input.insert(input.end(), buffer, buffer + count);
+		fclose(file);
+
+		// A copy has no spare capacity, so ASan sees reads past the end.
+		std::vector<std::uint8_t> exact(input);
+		LLVMFuzzerTestOneInput(exact.data(), exact.size());
+	}
+
+	printf("replayed %d inputs\n", argc - 1 - failures);
+	return failures != 0;
+}
+
+#endif
@@ -0,0 +1,498 @@
+//***************************************************************************************
+// ImageIO.cpp
+//***************************************************************************************
+
+#include "ImageIO.h"
+#include "../Common/BCDecode.h"
+#include "../Common/PixelConvert.h"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include <png.h>
+#include <jpeglib.h>
+
+#if defined(TEXTOOLS_WITH_AVIF)
+#include <avif/avif.h>
+#endif
+
+#if !defined(TEXTOOLS_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#define TEXTOOLS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	bool ReadFile(const std::filesystem::path& path, std::vector<std::uint8_t>& data)
+	{
+		std::ifstream in(path, std::ios::binary | std::ios::ate);
+		if(!in)
+			return false;
+
+		std::streamsize size = in.tellg();
+		in.seekg(0);
+		data.resize((size_t)std::max<std::streamsize>(0, size));
+		return (bool)in.read(reinterpret_cast<char*>(data.data()), size);
+	}
+
+	std::uint32_t Read32(const std::uint8_t* p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((std::uint32_t)p[3] << 24);
+	}
+
+	std::uint16_t Read16(const std::uint8_t* p)
+	{
+		return (std::uint16_t)(p[0] | (p[1] << 8));
+	}
+
+	//
+	// BMP.
+	//
+
+	// Extracts the channel selected by mask and scales it to 8 bits.
+	std::uint8_t MaskChannel(std::uint32_t pixel, std::uint32_t mask)
+	{
+		if(mask == 0)
+			return 0;
+
+		int shift = 0;
+		while(!(mask & (1u << shift)))
+			++shift;
+
+		std::uint32_t max = mask >> shift;
+		std::uint32_t v = (pixel & mask) >> shift;
+		return (std::uint8_t)((v*255 + max/2) / max);
+	}
+
+	bool LoadBMP(const std::vector<std::uint8_t>& file, Image& image, std::string& error)
+	{
+		if(file.size() < 54)
+		{
+			error = "truncated BMP header";
+			return false;
+		}
+
+		const std::uint8_t* info = file.data() + 14;
+		std::uint32_t dataOffset = Read32(file.data() + 10);
+		std::uint32_t headerSize = Read32(info);
+		std::int32_t width = (std::int32_t)Read32(info + 4);
+		std::int32_t height = (std::int32_t)Read32(info + 8);
+		std::uint16_t bpp = Read16(info + 14);
+		std::uint32_t compression = Read32(info + 16);
+		std::uint32_t colorsUsed = Read32(info + 32);
+
+		const std::uint32_t BI_RGB = 0;
+		const std::uint32_t BI_BITFIELDS = 3;
+		if((compression != BI_RGB && compression != BI_BITFIELDS) || (bpp != 8 && bpp != 24 && bpp != 32))
+		{
+			error = "unsupported BMP encoding (" + std::to_string(bpp) + " bpp, compression " + std::to_string(compression) + ")";
+			return false;
+		}
+
+		// Negative height means top-down rows.
+		bool topDown = height < 0;
+		std::uint32_t w = (std::uint32_t)std::abs(width);
+		std::uint32_t h = (std::uint32_t)std::abs(height);
+		std::size_t stride = ((std::size_t)w*bpp/8 + 3) & ~(std::size_t)3;
+		if(w == 0 || h == 0 || dataOffset > file.size() || file.size() - dataOffset < stride*h)
+		{
+			error = "truncated BMP pixel data";
+			return false;
+		}
+
+		std::uint32_t masks[4] = { 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 };
+		if(compression == BI_BITFIELDS)
+		{
+			// The masks follow a 40-byte header, or sit inside a V4/V5 header.
+			for(int c = 0; c < 3; ++c)
+				masks[c] = Read32(info + 40 + 4*c);
+			masks[3] = headerSize >= 56 ? Read32(info + 52) : 0;
+		}
+
+		const std::uint8_t* palette = info + headerSize;
+		std::uint32_t paletteSize = colorsUsed ? colorsUsed : 256;
+		if(bpp == 8 && palette + paletteSize*4 > file.data() + file.size())
+		{
+			error = "truncated BMP palette";
+			return false;
+		}
+
+		image.Width = w;
+		image.Height = h;
+		image.Pixels.resize((std::size_t)w*h*4);
+
+		bool anyAlpha = false;
+		for(std::uint32_t y = 0; y < h; ++y)
+		{
+			const std::uint8_t* src = file.data() + dataOffset + (topDown ? y : h - 1 - y)*stride;
+			std::uint8_t* dst = image.Pixels.data() + (std::size_t)y*w*4;
+			if(bpp == 24)
+			{
+				BGR8ToRGBA8(src, dst, w);
+				continue;
+			}
+
+			for(std::uint32_t x = 0; x < w; ++x, dst += 4)
+			{
+				if(bpp == 8)
+				{
+					const std::uint8_t* entry = palette + 4*std::min<std::uint32_t>(src[x], paletteSize - 1);
+					dst[0] = entry[2];
+					dst[1] = entry[1];
+					dst[2] = entry[0];
+					dst[3] = 255;
+				}
+				else
+				{
+					std::uint32_t pixel = Read32(src + 4*x);
+					dst[0] = MaskChannel(pixel, masks[0]);
+					dst[1] = MaskChannel(pixel, masks[1]);
+					dst[2] = MaskChannel(pixel, masks[2]);
+					dst[3] = MaskChannel(pixel, masks[3]);
+					anyAlpha |= dst[3] != 0;
+				}
+			}
+		}
+
+		// Most 32-bit writers leave the fourth byte zero; that means opaque.
+		if(bpp == 32 && (!anyAlpha || masks[3] == 0))
+		{
+			for(std::size_t i = 3; i < image.Pixels.size(); i += 4)
+				image.Pixels[i] = 255;
+		}
+
+		return true;
+	}
+
+	//
+	// PNG.
+	//
+
+	bool LoadPNG(const std::vector<std::uint8_t>& file, Image& image, std::string& error)
+	{
+		png_image png;
+		memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+
+		if(!png_image_begin_read_from_memory(&png, file.data(), file.size()))
+		{
+			error = png.message;
+			return false;
+		}
+
+		png.format = PNG_FORMAT_RGBA;
+		image.Width = png.width;
+		image.Height = png.height;
+		image.Pixels.resize(PNG_IMAGE_SIZE(png));
+
+		if(!png_image_finish_read(&png, nullptr, image.Pixels.data(), 0, nullptr))
+		{
+			error = png.message;
+			png_image_free(&png);
+			return false;
+		}
+
+		return true;
+	}
+
+	//
+	// JPEG.
+	//
+
+	struct JpegError
+	{
+		jpeg_error_mgr Manager;
+		std::jmp_buf Jump;
+		char Message[JMSG_LENGTH_MAX];
+	};
+
+	void OnJpegError(j_common_ptr cinfo)
+	{
+		JpegError* err = reinterpret_cast<JpegError*>(cinfo->err);
+		(*cinfo->err->format_message)(cinfo, err->Message);
+		std::longjmp(err->Jump, 1);
+	}
+
+	bool LoadJPEG(const std::vector<std::uint8_t>& file, Image& image, std::string& error)
+	{
+		jpeg_decompress_struct cinfo;
+		JpegError err;
+		cinfo.err = jpeg_std_error(&err.Manager);
+		err.Manager.error_exit = OnJpegError;
+
+		// Nothing with a destructor may live between setjmp and the decode.
+		if(setjmp(err.Jump))
+		{
+			error = err.Message;
+			jpeg_destroy_decompress(&cinfo);
+			return false;
+		}
+
+		jpeg_create_decompress(&cinfo);
+		jpeg_mem_src(&cinfo, const_cast<unsigned char*>(file.data()), (unsigned long)file.size());
+		jpeg_read_header(&cinfo, TRUE);
+		cinfo.out_color_space = JCS_RGB;
+		jpeg_start_decompress(&cinfo);
+
+		image.Width = cinfo.output_width;
+		image.Height = cinfo.output_height;
+		image.Pixels.resize((std::size_t)image.Width*image.Height*4);
+
+		// Decode each row into the back of its RGBA row, then spread it forwards.
+		while(cinfo.output_scanline < cinfo.output_height)
+		{
+			std::uint8_t* row = image.Pixels.data() + (std::size_t)cinfo.output_scanline*image.Width*4;
+			JSAMPROW rgb = row + image.Width;
+			jpeg_read_scanlines(&cinfo, &rgb, 1);
+			for(std::uint32_t x = 0; x < image.Width; ++x)
+			{
+				row[4*x] = rgb[3*x];
+				row[4*x + 1] = rgb[3*x + 1];
+				row[4*x + 2] = rgb[3*x + 2];
+				row[4*x + 3] = 255;
+			}
+		}
+
+		jpeg_finish_decompress(&cinfo);
+		jpeg_destroy_decompress(&cinfo);
+		return true;
+	}
+
+	//
+	// AVIF.
+	//
+
+	bool LoadAVIF(const std::vector<std::uint8_t>& file, Image& image, std::string& error)
+	{
+#if defined(TEXTOOLS_WITH_AVIF)
+		avifDecoder* decoder = avifDecoderCreate();
+		avifImage* avif = avifImageCreateEmpty();
+		if(decoder == nullptr || avif == nullptr)
+		{
+			error = "out of memory";
+			if(avif)
+				avifImageDestroy(avif);
+			if(decoder)
+				avifDecoderDestroy(decoder);
+			return false;
+		}
+
+		avifResult result = avifDecoderReadMemory(decoder, avif, file.data(), file.size());
+		if(result == AVIF_RESULT_OK)
+		{
+			image.Width = avif->width;
+			image.Height = avif->height;
+			image.Pixels.resize((std::size_t)image.Width*image.Height*4);
+
+			avifRGBImage rgb;
+			avifRGBImageSetDefaults(&rgb, avif);
+			rgb.format = AVIF_RGB_FORMAT_RGBA;
+			rgb.depth = 8;
+			rgb.pixels = image.Pixels.data();
+			rgb.rowBytes = image.Width*4;
+			result = avifImageYUVToRGB(avif, &rgb);
+		}
+
+		if(result != AVIF_RESULT_OK)
+			error = avifResultToString(result);
+
+		avifImageDestroy(avif);
+		avifDecoderDestroy(decoder);
+		return result == AVIF_RESULT_OK;
+#else
+		(void)file;
+		(void)image;
+		error = "AVIF support not built in (define TEXTOOLS_WITH_AVIF and link libavif)";
+		return false;
+#endif
+	}
+
+	//
+	// DDS.
+	//
+
+	bool LoadDDS(const std::vector<std::uint8_t>& file, Image& image, std::string& error)
+	{
+		DDS_TEXTURE_DATA dds;
+		if(FAILED(LoadDDSTextureDataFromMemory(file.data(), file.size(), dds)))
+		{
+			error = "invalid DDS file";
+			return false;
+		}
+
+		const DDS_TEXTURE_INFO& info = dds.info;
+		if(IsDecodableBC(info.format))
+		{
+			if(FAILED(DecodeBC(dds, 0, image.Pixels, &image.Width, &image.Height)))
+			{
+				error = "cannot decode DDS block data";
+				return false;
+			}
+			return true;
+		}
+
+		bool bgra = info.format == DXGI_FORMAT_B8G8R8A8_UNORM || info.format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+		bool bgrx = info.format == DXGI_FORMAT_B8G8R8X8_UNORM || info.format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+		bool rgba = info.format == DXGI_FORMAT_R8G8B8A8_UNORM || info.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+		if(!bgra && !bgrx && !rgba)
+		{
+			error = "unsupported DDS format " + std::to_string((int)info.format);
+			return false;
+		}
+
+		image.Width = info.width;
+		image.Height = info.height;
+		image.Pixels.resize((std::size_t)info.width*info.height*4);
+
+		const DDS_SUBRESOURCE& sub = dds.subresources[0];
+		for(std::uint32_t y = 0; y < info.height; ++y)
+		{
+			const std::uint8_t* src = static_cast<const std::uint8_t*>(sub.pData) + y*sub.rowPitch;
+			std::uint8_t* dst = image.Pixels.data() + (std::size_t)y*info.width*4;
+			if(rgba)
+				memcpy(dst, src, (std::size_t)info.width*4);
+			else if(bgrx)
+				BGRX8ToRGBA8(src, dst, info.width);
+			else
+				SwizzleRGBA8(src, dst, info.width);
+		}
+
+		return true;
+	}
+}
+
+bool Image::HasAlpha()const
+{
+	for(std::size_t i = 3; i < Pixels.size(); i += 4)
+	{
+		if(Pixels[i] != 255)
+			return true;
+	}
+	return false;
+}
+
+bool LoadImageFile(const std::filesystem::path& path, Image& image, std::string& error)
+{
+	std::vector<std::uint8_t> file;
+	if(!ReadFile(path, file))
+	{
+		error = "cannot read file";
+		return false;
+	}
+
+	image = Image();
+
+	const std::uint8_t* p = file.data();
+	const std::size_t n = file.size();
+	if(n >= 4 && memcmp(p, "DDS ", 4) == 0)
+		return LoadDDS(file, image, error);
+	if(n >= 8 && memcmp(p, "\x89PNG\r\n\x1a\n", 8) == 0)
+		return LoadPNG(file, image, error);
+	if(n >= 3 && p[0] == 0xFF && p[1] == 0xD8 && p[2] == 0xFF)
+		return LoadJPEG(file, image, error);
+	if(n >= 2 && p[0] == 'B' && p[1] == 'M')
+		return LoadBMP(file, image, error);
+	if(n >= 12 && memcmp(p + 4, "ftyp", 4) == 0 && (memcmp(p + 8, "avif", 4) == 0 || memcmp(p + 8, "avis", 4) == 0))
+		return LoadAVIF(file, image, error);
+
+	error = "unrecognised image format";
+	return false;
+}
+
+Image HalveImage(const Image& src)
+{
+	const std::uint32_t w = src.Width;
+	const std::uint32_t h = src.Height;
+
+	Image dst;
+	dst.Width = std::max(1u, w >> 1);
+	dst.Height = std::max(1u, h >> 1);
+	dst.Pixels.resize((std::size_t)dst.Width*dst.Height*4);
+
+	for(std::uint32_t y = 0; y < dst.Height; ++y)
+	{
+		const std::uint8_t* row0 = src.Pixels.data() + (std::size_t)std::min(2*y, h - 1)*w*4;
+		const std::uint8_t* row1 = src.Pixels.data() + (std::size_t)std::min(2*y + 1, h - 1)*w*4;
+		std::uint8_t* out = dst.Pixels.data() + (std::size_t)y*dst.Width*4;
+
+		std::uint32_t x = 0;
+#if TEXTOOLS_SSE2
+		// Two output texels from four source columns per step.
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		for(; 2*x + 3 < w; x += 2)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8*x));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8*x));
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+			lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+			hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+			__m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + 4*x), _mm_packus_epi16(sum, zero));
+		}
+#endif
+		for(; x < dst.Width; ++x)
+		{
+			std::uint32_t x0 = std::min(2*x, w - 1);
+			std::uint32_t x1 = std::min(2*x + 1, w - 1);
+			for(int c = 0; c < 4; ++c)
+			{
+				int sum = row0[4*x0 + c] + row0[4*x1 + c] + row1[4*x0 + c] + row1[4*x1 + c];
+				out[4*x + c] = (std::uint8_t)((sum + 2) >> 2);
+			}
+		}
+	}
+
+	return dst;
+}
+
+Image ResizeImage(const Image& src, std::uint32_t width, std::uint32_t height)
+{
+	// Box down while the image is at least twice the target, so the bilinear pass
+	// never skips source texels.
+	if(src.Width >= 2*width && src.Height >= 2*height)
+		return ResizeImage(HalveImage(src), width, height);
+
+	Image dst;
+	dst.Width = width;
+	dst.Height = height;
+	dst.Pixels.resize((std::size_t)width*height*4);
+
+	const float sx = (float)src.Width / width;
+	const float sy = (float)src.Height / height;
+	for(std::uint32_t y = 0; y < height; ++y)
+	{
+		float fy = std::max(0.0f, (y + 0.5f)*sy - 0.5f);
+		std::uint32_t y0 = std::min((std::uint32_t)fy, src.Height - 1);
+		std::uint32_t y1 = std::min(y0 + 1, src.Height - 1);
+		float ty = fy - y0;
+
+		const std::uint8_t* row0 = src.Pixels.data() + (std::size_t)y0*src.Width*4;
+		const std::uint8_t* row1 = src.Pixels.data() + (std::size_t)y1*src.Width*4;
+		std::uint8_t* out = dst.Pixels.data() + (std::size_t)y*width*4;
+
+		for(std::uint32_t x = 0; x < width; ++x)
+		{
+			float fx = std::max(0.0f, (x + 0.5f)*sx - 0.5f);
+			std::uint32_t x0 = std::min((std::uint32_t)fx, src.Width - 1);
+			std::uint32_t x1 = std::min(x0 + 1, src.Width - 1);
+			float tx = fx - x0;
+
+			for(int c = 0; c < 4; ++c)
+			{
+				float top = row0[4*x0 + c] + (row0[4*x1 + c] - row0[4*x0 + c])*tx;
+				float bottom = row1[4*x0 + c] + (row1[4*x1 + c] - row1[4*x0 + c])*tx;
+				out[4*x + c] = (std::uint8_t)(top + (bottom - top)*ty + 0.5f);
+			}
+		}
+	}
+
+	return dst;
+}
@@ -0,0 +1,46 @@
+//***************************************************************************************
+// ImageIO.h
+//
+// Source image reading for the offline texture tools.  Every reader produces tightly
+// packed RGBA8.  The container is recognised from its first bytes, not its extension
+// (Textures/ has PNG and DDS data behind .jpg names).
+//
+//   BMP   native: 8-bit palettized, 24-bit and 32-bit, uncompressed or bitfields.
+//         32-bit images whose alpha is zero everywhere are treated as opaque.
+//   PNG   libpng (simplified API).
+//   JPEG  libjpeg / libjpeg-turbo.
+//   AVIF  libavif, only when built with TEXTOOLS_WITH_AVIF.
+//   DDS   the Common loader; block-compressed data goes through BCDecode.
+//
+// HalveImage and ResizeImage are the resampling the tools share.
+//
+// Link with -lpng -ljpeg (and -lavif).
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct Image
+{
+	std::uint32_t Width = 0;
+	std::uint32_t Height = 0;
+	std::vector<std::uint8_t> Pixels;  // Width*Height RGBA8, top row first.
+
+	bool HasAlpha()const;
+};
+
+// Reads path into image.  On failure returns false and describes the problem in error.
+bool LoadImageFile(const std::filesystem::path& path, Image& image, std::string& error);
+
+// Returns src halved with a 2x2 box filter: max(1, w/2) x max(1, h/2), each texel the
+// rounded mean of its footprint, clamped at the right and bottom edges.
+Image HalveImage(const Image& src);
+
+// Returns src resampled to width x height with a bilinear filter (texel centres
+// aligned, edges clamped).  Minifying by more than 2x should go through HalveImage
+// first; ResizeImage does that itself.
+Image ResizeImage(const Image& src, std::uint32_t width, std::uint32_t height);
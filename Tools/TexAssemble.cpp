@@ -0,0 +1,666 @@
+//***************************************************************************************
+// TexAssemble.cpp
+//
+// Builds texture arrays, cube maps and atlases from individual images, in place of
+// the Windows-only texassemble.exe that produced treeArray2.dds and flagArray.dds.
+//
+//   array  Slices in the order given.  Images that differ from the first image's
+//          size (or --width/--height) are resized to it, as those arrays need.
+//          Mips use --filter (see MipGenerator.h).
+//   cube   Six faces, +X -X +Y -Y +Z -Z.
+//   atlas  Packs the images into as few pages as fit in --max-size, using MaxRects
+//          with best-short-side-fit.  Each image gets a gutter of --padding texels
+//          repeating its edges, and cells are aligned to 4 texels so BC blocks never
+//          straddle two images.  A UV remap table (see AtlasMap.h) is written next to
+//          the pages; AtlasMap::Apply folds an entry into Material::MatTransform.
+//          With --mips the chain stops at the level where the gutter would shrink
+//          below one texel, so no image filters in its neighbours; atlas mips are
+//          always boxed, since the wider kernels would reach past the gutter.
+//
+// Built by the TexAssemble target of the root CMakeLists.txt, which needs libpng and
+// libjpeg (and libavif with -DTEXTOOLS_WITH_AVIF=ON).
+//
+// Usage: TexAssemble array|cube|atlas -o out.dds [--map out.atlas]
+//                    [--format rgba|bgra|bc1|bc3|bc7] [--srgb] [--mips]
+//                    [--filter box|kaiser|lanczos] [--wrap]
+//                    [--width W --height H] [--padding N] [--max-size N]
+//                    [--threads N] inputs...
+//***************************************************************************************
+
+#include "ImageIO.h"
+#include "../Common/BCEncode.h"
+#include "../Common/DDSWriter.h"
+#include "../Common/MipGenerator.h"
+#include "../Common/ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+namespace fs = std::filesystem;
+
+namespace
+{
+	struct Options
+	{
+		std::string Mode;
+		fs::path Out;
+		fs::path Map;
+		std::string Format = "rgba";
+		bool SRGB = false;
+		bool Mips = false;
+		MipFilter Filter = MipFilter::Box;
+		bool Wrap = false;
+		std::uint32_t Width = 0;
+		std::uint32_t Height = 0;
+		std::uint32_t Padding = 4;
+		std::uint32_t MaxSize = 4096;
+		unsigned int Threads = 0;
+	};
+
+	struct Source
+	{
+		fs::path Path;
+		Image Pixels;
+	};
+
+	DXGI_FORMAT ParseFormat(const Options& opt)
+	{
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		if(opt.Format == "rgba")
+			format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		else if(opt.Format == "bgra")
+			format = DXGI_FORMAT_B8G8R8A8_UNORM;
+		else if(opt.Format == "bc1")
+			format = DXGI_FORMAT_BC1_UNORM;
+		else if(opt.Format == "bc3")
+			format = DXGI_FORMAT_BC3_UNORM;
+		else if(opt.Format == "bc7")
+			format = DXGI_FORMAT_BC7_UNORM;
+
+		return opt.SRGB ? MakeSRGB(format) : format;
+	}
+
+	std::uint32_t AlignUp(std::uint32_t v, std::uint32_t alignment)
+	{
+		return (v + alignment - 1) / alignment * alignment;
+	}
+
+	//
+	// Output.
+	//
+
+	// Converts one RGBA8 level to format into data, returning its row pitch.
+	bool EncodeLevel(DXGI_FORMAT format, const MipImage& level, ThreadPool& pool,
+		std::vector<std::uint8_t>& data, std::size_t& rowBytes)
+	{
+		size_t numBytes = 0;
+		GetSurfaceInfo(level.Width, level.Height, format, &numBytes, &rowBytes, nullptr);
+		data.resize(numBytes);
+
+		if(IsEncodableBC(format))
+		{
+			return SUCCEEDED(EncodeBC(format, level.Pixels.data(), level.Width, level.Height,
+				(std::size_t)level.Width*4, data.data(), rowBytes, &pool));
+		}
+
+		memcpy(data.data(), level.Pixels.data(), numBytes);
+		if(format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
+		{
+			for(std::size_t i = 0; i < numBytes; i += 4)
+				std::swap(data[i], data[i + 2]);
+		}
+		return true;
+	}
+
+	// Writes slices (each a mip chain of equal length) as one DDS file.
+	bool WriteTexture(const Options& opt, ThreadPool& pool, const fs::path& path,
+		const std::vector<std::vector<MipImage>>& slices, bool isCubeMap)
+	{
+		const DXGI_FORMAT format = ParseFormat(opt);
+		const std::uint32_t mipCount = (std::uint32_t)slices[0].size();
+
+		std::vector<std::vector<std::uint8_t>> data(slices.size()*mipCount);
+		std::vector<DDS_SUBRESOURCE> subresources(data.size());
+		for(std::size_t slice = 0; slice < slices.size(); ++slice)
+		{
+			for(std::uint32_t mip = 0; mip < mipCount; ++mip)
+			{
+				const std::size_t index = slice*mipCount + mip;
+				std::size_t rowBytes = 0;
+				if(!EncodeLevel(format, slices[slice][mip], pool, data[index], rowBytes))
+				{
+					fprintf(stderr, "%s: encoding failed\n", path.string().c_str());
+					return false;
+				}
+				subresources[index] = { data[index].data(), (intptr_t)rowBytes, (intptr_t)data[index].size() };
+			}
+		}
+
+		DDS_TEXTURE_INFO info = {};
+		info.dimension = DDS_DIMENSION_TEXTURE2D;
+		info.format = format;
+		info.width = slices[0][0].Width;
+		info.height = slices[0][0].Height;
+		info.depth = 1;
+		info.mipCount = mipCount;
+		info.arraySize = (std::uint32_t)slices.size();
+		info.isCubeMap = isCubeMap;
+		info.alphaMode = DDS_ALPHA_MODE_STRAIGHT;
+
+		HRESULT hr = SaveDDSTextureToFile(path.wstring().c_str(), info, subresources.data(), subresources.size());
+		if(FAILED(hr))
+		{
+			fprintf(stderr, "%s: cannot write (hr 0x%08X)\n", path.string().c_str(), (unsigned int)hr);
+			return false;
+		}
+
+		printf("%s (%ux%u x%zu, %u mips)\n", path.string().c_str(), info.width, info.height, slices.size(), mipCount);
+		return true;
+	}
+
+	// Extends each slice's top level to mipCount levels.
+	bool BuildMips(const Options& opt, ThreadPool& pool, MipFilter filter, std::uint32_t mipCount,
+		std::vector<std::vector<MipImage>>& slices)
+	{
+		MipOptions mipOptions;
+		mipOptions.Filter = filter;
+		mipOptions.SRGB = opt.SRGB;
+		mipOptions.Wrap = opt.Wrap;
+		mipOptions.MipCount = mipCount;
+
+		if(FAILED(GenerateMips(slices, mipOptions, &pool)))
+		{
+			fprintf(stderr, "mip generation failed\n");
+			return false;
+		}
+		return true;
+	}
+
+	//
+	// Arrays and cube maps.
+	//
+
+	bool AssembleArray(const Options& opt, ThreadPool& pool, std::vector<Source>& sources)
+	{
+		const bool isCubeMap = opt.Mode == "cube";
+		if(isCubeMap && sources.size() != 6)
+		{
+			fprintf(stderr, "a cube map needs six faces, got %zu\n", sources.size());
+			return false;
+		}
+
+		const std::uint32_t width = opt.Width ? opt.Width : sources[0].Pixels.Width;
+		const std::uint32_t height = opt.Height ? opt.Height : sources[0].Pixels.Height;
+		if(IsEncodableBC(ParseFormat(opt)) && (width % 4 != 0 || height % 4 != 0))
+		{
+			fprintf(stderr, "block-compressed arrays need a size that is a multiple of 4 (%ux%u)\n", width, height);
+			return false;
+		}
+
+		const std::uint32_t mipCount = opt.Mips ? FullMipCount(width, height) : 1;
+
+		std::vector<std::vector<MipImage>> slices(sources.size());
+		for(std::size_t i = 0; i < sources.size(); ++i)
+		{
+			Image& image = sources[i].Pixels;
+			if(image.Width != width || image.Height != height)
+			{
+				printf("%s: resized %ux%u -> %ux%u\n", sources[i].Path.string().c_str(), image.Width, image.Height, width, height);
+				image = ResizeImage(image, width, height);
+			}
+			slices[i].push_back({ image.Width, image.Height, std::move(image.Pixels) });
+		}
+
+		if(!BuildMips(opt, pool, opt.Filter, mipCount, slices))
+			return false;
+
+		return WriteTexture(opt, pool, opt.Out, slices, isCubeMap);
+	}
+
+	//
+	// Atlases.
+	//
+
+	struct Rect
+	{
+		std::uint32_t X = 0;
+		std::uint32_t Y = 0;
+		std::uint32_t W = 0;
+		std::uint32_t H = 0;
+	};
+
+	// MaxRects bin packer (Jylänki, "A Thousand Ways to Pack the Bin").  The free list
+	// holds maximal free rectangles, which may overlap; a placement splits every free
+	// rectangle it touches and rectangles contained in others are dropped.
+	class MaxRectsPacker
+	{
+	public:
+		MaxRectsPacker(std::uint32_t width, std::uint32_t height)
+		{
+			Rect all;
+			all.W = width;
+			all.H = height;
+			mFree.push_back(all);
+		}
+
+		// Best short side fit: the free rectangle leaving the smallest leftover on its
+		// tighter side, ties broken by the longer side.
+		bool Insert(std::uint32_t w, std::uint32_t h, Rect& placed)
+		{
+			std::uint32_t bestShort = UINT32_MAX;
+			std::uint32_t bestLong = UINT32_MAX;
+			for(const Rect& f : mFree)
+			{
+				if(f.W < w || f.H < h)
+					continue;
+
+				std::uint32_t dw = f.W - w;
+				std::uint32_t dh = f.H - h;
+				std::uint32_t shortSide = std::min(dw, dh);
+				std::uint32_t longSide = std::max(dw, dh);
+				if(shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+				{
+					placed = { f.X, f.Y, w, h };
+					bestShort = shortSide;
+					bestLong = longSide;
+				}
+			}
+
+			if(bestShort == UINT32_MAX)
+				return false;
+
+			Split(placed);
+			Prune();
+			return true;
+		}
+
+	private:
+		void Split(const Rect& used)
+		{
+			std::vector<Rect> next;
+			for(const Rect& f : mFree)
+			{
+				if(used.X >= f.X + f.W || used.X + used.W <= f.X ||
+					used.Y >= f.Y + f.H || used.Y + used.H <= f.Y)
+				{
+					next.push_back(f);
+					continue;
+				}
+
+				if(used.X > f.X)
+					next.push_back({ f.X, f.Y, used.X - f.X, f.H });
+				if(used.X + used.W < f.X + f.W)
+					next.push_back({ used.X + used.W, f.Y, f.X + f.W - used.X - used.W, f.H });
+				if(used.Y > f.Y)
+					next.push_back({ f.X, f.Y, f.W, used.Y - f.Y });
+				if(used.Y + used.H < f.Y + f.H)
+					next.push_back({ f.X, used.Y + used.H, f.W, f.Y + f.H - used.Y - used.H });
+			}
+			mFree.swap(next);
+		}
+
+		static bool Contains(const Rect& a, const Rect& b)
+		{
+			return b.X >= a.X && b.Y >= a.Y && b.X + b.W <= a.X + a.W && b.Y + b.H <= a.Y + a.H;
+		}
+
+		void Prune()
+		{
+			for(std::size_t i = 0; i < mFree.size(); ++i)
+			{
+				for(std::size_t j = i + 1; j < mFree.size(); ++j)
+				{
+					if(Contains(mFree[j], mFree[i]))
+					{
+						mFree.erase(mFree.begin() + i);
+						--i;
+						break;
+					}
+					if(Contains(mFree[i], mFree[j]))
+					{
+						mFree.erase(mFree.begin() + j);
+						--j;
+					}
+				}
+			}
+		}
+
+		std::vector<Rect> mFree;
+	};
+
+	struct Page
+	{
+		std::uint32_t Width = 0;
+		std::uint32_t Height = 0;
+		std::vector<std::pair<std::size_t, Rect>> Cells;  // source index, padded cell
+	};
+
+	// Tries to place every cell in a width x height page, in order.  Returns the
+	// indices that did not fit.
+	std::vector<std::size_t> PackPage(const std::vector<Rect>& cells, const std::vector<std::size_t>& order,
+		std::uint32_t width, std::uint32_t height, Page& page)
+	{
+		MaxRectsPacker packer(width, height);
+		page = Page();
+		page.Width = width;
+		page.Height = height;
+
+		std::vector<std::size_t> rest;
+		for(std::size_t index : order)
+		{
+			Rect placed;
+			if(packer.Insert(cells[index].W, cells[index].H, placed))
+				page.Cells.push_back({ index, placed });
+			else
+				rest.push_back(index);
+		}
+		return rest;
+	}
+
+	// Smallest power-of-two page holding all of order, else a full max-size page and
+	// the remainder on further pages.
+	std::vector<Page> PackAtlas(const std::vector<Rect>& cells, std::vector<std::size_t> order,
+		std::uint32_t minSize, std::uint32_t maxSize)
+	{
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> sizes;
+		for(std::uint32_t w = minSize; w <= maxSize; w *= 2)
+		{
+			for(std::uint32_t h = minSize; h <= maxSize; h *= 2)
+				sizes.push_back({ w, h });
+		}
+		std::sort(sizes.begin(), sizes.end(), [](const auto& a, const auto& b)
+		{
+			std::uint64_t areaA = (std::uint64_t)a.first*a.second;
+			std::uint64_t areaB = (std::uint64_t)b.first*b.second;
+			if(areaA != areaB)
+				return areaA < areaB;
+			return std::max(a.first, a.second) < std::max(b.first, b.second);
+		});
+
+		std::vector<Page> pages;
+		while(!order.empty())
+		{
+			std::uint64_t area = 0;
+			for(std::size_t index : order)
+				area += (std::uint64_t)cells[index].W*cells[index].H;
+
+			Page page;
+			bool done = false;
+			for(const auto& size : sizes)
+			{
+				if((std::uint64_t)size.first*size.second < area)
+					continue;
+				if(PackPage(cells, order, size.first, size.second, page).empty())
+				{
+					done = true;
+					break;
+				}
+			}
+
+			if(done)
+			{
+				pages.push_back(std::move(page));
+				break;
+			}
+
+			order = PackPage(cells, order, maxSize, maxSize, page);
+			pages.push_back(std::move(page));
+		}
+		return pages;
+	}
+
+	fs::path PagePath(const Options& opt, std::size_t page, std::size_t pageCount)
+	{
+		if(pageCount == 1)
+			return opt.Out;
+
+		fs::path path = opt.Out;
+		path.replace_filename(opt.Out.stem().string() + "_" + std::to_string(page) + opt.Out.extension().string());
+		return path;
+	}
+
+	bool AssembleAtlas(const Options& opt, ThreadPool& pool, std::vector<Source>& sources)
+	{
+		// The gutter allows one mip per halving before it runs out; cells are aligned
+		// so that each of those levels still starts every image on a block boundary.
+		std::uint32_t gutterLevels = 1;
+		while((opt.Padding >> gutterLevels) != 0)
+			++gutterLevels;
+		const std::uint32_t mipLimit = opt.Mips ? (opt.Padding ? gutterLevels : 1) : 1;
+		const std::uint32_t alignment = std::max(4u, 1u << (mipLimit - 1));
+
+		std::set<std::string> names;
+		std::vector<Rect> cells(sources.size());
+		for(std::size_t i = 0; i < sources.size(); ++i)
+		{
+			const Image& image = sources[i].Pixels;
+			cells[i].W = AlignUp(image.Width + 2*opt.Padding, alignment);
+			cells[i].H = AlignUp(image.Height + 2*opt.Padding, alignment);
+			if(cells[i].W > opt.MaxSize || cells[i].H > opt.MaxSize)
+			{
+				fprintf(stderr, "%s: %ux%u does not fit a %u page\n", sources[i].Path.string().c_str(),
+					image.Width, image.Height, opt.MaxSize);
+				return false;
+			}
+
+			if(!names.insert(sources[i].Path.stem().string()).second)
+			{
+				fprintf(stderr, "%s: duplicate name in atlas\n", sources[i].Path.string().c_str());
+				return false;
+			}
+		}
+
+		// Largest side first, then largest area.
+		std::vector<std::size_t> order(sources.size());
+		for(std::size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+		{
+			std::uint32_t sideA = std::max(cells[a].W, cells[a].H);
+			std::uint32_t sideB = std::max(cells[b].W, cells[b].H);
+			if(sideA != sideB)
+				return sideA > sideB;
+			return (std::uint64_t)cells[a].W*cells[a].H > (std::uint64_t)cells[b].W*cells[b].H;
+		});
+
+		std::vector<Page> pages = PackAtlas(cells, order, alignment, opt.MaxSize);
+
+		FILE* map = fopen(opt.Map.string().c_str(), "w");
+		if(!map)
+		{
+			fprintf(stderr, "%s: cannot write\n", opt.Map.string().c_str());
+			return false;
+		}
+		fprintf(map, "# TexAssemble atlas map\n");
+		fprintf(map, "# name page scaleU scaleV offsetU offsetV x y width height\n");
+
+		bool ok = true;
+		for(std::size_t p = 0; p < pages.size() && ok; ++p)
+		{
+			const Page& page = pages[p];
+			const fs::path path = PagePath(opt, p, pages.size());
+
+			Image atlas;
+			atlas.Width = page.Width;
+			atlas.Height = page.Height;
+			atlas.Pixels.assign((std::size_t)atlas.Width*atlas.Height*4, 0);
+
+			for(const auto& cell : page.Cells)
+			{
+				const Source& source = sources[cell.first];
+				const Image& image = source.Pixels;
+				const Rect& r = cell.second;
+
+				// Fill the whole cell, clamping to the image, so the gutter repeats the edges.
+				for(std::uint32_t y = 0; y < r.H; ++y)
+				{
+					int sy = std::min(std::max((int)y - (int)opt.Padding, 0), (int)image.Height - 1);
+					std::uint8_t* dst = atlas.Pixels.data() + ((std::size_t)(r.Y + y)*atlas.Width + r.X)*4;
+					for(std::uint32_t x = 0; x < r.W; ++x)
+					{
+						int sx = std::min(std::max((int)x - (int)opt.Padding, 0), (int)image.Width - 1);
+						memcpy(dst + 4*x, image.Pixels.data() + ((std::size_t)sy*image.Width + sx)*4, 4);
+					}
+				}
+
+				const std::uint32_t x = r.X + opt.Padding;
+				const std::uint32_t y = r.Y + opt.Padding;
+				fprintf(map, "%s %s %.9g %.9g %.9g %.9g %u %u %u %u\n", source.Path.stem().string().c_str(),
+					path.filename().string().c_str(),
+					(double)image.Width / atlas.Width, (double)image.Height / atlas.Height,
+					(double)x / atlas.Width, (double)y / atlas.Height,
+					x, y, image.Width, image.Height);
+			}
+
+			std::vector<std::vector<MipImage>> slices(1);
+			slices[0].push_back({ atlas.Width, atlas.Height, std::move(atlas.Pixels) });
+			ok = BuildMips(opt, pool, MipFilter::Box, mipLimit, slices) && WriteTexture(opt, pool, path, slices, false);
+
+			printf("  page %zu: %zu images\n", p, page.Cells.size());
+		}
+
+		if(fclose(map) != 0)
+			ok = false;
+		if(ok)
+			printf("%s\n", opt.Map.string().c_str());
+		return ok;
+	}
+
+	bool IsSourceExtension(const fs::path& path)
+	{
+		std::string ext = path.extension().string();
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+		return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".avif" || ext == ".dds";
+	}
+
+	void Usage(const char* exe)
+	{
+		fprintf(stderr, "usage: %s array|cube|atlas -o out.dds [--map out.atlas] "
+			"[--format rgba|bgra|bc1|bc3|bc7] [--srgb] [--mips] [--filter box|kaiser|lanczos] [--wrap] "
+			"[--width W --height H] "
+			"[--padding N] [--max-size N] [--threads N] inputs...\n", exe);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options opt;
+	std::vector<fs::path> inputs;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			opt.Out = argv[++i];
+		else if(strcmp(argv[i], "--map") == 0 && i + 1 < argc)
+			opt.Map = argv[++i];
+		else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+			opt.Format = argv[++i];
+		else if(strcmp(argv[i], "--srgb") == 0)
+			opt.SRGB = true;
+		else if(strcmp(argv[i], "--mips") == 0)
+			opt.Mips = true;
+		else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			const char* filter = argv[++i];
+			if(strcmp(filter, "box") == 0)
+				opt.Filter = MipFilter::Box;
+			else if(strcmp(filter, "kaiser") == 0)
+				opt.Filter = MipFilter::Kaiser;
+			else if(strcmp(filter, "lanczos") == 0)
+				opt.Filter = MipFilter::Lanczos;
+			else
+			{
+				fprintf(stderr, "unknown filter %s\n", filter);
+				return 1;
+			}
+		}
+		else if(strcmp(argv[i], "--wrap") == 0)
+			opt.Wrap = true;
+		else if(strcmp(argv[i], "--width") == 0 && i + 1 < argc)
+			opt.Width = (std::uint32_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+			opt.Height = (std::uint32_t)std::max(1, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--padding") == 0 && i + 1 < argc)
+			opt.Padding = (std::uint32_t)std::max(0, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--max-size") == 0 && i + 1 < argc)
+			opt.MaxSize = (std::uint32_t)std::max(4, atoi(argv[++i]));
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			opt.Threads = (unsigned int)std::max(1, atoi(argv[++i]));
+		else if(argv[i][0] == '-')
+		{
+			Usage(argv[0]);
+			return 1;
+		}
+		else if(opt.Mode.empty())
+			opt.Mode = argv[i];
+		else
+			inputs.push_back(argv[i]);
+	}
+
+	if((opt.Mode != "array" && opt.Mode != "cube" && opt.Mode != "atlas") || opt.Out.empty() || inputs.empty())
+	{
+		Usage(argv[0]);
+		return 1;
+	}
+
+	if(ParseFormat(opt) == DXGI_FORMAT_UNKNOWN)
+	{
+		fprintf(stderr, "unknown format %s\n", opt.Format.c_str());
+		return 1;
+	}
+
+	// The max page size must be a power of two for the packer's size search.
+	std::uint32_t maxSize = 4;
+	while(maxSize*2 <= opt.MaxSize)
+		maxSize *= 2;
+	opt.MaxSize = maxSize;
+
+	if(opt.Map.empty())
+		opt.Map = fs::path(opt.Out).replace_extension(".atlas");
+
+	// Directories expand to their images in name order; files keep command-line order,
+	// which is the slice order of an array.
+	std::vector<Source> sources;
+	for(const fs::path& input : inputs)
+	{
+		std::vector<fs::path> paths;
+		std::error_code ec;
+		if(fs::is_directory(input, ec))
+		{
+			for(const auto& entry : fs::directory_iterator(input, ec))
+			{
+				if(entry.is_regular_file() && IsSourceExtension(entry.path()))
+					paths.push_back(entry.path());
+			}
+			std::sort(paths.begin(), paths.end());
+		}
+		else
+			paths.push_back(input);
+
+		for(const fs::path& path : paths)
+		{
+			Source source;
+			source.Path = path;
+			std::string error;
+			if(!LoadImageFile(path, source.Pixels, error))
+			{
+				fprintf(stderr, "%s: %s\n", path.string().c_str(), error.c_str());
+				return 1;
+			}
+			sources.push_back(std::move(source));
+		}
+	}
+
+	unsigned int threads = opt.Threads ? opt.Threads : std::max(1u, std::thread::hardware_concurrency());
+	ThreadPool pool(std::max(1u, threads - 1));
+
+	bool ok = opt.Mode == "atlas" ? AssembleAtlas(opt, pool, sources) : AssembleArray(opt, pool, sources);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,369 @@
+//***************************************************************************************
+// TexCook.cpp
+//
+// Offline texture cooker: turns the raw sources in Textures/ (PNG, JPEG, BMP, AVIF,
+// and DDS used as a source) into block-compressed DDS files with a full mip chain
+// that DDSTextureLoader reads.  Runs on Windows and Linux.
+//
+// Mips come from MipGenerator (box, Kaiser or Lanczos; linear-space for --srgb;
+// renormalized for normal maps).  Each level is then encoded with BCEncode, block
+// rows spread across a ThreadPool.  Outputs newer than their source, whose format and
+// mip count match the options, are skipped, so the cooker can run on every build.
+//
+// --format auto picks BC5 for normal maps (names containing _nmap or _normal), BC1
+// for opaque images and images with only on/off alpha (cutouts), and BC3 otherwise.
+// BC5 keeps x and y only (see NormalMap.h); the cooker rebuilds z from the encoded
+// top mip and reports its angular error against the source, and warns when the
+// source alpha, which BC5 drops, was not opaque (some *_nmap files keep height there).
+//
+// Built by the TexCook target of the root CMakeLists.txt, which needs libpng and
+// libjpeg (and libavif with -DTEXTOOLS_WITH_AVIF=ON).
+//
+// Usage: TexCook [--out Cooked] [--format auto|bc1|bc3|bc4|bc5|bc7] [--srgb]
+//                [--filter box|kaiser|lanczos] [--wrap] [--no-mips] [--threads N]
+//                [--force] inputs...
+//   Inputs are image files or directories of them.
+//***************************************************************************************
+
+#include "ImageIO.h"
+#include "../Common/BCEncode.h"
+#include "../Common/BCDecode.h"
+#include "../Common/MipGenerator.h"
+#include "../Common/NormalMap.h"
+#include "../Common/PixelConvert.h"
+#include "../Common/DDSWriter.h"
+#include "../Common/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+using namespace DirectX;
+namespace fs = std::filesystem;
+
+namespace
+{
+	struct Options
+	{
+		fs::path OutDir = "Cooked";
+		std::string Format = "auto";
+		bool SRGB = false;
+		bool Mips = true;
+		MipFilter Filter = MipFilter::Box;
+		bool Wrap = false;
+		bool Force = false;
+		unsigned int Threads = 0;
+	};
+
+	bool IsSourceExtension(const fs::path& path)
+	{
+		std::string ext = path.extension().string();
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+		return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".avif";
+	}
+
+	bool IsNormalMapName(const fs::path& path)
+	{
+		std::string stem = path.stem().string();
+		std::transform(stem.begin(), stem.end(), stem.begin(), [](unsigned char c) { return (char)tolower(c); });
+		return stem.find("_nmap") != std::string::npos || stem.find("_normal") != std::string::npos;
+	}
+
+	DXGI_FORMAT ChooseFormat(const Options& opt, const fs::path& source, const Image& image)
+	{
+		DXGI_FORMAT format = DXGI_FORMAT_BC1_UNORM;
+		if(opt.Format == "bc1")
+			format = DXGI_FORMAT_BC1_UNORM;
+		else if(opt.Format == "bc3")
+			format = DXGI_FORMAT_BC3_UNORM;
+		else if(opt.Format == "bc4")
+			format = DXGI_FORMAT_BC4_UNORM;
+		else if(opt.Format == "bc5")
+			format = DXGI_FORMAT_BC5_UNORM;
+		else if(opt.Format == "bc7")
+			format = DXGI_FORMAT_BC7_UNORM;
+		else if(IsNormalMapName(source))
+			return DXGI_FORMAT_BC5_UNORM;
+		else
+		{
+			bool partial = false;
+			for(std::size_t i = 3; i < image.Pixels.size() && !partial; i += 4)
+				partial = image.Pixels[i] != 0 && image.Pixels[i] != 255;
+			format = partial ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_BC1_UNORM;
+		}
+
+		return opt.SRGB ? MakeSRGB(format) : format;
+	}
+
+	// An output is current if it is newer than its source and was cooked with the
+	// same format choice and mip setting.
+	bool IsUpToDate(const Options& opt, const fs::path& source, const fs::path& output)
+	{
+		std::error_code ec;
+		if(opt.Force || !fs::exists(output, ec))
+			return false;
+
+		if(fs::last_write_time(output, ec) < fs::last_write_time(source, ec) || ec)
+			return false;
+
+		DDS_TEXTURE_INFO info;
+		if(FAILED(GetDDSTextureInfoFromFile(output.wstring().c_str(), &info)))
+			return false;
+
+		if(opt.Format != "auto" || IsNormalMapName(source))
+		{
+			Image none;
+			if(info.format != ChooseFormat(opt, source, none))
+				return false;
+		}
+		else if(info.format != (opt.SRGB ? MakeSRGB(DXGI_FORMAT_BC1_UNORM) : DXGI_FORMAT_BC1_UNORM) &&
+			info.format != (opt.SRGB ? MakeSRGB(DXGI_FORMAT_BC3_UNORM) : DXGI_FORMAT_BC3_UNORM))
+		{
+			return false;
+		}
+
+		std::uint32_t mips = opt.Mips ? FullMipCount(info.width, info.height) : 1;
+		return info.mipCount == mips;
+	}
+
+	// How far the BC5 top mip, with z rebuilt, is from the source normals.
+	std::string CheckNormalMap(const Image& source, const std::vector<std::uint8_t>& blocks,
+		std::uint32_t width, std::uint32_t height, std::size_t rowBytes)
+	{
+		std::vector<std::uint8_t> decoded((std::size_t)width*height*4);
+		DDS_SUBRESOURCE sub = { blocks.data(), (intptr_t)rowBytes, (intptr_t)blocks.size() };
+		if(FAILED(DecodeBC(DXGI_FORMAT_BC5_UNORM, sub, width, height, decoded.data(), (std::size_t)width*4)))
+			return ", cannot decode for checking";
+		ReconstructNormalZRGBA8(decoded.data(), decoded.data(), (std::size_t)width*height);
+
+		NormalMapError error = MeasureNormalMapError(source.Pixels.data(), decoded.data(), (std::size_t)width*height);
+		char text[96];
+		snprintf(text, sizeof(text), ", normals %.2f deg mean, %.2f deg max", error.MeanDegrees, error.MaxDegrees);
+		return text;
+	}
+
+	bool Cook(const Options& opt, ThreadPool& pool, const fs::path& source, const fs::path& output, std::string& note)
+	{
+		Image image;
+		std::string error;
+		if(!LoadImageFile(source, image, error))
+		{
+			fprintf(stderr, "%s: %s\n", source.string().c_str(), error.c_str());
+			return false;
+		}
+
+		const DXGI_FORMAT format = ChooseFormat(opt, source, image);
+		const std::uint32_t mipCount = opt.Mips ? FullMipCount(image.Width, image.Height) : 1;
+
+		MipOptions mipOptions;
+		mipOptions.Filter = opt.Filter;
+		mipOptions.SRGB = opt.SRGB;
+		mipOptions.NormalMap = IsNormalMapName(source) || format == DXGI_FORMAT_BC5_UNORM;
+		mipOptions.Wrap = opt.Wrap;
+		mipOptions.MipCount = mipCount;
+
+		const bool checkNormals = format == DXGI_FORMAT_BC5_UNORM && mipOptions.NormalMap;
+		if(checkNormals)
+		{
+			bool opaque = true;
+			for(std::size_t i = 3; i < image.Pixels.size() && opaque; i += 4)
+				opaque = image.Pixels[i] == 255;
+			if(!opaque)
+				note += ", source alpha dropped";
+		}
+
+		// The source stays around to check the encoded normals against.
+		std::vector<std::vector<MipImage>> chains(1);
+		chains[0].push_back({ image.Width, image.Height, checkNormals ? image.Pixels : std::move(image.Pixels) });
+		if(FAILED(GenerateMips(chains, mipOptions, &pool)))
+		{
+			fprintf(stderr, "%s: mip generation failed\n", source.string().c_str());
+			return false;
+		}
+		const std::vector<MipImage>& levels = chains[0];
+
+		std::vector<std::vector<std::uint8_t>> blocks(mipCount);
+		std::vector<DDS_SUBRESOURCE> subresources(mipCount);
+
+		for(std::uint32_t mip = 0; mip < mipCount; ++mip)
+		{
+			const std::uint32_t w = levels[mip].Width;
+			const std::uint32_t h = levels[mip].Height;
+
+			size_t numBytes = 0;
+			size_t rowBytes = 0;
+			GetSurfaceInfo(w, h, format, &numBytes, &rowBytes, nullptr);
+			blocks[mip].resize(numBytes);
+
+			if(FAILED(EncodeBC(format, levels[mip].Pixels.data(), w, h, (std::size_t)w*4, blocks[mip].data(), rowBytes, &pool)))
+			{
+				fprintf(stderr, "%s: encoding failed\n", source.string().c_str());
+				return false;
+			}
+
+			subresources[mip] = { blocks[mip].data(), (intptr_t)rowBytes, (intptr_t)numBytes };
+
+			if(mip == 0 && checkNormals)
+				note += CheckNormalMap(image, blocks[0], w, h, rowBytes);
+		}
+
+		DDS_TEXTURE_INFO info = {};
+		info.dimension = DDS_DIMENSION_TEXTURE2D;
+		info.format = format;
+		info.width = levels[0].Width;
+		info.height = levels[0].Height;
+		info.depth = 1;
+		info.mipCount = mipCount;
+		info.arraySize = 1;
+		info.alphaMode = (format == DXGI_FORMAT_BC5_UNORM || format == DXGI_FORMAT_BC4_UNORM) ?
+			DDS_ALPHA_MODE_UNKNOWN : DDS_ALPHA_MODE_STRAIGHT;
+
+		HRESULT hr = SaveDDSTextureToFile(output.wstring().c_str(), info, subresources.data(), subresources.size());
+		if(FAILED(hr))
+		{
+			fprintf(stderr, "%s: cannot write (hr 0x%08X)\n", output.string().c_str(), (unsigned int)hr);
+			return false;
+		}
+
+		return true;
+	}
+
+	const char* FormatName(DXGI_FORMAT format)
+	{
+		switch(format)
+		{
+		case DXGI_FORMAT_BC1_UNORM: case DXGI_FORMAT_BC1_UNORM_SRGB: return "BC1";
+		case DXGI_FORMAT_BC3_UNORM: case DXGI_FORMAT_BC3_UNORM_SRGB: return "BC3";
+		case DXGI_FORMAT_BC4_UNORM: return "BC4";
+		case DXGI_FORMAT_BC5_UNORM: return "BC5";
+		case DXGI_FORMAT_BC7_UNORM: case DXGI_FORMAT_BC7_UNORM_SRGB: return "BC7";
+		default: return "?";
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options opt;
+	std::vector<fs::path> inputs;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			opt.OutDir = argv[++i];
+		else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+			opt.Format = argv[++i];
+		else if(strcmp(argv[i], "--srgb") == 0)
+			opt.SRGB = true;
+		else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			const char* filter = argv[++i];
+			if(strcmp(filter, "box") == 0)
+				opt.Filter = MipFilter::Box;
+			else if(strcmp(filter, "kaiser") == 0)
+				opt.Filter = MipFilter::Kaiser;
+			else if(strcmp(filter, "lanczos") == 0)
+				opt.Filter = MipFilter::Lanczos;
+			else
+			{
+				fprintf(stderr, "unknown filter %s\n", filter);
+				return 1;
+			}
+		}
+		else if(strcmp(argv[i], "--wrap") == 0)
+			opt.Wrap = true;
+		else if(strcmp(argv[i], "--no-mips") == 0)
+			opt.Mips = false;
+		else if(strcmp(argv[i], "--force") == 0)
+			opt.Force = true;
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			opt.Threads = (unsigned int)std::max(1, atoi(argv[++i]));
+		else if(argv[i][0] == '-')
+		{
+			fprintf(stderr, "usage: %s [--out Cooked] [--format auto|bc1|bc3|bc4|bc5|bc7] [--srgb] "
+				"[--filter box|kaiser|lanczos] [--wrap] [--no-mips] [--threads N] [--force] inputs...\n", argv[0]);
+			return 1;
+		}
+		else
+			inputs.push_back(argv[i]);
+	}
+
+	const char* formats[] = { "auto", "bc1", "bc3", "bc4", "bc5", "bc7" };
+	if(std::find_if(std::begin(formats), std::end(formats),
+		[&](const char* f) { return opt.Format == f; }) == std::end(formats))
+	{
+		fprintf(stderr, "unknown format %s\n", opt.Format.c_str());
+		return 1;
+	}
+
+	if(opt.SRGB && (opt.Format == "bc4" || opt.Format == "bc5"))
+	{
+		fprintf(stderr, "--srgb does not apply to %s\n", opt.Format.c_str());
+		return 1;
+	}
+
+	std::vector<fs::path> sources;
+	for(const fs::path& input : inputs)
+	{
+		std::error_code ec;
+		if(fs::is_directory(input, ec))
+		{
+			for(const auto& entry : fs::directory_iterator(input, ec))
+			{
+				if(entry.is_regular_file() && IsSourceExtension(entry.path()))
+					sources.push_back(entry.path());
+			}
+		}
+		else
+			sources.push_back(input);
+	}
+	std::sort(sources.begin(), sources.end());
+
+	if(sources.empty())
+	{
+		fprintf(stderr, "no source images\n");
+		return 1;
+	}
+
+	std::error_code ec;
+	fs::create_directories(opt.OutDir, ec);
+
+	unsigned int threads = opt.Threads ? opt.Threads : std::max(1u, std::thread::hardware_concurrency());
+	ThreadPool pool(std::max(1u, threads - 1));
+
+	int failed = 0;
+	int cooked = 0;
+	int skipped = 0;
+	for(const fs::path& source : sources)
+	{
+		fs::path output = opt.OutDir / source.filename().replace_extension(".dds");
+		if(IsUpToDate(opt, source, output))
+		{
+			++skipped;
+			continue;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		std::string note;
+		if(!Cook(opt, pool, source, output, note))
+		{
+			++failed;
+			continue;
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		DDS_TEXTURE_INFO info;
+		if(SUCCEEDED(GetDDSTextureInfoFromFile(output.wstring().c_str(), &info)))
+		{
+			printf("%s -> %s (%ux%u %s, %u mips, %.0f ms%s)\n", source.string().c_str(), output.string().c_str(),
+				info.width, info.height, FormatName(info.format), info.mipCount, ms, note.c_str());
+		}
+		++cooked;
+	}
+
+	printf("%d cooked, %d up to date, %d failed\n", cooked, skipped, failed);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,248 @@
+//***************************************************************************************
+// TexPack.cpp
+//
+// Packs cooked DDS files into one TextureArchive (see Common/TextureArchive.h), so a
+// game opens one file at startup instead of one per texture.  Every .dds below each
+// input directory is stored under its path relative to that directory; mount the
+// archive over the same directory and the DDS loader reads from it unchanged.
+// Payloads are written in name order, each 4 KiB aligned, and files the loader
+// would reject are left out with a warning.
+//
+// Built by the TexPack target of the root CMakeLists.txt.
+//
+// Usage: TexPack -o textures.pak directories...
+//        TexPack --list textures.pak
+//***************************************************************************************
+
+#include "../Common/TextureArchive.h"
+#include "../Common/DDSTextureData.h"
+#include "../Common/XXHash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+namespace fs = std::filesystem;
+
+namespace
+{
+	struct PackFile
+	{
+		fs::path Path;
+		std::string Name;
+		std::vector<std::uint8_t> Data;
+	};
+
+	std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	bool ReadFile(const fs::path& path, std::vector<std::uint8_t>& data)
+	{
+		FILE* file = fopen(path.string().c_str(), "rb");
+		if(file == nullptr)
+			return false;
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		bool ok = size >= 0;
+		if(ok)
+		{
+			data.resize((size_t)size);
+			ok = fread(data.data(), 1, data.size(), file) == data.size();
+		}
+		fclose(file);
+		return ok;
+	}
+
+	bool WritePadding(FILE* file, std::uint64_t& position, std::uint64_t target)
+	{
+		static const std::uint8_t zeros[TEXTURE_ARCHIVE_ALIGNMENT] = {};
+		while(position < target)
+		{
+			size_t count = (size_t)std::min<std::uint64_t>(target - position, sizeof(zeros));
+			if(fwrite(zeros, 1, count, file) != count)
+				return false;
+			position += count;
+		}
+		return true;
+	}
+
+	bool WriteArchive(const fs::path& output, const std::vector<PackFile>& files)
+	{
+		// Index first, so opening the archive touches only its first pages.
+		std::vector<ArchiveEntry> entries(files.size());
+		std::string names;
+		for(size_t i = 0; i < files.size(); ++i)
+		{
+			ArchiveEntry& e = entries[i];
+			e.NameHash = XXH64(files[i].Name.data(), files[i].Name.size());
+			e.NameOffset = (std::uint32_t)names.size();
+			e.NameLength = (std::uint32_t)files[i].Name.size();
+			names += files[i].Name;
+		}
+
+		ArchiveHeader header;
+		header.Magic = TEXTURE_ARCHIVE_MAGIC;
+		header.Version = TEXTURE_ARCHIVE_VERSION;
+		header.EntryCount = (std::uint32_t)files.size();
+		header.Alignment = TEXTURE_ARCHIVE_ALIGNMENT;
+		header.IndexOffset = sizeof(ArchiveHeader);
+		header.DataOffset = AlignUp(header.IndexOffset + entries.size()*sizeof(ArchiveEntry) + names.size(),
+			TEXTURE_ARCHIVE_ALIGNMENT);
+
+		// Payloads stay in name order; only the index is sorted by hash.
+		std::uint64_t offset = header.DataOffset;
+		for(size_t i = 0; i < files.size(); ++i)
+		{
+			entries[i].Offset = offset;
+			entries[i].Size = files[i].Data.size();
+			offset = AlignUp(offset + files[i].Data.size(), TEXTURE_ARCHIVE_ALIGNMENT);
+		}
+
+		std::vector<ArchiveEntry> index = entries;
+		std::stable_sort(index.begin(), index.end(),
+			[](const ArchiveEntry& a, const ArchiveEntry& b) { return a.NameHash < b.NameHash; });
+
+		FILE* file = fopen(output.string().c_str(), "wb");
+		if(file == nullptr)
+			return false;
+
+		std::uint64_t position = 0;
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			fwrite(index.data(), sizeof(ArchiveEntry), index.size(), file) == index.size() &&
+			fwrite(names.data(), 1, names.size(), file) == names.size();
+		position = header.IndexOffset + index.size()*sizeof(ArchiveEntry) + names.size();
+
+		for(size_t i = 0; ok && i < files.size(); ++i)
+		{
+			ok = WritePadding(file, position, entries[i].Offset) &&
+				fwrite(files[i].Data.data(), 1, files[i].Data.size(), file) == files[i].Data.size();
+			position += files[i].Data.size();
+		}
+
+		ok = ok && WritePadding(file, position, AlignUp(position, TEXTURE_ARCHIVE_ALIGNMENT));
+		ok = (fclose(file) == 0) && ok;
+		return ok;
+	}
+
+	int List(const char* archiveFile)
+	{
+		TextureArchive archive;
+		HRESULT hr = archive.Open(fs::path(archiveFile).wstring().c_str());
+		if(FAILED(hr))
+		{
+			fprintf(stderr, "cannot open %s (0x%08x)\n", archiveFile, (unsigned int)hr);
+			return 1;
+		}
+
+		std::vector<std::uint32_t> order(archive.EntryCount());
+		for(std::uint32_t i = 0; i < archive.EntryCount(); ++i)
+			order[i] = i;
+		std::sort(order.begin(), order.end(),
+			[&](std::uint32_t a, std::uint32_t b) { return archive.Entry(a).Offset < archive.Entry(b).Offset; });
+
+		for(std::uint32_t i : order)
+		{
+			const ArchiveEntry& e = archive.Entry(i);
+			printf("%10llu %10llu  %s\n", (unsigned long long)e.Offset, (unsigned long long)e.Size,
+				archive.EntryName(i).c_str());
+		}
+		printf("%u entries\n", archive.EntryCount());
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	fs::path output;
+	std::vector<fs::path> inputs;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			output = argv[++i];
+		else if(strcmp(argv[i], "--list") == 0 && i + 1 < argc)
+			return List(argv[++i]);
+		else if(argv[i][0] == '-')
+		{
+			fprintf(stderr, "usage: %s -o textures.pak directories...\n"
+				"       %s --list textures.pak\n", argv[0], argv[0]);
+			return 1;
+		}
+		else
+			inputs.push_back(argv[i]);
+	}
+
+	if(output.empty() || inputs.empty())
+	{
+		fprintf(stderr, "usage: %s -o textures.pak directories...\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<PackFile> files;
+	int skipped = 0;
+	for(const fs::path& input : inputs)
+	{
+		std::error_code ec;
+		for(const auto& entry : fs::recursive_directory_iterator(input, ec))
+		{
+			if(!entry.is_regular_file() || entry.path().extension() != ".dds")
+				continue;
+
+			PackFile file;
+			file.Path = entry.path();
+			file.Name = TextureArchive::NormalizeName(entry.path().lexically_relative(input).generic_string());
+
+			DDS_TEXTURE_DATA data;
+			if(!ReadFile(file.Path, file.Data) ||
+			   FAILED(LoadDDSTextureDataFromMemory(file.Data.data(), file.Data.size(), data)))
+			{
+				fprintf(stderr, "skipping %s: not a loadable DDS file\n", file.Path.string().c_str());
+				++skipped;
+				continue;
+			}
+
+			files.push_back(std::move(file));
+		}
+	}
+
+	std::sort(files.begin(), files.end(),
+		[](const PackFile& a, const PackFile& b) { return a.Name < b.Name; });
+
+	for(size_t i = 1; i < files.size(); ++i)
+	{
+		if(files[i].Name == files[i - 1].Name)
+		{
+			fprintf(stderr, "%s and %s have the same name in the archive\n",
+				files[i - 1].Path.string().c_str(), files[i].Path.string().c_str());
+			return 1;
+		}
+	}
+
+	if(files.empty())
+	{
+		fprintf(stderr, "no .dds files\n");
+		return 1;
+	}
+
+	if(!WriteArchive(output, files))
+	{
+		fprintf(stderr, "cannot write %s\n", output.string().c_str());
+		return 1;
+	}
+
+	std::uint64_t bytes = 0;
+	for(const PackFile& file : files)
+		bytes += file.Data.size();
+	printf("%s: %zu textures, %llu bytes of payload, %d skipped\n", output.string().c_str(),
+		files.size(), (unsigned long long)bytes, skipped);
+	return 0;
+}